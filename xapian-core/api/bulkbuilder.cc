@@ -0,0 +1,395 @@
+/** @file bulkbuilder.cc
+ * @brief Build a compacted database from scratch in bulk
+ */
+/* Copyright (C) 2026 Xapian contributors
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301 USA
+ */
+
+#include <config.h>
+
+#include <xapian/bulkbuilder.h>
+
+#include <xapian/compactor.h>
+#include <xapian/database.h>
+#include <xapian/document.h>
+#include <xapian/error.h>
+
+#include "debuglog.h"
+#include "fileutils.h"
+#include "omassert.h"
+#include "str.h"
+
+#ifdef XAPIAN_HAS_GLASS_BACKEND
+# include "backends/glass/glass_database.h"
+#endif
+
+#include <algorithm>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#ifdef HAVE_STD_THREAD
+# include <exception>
+# include <system_error>
+# include <thread>
+#endif
+
+using namespace std;
+
+/// Default memory limit if none is specified.
+static const size_t DEFAULT_MEMORY_LIMIT = 256 << 20;
+
+/** How many documents to pass to WritableDatabase::add_documents() at once.
+ *
+ *  We only check the memory used between batches, so this shouldn't be too
+ *  large, but it needs to be large enough to keep all the threads busy.
+ */
+static const size_t BATCH_SIZE = 1000;
+
+namespace Xapian {
+
+class BulkBuilder::Internal : public Xapian::Internal::intrusive_base {
+    /// Don't allow copying.
+    Internal(const Internal&) = delete;
+
+    /// Don't allow assignment.
+    Internal& operator=(const Internal&) = delete;
+
+  public:
+    /// The path of the database to build.
+    string path;
+
+    /// The flags to pass to Database::compact().
+    int flags;
+
+    /// Memory limit for the run being built.
+    size_t run_memory_limit;
+
+    /// Maximum number of threads for add_documents().
+    unsigned parallelism;
+
+    /// Number of documents added so far.
+    Xapian::doccount doccount = 0;
+
+    /// Number of runs started so far.
+    unsigned runs = 0;
+
+    /// Has finish() been called?
+    bool finished = false;
+
+    /** Has adding a document failed?
+     *
+     *  A run buffers all its changes, so if adding a document to it fails
+     *  the whole run is discarded and the database can't be built.
+     */
+    bool failed = false;
+
+    /// The run currently being built (if any).
+    WritableDatabase run;
+
+    /// Is @a run open?
+    bool run_open = false;
+
+    /// Buffered metadata, written to the last run by finish().
+    map<string, string> metadata;
+
+#ifdef HAVE_STD_THREAD
+    /// Thread writing out the previous run (if any).
+    std::thread writer;
+
+    /// Exception thrown by @a writer (if any).
+    std::exception_ptr writer_error;
+#endif
+
+    Internal(const string& path_, int flags_, size_t memory_limit,
+	     unsigned parallelism_)
+	: path(path_), flags(flags_),
+	  run_memory_limit((memory_limit ? memory_limit : DEFAULT_MEMORY_LIMIT) / 2),
+	  parallelism(parallelism_) { }
+
+    ~Internal() {
+	try {
+	    wait_for_writer();
+	} catch (...) {
+	    // Ignore any errors - we're discarding the runs anyway.
+	}
+	try {
+	    if (run_open) run.close();
+	} catch (...) {
+	}
+	remove_runs();
+    }
+
+    /// Check documents can still be added.
+    void check_usable() const {
+	if (finished)
+	    throw Xapian::InvalidOperationError("BulkBuilder::finish() "
+						"already called");
+	if (failed)
+	    throw Xapian::InvalidOperationError("BulkBuilder failed to add a "
+						"document, so can't build the "
+						"database");
+    }
+
+    /// Return the path of run @a n.
+    string run_path(unsigned n) const {
+	return path + ".run" + str(n);
+    }
+
+    /// Remove the temporary databases for all the runs.
+    void remove_runs() {
+	for (unsigned n = 0; n != runs; ++n) {
+	    try {
+		removedir(run_path(n));
+	    } catch (...) {
+		// Leave it for the user to clean up.
+	    }
+	}
+    }
+
+    /// Wait for the previous run to be written out.
+    void wait_for_writer() {
+#ifdef HAVE_STD_THREAD
+	if (writer.joinable()) writer.join();
+	if (writer_error) {
+	    std::exception_ptr e = writer_error;
+	    writer_error = nullptr;
+	    std::rethrow_exception(e);
+	}
+#endif
+    }
+
+    /// Start a new run.
+    void start_run() {
+#ifdef XAPIAN_HAS_GLASS_BACKEND
+	string run_dir = run_path(runs);
+	// Remove any leftovers from a previous build which didn't finish.
+	removedir(run_dir);
+	++runs;
+	run = WritableDatabase(run_dir,
+			       DB_CREATE_OR_OVERWRITE |
+			       DB_BACKEND_GLASS |
+			       DB_NO_SYNC);
+	// We decide when to write out the run, so disable auto-commit.
+	auto glass = static_cast<GlassWritableDatabase*>(run.internal.get());
+	glass->set_flush_thresholds(0, 0);
+	run_open = true;
+#else
+	throw Xapian::FeatureUnavailableError("Glass backend disabled, "
+					      "but BulkBuilder needs it");
+#endif
+    }
+
+    /// Has the current run reached the memory limit?
+    bool run_full() const {
+#ifdef XAPIAN_HAS_GLASS_BACKEND
+	auto glass = static_cast<GlassWritableDatabase*>(run.internal.get());
+	return glass->get_buffered_memory() >= run_memory_limit;
+#else
+	return false;
+#endif
+    }
+
+    /** Return the run to add documents to.
+     *
+     *  If the current run has reached the memory limit, it is written out
+     *  and a new run started.  We check this before adding rather than after
+     *  so that finish() never has to merge an empty run.
+     */
+    WritableDatabase& get_run() {
+	if (run_open && run_full()) end_run();
+	if (!run_open) start_run();
+	return run;
+    }
+
+    /** Write out the current run.
+     *
+     *  If possible this happens in a background thread so the next run
+     *  can be built at the same time.
+     */
+    void end_run() {
+	if (!run_open) return;
+	wait_for_writer();
+	run_open = false;
+	unique_ptr<WritableDatabase> db(new WritableDatabase);
+	swap(*db, run);
+#ifdef HAVE_STD_THREAD
+	try {
+	    // The reference counts aren't thread-safe, so hand our only
+	    // reference to the database over to the thread.
+	    WritableDatabase* w = db.get();
+	    writer = std::thread([this, w]() {
+		unique_ptr<WritableDatabase> owned(w);
+		try {
+		    owned->close();
+		} catch (...) {
+		    writer_error = std::current_exception();
+		}
+	    });
+	    db.release();
+	    return;
+	} catch (const std::system_error&) {
+	    // Fall back to writing the run out in this thread.
+	}
+#endif
+	db->close();
+    }
+};
+
+/// Check the flags passed to BulkBuilder and fill in the default backend.
+static int
+check_flags(int flags)
+{
+    switch (flags & DB_BACKEND_MASK_) {
+	case 0:
+	    flags |= DB_BACKEND_HONEY;
+	    break;
+	case DB_BACKEND_HONEY:
+	case DB_BACKEND_GLASS:
+	    break;
+	default:
+	    throw Xapian::InvalidArgumentError("BulkBuilder can only build "
+					       "honey or glass databases");
+    }
+#ifndef XAPIAN_HAS_GLASS_BACKEND
+    throw Xapian::FeatureUnavailableError("Glass backend disabled, but "
+					  "BulkBuilder needs it");
+#endif
+    return flags;
+}
+
+BulkBuilder::BulkBuilder(const string& path, int flags,
+			 size_t memory_limit, unsigned parallelism)
+    : internal(new Internal(path, check_flags(flags), memory_limit,
+			    parallelism))
+{
+    LOGCALL_CTOR(API, "BulkBuilder", path | flags | memory_limit | parallelism);
+}
+
+BulkBuilder::~BulkBuilder()
+{
+    LOGCALL_DTOR(API, "BulkBuilder");
+}
+
+Xapian::docid
+BulkBuilder::add_document(const Xapian::Document& doc)
+{
+    LOGCALL(API, Xapian::docid, "BulkBuilder::add_document", doc);
+    internal->check_usable();
+    try {
+	internal->get_run().add_document(doc);
+    } catch (...) {
+	internal->failed = true;
+	throw;
+    }
+    RETURN(++internal->doccount);
+}
+
+Xapian::docid
+BulkBuilder::add_documents(const vector<Xapian::Document>& docs)
+{
+    LOGCALL(API, Xapian::docid, "BulkBuilder::add_documents", docs.size());
+    internal->check_usable();
+    if (docs.empty()) RETURN(0);
+    Xapian::docid first = internal->doccount + 1;
+    auto i = docs.begin();
+    while (i != docs.end()) {
+	auto n = min(size_t(docs.end() - i), BATCH_SIZE);
+	vector<Xapian::Document> batch(i, i + n);
+	try {
+	    internal->get_run().add_documents(batch, internal->parallelism);
+	} catch (...) {
+	    internal->failed = true;
+	    throw;
+	}
+	internal->doccount += Xapian::doccount(n);
+	i += n;
+    }
+    RETURN(first);
+}
+
+void
+BulkBuilder::set_metadata(const string& key, const string& value)
+{
+    LOGCALL_VOID(API, "BulkBuilder::set_metadata", key | value);
+    internal->check_usable();
+    if (key.empty())
+	throw Xapian::InvalidArgumentError("Empty metadata keys are invalid");
+    if (value.empty()) {
+	internal->metadata.erase(key);
+    } else {
+	internal->metadata[key] = value;
+    }
+}
+
+void
+BulkBuilder::finish(Xapian::Compactor* compactor, unsigned block_size)
+{
+    LOGCALL_VOID(API, "BulkBuilder::finish", compactor | block_size);
+    internal->check_usable();
+    internal->finished = true;
+
+    // The metadata goes in the last run, which is still open (unless no
+    // documents were added).
+    if (!internal->run_open) internal->start_run();
+    for (auto&& item : internal->metadata) {
+	internal->run.set_metadata(item.first, item.second);
+    }
+    internal->end_run();
+    internal->wait_for_writer();
+
+    Xapian::Database sources;
+    for (unsigned n = 0; n != internal->runs; ++n) {
+	sources.add_database(Xapian::Database(internal->run_path(n),
+					      DB_BACKEND_GLASS));
+    }
+    if (compactor) {
+	sources.compact(internal->path, internal->flags, block_size,
+			*compactor);
+    } else {
+	sources.compact(internal->path, internal->flags, block_size);
+    }
+    sources.close();
+    internal->remove_runs();
+}
+
+Xapian::doccount
+BulkBuilder::get_doccount() const
+{
+    return internal->doccount;
+}
+
+unsigned
+BulkBuilder::get_run_count() const
+{
+    return internal->runs;
+}
+
+string
+BulkBuilder::get_description() const
+{
+    string desc = "BulkBuilder(";
+    desc += internal->path;
+    desc += ", doccount=";
+    desc += str(internal->doccount);
+    desc += ", runs=";
+    desc += str(internal->runs);
+    desc += ')';
+    return desc;
+}
+
+}
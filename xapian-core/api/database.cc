@@ -539,6 +539,18 @@ WritableDatabase::commit()
     internal->commit();
 }
 
+void
+WritableDatabase::commit_async()
+{
+    internal->commit_async();
+}
+
+void
+WritableDatabase::wait_for_commit()
+{
+    internal->wait_for_commit();
+}
+
 void
 WritableDatabase::begin_transaction(bool flushed)
 {
@@ -557,6 +569,15 @@ WritableDatabase::add_document(const Document& doc)
     return internal->add_document(doc);
 }
 
+Xapian::docid
+WritableDatabase::add_documents(const vector<Document>& docs,
+				unsigned parallelism)
+{
+    if (docs.empty())
+	return 0;
+    return internal->add_documents(docs, parallelism);
+}
+
 void
 WritableDatabase::delete_document(Xapian::docid did)
 {
@@ -590,6 +611,16 @@ WritableDatabase::replace_document(const string& term, const Document& doc)
     return internal->replace_document(term, doc);
 }
 
+void
+WritableDatabase::set_document_value(Xapian::docid did, Xapian::valueno slot,
+				     const string& value)
+{
+    if (rare(did == 0))
+	docid_zero_invalid();
+
+    internal->set_document_value(did, slot, value);
+}
+
 void
 WritableDatabase::add_spelling(const string& word,
 			       Xapian::termcount freqinc) const
@@ -228,3 +228,66 @@ EditDistanceCalculator::calc(const unsigned* ptr, int len,
     return seqcmp_editdist<unsigned>(ptr, len, &target[0], target.size(),
 				     array, max_distance);
 }
+
+void
+EditDistanceCalculator::calc_prefix_row(size_t i) const
+{
+    // This is the usual dynamic programming approach to calculating the edit
+    // distance (with transpositions of adjacent characters counted as one
+    // edit, as the algorithm above does), which conveniently works a row -
+    // i.e. a character of the candidate - at a time.
+    const size_t width = target.size() + 1;
+    prefix_rows.resize((i + 1) * width);
+    prefix_row_mins.resize(i + 1);
+    int* row = &prefix_rows[i * width];
+    const int* prev = row - width;
+    unsigned ch = prefix_utf32[i - 1];
+    int row_min = row[0] = int(i);
+    for (size_t j = 1; j != width; ++j) {
+	int d = min(prev[j], row[j - 1]) + 1;
+	d = min(d, prev[j - 1] + (ch != target[j - 1]));
+	if (i > 1 && j > 1 &&
+	    ch == target[j - 2] && prefix_utf32[i - 2] == target[j - 1]) {
+	    d = min(d, prev[j - 2 - width] + 1);
+	}
+	row[j] = d;
+	row_min = min(row_min, d);
+    }
+    prefix_row_mins[i] = row_min;
+}
+
+size_t
+EditDistanceCalculator::unmatchable_prefix_len(const string& candidate,
+					       int max_distance) const
+{
+    if (prefix_rows.empty()) {
+	// Row 0 is the distance from the empty string to each prefix of the
+	// target.
+	for (size_t j = 0; j <= target.size(); ++j) {
+	    prefix_rows.push_back(int(j));
+	}
+	prefix_row_mins.push_back(0);
+    }
+
+    using Xapian::Utf8Iterator;
+    size_t i = 0;
+    for (Utf8Iterator it(candidate); it != Utf8Iterator(); ) {
+	unsigned ch = *it;
+	++it;
+	if (i == prefix_utf32.size() || prefix_utf32[i] != ch) {
+	    prefix_utf32.resize(i);
+	    prefix_utf32.push_back(ch);
+	    calc_prefix_row(i + 1);
+	}
+	++i;
+	// Appending a character can't reduce the smallest entry in the row,
+	// except that a transposition can reach back two rows, so every
+	// string starting with the first i characters is at least this many
+	// edits away.
+	int bound = min(prefix_row_mins[i], prefix_row_mins[i - 1] + 1);
+	if (bound > max_distance) {
+	    return candidate.size() - it.left();
+	}
+    }
+    return 0;
+}
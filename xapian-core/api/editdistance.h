@@ -24,6 +24,7 @@
 
 #include <cstdlib>
 #include <climits>
+#include <string>
 #include <vector>
 
 #include "omassert.h"
@@ -90,6 +91,26 @@ class EditDistanceCalculator {
      */
     int calc(const unsigned* ptr, int len, int max_distance) const;
 
+    /** The last candidate passed to unmatchable_prefix_len() in UTF-32.
+     *
+     *  Only as far as the rows in prefix_rows have been calculated.
+     */
+    mutable std::vector<unsigned> prefix_utf32;
+
+    /** Rows of the edit distance matrix between prefixes of prefix_utf32
+     *  and the target.
+     *
+     *  Row i (for the first i characters of prefix_utf32) starts at index
+     *  i * (target.size() + 1).
+     */
+    mutable std::vector<int> prefix_rows;
+
+    /// The smallest entry in each row in prefix_rows.
+    mutable std::vector<int> prefix_row_mins;
+
+    /// Calculate row @a i of prefix_rows from the rows before it.
+    void calc_prefix_row(size_t i) const;
+
   public:
     /** Constructor.
      *
@@ -129,13 +150,13 @@ class EditDistanceCalculator {
 	//
 	// First check based on the encoded UTF-8 length of the candidate.
 	// Each Unicode codepoint is 1-4 bytes in UTF-8 and one word in UTF-32,
-	// so the number of UTF-32 characters in candidate must be >= int(bytes
-	// + 3 / 4) and <= bytes.
+	// so the number of UTF-32 characters in candidate must be >= (bytes
+	// + 3) / 4 and <= bytes.
 	if (target.size() > candidate.size() + max_distance) {
 	    // Candidate too short.
 	    return INT_MAX;
 	}
-	if (target.size() + max_distance < candidate.size() * 3 / 4) {
+	if (target.size() + max_distance < (candidate.size() + 3) / 4) {
 	    // Candidate too long.
 	    return INT_MAX;
 	}
@@ -152,6 +173,28 @@ class EditDistanceCalculator {
 	// Actually calculate the edit distance.
 	return calc(&utf32[0], utf32.size(), max_distance);
     }
+
+    /** Find a prefix of a candidate which can't be extended to a match.
+     *
+     *  This allows a caller which is working through candidates in sorted
+     *  order to skip over every candidate starting with the prefix returned.
+     *
+     *  The rows of the edit distance matrix are kept from the previous call
+     *  and reused for the characters @a candidate shares with the previous
+     *  candidate, so this is cheap when consecutive candidates share a long
+     *  prefix.
+     *
+     *  @param candidate	String to check.
+     *  @param max_distance	The greatest edit distance that's interesting
+     *				to us.  This must be the same for every call
+     *				on the same object.
+     *
+     *  @return The length in bytes of the shortest prefix of @a candidate
+     *		which no string starting with can be within @a max_distance
+     *		edits of the target, or 0 if there's no such prefix.
+     */
+    size_t unmatchable_prefix_len(const std::string& candidate,
+				  int max_distance) const;
 };
 
 #endif // XAPIAN_INCLUDED_EDITDISTANCE_H
@@ -23,10 +23,15 @@
 #include "xapian/enquire.h"
 #include "enquireinternal.h"
 
+#include "backends/multi/multi_database.h"
 #include "expand/esetinternal.h"
 #include "expand/expandweight.h"
 #include "matcher/matcher.h"
+#include "msetcacheinternal.h"
 #include "msetinternal.h"
+#include "net/serialise.h"
+#include "pack.h"
+#include "serialise-double.h"
 #include "vectortermlist.h"
 #include "weight/weightinternal.h"
 #include "xapian/database.h"
@@ -35,6 +40,7 @@
 #include "xapian/intrusive_ptr.h"
 #include "xapian/keymaker.h"
 #include "xapian/matchspy.h"
+#include "xapian/msetcache.h"
 #include "xapian/query.h"
 #include "xapian/rset.h"
 #include "xapian/weight.h"
@@ -195,6 +201,31 @@ Enquire::set_time_limit(double time_limit)
     internal->time_limit = time_limit;
 }
 
+void
+Enquire::set_parallelism(unsigned n)
+{
+    internal->parallelism = n;
+}
+
+void
+Enquire::set_score_at_a_time(bool enabled, doccount max_postings)
+{
+    internal->score_at_a_time = enabled;
+    internal->saat_max_postings = max_postings;
+}
+
+void
+Enquire::set_mset_cache(const MSetCache& cache)
+{
+    internal->mset_cache = cache.internal.get();
+}
+
+void
+Enquire::clear_mset_cache()
+{
+    internal->mset_cache = NULL;
+}
+
 MSet
 Enquire::get_mset(doccount first,
 		  doccount maxitems,
@@ -279,6 +310,22 @@ Enquire::Internal::get_mset(doccount first,
 	query_length = query.get_length();
     }
 
+    string cache_key;
+    if (mset_cache.get() && !mdecider &&
+	!build_mset_cache_key(first, maxitems, checkatleast, rset, cache_key)) {
+	cache_key.clear();
+    }
+    if (!cache_key.empty()) {
+	string serialised;
+	if (mset_cache->lookup(cache_key, serialised)) {
+	    MSet mset;
+	    mset.internal->unserialise(serialised.data(),
+				       serialised.data() + serialised.size());
+	    mset.internal->set_enquire(this);
+	    return mset;
+	}
+    }
+
     Xapian::doccount first_orig = first;
     {
 	Xapian::doccount docs = db.get_doccount();
@@ -324,7 +371,11 @@ Enquire::Internal::get_mset(doccount first,
 			       sort_by,
 			       sort_val_reverse,
 			       time_limit,
-			       matchspies);
+			       parallelism,
+			       score_at_a_time,
+			       saat_max_postings,
+			       matchspies,
+			       &range_handles);
 
     if (first_orig != first && mset.internal.get()) {
 	mset.internal->set_first(first_orig);
@@ -336,9 +387,91 @@ Enquire::Internal::get_mset(doccount first,
 	mset.internal->set_stats(stats.release());
     }
 
+    if (!cache_key.empty()) {
+	mset_cache->store(cache_key, mset.internal->serialise());
+    }
+
     return mset;
 }
 
+bool
+Enquire::Internal::build_mset_cache_key(doccount first,
+					doccount maxitems,
+					doccount checkatleast,
+					const RSet* rset,
+					string& key) const
+{
+    // A MatchSpy needs to see the documents, and with a time limit the
+    // results depend on how fast the match runs.
+    if (!matchspies.empty() || time_limit > 0.0)
+	return false;
+
+    // The shards need to be read-only so that the revision identifies their
+    // contents (a WritableDatabase can have uncommitted changes).
+    Xapian::doccount n_shards = db.internal->size();
+    for (Xapian::doccount i = 0; i != n_shards; ++i) {
+	const Xapian::Database::Internal* subdb = db.internal.get();
+	if (n_shards > 1) {
+	    auto multidb = static_cast<const MultiDatabase*>(subdb);
+	    subdb = multidb->shards[i];
+	}
+	if (!subdb->is_read_only())
+	    return false;
+	string uuid = subdb->get_uuid();
+	if (uuid.empty())
+	    return false;
+	Xapian::rev revision;
+	try {
+	    revision = subdb->get_revision();
+	} catch (const Xapian::UnimplementedError&) {
+	    return false;
+	}
+	pack_string(key, uuid);
+	pack_uint(key, revision);
+    }
+
+    try {
+	string name = weight->name();
+	if (name.empty())
+	    return false;
+	pack_string(key, name);
+	pack_string(key, weight->serialise());
+	if (sort_functor.get()) {
+	    name = sort_functor->name();
+	    if (name.empty())
+		return false;
+	    pack_string(key, name);
+	    pack_string(key, sort_functor->serialise());
+	} else {
+	    pack_string(key, string());
+	}
+	pack_string(key, query.serialise());
+    } catch (const Xapian::UnimplementedError&) {
+	return false;
+    }
+
+    pack_string(key, rset ? serialise_rset(*rset) : string());
+    pack_uint(key, query_length);
+    pack_uint(key, unsigned(order));
+    pack_uint(key, unsigned(sort_by));
+    pack_uint(key, sort_key);
+    pack_bool(key, sort_val_reverse);
+    pack_uint(key, collapse_key);
+    pack_uint(key, collapse_max);
+    pack_uint(key, unsigned(percent_threshold));
+    key += serialise_double(weight_threshold);
+    // The estimates can differ slightly when the match is run in parallel.
+    pack_uint(key, parallelism);
+    // A score-at-a-time match gives slightly different weights, and if
+    // stopped early, different results.
+    pack_bool(key, score_at_a_time);
+    pack_uint(key, saat_max_postings);
+    pack_uint(key, first);
+    pack_uint(key, maxitems);
+    pack_uint(key, checkatleast);
+    return true;
+}
+
 TermIterator
 Enquire::Internal::get_matching_terms_begin(docid did) const
 {
@@ -22,6 +22,7 @@
 #define XAPIAN_INCLUDED_ENQUIREINTERNAL_H
 
 #include "backends/databaseinternal.h"
+#include "msetcacheinternal.h"
 #include "xapian/constants.h"
 #include "xapian/database.h"
 #include "xapian/enquire.h"
@@ -79,10 +80,36 @@ class Enquire::Internal : public Xapian::Internal::intrusive_base {
 
     double time_limit = 0.0;
 
+    unsigned parallelism = 1;
+
+    bool score_at_a_time = false;
+
+    Xapian::doccount saat_max_postings = 0;
+
+    /** Extra handles on each local shard, kept between matches.
+     *
+     *  Used to match ranges of docids in a shard in parallel.
+     */
+    mutable std::vector<std::vector<Xapian::Database>> range_handles;
+
+    /// Cache of results to use (NULL for none).
+    Xapian::Internal::intrusive_ptr<Xapian::MSetCache::Internal> mset_cache;
+
     enum { EXPAND_TRAD, EXPAND_BO1 } eweight = EXPAND_TRAD;
 
     double expand_k = 1.0;
 
+    /** Build the key identifying a search in an MSetCache.
+     *
+     *  @return false if the search can't be reliably identified, in which
+     *		case the results shouldn't be cached.
+     */
+    bool build_mset_cache_key(doccount first,
+			      doccount maxitems,
+			      doccount checkatleast,
+			      const RSet* rset,
+			      std::string& key) const;
+
   public:
     explicit
     Internal(const Database& db_);
@@ -0,0 +1,143 @@
+/** @file msetcache.cc
+ * @brief Cache of MSet objects for repeated searches
+ */
+/* Copyright (C) 2026 Xapian contributors
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301 USA
+ */
+
+#include <config.h>
+
+#include <xapian/msetcache.h>
+
+#include "msetcacheinternal.h"
+#include "str.h"
+
+#include <string>
+
+using namespace std;
+
+#ifdef HAVE_STD_THREAD
+# define LOCK_CACHE(I) lock_guard<std::mutex> lock((I).mutex)
+#else
+# define LOCK_CACHE(I) (void)0
+#endif
+
+namespace Xapian {
+
+MSetCache::MSetCache(const MSetCache&) = default;
+
+MSetCache&
+MSetCache::operator=(const MSetCache&) = default;
+
+MSetCache::MSetCache(MSetCache&&) = default;
+
+MSetCache&
+MSetCache::operator=(MSetCache&&) = default;
+
+MSetCache::MSetCache(size_t max_entries)
+    : internal(new MSetCache::Internal(max_entries)) {}
+
+MSetCache::~MSetCache() {}
+
+size_t
+MSetCache::size() const
+{
+    LOCK_CACHE(*internal);
+    return internal->index.size();
+}
+
+size_t
+MSetCache::get_max_entries() const
+{
+    return internal->max_entries;
+}
+
+void
+MSetCache::clear()
+{
+    LOCK_CACHE(*internal);
+    internal->index.clear();
+    internal->entries.clear();
+}
+
+unsigned long long
+MSetCache::get_hits() const
+{
+    LOCK_CACHE(*internal);
+    return internal->hits;
+}
+
+unsigned long long
+MSetCache::get_misses() const
+{
+    LOCK_CACHE(*internal);
+    return internal->misses;
+}
+
+string
+MSetCache::get_description() const
+{
+    LOCK_CACHE(*internal);
+    string desc = "MSetCache(";
+    desc += str(internal->index.size());
+    desc += '/';
+    desc += str(internal->max_entries);
+    desc += ", hits=";
+    desc += str(internal->hits);
+    desc += ", misses=";
+    desc += str(internal->misses);
+    desc += ')';
+    return desc;
+}
+
+bool
+MSetCache::Internal::lookup(const string& key, string& value)
+{
+    LOCK_CACHE(*this);
+    auto i = index.find(key);
+    if (i == index.end()) {
+	++misses;
+	return false;
+    }
+    ++hits;
+    // Move the entry to the front of the list.
+    entries.splice(entries.begin(), entries, i->second);
+    value = i->second->second;
+    return true;
+}
+
+void
+MSetCache::Internal::store(const string& key, string&& value)
+{
+    if (max_entries == 0)
+	return;
+    LOCK_CACHE(*this);
+    auto i = index.find(key);
+    if (i != index.end()) {
+	// Another thread ran the same search concurrently.
+	entries.splice(entries.begin(), entries, i->second);
+	i->second->second = std::move(value);
+	return;
+    }
+    if (index.size() >= max_entries) {
+	index.erase(entries.back().first);
+	entries.pop_back();
+    }
+    entries.emplace_front(key, std::move(value));
+    index.emplace(key, entries.begin());
+}
+
+}
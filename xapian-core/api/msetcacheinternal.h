@@ -0,0 +1,89 @@
+/** @file msetcacheinternal.h
+ * @brief Cache of MSet objects for repeated searches
+ */
+/* Copyright (C) 2026 Xapian contributors
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301 USA
+ */
+
+#ifndef XAPIAN_INCLUDED_MSETCACHEINTERNAL_H
+#define XAPIAN_INCLUDED_MSETCACHEINTERNAL_H
+
+#include <xapian/msetcache.h>
+
+#include <list>
+#include <string>
+#include <unordered_map>
+#include <utility>
+
+#ifdef HAVE_STD_THREAD
+# include <mutex>
+#endif
+
+namespace Xapian {
+
+class MSetCache::Internal : public Xapian::Internal::intrusive_base {
+    friend class MSetCache;
+
+    /** The cached entries, most recently used first.
+     *
+     *  Each entry is a key (as built by Enquire::Internal) and the
+     *  serialised MSet::Internal for the key.
+     */
+    std::list<std::pair<std::string, std::string>> entries;
+
+    /// Index of @a entries by key.
+    std::unordered_map<std::string,
+		       std::list<std::pair<std::string,
+					   std::string>>::iterator> index;
+
+    std::size_t max_entries;
+
+    unsigned long long hits = 0;
+
+    unsigned long long misses = 0;
+
+#ifdef HAVE_STD_THREAD
+    /// Lock protecting all the other members.
+    mutable std::mutex mutex;
+#endif
+
+  public:
+    explicit Internal(std::size_t max_entries_) : max_entries(max_entries_) {}
+
+    /** Look up cached results.
+     *
+     *  Updates the hit or miss count.
+     *
+     *  @param key	The key to look up.
+     *  @param value	Set to the serialised MSet::Internal if found.
+     *
+     *  @return true if @a key was found.
+     */
+    bool lookup(const std::string& key, std::string& value);
+
+    /** Add results to the cache.
+     *
+     *  If the cache is full, the least recently used entry is discarded.
+     *
+     *  @param key	The key to store under.
+     *  @param value	The serialised MSet::Internal.
+     */
+    void store(const std::string& key, std::string&& value);
+};
+
+}
+
+#endif // XAPIAN_INCLUDED_MSETCACHEINTERNAL_H
@@ -29,6 +29,7 @@
 #include "xapian/unicode.h"
 
 #include "api/editdistance.h"
+#include "backends/bitmappostlist.h"
 #include "backends/postlist.h"
 #include "heap.h"
 #include "matcher/andmaybepostlist.h"
@@ -149,6 +150,32 @@ struct ComparePostListTermFreqAscending {
     }
 };
 
+/** Skip a term list past all the terms starting with a prefix.
+ *
+ *  @param t	The term list.
+ *  @param term	The current term from @a t.
+ *  @param len	The length in bytes of the prefix of @a term to skip.
+ *
+ *  @return false if no term can sort after those with the prefix.
+ */
+static bool
+skip_past_prefix(TermList* t, const string& term, size_t len)
+{
+    // The first string after all those starting with the prefix is the prefix
+    // with any trailing 0xff bytes removed and the last byte incremented.
+    string next(term, 0, len);
+    while (!next.empty()) {
+	unsigned char ch = next.back();
+	if (ch != 0xff) {
+	    next.back() = char(ch + 1);
+	    t->skip_to(next);
+	    return true;
+	}
+	next.pop_back();
+    }
+    return false;
+}
+
 template<typename T>
 class Context {
     /** Helper for initialisation when T = PostList*.
@@ -264,7 +291,17 @@ done_skip_to:
 	    }
 	}
 
-	if (!query->test_prefix_known(term)) continue;
+	if (!query->test_prefix_known(term)) {
+	    // If no match can start with some prefix of term, skip over all
+	    // the terms which do rather than testing them one by one.
+	    size_t len = query->unmatchable_prefix_len(term);
+	    if (len) {
+		if (!skip_past_prefix(t.get(), term, len))
+		    break;
+		goto done_skip_to;
+	    }
+	    continue;
+	}
 
 	if (max_type < Xapian::Query::WILDCARD_LIMIT_MOST_FREQUENT) {
 	    if (expansions_left-- == 0) {
@@ -339,7 +376,18 @@ done_skip_to:
 	    }
 	}
 
-	if (!query->test(term)) continue;
+	if (!query->test(term)) {
+	    // Likewise skip terms starting with a prefix which is already too
+	    // many edits away.  In a large vocabulary this avoids looking at
+	    // most of the terms.
+	    size_t len = query->unmatchable_prefix_len(term);
+	    if (len) {
+		if (!skip_past_prefix(t.get(), term, len))
+		    break;
+		goto done_skip_to;
+	    }
+	    continue;
+	}
 
 	if (max_type < Xapian::Query::WILDCARD_LIMIT_MOST_FREQUENT) {
 	    if (expansions_left-- == 0) {
@@ -376,6 +424,39 @@ done_skip_to:
     }
 }
 
+/** Combine any BitmapPostList objects in @a pls into the first of them.
+ *
+ *  @param pls		The postlists (updated to remove those combined).
+ *  @param intersect	Intersect the bitmaps if true, unite them if false.
+ *  @param qopt		The QueryOptimiser, used to delete the postlists
+ *			combined.
+ */
+static void
+combine_bitmap_postlists(vector<PostList*>& pls, bool intersect,
+			 QueryOptimiser* qopt)
+{
+    BitmapPostList* first = NULL;
+    size_t out = 0;
+    for (size_t i = 0; i != pls.size(); ++i) {
+	BitmapPostList* bitmap_pl = pls[i]->as_bitmap_postlist();
+	if (bitmap_pl) {
+	    if (!first) {
+		first = bitmap_pl;
+	    } else {
+		if (intersect) {
+		    first->intersect(*bitmap_pl);
+		} else {
+		    first->unite(*bitmap_pl);
+		}
+		qopt->destroy_postlist(pls[i]);
+		continue;
+	    }
+	}
+	pls[out++] = pls[i];
+    }
+    pls.resize(out);
+}
+
 class BoolOrContext : public Context<PostList*> {
   public:
     BoolOrContext(QueryOptimiser* qopt_, size_t reserve)
@@ -387,6 +468,8 @@ class BoolOrContext : public Context<PostList*> {
 PostList *
 BoolOrContext::postlist()
 {
+    combine_bitmap_postlists(pls, false, qopt);
+
     PostList* pl;
     switch (pls.size()) {
 	case 0:
@@ -460,8 +543,12 @@ OrContext::postlist()
 	auto tf = pls.front().tf;
 	Heap::pop(pls.begin(), pls.end(), ComparePostListTermFreqAscending());
 	pls.pop_back();
-	PostList * pl;
-	pl = new OrPostList(pls.front().pl, r, qopt->matcher, qopt->db_size);
+	OrPostList* pl = new OrPostList(pls.front().pl, r,
+					qopt->matcher, qopt->db_size);
+	// Reading leaf postlists in batches leaves them positioned ahead of
+	// the current entry, so we can't if positions will be needed.
+	if (!qopt->need_positions)
+	    pl->enable_batching();
 
 	if (pls.size() == 1) {
 	    pls.clear();
@@ -636,6 +723,10 @@ AndContext::postlist()
 	return NULL;
     }
 
+    // Positional filters refer to entries in pls by index.
+    if (pos_filters.empty())
+	combine_bitmap_postlists(pls, true, qopt);
+
     auto matcher = qopt->matcher;
     auto db_size = qopt->db_size;
 
@@ -643,8 +734,13 @@ AndContext::postlist()
     if (pls.size() == 1) {
 	pl.reset(pls[0]);
     } else {
-	pl.reset(new MultiAndPostList(pls.begin(), pls.end(),
-				      matcher, db_size));
+	auto and_pl = new MultiAndPostList(pls.begin(), pls.end(),
+					   matcher, db_size);
+	pl.reset(and_pl);
+	// Reading leaf postlists in batches leaves them positioned ahead of
+	// the current entry, so we can't if positional filters need them.
+	if (pos_filters.empty() && !qopt->need_positions)
+	    and_pl->enable_batching();
     }
 
     if (not_ctx && !not_ctx->empty()) {
@@ -1497,6 +1593,40 @@ QueryWildcard::test_wildcard_(const string& candidate, size_t o, size_t p,
     return (o == p);
 }
 
+size_t
+QueryWildcard::unmatchable_prefix_len(const string& candidate) const
+{
+    // The part of the pattern before any `*` has to match at a fixed position
+    // (in characters) so the first byte of a candidate which doesn't match
+    // a literal character there rules out every term with that prefix.
+    size_t o = prefix.size();
+    for (size_t i = head; i != pattern.size(); ++i) {
+	if (o == candidate.size()) break;
+	if ((flags & Query::WILDCARD_PATTERN_MULTI) && pattern[i] == '*') {
+	    break;
+	}
+	if ((flags & Query::WILDCARD_PATTERN_SINGLE) && pattern[i] == '?') {
+	    unsigned char b = candidate[o];
+	    unsigned seqlen = 1;
+	    if (b >= 0xc0) {
+		if (b < 0xe0) {
+		    seqlen = 2;
+		} else if (b < 0xf0) {
+		    seqlen = 3;
+		} else {
+		    seqlen = 4;
+		}
+	    }
+	    o += seqlen;
+	    if (o > candidate.size()) break;
+	    continue;
+	}
+	if (pattern[i] != candidate[o]) return o + 1;
+	++o;
+    }
+    return 0;
+}
+
 bool
 QueryWildcard::test_prefix_known(const string& candidate) const
 {
@@ -483,6 +483,15 @@ class QueryWildcard : public Query::Internal {
 	return startswith(candidate, prefix) && test_prefix_known(candidate);
     }
 
+    /** Find a prefix of a non-matching candidate which no match starts with.
+     *
+     *  @param candidate	A candidate known to match the fixed prefix.
+     *
+     *  @return The length in bytes of the prefix, or 0 if we can't rule out
+     *		any prefix.
+     */
+    size_t unmatchable_prefix_len(const std::string& candidate) const;
+
     Xapian::Query::op get_type() const noexcept XAPIAN_PURE_FUNCTION;
 
     std::string get_pattern() const { return pattern; }
@@ -562,6 +571,15 @@ class QueryEditDistance : public Query::Internal {
      */
     int test(const std::string& candidate) const;
 
+    /** Find a prefix of a candidate which no match starts with.
+     *
+     *  @return The length in bytes of the prefix, or 0 if we can't rule out
+     *		any prefix.
+     */
+    size_t unmatchable_prefix_len(const std::string& candidate) const {
+	return edcalc.unmatchable_prefix_len(candidate, get_threshold());
+    }
+
     Xapian::Query::op get_type() const noexcept XAPIAN_PURE_FUNCTION;
 
     std::string get_pattern() const { return pattern; }
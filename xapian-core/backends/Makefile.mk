@@ -1,6 +1,7 @@
 noinst_HEADERS +=\
 	backends/alltermslist.h\
 	backends/backends.h\
+	backends/bitmappostlist.h\
 	backends/byte_length_strings.h\
 	backends/contiguousalldocspostlist.h\
 	backends/databasehelpers.h\
@@ -9,14 +10,18 @@ noinst_HEADERS +=\
 	backends/documentinternal.h\
 	backends/empty_database.h\
 	backends/flint_lock.h\
+	backends/impactlist.h\
 	backends/leafpostlist.h\
 	backends/multi.h\
+	backends/parallelcompact.h\
 	backends/positionlist.h\
 	backends/postlist.h\
 	backends/prefix_compressed_strings.h\
+	backends/roaringbitmap.h\
 	backends/slowvaluelist.h\
 	backends/uuids.h\
 	backends/valuelist.h\
+	backends/valuerangefilter.h\
 	backends/valuestats.h
 
 EXTRA_DIST +=\
@@ -24,6 +29,7 @@ EXTRA_DIST +=\
 
 lib_src +=\
 	backends/alltermslist.cc\
+	backends/bitmappostlist.cc\
 	backends/dbcheck.cc\
 	backends/databasehelpers.cc\
 	backends/databaseinternal.cc\
@@ -31,8 +37,10 @@ lib_src +=\
 	backends/dbfactory.cc\
 	backends/documentinternal.cc\
 	backends/empty_database.cc\
+	backends/impactlist.cc\
 	backends/leafpostlist.cc\
 	backends/postlist.cc\
+	backends/roaringbitmap.cc\
 	backends/slowvaluelist.cc\
 	backends/uuids.cc\
 	backends/valuelist.cc
@@ -0,0 +1,148 @@
+/** @file bitmappostlist.cc
+ * @brief PostList iterating a RoaringBitmap
+ */
+/* Copyright (C) 2026 Xapian contributors
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301 USA
+ */
+
+#include <config.h>
+
+#include "bitmappostlist.h"
+
+#include "omassert.h"
+#include "str.h"
+
+#include "xapian/error.h"
+
+#include <algorithm>
+
+using namespace std;
+
+Xapian::doccount
+BitmapPostList::get_termfreq() const
+{
+    return bitmap.size();
+}
+
+Xapian::docid
+BitmapPostList::get_docid() const
+{
+    Assert(did != 0);
+    return did;
+}
+
+Xapian::termcount
+BitmapPostList::get_wdf() const
+{
+    Assert(did != 0);
+    return 1;
+}
+
+PositionList *
+BitmapPostList::read_position_list()
+{
+    // Throws the same exception.
+    return BitmapPostList::open_position_list();
+}
+
+PositionList *
+BitmapPostList::open_position_list() const
+{
+    throw Xapian::InvalidOperationError("Position lists not meaningful for BitmapPostList");
+}
+
+PostList *
+BitmapPostList::next(double)
+{
+    if (!started) {
+	started = true;
+	did = bitmap.next(container, 1);
+    } else if (did != 0) {
+	did = bitmap.next(container, did + 1);
+    }
+    return NULL;
+}
+
+PostList *
+BitmapPostList::skip_to(Xapian::docid target, double)
+{
+    if (!started) {
+	started = true;
+	did = bitmap.next(container, max(target, Xapian::docid(1)));
+    } else if (did != 0 && target > did) {
+	did = bitmap.next(container, target);
+    }
+    return NULL;
+}
+
+bool
+BitmapPostList::at_end() const
+{
+    return started && did == 0;
+}
+
+Xapian::doccount
+BitmapPostList::next_batch(Xapian::docid did_max,
+			   Xapian::docid* dids,
+			   Xapian::termcount* wdfs,
+			   Xapian::doccount n)
+{
+    Assert(n != 0);
+    Xapian::doccount count = 0;
+    while (true) {
+	BitmapPostList::next(0.0);
+	if (did == 0) break;
+	dids[count] = did;
+	wdfs[count] = 1;
+	if (++count == n || did > did_max) break;
+    }
+    return count;
+}
+
+BitmapPostList*
+BitmapPostList::as_bitmap_postlist()
+{
+    return this;
+}
+
+void
+BitmapPostList::intersect(const BitmapPostList& o)
+{
+    Assert(!started);
+    bitmap.intersect(o.bitmap);
+    desc += " AND ";
+    desc += o.desc;
+}
+
+void
+BitmapPostList::unite(const BitmapPostList& o)
+{
+    Assert(!started);
+    bitmap.unite(o.bitmap);
+    desc += " OR ";
+    desc += o.desc;
+}
+
+string
+BitmapPostList::get_description() const
+{
+    string msg("BitmapPostList(");
+    msg += desc;
+    msg += ", termfreq=";
+    msg += str(bitmap.size());
+    msg += ')';
+    return msg;
+}
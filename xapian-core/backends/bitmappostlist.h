@@ -0,0 +1,117 @@
+/** @file bitmappostlist.h
+ * @brief PostList iterating a RoaringBitmap
+ */
+/* Copyright (C) 2026 Xapian contributors
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301 USA
+ */
+
+#ifndef XAPIAN_INCLUDED_BITMAPPOSTLIST_H
+#define XAPIAN_INCLUDED_BITMAPPOSTLIST_H
+
+#include <string>
+
+#include "leafpostlist.h"
+#include "roaringbitmap.h"
+
+/** A PostList iterating the documents in a RoaringBitmap.
+ *
+ *  Backends can store a bitmap of the documents indexing a term as well as
+ *  its posting list, which the matcher uses for a term where the wdf and
+ *  positions aren't needed.  Several such postlists under an AND or OR can be
+ *  combined with intersect() or unite() before iteration starts, which works
+ *  a word at a time rather than a document at a time.
+ */
+class BitmapPostList : public LeafPostList {
+    /// Don't allow assignment.
+    void operator=(const BitmapPostList &) = delete;
+
+    /// Don't allow copying.
+    BitmapPostList(const BitmapPostList &) = delete;
+
+    /// The documents.
+    RoaringBitmap bitmap;
+
+    /// The index of the container in @a bitmap holding @a did.
+    size_t container = 0;
+
+    /** The current document id.
+     *
+     *  This will be 0 before we start and once we reach the end.
+     */
+    Xapian::docid did = 0;
+
+    /// Have we started iterating?
+    bool started = false;
+
+    /// The term(s) the bitmap is for, for get_description().
+    std::string desc;
+
+  public:
+    /// Constructor.
+    BitmapPostList(const std::string& term_, RoaringBitmap&& bitmap_)
+	: LeafPostList(term_), bitmap(std::move(bitmap_)), desc(term_) { }
+
+    /** Return the term frequency.
+     *
+     *  This is exact, even after intersect() or unite().
+     */
+    Xapian::doccount get_termfreq() const;
+
+    /// Return the current docid.
+    Xapian::docid get_docid() const;
+
+    /// Always return 1 (the wdf isn't stored in the bitmap).
+    Xapian::termcount get_wdf() const;
+
+    /// Throws InvalidOperationError.
+    PositionList *read_position_list();
+
+    /// Throws InvalidOperationError.
+    PositionList * open_position_list() const;
+
+    /// Advance to the next document.
+    PostList * next(double w_min);
+
+    /// Skip ahead to next document with docid >= target.
+    PostList * skip_to(Xapian::docid target, double w_min);
+
+    /// Return true if and only if we're off the end of the list.
+    bool at_end() const;
+
+    Xapian::doccount next_batch(Xapian::docid did_max,
+				Xapian::docid* dids,
+				Xapian::termcount* wdfs,
+				Xapian::doccount n);
+
+    BitmapPostList* as_bitmap_postlist();
+
+    /** Remove the documents which aren't in @a o.
+     *
+     *  Only call this before iteration has started.
+     */
+    void intersect(const BitmapPostList& o);
+
+    /** Add the documents in @a o.
+     *
+     *  Only call this before iteration has started.
+     */
+    void unite(const BitmapPostList& o);
+
+    /// Return a string description of this object.
+    std::string get_description() const;
+};
+
+#endif // XAPIAN_INCLUDED_BITMAPPOSTLIST_H
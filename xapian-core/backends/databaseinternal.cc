@@ -34,6 +34,7 @@
 #include <algorithm>
 #include <memory>
 #include <string>
+#include <vector>
 
 using namespace std;
 using Xapian::Internal::intrusive_ptr;
@@ -103,6 +104,17 @@ Database::Internal::commit()
     invalid_operation("WritableDatabase::commit() called with a read-only shard");
 }
 
+void
+Database::Internal::commit_async()
+{
+    commit();
+}
+
+void
+Database::Internal::wait_for_commit()
+{
+}
+
 void
 Database::Internal::cancel()
 {
@@ -176,6 +188,19 @@ Database::Internal::add_document(const Xapian::Document &)
 		      "read-only shard");
 }
 
+Xapian::docid
+Database::Internal::add_documents(const vector<Xapian::Document>& docs,
+				  unsigned)
+{
+    Xapian::docid first_did = 0;
+    for (const Xapian::Document& doc : docs) {
+	Xapian::docid did = add_document(doc);
+	if (first_did == 0)
+	    first_did = did;
+    }
+    return first_did;
+}
+
 void
 Database::Internal::delete_document(Xapian::docid)
 {
@@ -264,6 +289,44 @@ Database::Internal::replace_document(const string & unique_term,
     return did;
 }
 
+void
+Database::Internal::set_document_value(Xapian::docid did,
+				       Xapian::valueno slot,
+				       const string& value)
+{
+    // Default implementation - overridden for glass and sharded databases.
+
+    if (is_read_only()) {
+	// This can happen if a read-only shard gets added to a
+	// WritableDatabase.
+	invalid_operation("WritableDatabase::set_document_value() called with "
+			  "a read-only shard");
+    }
+
+    Xapian::Document document(open_document(did, false));
+    if (document.get_value(slot) == value) return;
+    document.add_value(slot, value);
+    replace_document(did, document);
+}
+
+LeafPostList*
+Database::Internal::open_bitmap_post_list(const string&) const
+{
+    return NULL;
+}
+
+bool
+Database::Internal::get_impact_params(string&) const
+{
+    return false;
+}
+
+bool
+Database::Internal::get_impact_list(const string&, string&) const
+{
+    return false;
+}
+
 ValueList *
 Database::Internal::open_value_list(Xapian::valueno slot) const
 {
@@ -403,6 +466,12 @@ Database::Internal::invalidate_doc_object(Xapian::Document::Internal*) const
     // Do nothing, by default.
 }
 
+int
+Database::Internal::get_open_flags() const
+{
+    return 0;
+}
+
 void
 Database::Internal::get_used_docid_range(Xapian::docid &,
 					 Xapian::docid &) const
@@ -34,6 +34,7 @@
 #include <xapian/valueiterator.h>
 
 #include <string>
+#include <vector>
 
 typedef Xapian::TermIterator::Internal TermList;
 typedef Xapian::PositionIterator::Internal PositionList;
@@ -89,11 +90,6 @@ class Database::Internal : public Xapian::Internal::intrusive_base {
     /// Current transaction state.
     transaction_state state;
 
-    /// Test if this shard is read-only.
-    bool is_read_only() const {
-	return state == TRANSACTION_READONLY;
-    }
-
     /// Test if a transaction is currently active.
     bool transaction_active() const { return state > 0; }
 
@@ -122,6 +118,11 @@ class Database::Internal : public Xapian::Internal::intrusive_base {
      */
     virtual ~Internal() {}
 
+    /// Test if this shard is read-only.
+    bool is_read_only() const {
+	return state == TRANSACTION_READONLY;
+    }
+
     typedef Xapian::doccount size_type;
 
     virtual size_type size() const;
@@ -224,6 +225,42 @@ class Database::Internal : public Xapian::Internal::intrusive_base {
     virtual LeafPostList* open_leaf_post_list(const std::string& term,
 					      bool need_read_pos) const = 0;
 
+    /** Create a postlist for a term from a stored bitmap, if there is one.
+     *
+     *  The postlist returned reports a wdf of 1 for every document and
+     *  doesn't support positions, so it's only suitable for terms where
+     *  neither are needed.
+     *
+     *  @param term	The term to open a postlist for (not empty).
+     *
+     *  @return	A new BitmapPostList, or NULL if there's no bitmap stored for
+     *		@a term (the default implementation always returns NULL).
+     */
+    virtual LeafPostList* open_bitmap_post_list(const std::string& term) const;
+
+    /** Check if impact-ordered posting lists can be read.
+     *
+     *  @param[out] params	The serialised BM25Weight which the impacts
+     *				were calculated for.
+     *
+     *  @return	true if get_impact_list() can be used (the default
+     *		implementation always returns false).
+     */
+    virtual bool get_impact_params(std::string& params) const;
+
+    /** Read the impact-ordered posting list for a term.
+     *
+     *  Only call this if get_impact_params() returned true.
+     *
+     *  @param term	The term (not empty).
+     *  @param[out] data	The encoded list (see encode_impact_list()).
+     *
+     *  @return	false if there's no list for @a term, which means it doesn't
+     *		index any documents.
+     */
+    virtual bool get_impact_list(const std::string& term,
+				 std::string& data) const;
+
     /** Open a value stream.
      *
      *  This returns the value in a particular slot for each document.
@@ -374,6 +411,18 @@ class Database::Internal : public Xapian::Internal::intrusive_base {
     /** Commit pending modifications to the database. */
     virtual void commit();
 
+    /** Commit pending modifications, but don't wait for them to be synced.
+     *
+     *  The default implementation calls commit().
+     */
+    virtual void commit_async();
+
+    /** Wait for a commit started by commit_async() to be synced.
+     *
+     *  The default implementation does nothing.
+     */
+    virtual void wait_for_commit();
+
     /** Cancel pending modifications to the database. */
     virtual void cancel();
 
@@ -389,6 +438,19 @@ class Database::Internal : public Xapian::Internal::intrusive_base {
 
     virtual docid add_document(const Document& document);
 
+    /** Add several documents.
+     *
+     *  The default implementation calls add_document() for each document.
+     *
+     *  @param docs		The documents to add (not empty).
+     *  @param parallelism	Maximum number of threads to use (0 for as
+     *				many as the hardware supports).
+     *
+     *  @return The docid of the first document added.
+     */
+    virtual docid add_documents(const std::vector<Document>& docs,
+				unsigned parallelism);
+
     virtual void delete_document(docid did);
 
     /** Delete any documents indexed by a term from the database. */
@@ -401,6 +463,14 @@ class Database::Internal : public Xapian::Internal::intrusive_base {
     virtual docid replace_document(const std::string& unique_term,
 				   const Document& document);
 
+    /** Set the value in a slot of an existing document.
+     *
+     *  The default implementation reads the document, sets the value and
+     *  calls replace_document().
+     */
+    virtual void set_document_value(docid did, valueno slot,
+				    const std::string& value);
+
     /** Request a document.
      *
      *  This tells the database that we're going to want a particular
@@ -463,6 +533,17 @@ class Database::Internal : public Xapian::Internal::intrusive_base {
      */
     virtual int get_backend_info(std::string* path) const = 0;
 
+    /** Return the flags to open another handle on this database with.
+     *
+     *  This is the Xapian::DB_BACKEND_* flag for the backend plus any other
+     *  flags which affect how it's read (such as Xapian::DB_MMAP), for
+     *  passing to the Database constructor along with the path returned by
+     *  get_backend_info().
+     *
+     *  The default implementation returns 0.
+     */
+    virtual int get_open_flags() const;
+
     /** Find lowest and highest docids actually in use.
      *
      *  Only used by compaction, so only needs to be implemented by
@@ -61,22 +61,31 @@ using namespace std;
 namespace Xapian {
 
 static void
-open_stub(Database& db, const string& file)
+open_stub(Database& db, const string& file, int flags)
 {
+    // Only pass on flags which make sense for databases listed in a stub.
+    flags &= DB_MMAP;
     read_stub_file(file,
-		   [&db](const string& path) {
-		       db.add_database(Database(path));
+		   [&db, flags](const string& path) {
+		       db.add_database(Database(path, flags));
 		   },
-		   [&db](const string& path) {
+		   [&db, flags](const string& path) {
 #ifdef XAPIAN_HAS_GLASS_BACKEND
-		       db.add_database(Database(new GlassDatabase(path)));
+		       bool use_mmap = (flags & DB_MMAP);
+		       db.add_database(Database(new GlassDatabase(path,
+								  DB_READONLY_,
+								  0,
+								  use_mmap)));
 #else
 		       (void)path;
 #endif
 		   },
-		   [&db](const string& path) {
+		   [&db, flags](const string& path) {
 #ifdef XAPIAN_HAS_HONEY_BACKEND
-		       db.add_database(Database(new HoneyDatabase(path)));
+		       bool use_mmap = (flags & DB_MMAP);
+		       db.add_database(Database(new HoneyDatabase(path,
+								  DB_READONLY_,
+								  use_mmap)));
 #else
 		       (void)path;
 #endif
@@ -160,26 +169,27 @@ Database::Database(const string& path, int flags)
 {
     LOGCALL_CTOR(API, "Database", path|flags);
 
+    bool use_mmap = (flags & DB_MMAP);
     int type = flags & DB_BACKEND_MASK_;
     switch (type) {
 	case DB_BACKEND_CHERT:
 	    throw FeatureUnavailableError("Chert backend no longer supported");
 	case DB_BACKEND_GLASS:
 #ifdef XAPIAN_HAS_GLASS_BACKEND
-	    internal = new GlassDatabase(path);
+	    internal = new GlassDatabase(path, DB_READONLY_, 0, use_mmap);
 	    return;
 #else
 	    throw FeatureUnavailableError("Glass backend disabled");
 #endif
 	case DB_BACKEND_HONEY:
 #ifdef XAPIAN_HAS_HONEY_BACKEND
-	    internal = new HoneyDatabase(path);
+	    internal = new HoneyDatabase(path, DB_READONLY_, use_mmap);
 	    return;
 #else
 	    throw FeatureUnavailableError("Honey backend disabled");
 #endif
 	case DB_BACKEND_STUB:
-	    open_stub(*this, path);
+	    open_stub(*this, path, flags);
 	    return;
 	case DB_BACKEND_INMEMORY:
 #ifdef XAPIAN_HAS_INMEMORY_BACKEND
@@ -204,7 +214,7 @@ Database::Database(const string& path, int flags)
 	    case BACKEND_GLASS:
 #ifdef XAPIAN_HAS_GLASS_BACKEND
 		// Single file glass format.
-		internal = new GlassDatabase(fd);
+		internal = new GlassDatabase(fd, use_mmap);
 		return;
 #else
 		throw FeatureUnavailableError("Glass backend disabled");
@@ -212,14 +222,14 @@ Database::Database(const string& path, int flags)
 	    case BACKEND_HONEY:
 #ifdef XAPIAN_HAS_HONEY_BACKEND
 		// Single file honey format.
-		internal = new HoneyDatabase(fd);
+		internal = new HoneyDatabase(fd, DB_READONLY_, use_mmap);
 		return;
 #else
 		throw FeatureUnavailableError("Honey backend disabled");
 #endif
 	}
 
-	open_stub(*this, path);
+	open_stub(*this, path, flags);
 	return;
     }
 
@@ -229,14 +239,14 @@ Database::Database(const string& path, int flags)
 
 #ifdef XAPIAN_HAS_GLASS_BACKEND
     if (file_exists(path + "/iamglass")) {
-	internal = new GlassDatabase(path);
+	internal = new GlassDatabase(path, DB_READONLY_, 0, use_mmap);
 	return;
     }
 #endif
 
 #ifdef XAPIAN_HAS_HONEY_BACKEND
     if (file_exists(path + "/iamhoney")) {
-	internal = new HoneyDatabase(path);
+	internal = new HoneyDatabase(path, DB_READONLY_, use_mmap);
 	return;
     }
 #endif
@@ -245,7 +255,7 @@ Database::Database(const string& path, int flags)
     string stub_file = path;
     stub_file += "/XAPIANDB";
     if (usual(file_exists(stub_file))) {
-	open_stub(*this, stub_file);
+	open_stub(*this, stub_file, flags);
 	return;
     }
 
@@ -283,6 +293,7 @@ database_factory(int fd, int flags)
 	throw InvalidArgumentError("fd < 0", EBADF);
 
 #if defined XAPIAN_HAS_GLASS_BACKEND || defined XAPIAN_HAS_HONEY_BACKEND
+    bool use_mmap = (flags & DB_MMAP);
     int type = flags & DB_BACKEND_MASK_;
     if (type == 0) {
 	switch (test_if_single_file_db(fd)) {
@@ -297,11 +308,11 @@ database_factory(int fd, int flags)
     switch (type) {
 #ifdef XAPIAN_HAS_GLASS_BACKEND
 	case DB_BACKEND_GLASS:
-	    return new GlassDatabase(fd);
+	    return new GlassDatabase(fd, use_mmap);
 #endif
 #ifdef XAPIAN_HAS_HONEY_BACKEND
 	case DB_BACKEND_HONEY:
-	    return new HoneyDatabase(fd);
+	    return new HoneyDatabase(fd, DB_READONLY_, use_mmap);
 #endif
     }
 #endif
@@ -5,6 +5,7 @@ if BUILD_BACKEND_GLASS
 noinst_HEADERS +=\
 	backends/glass/glass_alldocspostlist.h\
 	backends/glass/glass_alltermslist.h\
+	backends/glass/glass_blockcache.h\
 	backends/glass/glass_changes.h\
 	backends/glass/glass_check.h\
 	backends/glass/glass_cursor.h\
@@ -13,8 +14,10 @@ noinst_HEADERS +=\
 	backends/glass/glass_dbcheck.h\
 	backends/glass/glass_defs.h\
 	backends/glass/glass_docdata.h\
+	backends/glass/glass_doclencolumn.h\
 	backends/glass/glass_document.h\
 	backends/glass/glass_freelist.h\
+	backends/glass/glass_impactlists.h\
 	backends/glass/glass_inverter.h\
 	backends/glass/glass_lazytable.h\
 	backends/glass/glass_metadata.h\
@@ -25,8 +28,11 @@ noinst_HEADERS +=\
 	backends/glass/glass_spellingwordslist.h\
 	backends/glass/glass_synonym.h\
 	backends/glass/glass_table.h\
+	backends/glass/glass_termbitmaps.h\
+	backends/glass/glass_termfilter.h\
 	backends/glass/glass_termlist.h\
 	backends/glass/glass_termlisttable.h\
+	backends/glass/glass_tombstones.h\
 	backends/glass/glass_valuelist.h\
 	backends/glass/glass_values.h\
 	backends/glass/glass_version.h
@@ -34,14 +40,17 @@ noinst_HEADERS +=\
 lib_src +=\
 	backends/glass/glass_alldocspostlist.cc\
 	backends/glass/glass_alltermslist.cc\
+	backends/glass/glass_blockcache.cc\
 	backends/glass/glass_changes.cc\
 	backends/glass/glass_check.cc\
 	backends/glass/glass_compact.cc\
 	backends/glass/glass_cursor.cc\
 	backends/glass/glass_database.cc\
 	backends/glass/glass_dbcheck.cc\
+	backends/glass/glass_doclencolumn.cc\
 	backends/glass/glass_document.cc\
 	backends/glass/glass_freelist.cc\
+	backends/glass/glass_impactlists.cc\
 	backends/glass/glass_inverter.cc\
 	backends/glass/glass_metadata.cc\
 	backends/glass/glass_positionlist.cc\
@@ -50,8 +59,11 @@ lib_src +=\
 	backends/glass/glass_spellingwordslist.cc\
 	backends/glass/glass_synonym.cc\
 	backends/glass/glass_table.cc\
+	backends/glass/glass_termbitmaps.cc\
+	backends/glass/glass_termfilter.cc\
 	backends/glass/glass_termlist.cc\
 	backends/glass/glass_termlisttable.cc\
+	backends/glass/glass_tombstones.cc\
 	backends/glass/glass_valuelist.cc\
 	backends/glass/glass_values.cc\
 	backends/glass/glass_version.cc
@@ -22,6 +22,7 @@
 #include <config.h>
 #include "glass_alldocspostlist.h"
 
+#include <algorithm>
 #include <string>
 
 #include "glass_database.h"
@@ -55,6 +56,19 @@ GlassAllDocsPostList::get_wdf() const
     RETURN(1);
 }
 
+Xapian::doccount
+GlassAllDocsPostList::next_batch(Xapian::docid did_max,
+				 Xapian::docid* dids,
+				 Xapian::termcount* wdfs,
+				 Xapian::doccount n)
+{
+    LOGCALL(DB, Xapian::doccount, "GlassAllDocsPostList::next_batch", did_max | dids | wdfs | n);
+    // The wdfs GlassPostList reads are the document lengths.
+    Xapian::doccount count = GlassPostList::next_batch(did_max, dids, wdfs, n);
+    fill_n(wdfs, count, Xapian::termcount(1));
+    RETURN(count);
+}
+
 PositionList *
 GlassAllDocsPostList::read_position_list()
 {
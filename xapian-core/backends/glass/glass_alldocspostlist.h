@@ -44,6 +44,11 @@ class GlassAllDocsPostList : public GlassPostList {
 
     Xapian::termcount get_wdf() const;
 
+    Xapian::doccount next_batch(Xapian::docid did_max,
+				Xapian::docid* dids,
+				Xapian::termcount* wdfs,
+				Xapian::doccount n);
+
     PositionList *read_position_list();
 
     PositionList *open_position_list() const;
@@ -0,0 +1,268 @@
+/** @file glass_blockcache.cc
+ * @brief Process-wide cache of glass table blocks
+ */
+/* Copyright (C) 2026 Xapian contributors
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301
+ * USA
+ */
+
+#include <config.h>
+
+#include "glass_blockcache.h"
+
+#include "parseint.h"
+#include "xapian/error.h"
+
+#include <cstdlib>
+#include <cstring>
+#include <list>
+#include <map>
+#include <memory>
+#include <unordered_map>
+
+#ifdef HAVE_STD_THREAD
+# include <mutex>
+# define LOCK(M) lock_guard<mutex> lock(M)
+#else
+# define LOCK(M) (void)0
+#endif
+
+using namespace std;
+
+namespace {
+
+/// Default total size of the cache in bytes.
+const size_t DEFAULT_CACHE_SIZE = 16 * 1024 * 1024;
+
+/// Number of independently locked shards to split the cache into.
+const unsigned N_SHARDS = 16;
+
+struct Key {
+    uint64_t file_id;
+
+    uint4 n;
+
+    uint4 rev;
+
+    bool operator==(const Key& o) const {
+	return file_id == o.file_id && n == o.n && rev == o.rev;
+    }
+};
+
+struct KeyHash {
+    size_t operator()(const Key& key) const {
+	uint64_t h = key.file_id * 0x9e3779b97f4a7c15ull;
+	h ^= (uint64_t(key.n) << 32) | key.rev;
+	h ^= h >> 29;
+	h *= 0xbf58476d1ce4e5b9ull;
+	h ^= h >> 32;
+	return size_t(h);
+    }
+};
+
+struct Entry {
+    Key key;
+
+    unique_ptr<uint8_t[]> data;
+
+    unsigned size;
+
+    Entry(const Key& key_, unique_ptr<uint8_t[]>&& data_, unsigned size_)
+	: key(key_), data(std::move(data_)), size(size_) {}
+};
+
+class Shard {
+    /// Entries, most recently used first.
+    list<Entry> lru;
+
+    unordered_map<Key, list<Entry>::iterator, KeyHash> index;
+
+    /// Total size of the blocks in this shard.
+    size_t used = 0;
+
+#ifdef HAVE_STD_THREAD
+    mutex mut;
+#endif
+
+  public:
+    size_t budget = 0;
+
+    bool lookup(const Key& key, uint8_t* p, unsigned block_size) {
+	LOCK(mut);
+	auto i = index.find(key);
+	if (i == index.end() || i->second->size != block_size)
+	    return false;
+	lru.splice(lru.begin(), lru, i->second);
+	memcpy(p, i->second->data.get(), block_size);
+	return true;
+    }
+
+    void add(const Key& key, unique_ptr<uint8_t[]>&& data, unsigned size) {
+	LOCK(mut);
+	if (index.find(key) != index.end()) {
+	    // Another table read the same block since we checked.
+	    return;
+	}
+	while (used + size > budget) {
+	    used -= lru.back().size;
+	    index.erase(lru.back().key);
+	    lru.pop_back();
+	}
+	lru.emplace_front(key, std::move(data), size);
+	index.emplace(key, lru.begin());
+	used += size;
+    }
+};
+
+class Cache {
+    Shard shards[N_SHARDS];
+
+    /// An id for a table file, and the number of tables using it.
+    struct FileId {
+	uint64_t id;
+
+	size_t refs;
+    };
+
+    /// Map from file identity to id.
+    map<string, FileId> file_ids;
+
+    /// Map from id back to file identity.
+    unordered_map<uint64_t, string> identities;
+
+    /** The last id handed out.
+     *
+     *  Ids aren't reused, so blocks cached under the id of a file which is
+     *  no longer open just get evicted in due course.
+     */
+    uint64_t last_id = 0;
+
+#ifdef HAVE_STD_THREAD
+    mutex file_ids_mutex;
+#endif
+
+  public:
+    explicit Cache(size_t size) {
+	for (auto&& shard : shards) {
+	    shard.budget = size / N_SHARDS;
+	}
+    }
+
+    size_t shard_budget() const { return shards[0].budget; }
+
+    uint64_t get_file_id(const string& identity) {
+	LOCK(file_ids_mutex);
+	auto r = file_ids.emplace(identity, FileId{0, 0});
+	FileId& file_id = r.first->second;
+	if (r.second) {
+	    file_id.id = ++last_id;
+	    identities.emplace(file_id.id, identity);
+	}
+	++file_id.refs;
+	return file_id.id;
+    }
+
+    void release_file_id(uint64_t id) {
+	LOCK(file_ids_mutex);
+	auto i = identities.find(id);
+	if (i == identities.end()) return;
+	auto j = file_ids.find(i->second);
+	if (--j->second.refs == 0) {
+	    file_ids.erase(j);
+	    identities.erase(i);
+	}
+    }
+
+    size_t get_file_id_count() {
+	LOCK(file_ids_mutex);
+	return file_ids.size();
+    }
+
+    Shard& get_shard(const Key& key) {
+	return shards[KeyHash()(key) % N_SHARDS];
+    }
+};
+
+Cache*
+make_cache()
+{
+    size_t size = DEFAULT_CACHE_SIZE;
+    const char* p = getenv("XAPIAN_BLOCK_CACHE_SIZE");
+    if (p && *p) {
+	if (!parse_unsigned(p, size)) {
+	    throw Xapian::InvalidArgumentError("XAPIAN_BLOCK_CACHE_SIZE must "
+					       "be a non-negative integer");
+	}
+    }
+    if (size == 0)
+	return NULL;
+    // This is deliberately never deleted, as tables might still be in use
+    // while static objects are being destroyed.
+    return new Cache(size);
+}
+
+Cache*
+get_cache()
+{
+    static Cache* cache = make_cache();
+    return cache;
+}
+
+}
+
+uint64_t
+GlassBlockCache::get_file_id(const string& identity)
+{
+    Cache* cache = get_cache();
+    return cache ? cache->get_file_id(identity) : 0;
+}
+
+void
+GlassBlockCache::release_file_id(uint64_t file_id)
+{
+    Cache* cache = get_cache();
+    if (cache) cache->release_file_id(file_id);
+}
+
+size_t
+GlassBlockCache::get_file_id_count()
+{
+    Cache* cache = get_cache();
+    return cache ? cache->get_file_id_count() : 0;
+}
+
+bool
+GlassBlockCache::lookup(uint64_t file_id, uint4 n, uint4 rev,
+			uint8_t* p, unsigned block_size)
+{
+    Cache* cache = get_cache();
+    Key key{file_id, n, rev};
+    return cache->get_shard(key).lookup(key, p, block_size);
+}
+
+void
+GlassBlockCache::add(uint64_t file_id, uint4 n, uint4 rev,
+		     const uint8_t* p, unsigned block_size)
+{
+    Cache* cache = get_cache();
+    if (block_size > cache->shard_budget())
+	return;
+    // Copy the block before taking the lock.
+    unique_ptr<uint8_t[]> data(new uint8_t[block_size]);
+    memcpy(data.get(), p, block_size);
+    Key key{file_id, n, rev};
+    cache->get_shard(key).add(key, std::move(data), block_size);
+}
@@ -0,0 +1,106 @@
+/** @file glass_blockcache.h
+ * @brief Process-wide cache of glass table blocks
+ */
+/* Copyright (C) 2026 Xapian contributors
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301
+ * USA
+ */
+
+#ifndef XAPIAN_INCLUDED_GLASS_BLOCKCACHE_H
+#define XAPIAN_INCLUDED_GLASS_BLOCKCACHE_H
+
+#include "glass_defs.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+/** Process-wide cache of blocks read from glass tables.
+ *
+ *  Each GlassTable only keeps the blocks in its cursors, so without this
+ *  every Database object has to read the blocks it needs for itself, even
+ *  when another Database object open on the same database has just read
+ *  them.  This cache is shared by all tables opened read-only, and is
+ *  particularly effective for the branch blocks near the root of each
+ *  table, which almost every lookup needs.
+ *
+ *  Blocks are keyed on an id for the table file, the block number and the
+ *  revision of the table being read.  Block numbers get reused as a
+ *  database is modified, but a revision's blocks don't change, so a new
+ *  revision simply gets new entries and old entries get evicted as they
+ *  stop being used.
+ *
+ *  The cache is split into shards to reduce lock contention between
+ *  threads, each with its own LRU list.  The total size in bytes can be set
+ *  with the environment variable XAPIAN_BLOCK_CACHE_SIZE (read when the
+ *  cache is first used) - the default is 16MB, and 0 disables the cache.
+ */
+class GlassBlockCache {
+  public:
+    /** Get the id to use for a table file.
+     *
+     *  @param identity	String identifying the table file - this needs to
+     *			include the database's UUID as well as the file's
+     *			device and inode numbers, since those can get reused
+     *			once a file is deleted.
+     *
+     *  Each call must be matched by a call to release_file_id() once the
+     *  table is closed.
+     *
+     *  @return A non-zero id, or 0 if the cache is disabled.
+     */
+    static std::uint64_t get_file_id(const std::string& identity);
+
+    /** Release an id returned by get_file_id().
+     *
+     *  Once every table using an id has released it, the id is forgotten.
+     *
+     *  @param file_id	Id from get_file_id() (must be non-zero).
+     */
+    static void release_file_id(std::uint64_t file_id);
+
+    /// Return the number of file ids in use (for testing).
+    static std::size_t get_file_id_count();
+
+    /** Look up a block.
+     *
+     *  @param file_id	Id from get_file_id().
+     *  @param n	Block number.
+     *  @param rev	Revision of the table being read.
+     *  @param p	Buffer of size @a block_size to copy the block to.
+     *  @param block_size	The block size of the table.
+     *
+     *  @return true if the block was found.
+     */
+    static bool lookup(std::uint64_t file_id, uint4 n, uint4 rev,
+		       uint8_t* p, unsigned block_size);
+
+    /** Add a block to the cache.
+     *
+     *  The caller must only add blocks which have been checked to be valid
+     *  for revision @a rev.
+     *
+     *  @param file_id	Id from get_file_id().
+     *  @param n	Block number.
+     *  @param rev	Revision of the table being read.
+     *  @param p	The block.
+     *  @param block_size	The block size of the table.
+     */
+    static void add(std::uint64_t file_id, uint4 n, uint4 rev,
+		    const uint8_t* p, unsigned block_size);
+};
+
+#endif // XAPIAN_INCLUDED_GLASS_BLOCKCACHE_H
@@ -74,6 +74,9 @@ class GlassChanges {
 
     void commit(glass_revision_number_t new_rev, int flags);
 
+    /// Is a changeset currently being written?
+    bool is_active() const { return changes_fd >= 0; }
+
     static void check(const std::string & changes_file);
 };
 
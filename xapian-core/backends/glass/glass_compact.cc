@@ -27,6 +27,7 @@
 #include "xapian/types.h"
 
 #include <algorithm>
+#include <functional>
 #include <memory>
 #include <queue>
 
@@ -34,6 +35,7 @@
 #include <cstdio>
 
 #include "backends/flint_lock.h"
+#include "backends/parallelcompact.h"
 #include "glass_database.h"
 #include "glass_defs.h"
 #include "glass_table.h"
@@ -42,6 +44,7 @@
 #include "filetests.h"
 #include "internaltypes.h"
 #include "pack.h"
+#include "packedpositions.h"
 #include "backends/valuestats.h"
 
 #include "../byte_length_strings.h"
@@ -80,20 +83,27 @@ is_doclenchunk_key(const string & key)
 class PostlistCursor : private GlassCursor {
     Xapian::docid offset;
 
-  public:
-    string key, tag;
-    Xapian::docid firstdid;
-    Xapian::termcount tf, cf;
+    /// Documents whose postings to drop (NULL if there aren't any).
+    const GlassTombstones* tombstones;
 
-    PostlistCursor(const GlassTable *in, Xapian::docid offset_)
-	: GlassCursor(in), offset(offset_), firstdid(0)
-    {
-	rewind();
-	next();
-    }
-
-    bool next() {
-	if (!GlassCursor::next()) return false;
+    /** Frequencies from an initial chunk we dropped.
+     *
+     *  These get added to the next chunk we return, which will be for the
+     *  same term.
+     */
+    Xapian::termcount dropped_tf = 0, dropped_cf = 0;
+
+    /// Read the current entry, returning false if it should be skipped.
+    bool read_entry() {
+	if (GlassTombstones::is_key(current_key)) return false;
+	// The output gets a new document length column if it needs one.
+	if (GlassDocLenColumn::is_key(current_key)) return false;
+	// Likewise for term bitmaps.
+	if (GlassTermBitmaps::is_key(current_key)) return false;
+	// And impact lists, which depend on the document lengths.
+	if (GlassImpactLists::is_key(current_key)) return false;
+	// And the term filter, which is rebuilt sized for the merged terms.
+	if (GlassTermFilter::is_key(current_key)) return false;
 	// We put all chunks into the non-initial chunk form here, then fix up
 	// the first chunk for each term in the merged database as we merge.
 	read_tag();
@@ -125,15 +135,16 @@ class PostlistCursor : private GlassCursor {
 	// plus optionally: pack_uint_preserving_sort(key, did)
 	const char * d = key.data();
 	const char * e = d + key.size();
+	string tname;
 	if (is_doclenchunk_key(key)) {
 	    d += 2;
 	} else {
-	    string tname;
 	    if (!unpack_string_preserving_sort(&d, e, tname))
 		throw Xapian::DatabaseCorruptError("Bad postlist key");
 	}
 
-	if (d == e) {
+	bool initial = (d == e);
+	if (initial) {
 	    // This is an initial chunk for a term, so adjust tag header.
 	    d = tag.data();
 	    e = d + tag.size();
@@ -155,9 +166,51 @@ class PostlistCursor : private GlassCursor {
 		key.erase(tmp - 1);
 	    }
 	}
+
+	// Tombstoned documents have no document length entry, so only the
+	// postings for terms need filtering.
+	if (tombstones && !is_doclenchunk_key(key)) {
+	    if (initial) {
+		Xapian::doccount removed_tf;
+		Xapian::termcount removed_cf;
+		tombstones->count_postings(*get_table(), tname,
+					   removed_tf, removed_cf);
+		tf -= removed_tf;
+		cf -= removed_cf;
+	    }
+	    if (!tombstones->filter_postlist_chunk(tag, firstdid)) {
+		dropped_tf += tf;
+		dropped_cf += cf;
+		return false;
+	    }
+	    tf += dropped_tf;
+	    cf += dropped_cf;
+	    dropped_tf = dropped_cf = 0;
+	}
 	firstdid += offset;
 	return true;
     }
+
+  public:
+    string key, tag;
+    Xapian::docid firstdid;
+    Xapian::termcount tf, cf;
+
+    PostlistCursor(const GlassTable *in, Xapian::docid offset_,
+		   const GlassTombstones* tombstones_ = NULL)
+	: GlassCursor(in), offset(offset_), tombstones(tombstones_),
+	  firstdid(0)
+    {
+	rewind();
+	next();
+    }
+
+    bool next() {
+	while (GlassCursor::next()) {
+	    if (read_entry()) return true;
+	}
+	return false;
+    }
 };
 
 class PostlistCursorGt {
@@ -188,18 +241,19 @@ encode_valuestats(Xapian::doccount freq,
 static void
 merge_postlists(Xapian::Compactor * compactor,
 		GlassTable * out, vector<Xapian::docid>::const_iterator offset,
+		vector<const GlassTombstones*>::const_iterator tombstones,
 		vector<const GlassTable*>::const_iterator b,
 		vector<const GlassTable*>::const_iterator e)
 {
     priority_queue<PostlistCursor *, vector<PostlistCursor *>, PostlistCursorGt> pq;
-    for ( ; b != e; ++b, ++offset) {
+    for ( ; b != e; ++b, ++offset, ++tombstones) {
 	const GlassTable *in = *b;
 	if (in->empty()) {
 	    // Skip empty tables.
 	    continue;
 	}
 
-	pq.push(new PostlistCursor(in, *offset));
+	pq.push(new PostlistCursor(in, *offset, *tombstones));
     }
 
     string last_key;
@@ -424,7 +478,8 @@ merge_spellings(GlassTable * out,
 	if (pq.empty() || pq.top()->current_key > key) {
 	    // No need to merge the tags, just copy the (possibly compressed)
 	    // tag value.
-	    bool compressed = cur->read_tag(true);
+	    bool keep = (cur->get_compressor() == out->get_compressor());
+	    bool compressed = cur->read_tag(keep);
 	    out->add(key, cur->current_tag, compressed);
 	    if (cur->next()) {
 		pq.push(cur);
@@ -533,7 +588,8 @@ merge_synonyms(GlassTable * out,
 	if (pq.empty() || pq.top()->current_key > key) {
 	    // No need to merge the tags, just copy the (possibly compressed)
 	    // tag value.
-	    bool compressed = cur->read_tag(true);
+	    bool keep = (cur->get_compressor() == out->get_compressor());
+	    bool compressed = cur->read_tag(keep);
 	    out->add(key, cur->current_tag, compressed);
 	    if (cur->next()) {
 		pq.push(cur);
@@ -597,17 +653,29 @@ static void
 multimerge_postlists(Xapian::Compactor * compactor,
 		     GlassTable * out, const char * tmpdir,
 		     vector<const GlassTable *> tmp,
-		     vector<Xapian::docid> off)
+		     vector<Xapian::docid> off,
+		     vector<const GlassTombstones*> tombstones,
+		     unsigned parallelism)
 {
     unsigned int c = 0;
     while (tmp.size() > 3) {
-	vector<const GlassTable *> tmpout;
-	tmpout.reserve(tmp.size() / 2);
-	vector<Xapian::docid> newoff;
-	newoff.resize(tmp.size() / 2);
+	// Work out which inputs each merge in this pass reads.
+	vector<unsigned int> starts;
+	starts.reserve(tmp.size() / 2 + 1);
 	for (unsigned int i = 0, j; i < tmp.size(); i = j) {
+	    starts.push_back(i);
 	    j = i + 2;
 	    if (j == tmp.size() - 1) ++j;
+	}
+	starts.push_back(tmp.size());
+
+	vector<const GlassTable *> tmpout(tmp.size() / 2);
+	vector<Xapian::docid> newoff;
+	newoff.resize(tmp.size() / 2);
+	// The merges in a pass are independent, so can run in parallel.
+	run_in_parallel(tmpout.size(), parallelism, [&](size_t n) {
+	    unsigned int i = starts[n];
+	    unsigned int j = starts[n + 1];
 
 	    string dest = tmpdir;
 	    char buf[64];
@@ -626,6 +694,7 @@ multimerge_postlists(Xapian::Compactor * compactor,
 	    tmptab->create_and_open(flags, root_info);
 
 	    merge_postlists(compactor, tmptab, off.begin() + i,
+			    tombstones.begin() + i,
 			    tmp.begin() + i, tmp.begin() + j);
 	    if (c > 0) {
 		for (unsigned int k = i; k < j; ++k) {
@@ -634,16 +703,19 @@ multimerge_postlists(Xapian::Compactor * compactor,
 		    tmp[k] = NULL;
 		}
 	    }
-	    tmpout.push_back(tmptab);
+	    tmpout[n] = tmptab;
 	    tmptab->flush_db();
 	    tmptab->commit(1, &root_info);
 	    AssertRel(root_info.get_blocksize(),==,65536);
-	}
+	});
 	swap(tmp, tmpout);
 	swap(off, newoff);
+	// The temporary tables don't contain any tombstoned documents.
+	tombstones.assign(tmp.size(), NULL);
 	++c;
     }
-    merge_postlists(compactor, out, off.begin(), tmp.begin(), tmp.end());
+    merge_postlists(compactor, out, off.begin(), tombstones.begin(),
+		    tmp.begin(), tmp.end());
     if (c > 0) {
 	for (size_t k = 0; k < tmp.size(); ++k) {
 	    unlink(tmp[k]->get_path().c_str());
@@ -656,28 +728,38 @@ multimerge_postlists(Xapian::Compactor * compactor,
 class PositionCursor : private GlassCursor {
     Xapian::docid offset;
 
+    /// Documents whose positions to drop (NULL if there aren't any).
+    const GlassTombstones* tombstones;
+
   public:
     string key;
     Xapian::docid firstdid;
 
-    PositionCursor(const GlassTable *in, Xapian::docid offset_)
-	: GlassCursor(in), offset(offset_), firstdid(0) {
+    /// The encoding the position lists are stored in.
+    unsigned encoding;
+
+    PositionCursor(const GlassTable *in, Xapian::docid offset_,
+		   const GlassTombstones* tombstones_ = NULL)
+	: GlassCursor(in), offset(offset_), tombstones(tombstones_),
+	  firstdid(0), encoding(in->get_encoding()) {
 	rewind();
 	next();
     }
 
     bool next() {
-	if (!GlassCursor::next()) return false;
-	read_tag();
-	const char * d = current_key.data();
-	const char * e = d + current_key.size();
 	string term;
 	Xapian::docid did;
-	if (!unpack_string_preserving_sort(&d, e, term) ||
-	    !unpack_uint_preserving_sort(&d, e, &did) ||
-	    d != e) {
-	    throw Xapian::DatabaseCorruptError("Bad position key");
-	}
+	do {
+	    if (!GlassCursor::next()) return false;
+	    const char * d = current_key.data();
+	    const char * e = d + current_key.size();
+	    if (!unpack_string_preserving_sort(&d, e, term) ||
+		!unpack_uint_preserving_sort(&d, e, &did) ||
+		d != e) {
+		throw Xapian::DatabaseCorruptError("Bad position key");
+	    }
+	} while (tombstones && tombstones->contains(did));
+	read_tag();
 
 	key.resize(0);
 	pack_string_preserving_sort(key, term);
@@ -701,7 +783,8 @@ class PositionCursorGt {
 
 static void
 merge_positions(GlassTable *out, const vector<const GlassTable*> & inputs,
-		const vector<Xapian::docid> & offset)
+		const vector<Xapian::docid> & offset,
+		const vector<const GlassTombstones*> & tombstones)
 {
     priority_queue<PositionCursor *, vector<PositionCursor *>, PositionCursorGt> pq;
     for (size_t i = 0; i < inputs.size(); ++i) {
@@ -711,13 +794,19 @@ merge_positions(GlassTable *out, const vector<const GlassTable*> & inputs,
 	    continue;
 	}
 
-	pq.push(new PositionCursor(in, offset[i]));
+	pq.push(new PositionCursor(in, offset[i], tombstones[i]));
     }
 
     while (!pq.empty()) {
 	PositionCursor * cur = pq.top();
 	pq.pop();
-	out->add(cur->key, cur->get_tag());
+	if (cur->encoding == out->get_encoding()) {
+	    out->add(cur->key, cur->get_tag());
+	} else {
+	    string tag = cur->get_tag();
+	    convert_positions(tag, cur->encoding, out->get_encoding());
+	    out->add(cur->key, tag);
+	}
 	if (cur->next()) {
 	    pq.push(cur);
 	} else {
@@ -728,21 +817,31 @@ merge_positions(GlassTable *out, const vector<const GlassTable*> & inputs,
 
 static void
 merge_docid_keyed(GlassTable *out, const vector<const GlassTable*> & inputs,
-		  const vector<Xapian::docid> & offset)
+		  const vector<Xapian::docid> & offset,
+		  const vector<const GlassTombstones*> * tombstones = NULL)
 {
     for (size_t i = 0; i < inputs.size(); ++i) {
 	Xapian::docid off = offset[i];
+	const GlassTombstones* ts = tombstones ? (*tombstones)[i] : NULL;
 
 	const GlassTable * in = inputs[i];
 	if (in->empty()) continue;
 
+	// Compressed tags can be copied over as they are unless they need
+	// recompressing with a different algorithm or dictionary.
+	bool keep = out->same_compression(*in);
+
 	GlassCursor cur(in);
 	cur.rewind();
 
 	string key;
 	while (cur.next()) {
-	    // Adjust the key if this isn't the first database.
-	    if (off) {
+	    // The output gets its own dictionary (if it uses one).
+	    if (cur.current_key == GLASS_DICTIONARY_KEY) continue;
+
+	    // Adjust the key if this isn't the first database, and drop the
+	    // entries for tombstoned documents.
+	    if (off || ts) {
 		Xapian::docid did;
 		const char * d = cur.current_key.data();
 		const char * e = d + cur.current_key.size();
@@ -751,6 +850,7 @@ merge_docid_keyed(GlassTable *out, const vector<const GlassTable*> & inputs,
 		    msg += inputs[i]->get_path();
 		    throw Xapian::DatabaseCorruptError(msg);
 		}
+		if (ts && ts->contains(did)) continue;
 		did += off;
 		key.resize(0);
 		pack_uint_preserving_sort(key, did);
@@ -762,12 +862,59 @@ merge_docid_keyed(GlassTable *out, const vector<const GlassTable*> & inputs,
 	    } else {
 		key = cur.current_key;
 	    }
-	    bool compressed = cur.read_tag(true);
+	    bool compressed = cur.read_tag(keep);
 	    out->add(key, cur.current_tag, compressed);
 	}
     }
 }
 
+/// Maximum size of dictionary to train for the docdata table.
+static const size_t DOCDATA_DICTIONARY_SIZE = 64 * 1024;
+
+/// Maximum amount of document data to train the dictionary on.
+static const size_t DOCDATA_SAMPLE_SIZE = 100 * DOCDATA_DICTIONARY_SIZE;
+
+/// Maximum number of document data entries to train the dictionary on.
+static const size_t DOCDATA_SAMPLE_COUNT = 50000;
+
+/** Train a zstd dictionary for the docdata table from @a inputs.
+ *
+ *  We sample entries evenly across the inputs rather than just taking the
+ *  first ones so that the dictionary reflects the whole collection.
+ *
+ *  @return The dictionary, or an empty string if there isn't enough
+ *	    document data to train one.
+ */
+static string
+train_docdata_dictionary(const vector<const GlassTable*> & inputs)
+{
+    glass_tablesize_t total = 0;
+    for (auto in : inputs) total += in->get_entry_count();
+    glass_tablesize_t step = total / DOCDATA_SAMPLE_COUNT + 1;
+
+    string samples;
+    vector<size_t> sizes;
+    glass_tablesize_t n = 0;
+    for (auto in : inputs) {
+	if (in->empty()) continue;
+
+	GlassCursor cur(in);
+	cur.rewind();
+	while (samples.size() < DOCDATA_SAMPLE_SIZE && cur.next()) {
+	    if (n++ % step != 0) continue;
+	    if (cur.current_key == GLASS_DICTIONARY_KEY) continue;
+	    cur.read_tag();
+	    // Large entries are unlikely to be typical, and don't benefit
+	    // much from a dictionary anyway.
+	    if (cur.current_tag.size() > DOCDATA_DICTIONARY_SIZE) continue;
+	    samples += cur.current_tag;
+	    sizes.push_back(cur.current_tag.size());
+	}
+    }
+    return CompressionStream::train_dictionary(samples, sizes,
+					       DOCDATA_DICTIONARY_SIZE);
+}
+
 }
 
 using namespace GlassCompact;
@@ -808,6 +955,11 @@ GlassDatabase::compact(Xapian::Compactor * compactor,
 
     bool single_file = (flags & Xapian::DBCOMPACT_SINGLE_FILE);
     bool multipass = (flags & Xapian::DBCOMPACT_MULTIPASS);
+    bool docdata_dictionary = (flags & Xapian::DBCOMPACT_DOCDATA_DICTIONARY);
+    if (docdata_dictionary) {
+	// Check up front rather than failing part way through.
+	CompressionStream::check_compressor(CompressionStream::ZSTD_DICT);
+    }
     if (single_file) {
 	// FIXME: Support this combination - we need to put temporary files
 	// somewhere.
@@ -867,6 +1019,65 @@ GlassDatabase::compact(Xapian::Compactor * compactor,
 	fl.pack(fl_serialised);
     }
 
+    // Single file output has to be written one table at a time.
+    unsigned parallelism = 1;
+    if (compactor && !single_file) parallelism = compactor->get_parallelism();
+    unique_ptr<SerialisedCompactor> serialised_compactor;
+    if (parallelism > 1) {
+	serialised_compactor.reset(new SerialisedCompactor(*compactor));
+	compactor = serialised_compactor.get();
+    }
+    // Merges to run in parallel once all the output tables are set up.
+    vector<function<void()>> merges;
+
+    // Documents deleted with DB_LAZY_DELETE still have postings, positions
+    // and termlists which we need to drop.  Read these up front so the
+    // merges don't race to load them.
+    vector<const GlassTombstones*> tombstones;
+    tombstones.reserve(sources.size());
+    for (auto src : sources) {
+	auto db = static_cast<const GlassDatabase*>(src);
+	const GlassTombstones& ts = db->postlist_table.get_tombstones();
+	tombstones.push_back(ts.empty() ? NULL : &ts);
+    }
+
+    // Keep the document length column if any input has one.
+    bool doclen_column = (flags & Xapian::DBCOMPACT_DOCLEN_COLUMN);
+    for (auto src : sources) {
+	if (doclen_column) break;
+	auto db = static_cast<const GlassDatabase*>(src);
+	doclen_column = db->postlist_table.has_doclen_column();
+    }
+
+    // Likewise for term bitmaps, which are rebuilt as the doccount and
+    // termfreqs may have changed.
+    bool term_bitmaps = (flags & Xapian::DBCOMPACT_TERM_BITMAPS);
+    for (auto src : sources) {
+	if (term_bitmaps) break;
+	auto db = static_cast<const GlassDatabase*>(src);
+	term_bitmaps = db->postlist_table.has_term_bitmaps();
+    }
+    // And impact-ordered posting lists, which depend on the average document
+    // length as well.
+    bool impact_lists = (flags & Xapian::DBCOMPACT_IMPACT_ORDERED);
+    for (auto src : sources) {
+	if (impact_lists) break;
+	auto db = static_cast<const GlassDatabase*>(src);
+	impact_lists = db->postlist_table.has_impact_lists();
+    }
+    // And the term filter, which is sized for the number of terms.
+    bool term_filter = (flags & Xapian::DBCOMPACT_TERM_FILTER);
+    for (auto src : sources) {
+	if (term_filter) break;
+	auto db = static_cast<const GlassDatabase*>(src);
+	term_filter = db->postlist_table.has_term_filter();
+    }
+    Xapian::doccount doccount_out = version_file_out->get_doccount();
+    Xapian::totallength total_doclen_out =
+	version_file_out->get_total_doclen();
+
+    bool packed_positions = (flags & Xapian::DBCOMPACT_PACKED_POSITIONS);
+
     vector<GlassTable *> tabs;
     tabs.reserve(tables_end - tables);
     off_t prev_size = block_size;
@@ -985,6 +1196,23 @@ GlassDatabase::compact(Xapian::Compactor * compactor,
 	}
 	tabs.push_back(out);
 	RootInfo * root_info = version_file_out->root_to_set(t->type);
+	// Compress tags using the same algorithm as the first source does, so
+	// they can usually be copied over without recompressing them.
+	auto first_db = static_cast<const GlassDatabase*>(sources[0]);
+	const RootInfo& first_root = first_db->version_file.get_root(t->type);
+	unsigned compressor = first_root.get_compressor();
+	// There's no dictionary in the new table until set_dictionary() is
+	// called below.
+	if (compressor == CompressionStream::ZSTD_DICT)
+	    compressor = CompressionStream::ZSTD;
+	root_info->set_compressor(compressor);
+	if (t->type == Glass::POSITION) {
+	    // Likewise keep the first source's position list encoding unless
+	    // we've been asked to pack them.
+	    root_info->set_encoding(packed_positions ?
+				    unsigned(POSITIONS_PACKED) :
+				    first_root.get_encoding());
+	}
 	if (single_file) {
 	    root_info->set_free_list(fl_serialised);
 	    out->open(FLAGS, version_file_out->get_root(t->type), version_file_out->get_revision());
@@ -995,92 +1223,137 @@ GlassDatabase::compact(Xapian::Compactor * compactor,
 	out->set_full_compaction(compaction != compactor->STANDARD);
 	if (compaction == compactor->FULLER) out->set_max_item_size(1);
 
-	switch (t->type) {
-	    case Glass::POSTLIST: {
-		if (multipass && inputs.size() > 3) {
-		    multimerge_postlists(compactor, out, destdir,
-					 inputs, offset);
-		} else {
-		    merge_postlists(compactor, out, offset.begin(),
-				    inputs.begin(), inputs.end());
+	// Merge the table and report how it went.  We can't start this
+	// until all the output tables exist if we're going to merge them in
+	// parallel.  The merges run after this loop has finished, so the
+	// lambda has to capture the loop's locals (including whether stat
+	// failed on any of the inputs) by value.
+	auto merge = [=, &fl_serialised, &prev_size]() {
+	    switch (t->type) {
+		case Glass::POSTLIST: {
+		    if (multipass && inputs.size() > 3) {
+			multimerge_postlists(compactor, out, destdir,
+					     inputs, offset, tombstones,
+					     parallelism);
+		    } else {
+			merge_postlists(compactor, out, offset.begin(),
+					tombstones.begin(),
+					inputs.begin(), inputs.end());
+		    }
+		    if (doclen_column) GlassDocLenColumn::build(*out);
+		    if (term_bitmaps) {
+			GlassTermBitmaps::build_all(*out, doccount_out);
+		    }
+		    if (impact_lists) {
+			GlassImpactLists::build_all(*out, doccount_out,
+						    total_doclen_out);
+		    }
+		    if (term_filter) GlassTermFilter::build_all(*out);
+		    break;
+		}
+		case Glass::SPELLING:
+		    merge_spellings(out, inputs.begin(), inputs.end());
+		    break;
+		case Glass::SYNONYM:
+		    merge_synonyms(out, inputs.begin(), inputs.end());
+		    break;
+		case Glass::POSITION:
+		    merge_positions(out, inputs, offset, tombstones);
+		    break;
+		case Glass::TERMLIST:
+		    merge_docid_keyed(out, inputs, offset, &tombstones);
+		    break;
+		default: {
+		    // DocData
+		    string dictionary;
+		    if (docdata_dictionary) {
+			dictionary = train_docdata_dictionary(inputs);
+		    }
+		    if (dictionary.empty()) {
+			// Keep using the first source's dictionary, if any.
+			dictionary = inputs[0]->get_dictionary();
+		    }
+		    if (!dictionary.empty()) {
+			out->set_dictionary(dictionary);
+			root_info->set_compressor(CompressionStream::ZSTD_DICT);
+		    }
+		    merge_docid_keyed(out, inputs, offset);
+		    break;
 		}
-		break;
 	    }
-	    case Glass::SPELLING:
-		merge_spellings(out, inputs.begin(), inputs.end());
-		break;
-	    case Glass::SYNONYM:
-		merge_synonyms(out, inputs.begin(), inputs.end());
-		break;
-	    case Glass::POSITION:
-		merge_positions(out, inputs, offset);
-		break;
-	    default:
-		// DocData, Termlist
-		merge_docid_keyed(out, inputs, offset);
-		break;
-	}
 
-	// Commit as revision 1.
-	out->flush_db();
-	out->commit(1, root_info);
-	out->sync();
-	if (single_file) fl_serialised = root_info->get_free_list();
-
-	off_t out_size = 0;
-	if (!bad_stat && !single_file_in) {
-	    off_t db_size;
-	    if (single_file) {
-		db_size = file_size(fd);
-	    } else {
-		db_size = file_size(dest + GLASS_TABLE_EXTENSION);
-	    }
-	    if (errno == 0) {
+	    // Commit as revision 1.
+	    out->flush_db();
+	    out->commit(1, root_info);
+	    out->sync();
+	    if (single_file) fl_serialised = root_info->get_free_list();
+
+	    // Also note if we can't stat the output.
+	    bool stat_failed = bad_stat;
+	    off_t out_size = 0;
+	    if (!stat_failed && !single_file_in) {
+		off_t db_size;
 		if (single_file) {
-		    off_t old_prev_size = max(prev_size, off_t(block_size));
-		    prev_size = db_size;
-		    db_size -= old_prev_size;
+		    db_size = file_size(fd);
+		} else {
+		    db_size = file_size(dest + GLASS_TABLE_EXTENSION);
+		}
+		if (errno == 0) {
+		    if (single_file) {
+			off_t old_prev_size = max(prev_size, off_t(block_size));
+			prev_size = db_size;
+			db_size -= old_prev_size;
+		    }
+		    out_size = db_size / 1024;
+		} else {
+		    stat_failed = (errno != ENOENT);
 		}
-		out_size = db_size / 1024;
-	    } else {
-		bad_stat = (errno != ENOENT);
 	    }
-	}
-	if (bad_stat) {
-	    if (compactor)
-		compactor->set_status(t->name, "Done (couldn't stat all the DB files)");
-	} else if (single_file_in) {
-	    if (compactor)
-		compactor->set_status(t->name, "Done (table sizes unknown for single file DB input)");
-	} else {
-	    string status;
-	    if (out_size == in_size) {
-		status = "Size unchanged (";
+	    if (stat_failed) {
+		if (compactor)
+		    compactor->set_status(t->name, "Done (couldn't stat all the DB files)");
+	    } else if (single_file_in) {
+		if (compactor)
+		    compactor->set_status(t->name, "Done (table sizes unknown for single file DB input)");
 	    } else {
-		off_t delta;
-		if (out_size < in_size) {
-		    delta = in_size - out_size;
-		    status = "Reduced by ";
+		string status;
+		if (out_size == in_size) {
+		    status = "Size unchanged (";
 		} else {
-		    delta = out_size - in_size;
-		    status = "INCREASED by ";
-		}
-		if (in_size) {
-		    status += str(100 * delta / in_size);
-		    status += "% ";
+		    off_t delta;
+		    if (out_size < in_size) {
+			delta = in_size - out_size;
+			status = "Reduced by ";
+		    } else {
+			delta = out_size - in_size;
+			status = "INCREASED by ";
+		    }
+		    if (in_size) {
+			status += str(100 * delta / in_size);
+			status += "% ";
+		    }
+		    status += str(delta);
+		    status += "K (";
+		    status += str(in_size);
+		    status += "K -> ";
 		}
-		status += str(delta);
-		status += "K (";
-		status += str(in_size);
-		status += "K -> ";
+		status += str(out_size);
+		status += "K)";
+		if (compactor)
+		    compactor->set_status(t->name, status);
 	    }
-	    status += str(out_size);
-	    status += "K)";
-	    if (compactor)
-		compactor->set_status(t->name, status);
+	};
+	if (parallelism > 1) {
+	    merges.push_back(merge);
+	} else {
+	    merge();
 	}
     }
 
+    run_in_parallel(merges.size(), parallelism, [&](size_t i) {
+	merges[i]();
+    });
+
     // If compacting to a single file output and all the tables are empty, pad
     // the output so that it isn't mistaken for a stub database when we try to
     // open it.  For this it needs to be a multiple of 2KB in size.
@@ -1103,6 +1376,9 @@ GlassDatabase::compact(Xapian::Compactor * compactor,
 	}
     }
     version_file_out->set_last_docid(last_docid);
+    // Older versions of Xapian wouldn't keep these up to date.
+    version_file_out->set_postlist_extras(doclen_column || term_bitmaps ||
+					  impact_lists || term_filter);
     string tmpfile = version_file_out->write(1, FLAGS);
     for (unsigned j = 0; j != tabs.size(); ++j) {
 	tabs[j]->sync();
@@ -317,6 +317,12 @@ GlassCursor::read_tag(bool keep_compressed)
     RETURN(tag_status == COMPRESSED);
 }
 
+int
+GlassCursor::get_compressor() const
+{
+    return B->get_compressor();
+}
+
 bool
 MutableGlassCursor::del()
 {
@@ -264,6 +264,12 @@ class GlassCursor {
      */
     bool read_tag(bool keep_compressed = false);
 
+    /** Return the algorithm used to compress tags in the table.
+     *
+     *  See GlassTable::get_compressor().
+     */
+    int get_compressor() const;
+
     /** Advance to the next key.
      *
      *  If cursor is unpositioned, the result is simply false.
@@ -34,6 +34,7 @@
 #include "xapian/error.h"
 #include "xapian/valueiterator.h"
 
+#include "backends/bitmappostlist.h"
 #include "backends/contiguousalldocspostlist.h"
 #include "glass_alldocspostlist.h"
 #include "glass_alltermslist.h"
@@ -71,6 +72,14 @@
 #include <cstdlib>
 #include <memory>
 #include <string>
+#include <vector>
+
+#ifdef HAVE_STD_THREAD
+# include <atomic>
+# include <exception>
+# include <system_error>
+# include <thread>
+#endif
 
 using namespace std;
 using namespace Xapian;
@@ -96,7 +105,7 @@ using Xapian::Internal::intrusive_ptr;
  * and stores handles to the tables.
  */
 GlassDatabase::GlassDatabase(const string &glass_dir, int flags,
-			     unsigned int block_size)
+			     unsigned int block_size, bool use_mmap)
 	: Xapian::Database::Internal(flags == Xapian::DB_READONLY_ ?
 				     TRANSACTION_READONLY :
 				     TRANSACTION_NONE),
@@ -115,9 +124,12 @@ GlassDatabase::GlassDatabase(const string &glass_dir, int flags,
 	  lock(db_dir),
 	  changes(db_dir)
 {
-    LOGCALL_CTOR(DB, "GlassDatabase", glass_dir | flags | block_size);
+    LOGCALL_CTOR(DB, "GlassDatabase",
+		 glass_dir | flags | block_size | use_mmap);
 
     if (readonly) {
+	if (use_mmap)
+	    set_tables_use_mmap();
 	open_tables(flags);
 	return;
     }
@@ -165,7 +177,7 @@ GlassDatabase::GlassDatabase(const string &glass_dir, int flags,
     open_tables(flags);
 }
 
-GlassDatabase::GlassDatabase(int fd)
+GlassDatabase::GlassDatabase(int fd, bool use_mmap)
 	: Xapian::Database::Internal(TRANSACTION_READONLY),
 	  db_dir(),
 	  readonly(true),
@@ -180,7 +192,9 @@ GlassDatabase::GlassDatabase(int fd)
 	  lock(),
 	  changes(string())
 {
-    LOGCALL_CTOR(DB, "GlassDatabase", fd);
+    LOGCALL_CTOR(DB, "GlassDatabase", fd | use_mmap);
+    if (use_mmap)
+	set_tables_use_mmap();
     open_tables(Xapian::DB_READONLY_);
 }
 
@@ -203,8 +217,26 @@ GlassDatabase::create_and_open_tables(int flags, unsigned int block_size)
     // The caller is expected to create the database directory if it doesn't
     // already exist.
 
+    unsigned compressor = CompressionStream::ZLIB;
+    if (flags & Xapian::DB_COMPRESS_LZ4) {
+	if (flags & Xapian::DB_COMPRESS_ZSTD) {
+	    throw Xapian::InvalidArgumentError("DB_COMPRESS_LZ4 and "
+					       "DB_COMPRESS_ZSTD can't both "
+					       "be specified");
+	}
+	compressor = CompressionStream::LZ4;
+    } else if (flags & Xapian::DB_COMPRESS_ZSTD) {
+	compressor = CompressionStream::ZSTD;
+    }
+    // Report if it's unavailable before we write anything.
+    CompressionStream::check_compressor(compressor);
+
+    unsigned position_encoding = POSITIONS_INTERPOLATIVE;
+    if (flags & Xapian::DB_PACKED_POSITIONS)
+	position_encoding = POSITIONS_PACKED;
+
     GlassVersion &v = version_file;
-    v.create(block_size);
+    v.create(block_size, compressor, position_encoding);
 
     glass_revision_number_t rev = v.get_revision();
     const string& tmpfile = v.write(rev, flags);
@@ -223,6 +255,17 @@ GlassDatabase::create_and_open_tables(int flags, unsigned int block_size)
     Assert(database_exists());
 }
 
+void
+GlassDatabase::set_tables_use_mmap()
+{
+    docdata_table.set_use_mmap();
+    spelling_table.set_use_mmap();
+    synonym_table.set_use_mmap();
+    termlist_table.set_use_mmap();
+    position_table.set_use_mmap();
+    postlist_table.set_use_mmap();
+}
+
 bool
 GlassDatabase::open_tables(int flags)
 {
@@ -248,12 +291,17 @@ GlassDatabase::open_tables(int flags)
 	RETURN(false);
     }
 
-    docdata_table.open(flags, version_file.get_root(Glass::DOCDATA), rev);
-    spelling_table.open(flags, version_file.get_root(Glass::SPELLING), rev);
-    synonym_table.open(flags, version_file.get_root(Glass::SYNONYM), rev);
-    termlist_table.open(flags, version_file.get_root(Glass::TERMLIST), rev);
-    position_table.open(flags, version_file.get_root(Glass::POSITION), rev);
-    postlist_table.open(flags, version_file.get_root(Glass::POSTLIST), rev);
+    const char* uuid = version_file.get_uuid();
+    docdata_table.open(flags, version_file.get_root(Glass::DOCDATA), rev, uuid);
+    spelling_table.open(flags, version_file.get_root(Glass::SPELLING), rev,
+			uuid);
+    synonym_table.open(flags, version_file.get_root(Glass::SYNONYM), rev, uuid);
+    termlist_table.open(flags, version_file.get_root(Glass::TERMLIST), rev,
+			uuid);
+    position_table.open(flags, version_file.get_root(Glass::POSITION), rev,
+			uuid);
+    postlist_table.open(flags, version_file.get_root(Glass::POSTLIST), rev,
+			uuid);
 
     Xapian::termcount swfub = version_file.get_spelling_wordfreq_upper_bound();
     spelling_table.set_wordfreq_upper_bound(swfub);
@@ -327,10 +375,32 @@ GlassDatabase::get_changeset_revisions(const string & path,
 				    "changeset at " + path);
 }
 
+bool
+GlassPendingSync::run()
+{
+    int fd = version_fd;
+    version_fd = -1;
+    if ((flags & Xapian::DB_NO_SYNC) == 0) {
+	for (int table_fd : table_fds) {
+	    if (!io_sync(table_fd)) {
+		int saved_errno = errno;
+		(void)close(fd);
+		if (!tmpfile.empty())
+		    (void)unlink(tmpfile.c_str());
+		errno = saved_errno;
+		return false;
+	    }
+	}
+    }
+    return GlassVersion::sync_file(fd, tmpfile, db_dir, flags);
+}
+
 void
-GlassDatabase::set_revision_number(int flags, glass_revision_number_t new_revision)
+GlassDatabase::set_revision_number(int flags,
+				   glass_revision_number_t new_revision,
+				   GlassPendingSync* pending)
 {
-    LOGCALL_VOID(DB, "GlassDatabase::set_revision_number", flags|new_revision);
+    LOGCALL_VOID(DB, "GlassDatabase::set_revision_number", flags|new_revision|pending);
 
     glass_revision_number_t rev = version_file.get_revision();
     if (new_revision <= rev && rev != 0) {
@@ -350,14 +420,45 @@ GlassDatabase::set_revision_number(int flags, glass_revision_number_t new_revisi
     version_file.set_spelling_wordfreq_upper_bound(spelling_table.flush_db());
     docdata_table.flush_db();
 
-    postlist_table.commit(new_revision, version_file.root_to_set(Glass::POSTLIST));
-    position_table.commit(new_revision, version_file.root_to_set(Glass::POSITION));
-    termlist_table.commit(new_revision, version_file.root_to_set(Glass::TERMLIST));
-    synonym_table.commit(new_revision, version_file.root_to_set(Glass::SYNONYM));
-    spelling_table.commit(new_revision, version_file.root_to_set(Glass::SPELLING));
-    docdata_table.commit(new_revision, version_file.root_to_set(Glass::DOCDATA));
-
+    // The changeset for a revision has to be written after the revision is
+    // synced, so we only defer syncing if there isn't one.
+    bool defer = (pending && !changes.is_active() &&
+		  !version_file.single_file());
+
+    // If we defer syncing, the version file on disk still refers to the
+    // previous revision while the next one is being written, so blocks freed
+    // by this revision mustn't be reused until after the next commit.
+    postlist_table.commit(new_revision,
+			  version_file.root_to_set(Glass::POSTLIST), defer);
+    position_table.commit(new_revision,
+			  version_file.root_to_set(Glass::POSITION), defer);
+    termlist_table.commit(new_revision,
+			  version_file.root_to_set(Glass::TERMLIST), defer);
+    synonym_table.commit(new_revision,
+			 version_file.root_to_set(Glass::SYNONYM), defer);
+    spelling_table.commit(new_revision,
+			  version_file.root_to_set(Glass::SPELLING), defer);
+    docdata_table.commit(new_revision,
+			 version_file.root_to_set(Glass::DOCDATA), defer);
+
+    version_file.set_postlist_extras(postlist_table.has_extras());
     const string & tmpfile = version_file.write(new_revision, flags);
+    if (defer) {
+	pending->flags = flags;
+	pending->table_fds.clear();
+	const GlassTable* tables[] = {
+	    &postlist_table, &position_table, &termlist_table,
+	    &synonym_table, &spelling_table, &docdata_table
+	};
+	for (const GlassTable* table : tables) {
+	    if (table->is_open())
+		pending->table_fds.push_back(table->get_fd());
+	}
+	pending->tmpfile = tmpfile;
+	pending->db_dir = db_dir;
+	pending->version_fd = version_file.defer_sync(new_revision);
+	return;
+    }
     if (!postlist_table.sync() ||
 	!position_table.sync() ||
 	!termlist_table.sync() ||
@@ -382,12 +483,19 @@ GlassDatabase::request_document(Xapian::docid did) const
 void
 GlassDatabase::readahead_for_query(const Xapian::Query &query) const
 {
+    // The unique terms are in sorted order, and so are the keys.
+    vector<string> keys;
     Xapian::TermIterator t;
     for (t = query.get_unique_terms_begin(); t != Xapian::TermIterator(); ++t) {
-	const string & term = *t;
-	if (!postlist_table.readahead_key(GlassPostListTable::make_key(term)))
-	    break;
+	keys.push_back(GlassPostListTable::make_key(*t));
+    }
+    if (keys.size() == 1) {
+	// Just hint the block below the root, as reading blocks to find
+	// the levels further down wouldn't save any time for a single key.
+	(void)postlist_table.readahead_key(keys[0]);
+	return;
     }
+    (void)postlist_table.readahead_keys(keys);
 }
 
 bool
@@ -654,9 +762,9 @@ GlassDatabase::modifications_failed(glass_revision_number_t new_revision,
 }
 
 void
-GlassDatabase::apply()
+GlassDatabase::apply(GlassPendingSync* pending)
 {
-    LOGCALL_VOID(DB, "GlassDatabase::apply", NO_ARGS);
+    LOGCALL_VOID(DB, "GlassDatabase::apply", pending);
     if (!postlist_table.is_modified() &&
 	!position_table.is_modified() &&
 	!termlist_table.is_modified() &&
@@ -671,7 +779,7 @@ GlassDatabase::apply()
 
     int flags = postlist_table.get_flags();
     try {
-	set_revision_number(flags, new_revision);
+	set_revision_number(flags, new_revision, pending);
     } catch (const Xapian::Error &e) {
 	modifications_failed(new_revision, e.get_description());
 	throw;
@@ -773,6 +881,12 @@ GlassDatabase::get_freqs(const string & term,
     LOGCALL_VOID(DB, "GlassDatabase::get_freqs", term | termfreq_ptr | collfreq_ptr);
     Assert(!term.empty());
     postlist_table.get_freqs(term, termfreq_ptr, collfreq_ptr);
+    if (termfreq_ptr && !postlist_table.get_tombstones().empty()) {
+	// The stored frequencies still count tombstoned documents until the
+	// database is compacted.  We don't try to adjust them, but the
+	// weighting schemes assume termfreq <= doccount.
+	*termfreq_ptr = min(*termfreq_ptr, get_doccount());
+    }
 }
 
 Xapian::doccount
@@ -865,6 +979,34 @@ GlassDatabase::open_leaf_post_list(const string& term, bool need_read_pos) const
     RETURN(new GlassPostList(ptrtothis, term, true));
 }
 
+LeafPostList*
+GlassDatabase::open_bitmap_post_list(const string& term) const
+{
+    LOGCALL(DB, LeafPostList *, "GlassDatabase::open_bitmap_post_list", term);
+    RoaringBitmap bitmap;
+    if (!postlist_table.has_term_bitmaps() ||
+	!postlist_table.get_term_bitmap(term, bitmap)) {
+	RETURN(NULL);
+    }
+    RETURN(new BitmapPostList(term, std::move(bitmap)));
+}
+
+bool
+GlassDatabase::get_impact_params(string& params) const
+{
+    LOGCALL(DB, bool, "GlassDatabase::get_impact_params", NO_ARGS);
+    if (!postlist_table.has_current_impact_lists()) RETURN(false);
+    params = postlist_table.get_impact_params();
+    RETURN(true);
+}
+
+bool
+GlassDatabase::get_impact_list(const string& term, string& data) const
+{
+    LOGCALL(DB, bool, "GlassDatabase::get_impact_list", term);
+    RETURN(postlist_table.get_impact_list(term, data));
+}
+
 ValueList *
 GlassDatabase::open_value_list(Xapian::valueno slot) const
 {
@@ -916,6 +1058,7 @@ GlassDatabase::read_position_list(GlassRePositionList* pos_list,
 Xapian::termcount
 GlassDatabase::positionlist_count(Xapian::docid did, const string& term) const
 {
+    if (postlist_table.get_tombstones().contains(did)) return 0;
     return position_table.positionlist_count(did, term);
 }
 
@@ -923,6 +1066,8 @@ PositionList *
 GlassDatabase::open_position_list(Xapian::docid did, const string& term) const
 {
     Assert(did != 0);
+    if (postlist_table.get_tombstones().contains(did))
+	return new GlassPositionList(string(), false);
     return new GlassPositionList(&position_table, did, term);
 }
 
@@ -1073,8 +1218,13 @@ GlassWritableDatabase::GlassWritableDatabase(const string &dir, int flags,
 	: GlassDatabase(dir, flags, block_size),
 	  change_count(0),
 	  flush_threshold(0),
+	  flush_threshold_bytes(0),
 	  modify_shortcut_document(NULL),
-	  modify_shortcut_docid(0)
+	  modify_shortcut_docid(0),
+	  lazy_delete(flags & Xapian::DB_LAZY_DELETE),
+	  want_doclen_column(flags & Xapian::DB_DOCLEN_COLUMN),
+	  want_term_bitmaps(flags & Xapian::DB_TERM_BITMAPS),
+	  want_term_filter(flags & Xapian::DB_TERM_FILTER)
 {
     LOGCALL_CTOR(DB, "GlassWritableDatabase", dir | flags | block_size);
 
@@ -1087,12 +1237,26 @@ GlassWritableDatabase::GlassWritableDatabase(const string &dir, int flags,
     }
     if (flush_threshold == 0)
 	flush_threshold = 10000;
+
+    p = getenv("XAPIAN_FLUSH_THRESHOLD_BYTES");
+    if (p && *p) {
+	if (!parse_unsigned(p, flush_threshold_bytes)) {
+	    throw Xapian::InvalidArgumentError("XAPIAN_FLUSH_THRESHOLD_BYTES "
+					       "must be a non-negative "
+					       "integer");
+	}
+    }
 }
 
 GlassWritableDatabase::~GlassWritableDatabase()
 {
     LOGCALL_DTOR(DB, "GlassWritableDatabase");
     dtor_called();
+#ifdef HAVE_STD_THREAD
+    // dtor_called() won't have waited if a transaction was active.
+    if (commit_thread.joinable())
+	commit_thread.join();
+#endif
 }
 
 void
@@ -1104,13 +1268,47 @@ GlassWritableDatabase::commit()
     apply();
 }
 
+void
+GlassWritableDatabase::commit_async()
+{
+    if (transaction_active())
+	throw Xapian::InvalidOperationError("Can't commit during a transaction");
+    if (change_count) flush_postlist_changes();
+    apply(true);
+}
+
+void
+GlassWritableDatabase::wait_for_commit()
+{
+#ifdef HAVE_STD_THREAD
+    if (!commit_thread.joinable())
+	return;
+    commit_thread.join();
+    if (!pending_sync_ok) {
+	pending_sync_ok = true;
+	// The tables were committed in memory but the new revision isn't on
+	// disk, and changes since may build on it, so we can't safely carry
+	// on.
+	GlassDatabase::close();
+	throw Xapian::DatabaseError("Commit failed", pending_sync_errno);
+    }
+#endif
+}
+
+void
+GlassWritableDatabase::set_flush_thresholds(Xapian::doccount changes_threshold,
+					    size_t bytes_threshold)
+{
+    flush_threshold = changes_threshold ? changes_threshold : Xapian::doccount(-1);
+    flush_threshold_bytes = bytes_threshold;
+}
+
 void
 GlassWritableDatabase::check_flush_threshold()
 {
-    // FIXME: this should be done by checking memory usage, not the number of
-    // changes.  We could also look at the amount of data the inverter object
-    // currently holds.
-    if (++change_count >= flush_threshold) {
+    if (++change_count >= flush_threshold ||
+	(flush_threshold_bytes &&
+	 inverter.get_memory_used() >= flush_threshold_bytes)) {
 	flush_postlist_changes();
 	if (!transaction_active()) apply();
     }
@@ -1123,6 +1321,24 @@ GlassWritableDatabase::flush_postlist_changes()
 	version_file.set_oldest_changeset(changes.get_oldest_changeset());
 	inverter.flush(postlist_table);
 	inverter.flush_pos_lists(position_table);
+	postlist_table.flush_tombstones();
+	if (want_doclen_column && !postlist_table.has_doclen_column()) {
+	    // Once added, the column is kept up to date as document lengths
+	    // are merged.
+	    postlist_table.build_doclen_column();
+	}
+	postlist_table.flush_term_bitmaps(version_file.get_doccount());
+	if (want_term_bitmaps && !postlist_table.has_term_bitmaps()) {
+	    // Once added, bitmaps are kept up to date as postlist changes are
+	    // merged.
+	    postlist_table.build_term_bitmaps(version_file.get_doccount());
+	}
+	postlist_table.flush_term_filter();
+	if (want_term_filter && !postlist_table.has_term_filter()) {
+	    // Once added, new terms are added to the filter as postlist
+	    // changes are merged.
+	    postlist_table.build_term_filter();
+	}
 
 	change_count = 0;
     } catch (...) {
@@ -1138,6 +1354,7 @@ void
 GlassWritableDatabase::close()
 {
     LOGCALL_VOID(DB, "GlassWritableDatabase::close", NO_ARGS);
+    wait_for_commit();
     if (!transaction_active()) {
 	commit();
 	// FIXME: if commit() throws, should we still close?
@@ -1146,9 +1363,36 @@ GlassWritableDatabase::close()
 }
 
 void
-GlassWritableDatabase::apply()
+GlassWritableDatabase::apply(bool async)
 {
+    // Only one revision can be pending at once, and it needs to be on disk
+    // before a later one.
+    wait_for_commit();
     value_manager.set_value_stats(value_stats);
+#ifdef HAVE_STD_THREAD
+    if (async) {
+	GlassDatabase::apply(&pending_sync);
+	if (!pending_sync.pending())
+	    return;
+	try {
+	    commit_thread = thread([this]() {
+		pending_sync_ok = pending_sync.run();
+		if (!pending_sync_ok)
+		    pending_sync_errno = errno;
+	    });
+	} catch (const system_error&) {
+	    // Failing to start a thread isn't fatal - just sync now.
+	    if (!pending_sync.run()) {
+		int saved_errno = errno;
+		GlassDatabase::close();
+		throw Xapian::DatabaseError("Commit failed", saved_errno);
+	    }
+	}
+	return;
+    }
+#else
+    (void)async;
+#endif
     GlassDatabase::apply();
 }
 
@@ -1216,6 +1460,205 @@ GlassWritableDatabase::add_document_(Xapian::docid did,
     RETURN(did);
 }
 
+#ifdef HAVE_STD_THREAD
+namespace {
+
+/// Maximum number of documents add_documents() prepares at once.
+const size_t ADD_DOCUMENTS_BATCH_SIZE = 1000;
+
+/// A term in a document being added by add_documents().
+struct PreparedTerm {
+    string name;
+
+    Xapian::termcount wdf;
+
+    /// The term's positions in the Document, or NULL to use own_positions.
+    const Xapian::VecCOW<Xapian::termpos>* positions = NULL;
+
+    /// Positions read from a TermIterator without a vector of positions.
+    Xapian::VecCOW<Xapian::termpos> own_positions;
+
+    PreparedTerm(const string& name_, Xapian::termcount wdf_)
+	: name(name_), wdf(wdf_) {}
+
+    const Xapian::VecCOW<Xapian::termpos>& get_positions() const {
+	return positions ? *positions : own_positions;
+    }
+};
+
+/** A document being added by add_documents().
+ *
+ *  Everything needed from the Document is copied in by the calling thread,
+ *  so the worker threads don't touch Document objects (which aren't safe to
+ *  use from several threads at once).
+ */
+struct PreparedDocument {
+    vector<PreparedTerm> terms;
+
+    Xapian::termcount doclen = 0;
+
+    /// The encoded termlist entry.
+    string termlist_tag;
+};
+
+}
+#endif
+
+Xapian::docid
+GlassWritableDatabase::add_documents(const vector<Xapian::Document>& docs,
+				     unsigned parallelism)
+{
+    LOGCALL(DB, Xapian::docid, "GlassWritableDatabase::add_documents",
+	    docs.size() | parallelism);
+#ifdef HAVE_STD_THREAD
+    if (parallelism == 0)
+	parallelism = thread::hardware_concurrency();
+    if (parallelism <= 1 || docs.size() <= 1)
+#endif
+    {
+	RETURN(Xapian::Database::Internal::add_documents(docs, parallelism));
+    }
+
+#ifdef HAVE_STD_THREAD
+    // Make sure the docid counter doesn't overflow.
+    if (GLASS_MAX_DOCID - version_file.get_last_docid() < docs.size())
+	throw Xapian::DatabaseError("Run out of docids - you'll have to use copydatabase to eliminate any gaps before you can add more documents");
+    Xapian::docid first_did = version_file.get_last_docid() + 1;
+
+    vector<PreparedDocument> prepared;
+    size_t start = 0;
+    while (start != docs.size()) {
+	// End each batch where add_document() would flush, so we flush at the
+	// same points.
+	size_t n = docs.size() - start;
+	n = min(n, ADD_DOCUMENTS_BATCH_SIZE);
+	if (change_count < flush_threshold)
+	    n = min(n, size_t(flush_threshold - change_count));
+	Xapian::docid batch_did = first_did + start;
+
+	size_t n_chunks = min(size_t(parallelism), n);
+	vector<Inverter> partials(n_chunks);
+	vector<exception_ptr> errors(n_chunks);
+	try {
+	    // Copy the terms from the documents and check them.
+	    prepared.clear();
+	    prepared.resize(n);
+	    for (size_t i = 0; i != n; ++i) {
+		const Xapian::Document& doc = docs[start + i];
+		PreparedDocument& p = prepared[i];
+		p.terms.reserve(doc.termlist_count());
+		for (Xapian::TermIterator term = doc.termlist_begin();
+		     term != doc.termlist_end();
+		     ++term) {
+		    termcount wdf = term.get_wdf();
+		    p.doclen += wdf;
+		    version_file.check_wdf(wdf);
+
+		    const string& tname = *term;
+		    if (tname.size() > MAX_SAFE_TERM_LENGTH)
+			throw Xapian::InvalidArgumentError("Term too long (> " STRINGIZE(MAX_SAFE_TERM_LENGTH) "): " + tname);
+
+		    p.terms.emplace_back(tname, wdf);
+		    PreparedTerm& t = p.terms.back();
+		    t.positions = term.internal->get_vec_termpos();
+		    if (!t.positions) {
+			for (auto pos = term.positionlist_begin();
+			     pos != term.positionlist_end();
+			     ++pos) {
+			    t.own_positions.push_back(*pos);
+			}
+		    }
+		}
+	    }
+
+	    // Invert the documents in contiguous chunks, one Inverter per
+	    // chunk.
+	    atomic<size_t> next_chunk(0);
+	    bool need_termlist = termlist_table.is_open();
+	    auto worker = [&]() {
+		size_t c;
+		while ((c = next_chunk++) < n_chunks) {
+		    try {
+			Inverter& partial = partials[c];
+			size_t e = n * (c + 1) / n_chunks;
+			for (size_t i = n * c / n_chunks; i != e; ++i) {
+			    PreparedDocument& p = prepared[i];
+			    Xapian::docid did = batch_did + i;
+			    for (const PreparedTerm& t : p.terms) {
+				partial.add_posting(did, t.name, t.wdf);
+				partial.set_positionlist(position_table, did,
+							 t.name,
+							 t.get_positions());
+			    }
+			    partial.set_doclength(did, p.doclen, true);
+			    if (need_termlist && !p.terms.empty()) {
+				GlassTermListTable::TagEncoder enc(
+				    p.termlist_tag, p.doclen, p.terms.size());
+				for (const PreparedTerm& t : p.terms) {
+				    enc.append(t.name, t.wdf);
+				}
+			    }
+			}
+		    } catch (...) {
+			errors[c] = current_exception();
+		    }
+		}
+	    };
+
+	    // The calling thread does some of the work too, so we need one
+	    // less thread than the number of threads we're going to use.
+	    vector<thread> threads;
+	    threads.reserve(n_chunks - 1);
+	    try {
+		while (threads.size() + 1 < n_chunks) {
+		    threads.emplace_back(worker);
+		}
+	    } catch (const system_error&) {
+		// Failing to start a thread isn't fatal - we just use fewer
+		// threads.
+	    }
+	    worker();
+	    for (auto&& t : threads) {
+		t.join();
+	    }
+
+	    for (auto&& e : errors) {
+		if (e) rethrow_exception(e);
+	    }
+
+	    // Store everything else in document order, and merge the
+	    // Inverter objects.
+	    for (size_t i = 0; i != n; ++i) {
+		const Xapian::Document& doc = docs[start + i];
+		const PreparedDocument& p = prepared[i];
+		Xapian::docid did = version_file.get_next_docid();
+		AssertEq(did, batch_did + i);
+		docdata_table.replace_document_data(did, doc.get_data());
+		value_manager.add_document(did, doc, value_stats);
+		if (need_termlist) {
+		    termlist_table.add(GlassTermListTable::make_key(did),
+				       p.termlist_tag);
+		}
+		version_file.add_document(p.doclen);
+	    }
+	    for (auto&& partial : partials) {
+		inverter.merge(std::move(partial));
+	    }
+	} catch (...) {
+	    // As for add_document_(), discard all the pending changes.
+	    cancel();
+	    throw;
+	}
+
+	start += n;
+	change_count += n - 1;
+	check_flush_threshold();
+    }
+
+    RETURN(first_did);
+#endif
+}
+
 void
 GlassWritableDatabase::delete_document(Xapian::docid did)
 {
@@ -1246,25 +1689,32 @@ GlassWritableDatabase::delete_document(Xapian::docid did)
 	// Remove the values.
 	value_manager.delete_document(did, value_stats);
 
-	// OK, now add entries to remove the postings in the underlying record.
-	intrusive_ptr<const GlassWritableDatabase> ptrtothis(this);
-	GlassTermList termlist(ptrtothis, did);
+	if (lazy_delete) {
+	    // Leave the postings, positions and termlist for compaction (or
+	    // replace_document()) to remove.
+	    version_file.delete_document(get_doclength(did));
+	    postlist_table.add_tombstone(did);
+	} else {
+	    // OK, now add entries to remove the postings in the underlying record.
+	    intrusive_ptr<const GlassWritableDatabase> ptrtothis(this);
+	    GlassTermList termlist(ptrtothis, did);
 
-	version_file.delete_document(termlist.get_doclength());
+	    version_file.delete_document(termlist.get_doclength());
 
-	termlist.next();
-	while (!termlist.at_end()) {
-	    string tname = termlist.get_termname();
-	    inverter.delete_positionlist(did, tname);
+	    termlist.next();
+	    while (!termlist.at_end()) {
+		string tname = termlist.get_termname();
+		inverter.delete_positionlist(did, tname);
 
-	    inverter.remove_posting(did, tname, termlist.get_wdf());
+		inverter.remove_posting(did, tname, termlist.get_wdf());
 
-	    termlist.next();
-	}
+		termlist.next();
+	    }
 
-	// Remove the termlist.
-	if (termlist_table.is_open())
-	    termlist_table.delete_termlist(did);
+	    // Remove the termlist.
+	    if (termlist_table.is_open())
+		termlist_table.delete_termlist(did);
+	}
 
 	// Mark this document as removed.
 	inverter.delete_doclength(did);
@@ -1306,10 +1756,14 @@ GlassWritableDatabase::replace_document(Xapian::docid did,
 	    throw_termlist_table_close_exception();
 	}
 
+	// A document deleted with DB_LAZY_DELETE still has its termlist and
+	// postings, which we need to update as if it hadn't been deleted.
+	bool tombstoned = postlist_table.get_tombstones().contains(did);
+
 	// Check for a document read from this database being replaced - ie, a
 	// modification operation.
 	bool modifying = false;
-	if (modify_shortcut_docid &&
+	if (modify_shortcut_docid && !tombstoned &&
 	    document.internal->get_docid() == modify_shortcut_docid) {
 	    if (document.internal.get() == modify_shortcut_document) {
 		// We have a docid, it matches, and the pointer matches, so we
@@ -1334,7 +1788,7 @@ GlassWritableDatabase::replace_document(Xapian::docid did,
 	    bool pos_modified = !modifying ||
 				document.internal->positions_modified();
 	    intrusive_ptr<const GlassWritableDatabase> ptrtothis(this);
-	    GlassTermList termlist(ptrtothis, did, false);
+	    GlassTermList termlist(ptrtothis, did, false, true);
 	    // We passed false for throw_if_not_present so check at_end()
 	    // before next() to see if the document isn't present at all.
 	    if (termlist.at_end()) {
@@ -1343,7 +1797,8 @@ GlassWritableDatabase::replace_document(Xapian::docid did,
 	    }
 	    Xapian::TermIterator term = document.termlist_begin();
 	    Xapian::termcount old_doclen = termlist.get_doclength();
-	    version_file.delete_document(old_doclen);
+	    if (!tombstoned)
+		version_file.delete_document(old_doclen);
 	    Xapian::termcount new_doclen = old_doclen;
 
 	    string old_tname, new_tname;
@@ -1414,8 +1869,12 @@ GlassWritableDatabase::replace_document(Xapian::docid did,
 		termlist_table.set_termlist(did, document, new_doclen);
 
 	    // Set the new document length
-	    if (new_doclen != old_doclen)
+	    if (tombstoned) {
+		inverter.set_doclength(did, new_doclen, true);
+		postlist_table.remove_tombstone(did);
+	    } else if (new_doclen != old_doclen) {
 		inverter.set_doclength(did, new_doclen, false);
+	    }
 	    version_file.add_document(new_doclen);
 	}
 
@@ -1440,6 +1899,38 @@ GlassWritableDatabase::replace_document(Xapian::docid did,
     check_flush_threshold();
 }
 
+void
+GlassWritableDatabase::set_document_value(Xapian::docid did,
+					  Xapian::valueno slot,
+					  const string& value)
+{
+    LOGCALL_VOID(DB, "GlassWritableDatabase::set_document_value", did | slot | value);
+    Assert(did != 0);
+
+    // Ensure we throw DocumentNotFound if the document doesn't exist.
+    (void)get_doclength(did);
+
+    if (rare(modify_shortcut_docid == did)) {
+	// A Document object read before this change may hold the old value,
+	// so mustn't be used for a modification shortcut.
+	modify_shortcut_document = NULL;
+	modify_shortcut_docid = 0;
+    }
+
+    try {
+	value_manager.set_value(did, slot, value, value_stats);
+    } catch (...) {
+	// If an error occurs while updating a document, or doing any other
+	// transaction, the modifications so far must be cleared before
+	// returning control to the user - otherwise partial modifications will
+	// persist in memory, and eventually get written to disk.
+	cancel();
+	throw;
+    }
+
+    check_flush_threshold();
+}
+
 Xapian::Document::Internal *
 GlassWritableDatabase::open_document(Xapian::docid did, bool lazy) const
 {
@@ -1487,7 +1978,7 @@ GlassWritableDatabase::get_freqs(const string & term,
 {
     LOGCALL_VOID(DB, "GlassWritableDatabase::get_freqs", term | termfreq_ptr | collfreq_ptr);
     Assert(!term.empty());
-    GlassDatabase::get_freqs(term, termfreq_ptr, collfreq_ptr);
+    postlist_table.get_freqs(term, termfreq_ptr, collfreq_ptr);
     Xapian::termcount_diff tf_delta, cf_delta;
     if (inverter.get_deltas(term, tf_delta, cf_delta)) {
 	if (termfreq_ptr)
@@ -1495,6 +1986,10 @@ GlassWritableDatabase::get_freqs(const string & term,
 	if (collfreq_ptr)
 	    *collfreq_ptr += cf_delta;
     }
+    if (termfreq_ptr && !postlist_table.get_tombstones().empty()) {
+	// See GlassDatabase::get_freqs().
+	*termfreq_ptr = min(*termfreq_ptr, get_doccount());
+    }
 }
 
 Xapian::doccount
@@ -1576,6 +2071,25 @@ GlassWritableDatabase::open_leaf_post_list(const string& term,
     RETURN(new GlassPostList(ptrtothis, term, true));
 }
 
+LeafPostList*
+GlassWritableDatabase::open_bitmap_post_list(const string& term) const
+{
+    LOGCALL(DB, LeafPostList *, "GlassWritableDatabase::open_bitmap_post_list", term);
+    // Flush any buffered changes for this term's postlist, which also
+    // updates its bitmap.
+    inverter.flush_post_list(postlist_table, term);
+    RETURN(GlassDatabase::open_bitmap_post_list(term));
+}
+
+bool
+GlassWritableDatabase::get_impact_params(string&) const
+{
+    LOGCALL(DB, bool, "GlassWritableDatabase::get_impact_params", NO_ARGS);
+    // Any changes we make mark the impact lists as stale, but until they're
+    // flushed the lists may not match the postings.
+    RETURN(false);
+}
+
 ValueList *
 GlassWritableDatabase::open_value_list(Xapian::valueno slot) const
 {
@@ -1621,7 +2135,8 @@ GlassWritableDatabase::open_position_list(Xapian::docid did, const string& term)
     Assert(did != 0);
     string data;
     if (inverter.get_positionlist(did, term, data)) {
-	return new GlassPositionList(std::move(data));
+	return new GlassPositionList(std::move(data),
+				     position_table.is_packed());
     }
     return GlassDatabase::open_position_list(did, term);
 }
@@ -1649,6 +2164,10 @@ GlassWritableDatabase::open_allterms(const string & prefix) const
 void
 GlassWritableDatabase::cancel()
 {
+    // Cancelling resets the freelists to the last committed revision, which
+    // allows blocks it freed to be reused, so that revision needs to be on
+    // disk first.
+    wait_for_commit();
     GlassDatabase::cancel();
     inverter.clear();
     value_stats.clear();
@@ -45,12 +45,50 @@
 #include "xapian/constants.h"
 
 #include <map>
+#include <string>
+#include <vector>
+
+#ifdef HAVE_STD_THREAD
+# include <thread>
+#endif
 
 class GlassTermList;
 class GlassAllDocsPostList;
 class HoneyDatabase;
 class RemoteConnection;
 
+/** The files which still need syncing to make a new revision durable.
+ *
+ *  This allows the syncing to be done after the commit returns, on another
+ *  thread.  The revision only becomes visible to readers once the new
+ *  version file has been renamed into place by run().
+ */
+struct GlassPendingSync {
+    /// The DB_* flags in use.
+    int flags = 0;
+
+    /// The file descriptors of the tables which need syncing.
+    std::vector<int> table_fds;
+
+    /// The file descriptor of the new version file (-1 if nothing pending).
+    int version_fd = -1;
+
+    /// The new version file's temporary name (empty if written in place).
+    std::string tmpfile;
+
+    /// The database directory.
+    std::string db_dir;
+
+    /// Is there anything to sync?
+    bool pending() const { return version_fd >= 0; }
+
+    /** Sync the tables, then the new version file.
+     *
+     *  @return true on success; false on failure (with errno set).
+     */
+    bool run();
+};
+
 /** A backend designed for efficient indexing and retrieval, using
  *  compressed posting lists and a btree storage scheme.
  */
@@ -136,6 +174,9 @@ class GlassDatabase : public Xapian::Database::Internal {
      */
     bool open_tables(int flags);
 
+    /// Make all the tables read through memory mappings.
+    void set_tables_use_mmap();
+
     /** Get a write lock on the database, or throw an
      *  Xapian::DatabaseLockError if failure.
      *
@@ -163,8 +204,13 @@ class GlassDatabase : public Xapian::Database::Internal {
      *          be greater than the current revision number.  FIXME: If
      *          we support rewinding to a previous revision, maybe this
      *          needs to be greater than any previously used revision.
+     *
+     *  @param pending	If non-NULL and changesets aren't being written,
+     *			the files aren't synced, but instead @a pending is
+     *			filled in so that the caller can sync them later.
      */
-    void set_revision_number(int flags, glass_revision_number_t new_revision);
+    void set_revision_number(int flags, glass_revision_number_t new_revision,
+			     GlassPendingSync* pending = NULL);
 
     /** Re-open tables to recover from an overwritten condition,
      *  or just get most up-to-date version.
@@ -190,8 +236,10 @@ class GlassDatabase : public Xapian::Database::Internal {
      *  tables on disk will be left in an unmodified state (though possibly
      *  with increased revision numbers), and the outstanding changes will
      *  be lost.
+     *
+     *  @param pending	Passed on to set_revision_number().
      */
-    void apply();
+    void apply(GlassPendingSync* pending = NULL);
 
     /** Cancel any outstanding changes to the tables.
      */
@@ -226,12 +274,16 @@ class GlassDatabase : public Xapian::Database::Internal {
      *                    tables.  This is only important, and has the
      *                    correct value, when the database is being
      *                    created.
+     *
+     *  @param use_mmap	Read the tables through memory mappings (only
+     *			used when opening read-only).
      */
     explicit GlassDatabase(const string& db_dir_,
 			   int flags = Xapian::DB_READONLY_,
-			   unsigned int block_size = 0u);
+			   unsigned int block_size = 0u,
+			   bool use_mmap = false);
 
-    explicit GlassDatabase(int fd);
+    explicit GlassDatabase(int fd, bool use_mmap = false);
 
     ~GlassDatabase();
 
@@ -264,6 +316,9 @@ class GlassDatabase : public Xapian::Database::Internal {
     PostList * open_post_list(const string & tname) const;
     LeafPostList* open_leaf_post_list(const string& term,
 				      bool need_read_pos) const;
+    LeafPostList* open_bitmap_post_list(const string& term) const;
+    bool get_impact_params(string& params) const;
+    bool get_impact_list(const string& term, string& data) const;
     ValueList * open_value_list(Xapian::valueno slot) const;
     Xapian::Document::Internal* open_document(Xapian::docid did,
 					      bool lazy) const;
@@ -311,6 +366,12 @@ class GlassDatabase : public Xapian::Database::Internal {
 	return BACKEND_GLASS;
     }
 
+    int get_open_flags() const {
+	int flags = Xapian::DB_BACKEND_GLASS;
+	if (postlist_table.get_use_mmap()) flags |= Xapian::DB_MMAP;
+	return flags;
+    }
+
     bool single_file() const { return version_file.single_file(); }
 
     void get_used_docid_range(Xapian::docid & first,
@@ -351,6 +412,11 @@ class GlassWritableDatabase : public GlassDatabase {
     /// If change_count reaches this threshold we automatically flush.
     Xapian::doccount flush_threshold;
 
+    /** If the inverter's memory use reaches this many bytes we automatically
+     *  flush (0 means no limit).
+     */
+    size_t flush_threshold_bytes;
+
     /** A pointer to the last document which was returned by
      *  open_document(), or NULL if there is no such valid document.  This
      *  is used purely for comparing with a supplied document to help with
@@ -363,6 +429,44 @@ class GlassWritableDatabase : public GlassDatabase {
      */
     mutable Xapian::docid modify_shortcut_docid;
 
+    /** Should delete_document() tombstone documents?
+     *
+     *  Set by opening with Xapian::DB_LAZY_DELETE.
+     */
+    bool lazy_delete;
+
+    /** Should we add a dense array of document lengths if there isn't one?
+     *
+     *  Set by opening with Xapian::DB_DOCLEN_COLUMN.
+     */
+    bool want_doclen_column;
+
+    /** Should we add bitmaps for dense terms if there aren't any?
+     *
+     *  Set by opening with Xapian::DB_TERM_BITMAPS.
+     */
+    bool want_term_bitmaps;
+
+    /** Should we add a Bloom filter over the terms if there isn't one?
+     *
+     *  Set by opening with Xapian::DB_TERM_FILTER.
+     */
+    bool want_term_filter;
+
+#ifdef HAVE_STD_THREAD
+    /// Thread syncing the revision written by commit_async() (if any).
+    std::thread commit_thread;
+
+    /// The files which commit_thread is syncing.
+    GlassPendingSync pending_sync;
+
+    /// Did commit_thread succeed?
+    bool pending_sync_ok = true;
+
+    /// The errno from commit_thread if it failed.
+    int pending_sync_errno = 0;
+#endif
+
     /** Check if we should autoflush.
      *
      *  Called at the end of each document changing operation.
@@ -375,8 +479,12 @@ class GlassWritableDatabase : public GlassDatabase {
     /// Close all the tables permanently.
     void close();
 
-    /// Apply changes.
-    void apply();
+    /** Apply changes.
+     *
+     *  @param async	If true, sync the new revision on a background thread
+     *			where possible.
+     */
+    void apply(bool async = false);
 
     //@{
     /** Implementation of virtual methods: see Database::Internal for
@@ -384,12 +492,18 @@ class GlassWritableDatabase : public GlassDatabase {
      */
     void commit();
 
+    void commit_async();
+
+    void wait_for_commit();
+
     /** Cancel pending modifications to the database. */
     void cancel();
 
     Xapian::docid add_document(const Xapian::Document& document);
     Xapian::docid add_document_(Xapian::docid did,
 				const Xapian::Document& document);
+    Xapian::docid add_documents(const std::vector<Xapian::Document>& docs,
+				unsigned parallelism);
     // Stop the default implementation of delete_document(term) and
     // replace_document(term) from being hidden.  This isn't really
     // a problem as we only try to call them through the base class
@@ -400,6 +514,9 @@ class GlassWritableDatabase : public GlassDatabase {
     void delete_document(Xapian::docid did);
     void replace_document(Xapian::docid did, const Xapian::Document & document);
 
+    void set_document_value(Xapian::docid did, Xapian::valueno slot,
+			    const std::string& value);
+
     Xapian::Document::Internal * open_document(Xapian::docid did,
 					       bool lazy) const;
 
@@ -437,6 +554,8 @@ class GlassWritableDatabase : public GlassDatabase {
     PostList * open_post_list(const string & tname) const;
     LeafPostList* open_leaf_post_list(const string& term,
 				      bool need_read_pos) const;
+    LeafPostList* open_bitmap_post_list(const string& term) const;
+    bool get_impact_params(string& params) const;
     ValueList * open_value_list(Xapian::valueno slot) const;
 
     void read_position_list(GlassRePositionList* pos_list,
@@ -466,6 +585,24 @@ class GlassWritableDatabase : public GlassDatabase {
     bool has_uncommitted_changes() const;
 
     Xapian::Database::Internal* update_lock(int flags);
+
+    /** Set the thresholds for automatically flushing changes.
+     *
+     *  These override XAPIAN_FLUSH_THRESHOLD and
+     *  XAPIAN_FLUSH_THRESHOLD_BYTES.
+     *
+     *  @param changes_threshold	Flush after this many documents are
+     *				changed (0 for no limit).
+     *  @param bytes_threshold	Flush once the buffered changes are using
+     *				this many bytes of memory (0 for no limit).
+     */
+    void set_flush_thresholds(Xapian::doccount changes_threshold,
+			      size_t bytes_threshold);
+
+    /// Return the estimated bytes of memory used by buffered changes.
+    size_t get_buffered_memory() const {
+	return inverter.get_memory_used();
+    }
 };
 
 #ifdef DISABLE_GPL_LIBXAPIAN
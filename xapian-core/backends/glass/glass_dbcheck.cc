@@ -31,9 +31,17 @@
 #include "glass_check.h"
 #include "glass_cursor.h"
 #include "glass_defs.h"
+#include "glass_doclencolumn.h"
+#include "glass_impactlists.h"
 #include "glass_table.h"
+#include "glass_termbitmaps.h"
+#include "glass_termfilter.h"
+#include "glass_tombstones.h"
 #include "glass_version.h"
 #include "pack.h"
+#include "packedpositions.h"
+#include "backends/impactlist.h"
+#include "backends/roaringbitmap.h"
 #include "backends/valuestats.h"
 
 #include <xapian.h>
@@ -51,6 +59,31 @@ is_user_metadata_key(const string & key)
     return key.size() > 1 && key[0] == '\0' && key[1] == '\xc0';
 }
 
+/** Return the number of documents deleted with Xapian::DB_LAZY_DELETE.
+ *
+ *  Their termlists are left behind until the database is compacted.  If the
+ *  tombstones can't be read we return 0 - the check of the postlist table
+ *  will report the problem.
+ */
+static Xapian::doccount
+count_tombstones(const string& db_dir, int fd, off_t offset_,
+		 const GlassVersion& version_file)
+{
+    try {
+	unique_ptr<GlassTable> table(
+		fd < 0 ?
+		new GlassTable("postlist", db_dir + "/postlist.", true) :
+		new GlassTable("postlist", fd, offset_, true));
+	table->open(0, version_file.get_root(Glass::POSTLIST),
+		    version_file.get_revision());
+	GlassTombstones tombstones;
+	tombstones.load(*table);
+	return tombstones.size();
+    } catch (const Xapian::Error&) {
+	return 0;
+    }
+}
+
 struct VStats : public ValueStats {
     Xapian::doccount freq_real;
 
@@ -108,6 +141,31 @@ check_glass_table(const char * tablename, const string &db_dir, int fd,
 	Xapian::termcount termfreq = 0, collfreq = 0;
 	Xapian::termcount tf = 0, cf = 0;
 	Xapian::doccount num_doclens = 0;
+	// The lengths from the document length list, to check against the
+	// document length column (which sorts after it).
+	vector<Xapian::termcount> list_doclens;
+	bool have_doclen_column = false;
+	Xapian::doccount num_column_doclens = 0;
+	// The term bitmaps (which sort before the posting lists), to check
+	// against the posting lists.  Each is removed once checked.
+	bool have_term_bitmaps = false;
+	map<string, RoaringBitmap> term_bitmaps;
+	const RoaringBitmap* current_bitmap = NULL;
+	// The sizes of the impact lists (which also sort before the posting
+	// lists), to check against the posting lists.  Each is removed once
+	// checked.
+	bool have_impact_lists = false;
+	map<string, Xapian::doccount> impact_list_sizes;
+	// Stale impact lists don't get checked against the posting lists.
+	bool impact_lists_stale = false;
+	// The term filter (which sorts before everything else), to check that
+	// it contains every term.
+	bool have_term_filter = false;
+	uint32_t filter_blocks = 0;
+	Xapian::doccount filter_terms = 0;
+	string term_filter;
+	const size_t filter_block_bytes = GlassTermFilter::BLOCK_BITS / 8;
+	Xapian::doccount num_terms = 0;
 
 	for ( ; !cursor->after_end(); cursor->next()) {
 	    string & key = cursor->current_key;
@@ -195,6 +253,9 @@ check_glass_table(const char * tablename, const string &db_dir, int fd,
 		    }
 
 		    ++num_doclens;
+		    if (list_doclens.size() <= did)
+			list_doclens.resize(did + 1, Xapian::termcount(-1));
+		    list_doclens[did] = doclen;
 
 		    if (did > db_last_docid) {
 			if (out)
@@ -307,6 +368,247 @@ check_glass_table(const char * tablename, const string &db_dir, int fd,
 		continue;
 	    }
 
+	    if (GlassTombstones::is_key(key)) {
+		// Chunk of the bitmap of tombstoned documents.
+		const char * p = key.data() + 2;
+		const char * end = key.data() + key.size();
+		Xapian::docid chunk;
+		if (!unpack_uint_preserving_sort(&p, end, &chunk) || p != end) {
+		    if (out)
+			*out << "Bad tombstone chunk key" << endl;
+		    ++errors;
+		    continue;
+		}
+		cursor->read_tag();
+		const string & tag = cursor->current_tag;
+		if (tag.empty() || tag.size() > GlassTombstones::CHUNK_DOCS / 8) {
+		    if (out)
+			*out << "Tombstone chunk " << chunk << " has bad length "
+			     << tag.size() << endl;
+		    ++errors;
+		    continue;
+		}
+		unsigned char last_byte = tag.back();
+		if (last_byte == 0) {
+		    if (out)
+			*out << "Tombstone chunk " << chunk << " has trailing "
+				"zero bytes" << endl;
+		    ++errors;
+		    continue;
+		}
+		if (chunk == 0 && (tag[0] & 1)) {
+		    if (out)
+			*out << "Document id 0 is tombstoned" << endl;
+		    ++errors;
+		}
+		int top_bit = 7;
+		while (!(last_byte & (1 << top_bit))) --top_bit;
+		Xapian::docid last_tombstoned =
+		    chunk * GlassTombstones::CHUNK_DOCS +
+		    Xapian::docid(tag.size() - 1) * 8 + top_bit;
+		if (last_tombstoned > db_last_docid) {
+		    if (out)
+			*out << "Tombstoned document id " << last_tombstoned
+			     << " is larger than get_last_docid() "
+			     << db_last_docid << endl;
+		    ++errors;
+		}
+		continue;
+	    }
+
+	    if (GlassDocLenColumn::is_key(key)) {
+		cursor->read_tag();
+		const string & tag = cursor->current_tag;
+		if (key.size() == 2) {
+		    // Marker for the document length column.
+		    have_doclen_column = true;
+		    if (!tag.empty()) {
+			if (out)
+			    *out << "Doclen column marker isn't empty" << endl;
+			++errors;
+		    }
+		    continue;
+		}
+		if (!have_doclen_column) {
+		    if (out)
+			*out << "Doclen column chunk without marker" << endl;
+		    ++errors;
+		}
+		const char * p = key.data() + 2;
+		const char * end = key.data() + key.size();
+		Xapian::docid chunk;
+		if (!unpack_uint_preserving_sort(&p, end, &chunk) || p != end) {
+		    if (out)
+			*out << "Bad doclen column chunk key" << endl;
+		    ++errors;
+		    continue;
+		}
+		vector<Xapian::termcount> column;
+		if (!GlassDocLenColumn::decode(tag, column)) {
+		    if (out)
+			*out << "Doclen column chunk " << chunk << " is invalid"
+			     << endl;
+		    ++errors;
+		    continue;
+		}
+		for (size_t i = 0; i != column.size(); ++i) {
+		    Xapian::docid did = chunk * GlassDocLenColumn::CHUNK_DOCS + i;
+		    Xapian::termcount expected = Xapian::termcount(-1);
+		    if (did < list_doclens.size()) expected = list_doclens[did];
+		    if (column[i] != expected) {
+			if (out) {
+			    *out << "document id " << did << ": length in "
+				    "doclen column doesn't match doclen list"
+				 << endl;
+			}
+			++errors;
+		    }
+		    if (column[i] != Xapian::termcount(-1))
+			++num_column_doclens;
+		}
+		continue;
+	    }
+
+	    if (GlassTermBitmaps::is_key(key)) {
+		cursor->read_tag();
+		const string & tag = cursor->current_tag;
+		if (key.size() == 2) {
+		    // Marker for the term bitmaps.
+		    have_term_bitmaps = true;
+		    if (!tag.empty()) {
+			if (out)
+			    *out << "Term bitmaps marker isn't empty" << endl;
+			++errors;
+		    }
+		    continue;
+		}
+		if (!have_term_bitmaps) {
+		    if (out)
+			*out << "Term bitmap without marker" << endl;
+		    ++errors;
+		}
+		string term;
+		Xapian::docid container_key;
+		if (!GlassTermBitmaps::parse_key(key, term, container_key)) {
+		    if (out)
+			*out << "Bad term bitmap key" << endl;
+		    ++errors;
+		    continue;
+		}
+		RoaringBitmap::Container container;
+		if (!container.unserialise(tag.data(), tag.data() + tag.size())) {
+		    if (out)
+			*out << "Bitmap container " << container_key
+			     << " for term '" << term << "' is invalid" << endl;
+		    ++errors;
+		    continue;
+		}
+		term_bitmaps[term].append(container_key, std::move(container));
+		continue;
+	    }
+
+	    if (GlassTermFilter::is_key(key)) {
+		cursor->read_tag();
+		const string & tag = cursor->current_tag;
+		if (key.size() == 2) {
+		    // Marker for the term filter.
+		    if (!GlassTermFilter::parse_marker(tag, filter_blocks,
+						       filter_terms)) {
+			if (out)
+			    *out << "Term filter marker is invalid" << endl;
+			++errors;
+			continue;
+		    }
+		    have_term_filter = true;
+		    continue;
+		}
+		if (!have_term_filter) {
+		    if (out)
+			*out << "Term filter chunk without marker" << endl;
+		    ++errors;
+		    continue;
+		}
+		uint32_t chunk;
+		if (!GlassTermFilter::parse_key(key, chunk)) {
+		    if (out)
+			*out << "Bad term filter key" << endl;
+		    ++errors;
+		    continue;
+		}
+		uint32_t chunk_blocks = GlassTermFilter::CHUNK_BLOCKS;
+		size_t blocks_so_far = term_filter.size() / filter_block_bytes;
+		if (size_t(chunk) * chunk_blocks != blocks_so_far ||
+		    blocks_so_far >= filter_blocks) {
+		    if (out)
+			*out << "Term filter chunk " << chunk
+			     << " is out of sequence" << endl;
+		    ++errors;
+		    continue;
+		}
+		size_t expected = min(size_t(chunk_blocks),
+				      filter_blocks - blocks_so_far) *
+				  filter_block_bytes;
+		if (tag.size() != expected) {
+		    if (out)
+			*out << "Term filter chunk " << chunk << " has size "
+			     << tag.size() << ", should be " << expected
+			     << endl;
+		    ++errors;
+		    continue;
+		}
+		term_filter += tag;
+		continue;
+	    }
+
+	    if (GlassImpactLists::is_key(key)) {
+		cursor->read_tag();
+		const string & tag = cursor->current_tag;
+		if (key.size() == 2) {
+		    // Marker for the impact lists.
+		    have_impact_lists = true;
+		    impact_lists_stale = tag.empty();
+		    ImpactParams params;
+		    if (!impact_lists_stale && !params.unserialise_bm25(tag)) {
+			if (out)
+			    *out << "Impact lists marker is invalid" << endl;
+			++errors;
+		    }
+		    continue;
+		}
+		if (!have_impact_lists) {
+		    if (out)
+			*out << "Impact list without marker" << endl;
+		    ++errors;
+		}
+		string term(key, 2);
+		Xapian::doccount size = 0;
+		try {
+		    ImpactListReader reader(tag.data(), tag.data() + tag.size());
+		    unsigned impact;
+		    unsigned prev_impact = IMPACT_LEVELS + 1;
+		    Xapian::doccount count;
+		    while (reader.next_segment(impact, count)) {
+			if (impact >= prev_impact) {
+			    if (out)
+				*out << "Impact list for term '" << term
+				     << "' not in descending impact order"
+				     << endl;
+			    ++errors;
+			}
+			prev_impact = impact;
+			size += count;
+		    }
+		} catch (const Xapian::DatabaseCorruptError&) {
+		    if (out)
+			*out << "Impact list for term '" << term
+			     << "' is invalid" << endl;
+		    ++errors;
+		    continue;
+		}
+		if (!impact_lists_stale) impact_list_sizes[term] = size;
+		continue;
+	    }
+
 	    if (key.size() >= 2 && key[0] == '\0' && key[1] == '\xd8') {
 		// Value stream chunk.
 		const char * p = key.data();
@@ -429,6 +731,7 @@ check_glass_table(const char * tablename, const string &db_dir, int fd,
 		    tf = cf = 0;
 		    lastdid = 0;
 		}
+		current_bitmap = NULL;
 		++errors;
 	    }
 	    if (pos == end) {
@@ -443,6 +746,23 @@ check_glass_table(const char * tablename, const string &db_dir, int fd,
 		}
 		current_term = term;
 		tf = cf = 0;
+		++num_terms;
+		if (have_term_filter &&
+		    term_filter.size() == filter_blocks * filter_block_bytes) {
+		    uint64_t h = GlassTermFilter::hash(term);
+		    size_t block = GlassTermFilter::block_index(h,
+								filter_blocks);
+		    const char* p = term_filter.data() +
+				    block * filter_block_bytes;
+		    if (!GlassTermFilter::block_contains(p, h)) {
+			if (out)
+			    *out << "Term filter doesn't contain term '"
+				 << term << "'" << endl;
+			++errors;
+		    }
+		}
+		auto b = term_bitmaps.find(term);
+		current_bitmap = (b == term_bitmaps.end()) ? NULL : &b->second;
 
 		// Unpack extra header from first chunk.
 		cursor->read_tag();
@@ -524,6 +844,13 @@ check_glass_table(const char * tablename, const string &db_dir, int fd,
 		}
 		++tf;
 		cf += wdf;
+		if (current_bitmap && !current_bitmap->contains(did)) {
+		    if (out)
+			*out << "document id " << did << " is missing from the "
+				"bitmap for term '" << current_term << "'"
+			     << endl;
+		    ++errors;
+		}
 
 		if (pos == end) break;
 
@@ -566,6 +893,35 @@ check_glass_table(const char * tablename, const string &db_dir, int fd,
 			     << endl;
 		    ++errors;
 		}
+		if (current_bitmap) {
+		    if (current_bitmap->size() != tf) {
+			if (out)
+			    *out << "Bitmap for term '" << current_term
+				 << "' has " << current_bitmap->size()
+				 << " entries, should be " << tf << endl;
+			++errors;
+		    }
+		    term_bitmaps.erase(current_term);
+		    current_bitmap = NULL;
+		}
+		if (have_impact_lists && !impact_lists_stale) {
+		    auto im = impact_list_sizes.find(current_term);
+		    if (im == impact_list_sizes.end()) {
+			if (out)
+			    *out << "No impact list for term '" << current_term
+				 << "'" << endl;
+			++errors;
+		    } else {
+			if (im->second != tf) {
+			    if (out)
+				*out << "Impact list for term '"
+				     << current_term << "' has " << im->second
+				     << " entries, should be " << tf << endl;
+			    ++errors;
+			}
+			impact_list_sizes.erase(im);
+		    }
+		}
 		current_term.resize(0);
 	    }
 	}
@@ -576,6 +932,37 @@ check_glass_table(const char * tablename, const string &db_dir, int fd,
 	    ++errors;
 	}
 
+	for (auto& t : term_bitmaps) {
+	    if (out)
+		*out << "Bitmap for term '" << t.first << "' which has no "
+			"posting list" << endl;
+	    ++errors;
+	}
+
+	if (have_term_filter) {
+	    if (term_filter.size() != filter_blocks * filter_block_bytes) {
+		if (out)
+		    *out << "Term filter has "
+			 << term_filter.size() / filter_block_bytes
+			 << " blocks, should be " << filter_blocks << endl;
+		++errors;
+	    }
+	    if (filter_terms < num_terms) {
+		if (out)
+		    *out << "Term filter has had " << filter_terms
+			 << " terms added, but there are " << num_terms
+			 << endl;
+		++errors;
+	    }
+	}
+
+	for (auto& t : impact_list_sizes) {
+	    if (out)
+		*out << "Impact list for term '" << t.first << "' which has no "
+			"posting list" << endl;
+	    ++errors;
+	}
+
 	Xapian::doccount doccount = version_file.get_doccount();
 	if (num_doclens != doccount) {
 	    if (out)
@@ -599,9 +986,14 @@ check_glass_table(const char * tablename, const string &db_dir, int fd,
 	// so we can only check there aren't more docdata entries than
 	// documents.
 	Xapian::doccount doccount = version_file.get_doccount();
-	if (table->get_entry_count() > doccount) {
+	glass_tablesize_t entries = table->get_entry_count();
+	bool has_dictionary =
+	    (table->get_compressor() == CompressionStream::ZSTD_DICT);
+	// The compression dictionary is stored as an extra entry.
+	if (has_dictionary) --entries;
+	if (entries > doccount) {
 	    if (out)
-		*out << "More document data (" << table->get_entry_count()
+		*out << "More document data (" << entries
 		     << ") then documents (" << doccount << ")" << endl;
 	    ++errors;
 	}
@@ -610,6 +1002,8 @@ check_glass_table(const char * tablename, const string &db_dir, int fd,
 	for ( ; !cursor->after_end(); cursor->next()) {
 	    string & key = cursor->current_key;
 
+	    if (has_dictionary && key == GLASS_DICTIONARY_KEY) continue;
+
 	    // Get docid from key.
 	    const char * pos = key.data();
 	    const char * end = pos + key.size();
@@ -846,8 +1240,12 @@ check_glass_table(const char * tablename, const string &db_dir, int fd,
 	Xapian::doccount doccount = version_file.get_doccount();
 
 	// glass doesn't store a termlist entry if there are no terms, so we
-	// can only check there aren't more termlists than documents.
-	if (num_termlists > doccount) {
+	// can only check there aren't more termlists than documents (including
+	// those deleted with Xapian::DB_LAZY_DELETE, whose termlists are left
+	// until the database is compacted).
+	if (num_termlists > doccount &&
+	    num_termlists > doccount + count_tombstones(db_dir, fd, offset_,
+							version_file)) {
 	    if (out)
 		*out << "More termlists (" << num_termlists
 		     << ") then documents (" << doccount << ")" << endl;
@@ -928,6 +1326,42 @@ check_glass_table(const char * tablename, const string &db_dir, int fd,
 	    }
 	    if (pos == end) {
 		// Special case for single entry position list.
+	    } else if (table->get_encoding() == POSITIONS_PACKED) {
+		try {
+		    PackedPositionReader rd;
+		    Xapian::termpos p;
+		    Xapian::termcount pos_size = rd.init(pos, end, p);
+		    bool ok = true;
+		    for (Xapian::termcount i = 1; i != pos_size; ++i) {
+			Xapian::termpos pos_prev = p;
+			p = rd.next();
+			if (p <= pos_prev) {
+			    if (out)
+				*out << tablename << " table: Positions not "
+					"strictly monotonically increasing"
+				     << endl;
+			    ++errors;
+			    ok = false;
+			    break;
+			}
+		    }
+		    if (ok && p != pos_last) {
+			if (out)
+			    *out << tablename << " table: Last position "
+				 << p << " doesn't match " << pos_last << endl;
+			++errors;
+		    } else if (ok && !rd.check_all_gone()) {
+			if (out)
+			    *out << tablename << " table: Junk after position "
+				    "data" << endl;
+			++errors;
+		    }
+		} catch (const Xapian::DatabaseCorruptError&) {
+		    if (out)
+			*out << tablename << " table: Position list data "
+				"corrupt" << endl;
+		    ++errors;
+		}
 	    } else {
 		// Skip the header we just read.
 		BitReader rd(pos, end);
@@ -42,6 +42,14 @@
  */
 #define GLASS_MAX_DOCID Xapian::docid(0xffffffffffffffff)
 
+/** Key for the compression dictionary in a table which uses one.
+ *
+ *  Only tables keyed by docid use a dictionary, and pack_uint_preserving_sort()
+ *  never produces a key starting with '\xff', so this can't clash with an
+ *  entry.
+ */
+#define GLASS_DICTIONARY_KEY "\xff"
+
 namespace Glass {
     enum table_type {
 	POSTLIST,
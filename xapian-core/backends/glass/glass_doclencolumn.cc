@@ -0,0 +1,278 @@
+/** @file glass_doclencolumn.cc
+ * @brief Dense array of document lengths in a glass database
+ */
+/* Copyright (C) 2026 Xapian contributors
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301 USA
+ */
+
+#include <config.h>
+
+#include "glass_doclencolumn.h"
+
+#include "glass_cursor.h"
+#include "glass_table.h"
+#include "omassert.h"
+#include "pack.h"
+
+#include "xapian/error.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+
+using namespace std;
+
+/// Entry in a decoded chunk for an unused document ID.
+static constexpr Xapian::termcount NO_DOC = Xapian::termcount(-1);
+
+/// The value stored for an unused document ID in entries of @a width bytes.
+static inline uint32_t
+missing_value(unsigned width)
+{
+    return uint32_t(0xffffffff) >> (32 - width * 8);
+}
+
+string
+GlassDocLenColumn::make_key(Xapian::docid chunk)
+{
+    string key = make_marker_key();
+    pack_uint_preserving_sort(key, chunk);
+    return key;
+}
+
+bool
+GlassDocLenColumn::decode(const string& chunk_tag,
+			  vector<Xapian::termcount>& doclens)
+{
+    doclens.clear();
+    if (chunk_tag.empty()) return false;
+    auto p = reinterpret_cast<const unsigned char*>(chunk_tag.data());
+    unsigned width = *p++;
+    if (((width - 8) &~ 0x18) != 0) return false;
+    width /= 8;
+    size_t n = (chunk_tag.size() - 1) / width;
+    if ((chunk_tag.size() - 1) % width != 0 || n == 0 || n > CHUNK_DOCS)
+	return false;
+    uint32_t missing = missing_value(width);
+    doclens.reserve(n);
+    for (size_t i = 0; i != n; ++i) {
+	uint32_t doclen = 0;
+	for (unsigned j = 0; j != width; ++j) {
+	    doclen = (doclen << 8) | *p++;
+	}
+	doclens.push_back(doclen == missing ? NO_DOC : doclen);
+    }
+    // The last entry should always be for a used document ID.
+    return doclens.back() != NO_DOC;
+}
+
+string
+GlassDocLenColumn::encode(vector<Xapian::termcount> doclens)
+{
+    while (!doclens.empty() && doclens.back() == NO_DOC) doclens.pop_back();
+    string result;
+    if (doclens.empty()) return result;
+
+    Xapian::termcount max_doclen = 0;
+    for (auto doclen : doclens) {
+	if (doclen != NO_DOC) max_doclen = max(max_doclen, doclen);
+    }
+    // Use the narrowest entries which can hold max_doclen, remembering that
+    // all bits set means an unused document ID.
+    unsigned width = 1;
+    while (max_doclen >= missing_value(width)) {
+	if (rare(width == 4)) {
+	    throw Xapian::DatabaseError("Document length too large for the "
+					"document length column");
+	}
+	++width;
+    }
+    result.reserve(1 + doclens.size() * width);
+    result += char(width * 8);
+    for (auto doclen : doclens) {
+	for (unsigned j = width; j != 0; --j) {
+	    result += char(doclen >> ((j - 1) * 8));
+	}
+    }
+    return result;
+}
+
+void
+GlassDocLenColumn::build(GlassTable& table)
+{
+    vector<Xapian::termcount> doclens;
+    Xapian::docid chunk = 0;
+    auto set_doclen = [&](Xapian::docid did, Xapian::termcount doclen) {
+	if (did / CHUNK_DOCS != chunk) {
+	    string chunk_tag = encode(std::move(doclens));
+	    if (!chunk_tag.empty()) table.add(make_key(chunk), chunk_tag);
+	    doclens.clear();
+	    chunk = did / CHUNK_DOCS;
+	}
+	size_t i = did % CHUNK_DOCS;
+	if (doclens.size() <= i) doclens.resize(i + 1, NO_DOC);
+	doclens[i] = doclen;
+    };
+
+    // Read the document length posting list, which has the same format
+    // as the posting list for a term except for the keys.
+    unique_ptr<GlassCursor> cursor(table.cursor_get());
+    if (cursor && cursor->find_entry(pack_glass_postlist_key(string()))) {
+	cursor->read_tag();
+	const char* p = cursor->current_tag.data();
+	const char* end = p + cursor->current_tag.size();
+	// The first chunk starts with dummy frequencies (always zero).
+	Xapian::doccount tf;
+	Xapian::termcount cf;
+	Xapian::docid did;
+	if (!unpack_uint(&p, end, &tf) ||
+	    !unpack_uint(&p, end, &cf) ||
+	    !unpack_uint(&p, end, &did)) {
+	    throw Xapian::DatabaseCorruptError("Bad doclen chunk");
+	}
+	++did;
+	while (true) {
+	    bool is_last;
+	    Xapian::docid increase_to_last;
+	    Xapian::termcount doclen;
+	    if (!unpack_bool(&p, end, &is_last) ||
+		!unpack_uint(&p, end, &increase_to_last)) {
+		throw Xapian::DatabaseCorruptError("Bad doclen chunk");
+	    }
+	    // An empty list may just have a dummy first chunk.
+	    if (p == end && is_last) break;
+	    if (!unpack_uint(&p, end, &doclen)) {
+		throw Xapian::DatabaseCorruptError("Bad doclen chunk");
+	    }
+	    while (true) {
+		set_doclen(did, doclen);
+		if (p == end) break;
+		Xapian::docid inc;
+		if (!unpack_uint(&p, end, &inc) ||
+		    !unpack_uint(&p, end, &doclen)) {
+		    throw Xapian::DatabaseCorruptError("Bad doclen chunk");
+		}
+		did += inc + 1;
+	    }
+	    if (is_last) break;
+
+	    if (!cursor->next()) {
+		throw Xapian::DatabaseCorruptError("Unexpected end of doclen "
+						   "list");
+	    }
+	    const string& key = cursor->current_key;
+	    p = key.data();
+	    end = p + key.size();
+	    if (key.size() < 2 || p[0] != '\0' || p[1] != '\xe0') {
+		throw Xapian::DatabaseCorruptError("Unexpected end of doclen "
+						   "list");
+	    }
+	    p += 2;
+	    if (!unpack_uint_preserving_sort(&p, end, &did) || p != end) {
+		throw Xapian::DatabaseCorruptError("Bad doclen chunk key");
+	    }
+	    cursor->read_tag();
+	    p = cursor->current_tag.data();
+	    end = p + cursor->current_tag.size();
+	}
+    }
+    cursor.reset();
+    string chunk_tag = encode(std::move(doclens));
+    if (!chunk_tag.empty()) table.add(make_key(chunk), chunk_tag);
+    table.add(make_marker_key(), string());
+}
+
+void
+GlassDocLenColumn::check(const GlassTable& table)
+{
+    present = table.key_exists(make_marker_key());
+    checked = true;
+}
+
+bool
+GlassDocLenColumn::read(Xapian::docid did, Xapian::termcount& doclen) const
+{
+    if (tag.empty()) return false;
+    auto p = reinterpret_cast<const unsigned char*>(tag.data());
+    unsigned width = *p++ / 8;
+    size_t offset = size_t(did % CHUNK_DOCS) * width;
+    if (offset >= tag.size() - 1) return false;
+    p += offset;
+    uint32_t v = 0;
+    for (unsigned j = 0; j != width; ++j) {
+	v = (v << 8) | *p++;
+    }
+    if (v == missing_value(width)) return false;
+    doclen = v;
+    return true;
+}
+
+bool
+GlassDocLenColumn::get(const GlassTable& table, Xapian::docid did,
+		       Xapian::termcount& doclen)
+{
+    Assert(present);
+    Xapian::docid chunk = did / CHUNK_DOCS;
+    if (chunk != tag_chunk) {
+	tag_chunk = Xapian::docid(-1);
+	if (table.get_exact_entry(make_key(chunk), tag)) {
+	    unsigned width = 0;
+	    if (!tag.empty()) width = static_cast<unsigned char>(tag[0]);
+	    if (((width - 8) &~ 0x18) != 0 || (tag.size() - 1) % (width / 8)) {
+		throw Xapian::DatabaseCorruptError("Bad doclen column chunk");
+	    }
+	} else {
+	    tag.resize(0);
+	}
+	tag_chunk = chunk;
+    }
+    return read(did, doclen);
+}
+
+void
+GlassDocLenColumn::update(GlassTable& table,
+			  const map<Xapian::docid, Xapian::termcount>& doclens)
+{
+    Assert(present);
+    tag_chunk = Xapian::docid(-1);
+    vector<Xapian::termcount> entries;
+    auto i = doclens.begin();
+    while (i != doclens.end()) {
+	Xapian::docid chunk = i->first / CHUNK_DOCS;
+	string key = make_key(chunk);
+	string chunk_tag;
+	if (table.get_exact_entry(key, chunk_tag)) {
+	    if (!decode(chunk_tag, entries)) {
+		throw Xapian::DatabaseCorruptError("Bad doclen column chunk");
+	    }
+	} else {
+	    entries.clear();
+	}
+	do {
+	    size_t j = i->first % CHUNK_DOCS;
+	    if (entries.size() <= j) entries.resize(j + 1, NO_DOC);
+	    entries[j] = i->second;
+	    ++i;
+	} while (i != doclens.end() && i->first / CHUNK_DOCS == chunk);
+
+	chunk_tag = encode(std::move(entries));
+	if (chunk_tag.empty()) {
+	    table.del(key);
+	} else {
+	    table.add(key, chunk_tag);
+	}
+    }
+}
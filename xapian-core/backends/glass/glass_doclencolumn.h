@@ -0,0 +1,145 @@
+/** @file glass_doclencolumn.h
+ * @brief Dense array of document lengths in a glass database
+ */
+/* Copyright (C) 2026 Xapian contributors
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301 USA
+ */
+
+#ifndef XAPIAN_INCLUDED_GLASS_DOCLENCOLUMN_H
+#define XAPIAN_INCLUDED_GLASS_DOCLENCOLUMN_H
+
+#include "xapian/types.h"
+
+#include <map>
+#include <string>
+#include <vector>
+
+class GlassTable;
+
+/** A dense array of document lengths indexed by document ID.
+ *
+ *  The document lengths are always stored as a posting list, but looking
+ *  one up means finding the right chunk of that and then decoding entries
+ *  from the start of the chunk.  If a database has this column too (see
+ *  Xapian::DB_DOCLEN_COLUMN), a document length can be read directly.
+ *
+ *  The column is stored in the postlist table, split into chunks covering
+ *  CHUNK_DOCS document IDs each, so the key for a document's chunk can be
+ *  calculated from its ID.  Like honey's document length chunks, each chunk
+ *  starts with a byte giving the width in bits of the entries (8, 16, 24 or
+ *  32 - the smallest which can hold every length in the chunk), followed by
+ *  one big-endian entry per document ID, with all bits set for an unused
+ *  document ID.  Unused document IDs at the end of a chunk aren't stored,
+ *  and chunks with none in use aren't stored at all.
+ *
+ *  An entry with an empty tag marks that the column is present.
+ */
+class GlassDocLenColumn {
+    /// Have we checked whether the table has the column?
+    bool checked = false;
+
+    /// Does the table have the column?
+    bool present = false;
+
+    /// The chunk which @a tag holds, or -1 if none.
+    Xapian::docid tag_chunk = Xapian::docid(-1);
+
+    /// The current contents of chunk @a tag_chunk (empty if not stored).
+    std::string tag;
+
+    /// Look up @a did in @a tag.
+    bool read(Xapian::docid did, Xapian::termcount& doclen) const;
+
+  public:
+    /// The number of document IDs covered by each chunk.
+    static constexpr Xapian::docid CHUNK_DOCS = 2048;
+
+    /// Return the postlist table key for chunk @a chunk.
+    static std::string make_key(Xapian::docid chunk);
+
+    /// Return the key of the entry which marks the column as present.
+    static std::string make_marker_key() {
+	return std::string("\0\xe8", 2);
+    }
+
+    /// Is @a key the key of the marker or of a chunk of the column?
+    static bool is_key(const std::string& key) {
+	return key.size() > 1 && key[0] == '\0' && key[1] == '\xe8';
+    }
+
+    /** Decode a chunk.
+     *
+     *  @param chunk_tag	The tag of the chunk.
+     *  @param doclens		Set to the entries in the chunk, with
+     *				Xapian::termcount(-1) for unused document IDs.
+     *
+     *  @return false if @a chunk_tag isn't a valid chunk.
+     */
+    static bool decode(const std::string& chunk_tag,
+		       std::vector<Xapian::termcount>& doclens);
+
+    /** Encode a chunk.
+     *
+     *  @param doclens	The entries, as returned by decode().
+     *
+     *  @return The tag for the chunk, which is empty if there are no used
+     *		document IDs in it.
+     */
+    static std::string encode(std::vector<Xapian::termcount> doclens);
+
+    /** Write the column to @a table, replacing any existing column.
+     *
+     *  The document lengths are read from the document length posting list
+     *  in @a table.
+     */
+    static void build(GlassTable& table);
+
+    /// Forget cached data so it gets read again.
+    void reset() {
+	checked = false;
+	present = false;
+	tag_chunk = Xapian::docid(-1);
+	tag.resize(0);
+    }
+
+    /// Does @a table have the column?
+    bool exists(const GlassTable& table) {
+	if (!checked) check(table);
+	return present;
+    }
+
+    /// Check whether @a table has the column.
+    void check(const GlassTable& table);
+
+    /** Look up the length of document @a did.
+     *
+     *  Only call this if exists() returns true.
+     *
+     *  @return false if document @a did doesn't exist.
+     */
+    bool get(const GlassTable& table, Xapian::docid did,
+	     Xapian::termcount& doclen);
+
+    /** Apply changes to document lengths.
+     *
+     *  @param doclens	The new length for each changed document, or
+     *			Xapian::termcount(-1) if the document was deleted.
+     */
+    void update(GlassTable& table,
+		const std::map<Xapian::docid, Xapian::termcount>& doclens);
+};
+
+#endif // XAPIAN_INCLUDED_GLASS_DOCLENCOLUMN_H
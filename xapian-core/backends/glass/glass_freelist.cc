@@ -232,8 +232,15 @@ GlassFreeList::mark_block_unused(const GlassTable * B, uint4 block_size, uint4 b
 }
 
 void
-GlassFreeList::commit(const GlassTable * B, uint4 block_size)
+GlassFreeList::commit(const GlassTable * B, uint4 block_size,
+		      bool defer_reuse)
 {
+    if (fl_end_deferred) {
+	// The previous revision must be on disk by now, so blocks freed in it
+	// can be reused.
+	fl_end = fl_end_next;
+	fl_end_deferred = false;
+    }
     if (pw && flw.c != 0) {
 	memset(pw + flw.c, 255, FREELIST_END - flw.c - 4);
 #ifdef GLASS_FREELIST_SIZE
@@ -248,7 +255,12 @@ GlassFreeList::commit(const GlassTable * B, uint4 block_size)
 	    Assert(fl.n == fl_end.n || aligned_read4(p + FREELIST_END - 4) != UNUSED);
 	}
 	flw_appending = true;
-	fl_end = flw;
+	if (defer_reuse) {
+	    fl_end_next = flw;
+	    fl_end_deferred = true;
+	} else {
+	    fl_end = flw;
+	}
     }
 }
 
@@ -81,6 +81,15 @@ class GlassFreeList {
 
     bool flw_appending;
 
+    /** Where fl_end moves to once the pending revision is on disk.
+     *
+     *  Only meaningful if fl_end_deferred is true.
+     */
+    GlassFLCursor fl_end_next;
+
+    /// Is the move of fl_end to fl_end_next still to happen?
+    bool fl_end_deferred;
+
   private:
     /// Current freelist block.
     uint8_t * p;
@@ -93,6 +102,7 @@ class GlassFreeList {
 	revision = 0;
 	first_unused_block = 0;
 	flw_appending = false;
+	fl_end_deferred = false;
 	p = pw = NULL;
     }
 
@@ -100,6 +110,7 @@ class GlassFreeList {
 	revision = 0;
 	first_unused_block = 0;
 	flw_appending = false;
+	fl_end_deferred = false;
     }
 
     ~GlassFreeList() { delete [] p; delete [] pw; }
@@ -121,7 +132,16 @@ class GlassFreeList {
     // Used when compacting to a single file.
     void set_first_unused_block(uint4 base) { first_unused_block = base; }
 
-    void commit(const GlassTable * B, uint4 block_size);
+    /** Write out the freelist for the revision being committed.
+     *
+     *  @param defer_reuse  If true, the new revision won't be synced to disk
+     *			    before the next revision starts to be written, so
+     *			    blocks freed in it are still used by the revision
+     *			    on disk.  They're only made available for reuse by
+     *			    the commit after this one.
+     */
+    void commit(const GlassTable * B, uint4 block_size,
+		bool defer_reuse = false);
 
     void pack(std::string & buf) {
 	pack_uint(buf, revision);
@@ -138,6 +158,7 @@ class GlassFreeList {
 	if (r) {
 	    fl_end = flw;
 	    flw_appending = false;
+	    fl_end_deferred = false;
 	}
 	return r;
     }
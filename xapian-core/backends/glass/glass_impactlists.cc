@@ -0,0 +1,185 @@
+/** @file glass_impactlists.cc
+ * @brief Impact-ordered posting lists in a glass database
+ */
+/* Copyright (C) 2026 Xapian contributors
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301 USA
+ */
+
+#include <config.h>
+
+#include "glass_impactlists.h"
+
+#include "backends/impactlist.h"
+#include "glass_cursor.h"
+#include "glass_table.h"
+#include "pack.h"
+#include "stringutils.h"
+
+#include "xapian/error.h"
+#include "xapian/weight.h"
+
+#include <memory>
+#include <utility>
+#include <vector>
+
+using namespace std;
+
+/** Call @a action(did, wdf) for each posting in a posting list.
+ *
+ *  @param term	The term, or an empty string for the document length list
+ *		(in which case the "wdf" is the document length).
+ */
+template<typename Action>
+static void
+for_each_posting(const GlassTable& table, const string& term, Action action)
+{
+    unique_ptr<GlassCursor> cursor(table.cursor_get());
+    if (!cursor || !cursor->find_entry(pack_glass_postlist_key(term))) return;
+    // Keys of the chunks after the first are this followed by the first
+    // docid in the chunk.
+    string chunk_prefix;
+    if (term.empty()) {
+	chunk_prefix.assign("\0\xe0", 2);
+    } else {
+	pack_string_preserving_sort(chunk_prefix, term);
+    }
+
+    cursor->read_tag();
+    const char* p = cursor->current_tag.data();
+    const char* end = p + cursor->current_tag.size();
+    Xapian::doccount tf;
+    Xapian::termcount cf;
+    Xapian::docid did;
+    if (!unpack_uint(&p, end, &tf) ||
+	!unpack_uint(&p, end, &cf) ||
+	!unpack_uint(&p, end, &did)) {
+	throw Xapian::DatabaseCorruptError("Bad postlist chunk");
+    }
+    ++did;
+    while (true) {
+	bool is_last;
+	Xapian::docid increase_to_last;
+	Xapian::termcount wdf;
+	if (!unpack_bool(&p, end, &is_last) ||
+	    !unpack_uint(&p, end, &increase_to_last)) {
+	    throw Xapian::DatabaseCorruptError("Bad postlist chunk");
+	}
+	// An empty document length list may just have a dummy first chunk.
+	if (p == end && is_last) break;
+	if (!unpack_uint(&p, end, &wdf)) {
+	    throw Xapian::DatabaseCorruptError("Bad postlist chunk");
+	}
+	while (true) {
+	    action(did, wdf);
+	    if (p == end) break;
+	    Xapian::docid inc;
+	    if (!unpack_uint(&p, end, &inc) || !unpack_uint(&p, end, &wdf)) {
+		throw Xapian::DatabaseCorruptError("Bad postlist chunk");
+	    }
+	    did += inc + 1;
+	}
+	if (is_last) break;
+
+	if (!cursor->next() ||
+	    !startswith(cursor->current_key, chunk_prefix)) {
+	    throw Xapian::DatabaseCorruptError("Unexpected end of posting "
+					       "list");
+	}
+	const string& key = cursor->current_key;
+	p = key.data() + chunk_prefix.size();
+	end = key.data() + key.size();
+	if (!unpack_uint_preserving_sort(&p, end, &did) || p != end) {
+	    throw Xapian::DatabaseCorruptError("Bad postlist chunk key");
+	}
+	cursor->read_tag();
+	p = cursor->current_tag.data();
+	end = p + cursor->current_tag.size();
+    }
+}
+
+void
+GlassImpactLists::build_all(GlassTable& table,
+			    Xapian::doccount doccount,
+			    Xapian::totallength total_length)
+{
+    string params = Xapian::BM25Weight().serialise();
+    ImpactParams bm25;
+    (void)bm25.unserialise_bm25(params);
+    double len_factor = 0.0;
+    if (total_length != 0) len_factor = double(doccount) / total_length;
+
+    vector<Xapian::termcount> doclens;
+    for_each_posting(table, string(),
+		     [&](Xapian::docid did, Xapian::termcount doclen) {
+			 if (doclens.size() <= did) doclens.resize(did + 1);
+			 doclens[did] = doclen;
+		     });
+
+    // Find the terms from the keys of the first chunk of each posting list.
+    vector<string> terms;
+    {
+	unique_ptr<GlassCursor> cursor(table.cursor_get());
+	if (cursor) {
+	    cursor->rewind();
+	    while (cursor->next()) {
+		const string& key = cursor->current_key;
+		// Keys starting with a zero byte are special, except for terms
+		// which start with one (which are encoded as \0\xff).
+		if (key[0] == '\0' && key[1] != '\xff') continue;
+		const char* p = key.data();
+		const char* end = p + key.size();
+		string term;
+		(void)unpack_string_preserving_sort(&p, end, term);
+		// Only the key of the first chunk ends with the term.
+		if (p == end) terms.push_back(std::move(term));
+	    }
+	}
+    }
+
+    vector<pair<unsigned, Xapian::docid>> postings;
+    for (auto& term : terms) {
+	postings.clear();
+	for_each_posting(table, term,
+			 [&](Xapian::docid did, Xapian::termcount wdf) {
+			     Xapian::termcount len = 0;
+			     if (did < doclens.size()) len = doclens[did];
+			     double f = bm25.doc_factor(wdf, len, len_factor);
+			     postings.emplace_back(ImpactParams::quantise(f),
+						   did);
+			 });
+	string tag;
+	encode_impact_list(tag, postings);
+	table.add(make_key(term), tag);
+    }
+    table.add(make_marker_key(), params);
+}
+
+void
+GlassImpactLists::mark_stale(GlassTable& table)
+{
+    if (!is_current(table)) return;
+    table.add(make_marker_key(), string());
+    stale = true;
+    params.resize(0);
+}
+
+void
+GlassImpactLists::check(const GlassTable& table)
+{
+    present = table.get_exact_entry(make_marker_key(), params);
+    stale = present && params.empty();
+    checked = true;
+}
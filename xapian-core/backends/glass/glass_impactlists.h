@@ -0,0 +1,125 @@
+/** @file glass_impactlists.h
+ * @brief Impact-ordered posting lists in a glass database
+ */
+/* Copyright (C) 2026 Xapian contributors
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301 USA
+ */
+
+#ifndef XAPIAN_INCLUDED_GLASS_IMPACTLISTS_H
+#define XAPIAN_INCLUDED_GLASS_IMPACTLISTS_H
+
+#include "xapian/types.h"
+
+#include <string>
+
+class GlassTable;
+
+/** Impact-ordered posting lists.
+ *
+ *  If a database has these (see Xapian::DBCOMPACT_IMPACT_ORDERED), then as
+ *  well as its posting list, each term has a copy of its postings grouped by
+ *  their BM25 impact (see encode_impact_list()), which the matcher can use to
+ *  run a match score-at-a-time.
+ *
+ *  The impacts depend on the average document length, so they're only built
+ *  by compaction.  When changes are next flushed to the database, the lists
+ *  are marked as stale rather than removed (which would mean rewriting every
+ *  term's entry), and they're then ignored until the database is next
+ *  compacted.
+ *
+ *  Each term's list is stored in the postlist table keyed by the marker key
+ *  followed by the term.  The entry with the marker key marks that the
+ *  database has impact lists, and its tag is the serialised BM25Weight the
+ *  impacts were calculated for, or empty if the lists are stale.
+ */
+class GlassImpactLists {
+    /// Have we checked whether the table has impact lists?
+    bool checked = false;
+
+    /// Does the table have impact lists?
+    bool present = false;
+
+    /// Are the impact lists out of date?
+    bool stale = false;
+
+    /// The serialised BM25Weight the impacts were calculated for.
+    std::string params;
+
+  public:
+    /// Return the key of the entry which marks impact lists as present.
+    static std::string make_marker_key() {
+	return std::string("\0\xc8", 2);
+    }
+
+    /// Return the postlist table key for the impact list of @a term.
+    static std::string make_key(const std::string& term) {
+	return make_marker_key() + term;
+    }
+
+    /// Is @a key the key of the marker or of an impact list?
+    static bool is_key(const std::string& key) {
+	return key.size() > 1 && key[0] == '\0' && key[1] == '\xc8';
+    }
+
+    /** Write impact lists for every term in @a table.
+     *
+     *  @a table mustn't already have impact lists.
+     *
+     *  @param doccount		The number of documents.
+     *  @param total_length	The total length of all the documents.
+     */
+    static void build_all(GlassTable& table,
+			  Xapian::doccount doccount,
+			  Xapian::totallength total_length);
+
+    /** Mark the impact lists in @a table as stale.
+     *
+     *  Does nothing if @a table doesn't have impact lists or they're
+     *  already stale.
+     */
+    void mark_stale(GlassTable& table);
+
+    /// Forget cached data so it gets read again.
+    void reset() {
+	checked = false;
+	present = false;
+	stale = false;
+	params.resize(0);
+    }
+
+    /// Does @a table have impact lists (which may be stale)?
+    bool exists(const GlassTable& table) {
+	if (!checked) check(table);
+	return present;
+    }
+
+    /// Does @a table have impact lists which aren't stale?
+    bool is_current(const GlassTable& table) {
+	if (!checked) check(table);
+	return present && !stale;
+    }
+
+    /// Check whether @a table has impact lists.
+    void check(const GlassTable& table);
+
+    /** Return the serialised BM25Weight the impacts were calculated for.
+     *
+     *  Only call this if is_current() returns true.
+     */
+    const std::string& get_params() const { return params; }
+};
+
+#endif // XAPIAN_INCLUDED_GLASS_IMPACTLISTS_H
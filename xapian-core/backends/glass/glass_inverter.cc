@@ -26,12 +26,54 @@
 #include "glass_positionlist.h"
 
 #include "api/termlist.h"
+#include "stringutils.h"
 
+#include <algorithm>
 #include <map>
 #include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
 
 using namespace std;
 
+/// Bytes used by a pos_changes entry, excluding its docid map's nodes.
+static inline size_t
+pos_term_overhead()
+{
+    return sizeof(pair<const string, map<Xapian::docid, string>>);
+}
+
+/// Bytes used by an entry in a pos_changes docid map, excluding its string.
+static inline size_t
+pos_entry_overhead()
+{
+    return sizeof(pair<const Xapian::docid, string>);
+}
+
+void
+Inverter::PostingChanges::sort_changes()
+{
+    if (sorted)
+	return;
+    // Keep the most recent change for each docid - they were appended in
+    // order, so a stable sort puts the most recent last in each run.
+    stable_sort(pl_changes.begin(), pl_changes.end(),
+		[](const pair<Xapian::docid, Xapian::termcount>& a,
+		   const pair<Xapian::docid, Xapian::termcount>& b) {
+		    return a.first < b.first;
+		});
+    auto out = pl_changes.begin();
+    for (auto i = pl_changes.begin(); i != pl_changes.end(); ++i) {
+	auto next = i + 1;
+	if (next != pl_changes.end() && next->first == i->first)
+	    continue;
+	*out++ = *i;
+    }
+    pl_changes.erase(out, pl_changes.end());
+    sorted = true;
+}
+
 void
 Inverter::store_positions(const GlassPositionListTable & position_table,
 			  Xapian::docid did,
@@ -48,7 +90,9 @@ Inverter::store_positions(const GlassPositionListTable & position_table,
 	    auto j = m.find(did);
 	    if (j != m.end()) {
 		// Update existing entry.
+		pos_memory -= string_memory(j->second);
 		swap(j->second, s);
+		pos_memory += string_memory(j->second);
 		return;
 	    }
 	}
@@ -59,7 +103,7 @@ Inverter::store_positions(const GlassPositionListTable & position_table,
 	    return;
 	}
     }
-    set_positionlist(did, tname, s);
+    set_positionlist(did, tname, std::move(s));
 }
 
 void
@@ -96,10 +140,61 @@ Inverter::set_positionlist(const GlassPositionListTable & position_table,
 void
 Inverter::set_positionlist(Xapian::docid did,
 			   const string & term,
-			   const string & s)
+			   string && s)
 {
-    pos_changes.insert(make_pair(term, map<Xapian::docid, string>()))
-	.first->second[did] = s;
+    auto i = pos_changes.find(term);
+    if (i == pos_changes.end()) {
+	i = pos_changes.emplace(term, map<Xapian::docid, string>()).first;
+	pos_memory += HASH_NODE_OVERHEAD + pos_term_overhead() +
+		      string_memory(i->first);
+    }
+    auto r = i->second.emplace(did, string());
+    if (r.second) {
+	pos_memory += TREE_NODE_OVERHEAD + pos_entry_overhead();
+    } else {
+	pos_memory -= string_memory(r.first->second);
+    }
+    r.first->second = std::move(s);
+    pos_memory += string_memory(r.first->second);
+}
+
+void
+Inverter::merge(Inverter&& o)
+{
+    for (auto&& i : o.postlist_changes) {
+	auto j = postlist_changes.find(i.first);
+	if (j == postlist_changes.end()) {
+	    postlist_changes.emplace(i.first, std::move(i.second));
+	} else {
+	    // o.postlist_memory includes this entry, which we don't keep.
+	    postlist_memory -= memory_used(i.first, i.second);
+	    size_t old_memory = j->second.get_memory_used();
+	    j->second.merge(std::move(i.second));
+	    postlist_memory += j->second.get_memory_used() - old_memory;
+	}
+    }
+    postlist_memory += o.postlist_memory;
+
+    for (auto&& i : o.pos_changes) {
+	auto j = pos_changes.find(i.first);
+	if (j == pos_changes.end()) {
+	    pos_changes.emplace(i.first, std::move(i.second));
+	} else {
+	    pos_memory -= HASH_NODE_OVERHEAD + pos_term_overhead() +
+			  string_memory(i.first);
+	    map<Xapian::docid, string>& m = j->second;
+	    for (auto&& k : i.second) {
+		m.emplace_hint(m.end(), k.first, std::move(k.second));
+	    }
+	}
+    }
+    pos_memory += o.pos_memory;
+
+    for (auto&& i : o.doclen_changes) {
+	doclen_changes.insert(doclen_changes.end(), i);
+    }
+
+    o.clear();
 }
 
 void
@@ -134,9 +229,9 @@ Inverter::has_positions(const GlassPositionListTable & position_table) const
     // FIXME: Can we cheaply keep track of some things to make this more
     // efficient?  E.g. how many sets and deletes we had in total perhaps.
     glass_tablesize_t changes = 0;
-    for (auto i : pos_changes) {
+    for (auto&& i : pos_changes) {
 	const map<Xapian::docid, string>& m = i.second;
-	for (auto j : m) {
+	for (auto&& j : m) {
 	    const string & s = j.second;
 	    if (!s.empty())
 		return true;
@@ -155,26 +250,48 @@ Inverter::flush_doclengths(GlassPostListTable & table)
     doclen_changes.clear();
 }
 
+void
+Inverter::flush_post_lists(GlassPostListTable & table,
+			   vector<postlist_changes_iterator>& items)
+{
+    // Update the table in key order, which is much more efficient.
+    sort(items.begin(), items.end(),
+	 [](const postlist_changes_iterator& a,
+	    const postlist_changes_iterator& b) {
+	     return a->first < b->first;
+	 });
+    for (auto i : items) {
+	i->second.sort_changes();
+	table.merge_changes(i->first, i->second);
+	postlist_memory -= memory_used(i->first, i->second);
+	postlist_changes.erase(i);
+    }
+}
+
 void
 Inverter::flush_post_list(GlassPostListTable & table, const string & term)
 {
-    map<string, PostingChanges>::iterator i;
-    i = postlist_changes.find(term);
+    auto i = postlist_changes.find(term);
     if (i == postlist_changes.end()) return;
 
     // Flush buffered changes for just this term's postlist.
+    i->second.sort_changes();
     table.merge_changes(term, i->second);
+    postlist_memory -= memory_used(i->first, i->second);
     postlist_changes.erase(i);
 }
 
 void
 Inverter::flush_all_post_lists(GlassPostListTable & table)
 {
-    map<string, PostingChanges>::const_iterator i;
-    for (i = postlist_changes.begin(); i != postlist_changes.end(); ++i) {
-	table.merge_changes(i->first, i->second);
+    vector<postlist_changes_iterator> items;
+    items.reserve(postlist_changes.size());
+    for (auto i = postlist_changes.begin(); i != postlist_changes.end(); ++i) {
+	items.push_back(i);
     }
+    flush_post_lists(table, items);
     postlist_changes.clear();
+    postlist_memory = 0;
 }
 
 void
@@ -183,29 +300,12 @@ Inverter::flush_post_lists(GlassPostListTable & table, const string & pfx)
     if (pfx.empty())
 	return flush_all_post_lists(table);
 
-    map<string, PostingChanges>::iterator i, begin, end;
-    begin = postlist_changes.lower_bound(pfx);
-    string pfxinc = pfx;
-    while (true) {
-	if (pfxinc.back() != '\xff') {
-	    ++pfxinc.back();
-	    end = postlist_changes.lower_bound(pfxinc);
-	    break;
-	}
-	pfxinc.resize(pfxinc.size() - 1);
-	if (pfxinc.empty()) {
-	    end = postlist_changes.end();
-	    break;
-	}
-    }
-
-    for (i = begin; i != end; ++i) {
-	table.merge_changes(i->first, i->second);
+    vector<postlist_changes_iterator> items;
+    for (auto i = postlist_changes.begin(); i != postlist_changes.end(); ++i) {
+	if (startswith(i->first, pfx))
+	    items.push_back(i);
     }
-
-    // Erase all the entries in one go, as that's:
-    //  O(log(postlist_changes.size()) + O(number of elements removed)
-    postlist_changes.erase(begin, end);
+    flush_post_lists(table, items);
 }
 
 void
@@ -218,10 +318,20 @@ Inverter::flush(GlassPostListTable & table)
 void
 Inverter::flush_pos_lists(GlassPositionListTable & table)
 {
-    for (auto i : pos_changes) {
-	const string & term = i.first;
-	const map<Xapian::docid, string> & m = i.second;
-	for (auto j : m) {
+    vector<decltype(pos_changes)::const_iterator> items;
+    items.reserve(pos_changes.size());
+    for (auto i = pos_changes.cbegin(); i != pos_changes.cend(); ++i) {
+	items.push_back(i);
+    }
+    sort(items.begin(), items.end(),
+	 [](const decltype(pos_changes)::const_iterator& a,
+	    const decltype(pos_changes)::const_iterator& b) {
+	     return a->first < b->first;
+	 });
+    for (auto i : items) {
+	const string & term = i->first;
+	const map<Xapian::docid, string> & m = i->second;
+	for (auto&& j : m) {
 	    Xapian::docid did = j.first;
 	    const string & s = j.second;
 	    if (!s.empty())
@@ -231,4 +341,5 @@ Inverter::flush_pos_lists(GlassPositionListTable & table)
 	}
     }
     pos_changes.clear();
+    pos_memory = 0;
 }
@@ -27,6 +27,8 @@
 
 #include <map>
 #include <string>
+#include <unordered_map>
+#include <utility>
 #include <vector>
 
 #include "omassert.h"
@@ -43,7 +45,13 @@ class TermIterator;
 /** Magic wdf value used for a deleted posting. */
 const Xapian::termcount DELETED_POSTING = Xapian::termcount(-1);
 
-/** Class which "inverts the file". */
+/** Class which "inverts the file".
+ *
+ *  Changes are buffered in hash tables, which are only put into key order
+ *  when they're flushed, and the number of bytes of memory used to buffer
+ *  them is tracked so that the caller can flush once a memory budget is
+ *  reached.
+ */
 class Inverter {
     friend class GlassPostListTable;
 
@@ -57,22 +65,43 @@ class Inverter {
 	/// Change in collection frequency.
 	Xapian::termcount_diff cf_delta;
 
-	/// Changes to this term's postlist.
-	std::map<Xapian::docid, Xapian::termcount> pl_changes;
+	/** Changes to this term's postlist.
+	 *
+	 *  Changes are appended, so this is only in docid order (with one
+	 *  entry per docid) if @a sorted is true - sort_changes() ensures
+	 *  that.
+	 */
+	std::vector<std::pair<Xapian::docid, Xapian::termcount>> pl_changes;
+
+	/// Is @a pl_changes in ascending docid order without duplicates?
+	bool sorted = true;
+
+	void set_change(Xapian::docid did, Xapian::termcount wdf) {
+	    if (!pl_changes.empty()) {
+		Xapian::docid last = pl_changes.back().first;
+		if (did == last) {
+		    pl_changes.back().second = wdf;
+		    return;
+		}
+		if (did < last)
+		    sorted = false;
+	    }
+	    pl_changes.emplace_back(did, wdf);
+	}
 
       public:
 	/// Constructor for an added posting.
 	PostingChanges(Xapian::docid did, Xapian::termcount wdf)
 	    : tf_delta(1), cf_delta(Xapian::termcount_diff(wdf))
 	{
-	    pl_changes.insert(std::make_pair(did, wdf));
+	    pl_changes.emplace_back(did, wdf);
 	}
 
 	/// Constructor for a removed posting.
 	PostingChanges(Xapian::docid did, Xapian::termcount wdf, bool)
 	    : tf_delta(-1), cf_delta(-Xapian::termcount_diff(wdf))
 	{
-	    pl_changes.insert(std::make_pair(did, DELETED_POSTING));
+	    pl_changes.emplace_back(did, DELETED_POSTING);
 	}
 
 	/// Constructor for an updated posting.
@@ -80,7 +109,7 @@ class Inverter {
 		       Xapian::termcount new_wdf)
 	    : tf_delta(0), cf_delta(Xapian::termcount_diff(new_wdf - old_wdf))
 	{
-	    pl_changes.insert(std::make_pair(did, new_wdf));
+	    pl_changes.emplace_back(did, new_wdf);
 	}
 
 	/// Add a posting.
@@ -88,7 +117,7 @@ class Inverter {
 	    ++tf_delta;
 	    cf_delta += wdf;
 	    // Add did to term's postlist
-	    pl_changes[did] = wdf;
+	    set_change(did, wdf);
 	}
 
 	/// Remove a posting.
@@ -96,28 +125,99 @@ class Inverter {
 	    --tf_delta;
 	    cf_delta -= wdf;
 	    // Remove did from term's postlist.
-	    pl_changes[did] = DELETED_POSTING;
+	    set_change(did, DELETED_POSTING);
 	}
 
 	/// Update a posting.
 	void update_posting(Xapian::docid did, Xapian::termcount old_wdf,
 			    Xapian::termcount new_wdf) {
 	    cf_delta += new_wdf - old_wdf;
-	    pl_changes[did] = new_wdf;
+	    set_change(did, new_wdf);
 	}
 
+	/** Merge in changes from another PostingChanges object.
+	 *
+	 *  @a o must only contain changes for documents which this object
+	 *  has no changes for.
+	 */
+	void merge(PostingChanges&& o) {
+	    tf_delta += o.tf_delta;
+	    cf_delta += o.cf_delta;
+	    if (!o.sorted ||
+		(!pl_changes.empty() &&
+		 o.pl_changes.front().first < pl_changes.back().first)) {
+		sorted = false;
+	    }
+	    pl_changes.insert(pl_changes.end(),
+			      o.pl_changes.begin(), o.pl_changes.end());
+	}
+
+	/** Put the changes into docid order.
+	 *
+	 *  Where there are several changes for the same docid, the most
+	 *  recent one is kept.
+	 */
+	void sort_changes();
+
 	/// Get the term frequency delta.
 	Xapian::termcount_diff get_tfdelta() const { return tf_delta; }
 
 	/// Get the collection frequency delta.
 	Xapian::termcount_diff get_cfdelta() const { return cf_delta; }
+
+	/// Bytes of memory used by the changes (excluding this object).
+	size_t get_memory_used() const {
+	    return pl_changes.capacity() * sizeof(pl_changes[0]);
+	}
     };
 
     /// Buffered changes to postlists.
-    std::map<std::string, PostingChanges> postlist_changes;
+    std::unordered_map<std::string, PostingChanges> postlist_changes;
+
+    /** Buffered changes to positional data.
+     *
+     *  An empty string means the entry is to be deleted.
+     */
+    std::unordered_map<std::string,
+		       std::map<Xapian::docid, std::string>> pos_changes;
+
+    /// Bytes of memory used by @a postlist_changes.
+    size_t postlist_memory = 0;
+
+    /// Bytes of memory used by @a pos_changes.
+    size_t pos_memory = 0;
+
+    /// Bytes of memory used by an entry in @a postlist_changes.
+    static size_t memory_used(const std::string& term,
+			      const PostingChanges& changes) {
+	return HASH_NODE_OVERHEAD +
+	       sizeof(std::pair<const std::string, PostingChanges>) +
+	       string_memory(term) + changes.get_memory_used();
+    }
+
+    /// Bytes of memory used by a string's buffer (if not stored inline).
+    static size_t string_memory(const std::string& s) {
+	return s.capacity() > std::string().capacity() ? s.capacity() + 1 : 0;
+    }
+
+    /// Estimated bookkeeping overhead per unordered_map node.
+    static constexpr size_t HASH_NODE_OVERHEAD = 3 * sizeof(void*);
 
-    /// Buffered changes to positional data.
-    std::map<std::string, std::map<Xapian::docid, std::string>> pos_changes;
+    /// Estimated bookkeeping overhead per map node.
+    static constexpr size_t TREE_NODE_OVERHEAD = 4 * sizeof(void*);
+
+    /// Record the memory used for a new entry in @a postlist_changes.
+    void added_postlist_entry(const std::string& term,
+			      const PostingChanges& changes) {
+	postlist_memory += memory_used(term, changes);
+    }
+
+    typedef std::unordered_map<std::string, PostingChanges>::iterator
+	postlist_changes_iterator;
+
+    /// Flush and remove the postlist changes for @a items in term order.
+    void flush_post_lists(GlassPostListTable & table,
+			  std::vector<postlist_changes_iterator>& items);
 
     void store_positions(const GlassPositionListTable & position_table,
 			 Xapian::docid did,
@@ -127,7 +227,7 @@ class Inverter {
 
     void set_positionlist(Xapian::docid did,
 			  const std::string & term,
-			  const std::string & s);
+			  std::string && s);
 
   public:
     /// Buffered changes to document lengths.
@@ -136,38 +236,44 @@ class Inverter {
   public:
     void add_posting(Xapian::docid did, const std::string & term,
 		     Xapian::doccount wdf) {
-	std::map<std::string, PostingChanges>::iterator i;
-	i = postlist_changes.find(term);
+	auto i = postlist_changes.find(term);
 	if (i == postlist_changes.end()) {
-	    postlist_changes.insert(
-		std::make_pair(term, PostingChanges(did, wdf)));
+	    i = postlist_changes.emplace(term, PostingChanges(did, wdf)).first;
+	    added_postlist_entry(i->first, i->second);
 	} else {
+	    size_t old_memory = i->second.get_memory_used();
 	    i->second.add_posting(did, wdf);
+	    postlist_memory += i->second.get_memory_used() - old_memory;
 	}
     }
 
     void remove_posting(Xapian::docid did, const std::string & term,
 			Xapian::doccount wdf) {
-	std::map<std::string, PostingChanges>::iterator i;
-	i = postlist_changes.find(term);
+	auto i = postlist_changes.find(term);
 	if (i == postlist_changes.end()) {
-	    postlist_changes.insert(
-		std::make_pair(term, PostingChanges(did, wdf, false)));
+	    i = postlist_changes.emplace(term,
+					 PostingChanges(did, wdf, false)).first;
+	    added_postlist_entry(i->first, i->second);
 	} else {
+	    size_t old_memory = i->second.get_memory_used();
 	    i->second.remove_posting(did, wdf);
+	    postlist_memory += i->second.get_memory_used() - old_memory;
 	}
     }
 
     void update_posting(Xapian::docid did, const std::string & term,
 			Xapian::termcount old_wdf,
 			Xapian::termcount new_wdf) {
-	std::map<std::string, PostingChanges>::iterator i;
-	i = postlist_changes.find(term);
+	auto i = postlist_changes.find(term);
 	if (i == postlist_changes.end()) {
-	    postlist_changes.insert(
-		std::make_pair(term, PostingChanges(did, old_wdf, new_wdf)));
+	    i = postlist_changes.emplace(term,
+					 PostingChanges(did, old_wdf,
+							new_wdf)).first;
+	    added_postlist_entry(i->first, i->second);
 	} else {
+	    size_t old_memory = i->second.get_memory_used();
 	    i->second.update_posting(did, old_wdf, new_wdf);
+	    postlist_memory += i->second.get_memory_used() - old_memory;
 	}
     }
 
@@ -177,6 +283,18 @@ class Inverter {
 			  const Xapian::TermIterator & term,
 			  bool modifying = false);
 
+    /** Set the positions for a term in a new document.
+     *
+     *  Nothing is stored if @a posvec is empty.
+     */
+    void set_positionlist(const GlassPositionListTable & position_table,
+			  Xapian::docid did,
+			  const std::string & tname,
+			  const Xapian::VecCOW<Xapian::termpos> & posvec) {
+	if (!posvec.empty())
+	    store_positions(position_table, did, tname, posvec, false);
+    }
+
     void delete_positionlist(Xapian::docid did,
 			     const std::string & term);
 
@@ -186,10 +304,33 @@ class Inverter {
 
     bool has_positions(const GlassPositionListTable & position_table) const;
 
+    /** Merge in the changes from another Inverter.
+     *
+     *  This allows documents to be inverted in parallel into separate
+     *  Inverter objects.  @a o must only contain changes for documents which
+     *  this object has no changes for, and is left in an unspecified state.
+     */
+    void merge(Inverter&& o);
+
     void clear() {
 	doclen_changes.clear();
 	postlist_changes.clear();
 	pos_changes.clear();
+	postlist_memory = 0;
+	pos_memory = 0;
+    }
+
+    /** Return an estimate of the bytes of memory used by buffered changes.
+     *
+     *  This counts the postings, positional data, document lengths and
+     *  terms held, plus an allowance for the bookkeeping overhead of each
+     *  entry.
+     */
+    size_t get_memory_used() const {
+	return postlist_memory + pos_memory +
+	       doclen_changes.size() *
+	       (TREE_NODE_OVERHEAD +
+		sizeof(std::pair<const Xapian::docid, Xapian::termcount>));
     }
 
     void set_doclength(Xapian::docid did, Xapian::termcount doclen, bool add) {
@@ -236,8 +377,7 @@ class Inverter {
     bool get_deltas(const std::string & term,
 		    Xapian::termcount_diff & tf_delta,
 		    Xapian::termcount_diff & cf_delta) const {
-	std::map<std::string, PostingChanges>::const_iterator i;
-	i = postlist_changes.find(term);
+	auto i = postlist_changes.find(term);
 	if (i == postlist_changes.end()) {
 	    return false;
 	}
@@ -28,6 +28,7 @@
 #include "bitstream.h"
 #include "debuglog.h"
 #include "pack.h"
+#include "packedpositions.h"
 
 #include <string>
 
@@ -43,6 +44,10 @@ GlassPositionListTable::pack(string & s,
     pack_uint(s, vec.back());
 
     if (vec.size() > 1) {
+	if (is_packed()) {
+	    encode_packed_positions(s, vec);
+	    return;
+	}
 	BitWriter wr(s);
 	wr.encode(vec[0], vec.back());
 	wr.encode(vec.size() - 2, vec.back() - vec[0]);
@@ -69,6 +74,14 @@ GlassPositionListTable::positionlist_count(const string& data) const
 	RETURN(1);
     }
 
+    if (is_packed()) {
+	Xapian::termcount pos_size;
+	if (!unpack_uint(&pos, end, &pos_size)) {
+	    throw Xapian::DatabaseCorruptError("Position list data corrupt");
+	}
+	RETURN(pos_size + 2);
+    }
+
     // Skip the header we just read.
     BitReader rd(pos, end);
     Xapian::termpos pos_first = rd.decode(pos_last);
@@ -121,10 +134,16 @@ GlassBasePositionList::set_data(const string& data)
 	return;
     }
 
-    rd.init(pos, end);
-    Xapian::termpos pos_first = rd.decode(pos_last);
-    Xapian::termpos pos_size = rd.decode(pos_last - pos_first) + 2;
-    rd.decode_interpolative(0, pos_size - 1, pos_first, pos_last);
+    Xapian::termpos pos_first;
+    Xapian::termcount pos_size;
+    if (packed) {
+	pos_size = packed_rd.init(pos, end, pos_first);
+    } else {
+	rd.init(pos, end);
+	pos_first = rd.decode(pos_last);
+	pos_size = rd.decode(pos_last - pos_first) + 2;
+	rd.decode_interpolative(0, pos_size - 1, pos_first, pos_last);
+    }
     size = pos_size;
     last = pos_last;
     current_pos = pos_first;
@@ -163,7 +182,11 @@ GlassBasePositionList::next()
     if (current_pos == last) {
 	return false;
     }
-    current_pos = rd.decode_interpolative_next();
+    if (packed) {
+	current_pos = packed_rd.next();
+    } else {
+	current_pos = rd.decode_interpolative_next();
+    }
     return true;
 }
 
@@ -179,6 +202,11 @@ GlassBasePositionList::skip_to(Xapian::termpos termpos)
 	}
 	return false;
     }
+    if (packed) {
+	// The blocks record where they end, so we can skip whole blocks.
+	if (current_pos < termpos) current_pos = packed_rd.skip_to(termpos);
+	return true;
+    }
     while (current_pos < termpos) {
 	if (current_pos == last) {
 	    return false;
@@ -188,18 +216,20 @@ GlassBasePositionList::skip_to(Xapian::termpos termpos)
     return true;
 }
 
-GlassPositionList::GlassPositionList(string&& data)
+GlassPositionList::GlassPositionList(string&& data, bool packed_)
+    : GlassBasePositionList(packed_)
 {
-    LOGCALL_CTOR(DB, "GlassPositionList", data);
+    LOGCALL_CTOR(DB, "GlassPositionList", data | packed_);
 
     pos_data = std::move(data);
 
     set_data(pos_data);
 }
 
-GlassPositionList::GlassPositionList(const GlassTable* table,
+GlassPositionList::GlassPositionList(const GlassPositionListTable* table,
 				     Xapian::docid did,
 				     const string& term)
+    : GlassBasePositionList(table->is_packed())
 {
     LOGCALL_CTOR(DB, "GlassPositionList", table | did | term);
 
@@ -28,6 +28,7 @@
 #include "glass_cursor.h"
 #include "glass_lazytable.h"
 #include "pack.h"
+#include "packedpositions.h"
 #include "backends/positionlist.h"
 
 #include <string>
@@ -58,11 +59,16 @@ class GlassPositionListTable : public GlassLazyTable {
 	: GlassLazyTable("position", fd, offset_, readonly_) { }
 
     /** Pack a position list into a string.
+     *
+     *  The encoding used is the one recorded for the table.
      *
      *  @param s The string to append the position list data to.
      */
     void pack(string & s, const Xapian::VecCOW<Xapian::termpos> & vec) const;
 
+    /// Are entries stored in the packed encoding?
+    bool is_packed() const { return get_encoding() == POSITIONS_PACKED; }
+
     /** Set the position list for term tname in document did.
      */
     void set_positionlist(Xapian::docid did, const string & tname,
@@ -95,6 +101,12 @@ class GlassBasePositionList : public PositionList {
     /// Interpolative decoder.
     BitReader rd;
 
+    /// Decoder for the packed encoding.
+    PackedPositionReader packed_rd;
+
+    /// Is the data in the packed encoding?
+    bool packed;
+
     /// Current entry.
     Xapian::termpos current_pos;
 
@@ -115,8 +127,9 @@ class GlassBasePositionList : public PositionList {
     void set_data(const string& data);
 
   public:
-    /// Default constructor.
-    GlassBasePositionList() {}
+    /// Constructor.
+    explicit
+    GlassBasePositionList(bool packed_) : packed(packed_) {}
 
     /// Returns size of position list.
     Xapian::termcount get_approx_size() const;
@@ -149,12 +162,15 @@ class GlassPositionList : public GlassBasePositionList {
     GlassPositionList& operator=(const GlassPositionList&) = delete;
 
   public:
-    /// Construct and initialise with data.
-    explicit
-    GlassPositionList(string&& data);
+    /** Construct and initialise with data.
+     *
+     *  @param data	The positional data.
+     *  @param packed_	Is @a data in the packed encoding?
+     */
+    GlassPositionList(string&& data, bool packed_);
 
     /// Construct and initialise with data.
-    GlassPositionList(const GlassTable* table,
+    GlassPositionList(const GlassPositionListTable* table,
 		      Xapian::docid did,
 		      const string& term);
 };
@@ -173,8 +189,8 @@ class GlassRePositionList : public GlassBasePositionList {
   public:
     /// Constructor.
     explicit
-    GlassRePositionList(const GlassTable* table)
-	: cursor(table) {}
+    GlassRePositionList(const GlassPositionListTable* table)
+	: GlassBasePositionList(table->is_packed()), cursor(table) {}
 
     /** Fill list with data, and move the position to the start. */
     void assign_data(string&& data);
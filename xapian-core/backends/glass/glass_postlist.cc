@@ -25,6 +25,7 @@
 
 #include "glass_postlist.h"
 
+#include "backends/roaringbitmap.h"
 #include "glass_cursor.h"
 #include "glass_database.h"
 #include "debuglog.h"
@@ -32,6 +33,8 @@
 #include "str.h"
 #include "unicode/description_append.h"
 
+#include <algorithm>
+
 using Xapian::Internal::intrusive_ptr;
 
 // Static functions
@@ -156,7 +159,7 @@ GlassPostListTable::get_freqs(const string & term,
 {
     string key = make_key(term);
     string tag;
-    if (!get_exact_entry(key, tag)) {
+    if (!may_contain_term(term) || !get_exact_entry(key, tag)) {
 	if (termfreq_ptr)
 	    *termfreq_ptr = 0;
 	if (collfreq_ptr)
@@ -195,6 +198,12 @@ GlassPostListTable::get_freqs(const string & term,
 Xapian::termcount
 GlassPostListTable::get_doclength(Xapian::docid did,
 				  intrusive_ptr<const GlassDatabase> db) const {
+    if (doclen_column.exists(*this)) {
+	Xapian::termcount doclen;
+	if (!doclen_column.get(*this, did, doclen))
+	    throw Xapian::DocNotFoundError("Document " + str(did) + " not found");
+	return doclen;
+    }
     if (!doclen_pl.get()) {
 	// Don't keep a reference back to the database, since this
 	// would make a reference loop.
@@ -209,6 +218,10 @@ bool
 GlassPostListTable::document_exists(Xapian::docid did,
 				    intrusive_ptr<const GlassDatabase> db) const
 {
+    if (doclen_column.exists(*this)) {
+	Xapian::termcount doclen;
+	return doclen_column.get(*this, did, doclen);
+    }
     if (!doclen_pl.get()) {
 	// Don't keep a reference back to the database, since this
 	// would make a reference loop.
@@ -723,8 +736,20 @@ GlassPostList::GlassPostList(intrusive_ptr<const GlassDatabase> this_db_,
 void
 GlassPostList::init()
 {
-    string key = GlassPostListTable::make_key(term);
-    int found = cursor->find_entry(key);
+    if (!term.empty()) {
+	// A writer can tombstone documents while we're iterating, so always
+	// check if it's writable.
+	const GlassPostListTable& table = this_db->postlist_table;
+	const GlassTombstones& t = table.get_tombstones();
+	if (!t.empty() || table.is_writable()) tombstones = &t;
+    }
+
+    // Avoid searching the table for a term which the Bloom filter says
+    // isn't there.
+    bool found = false;
+    if (term.empty() || this_db->postlist_table.may_contain_term(term)) {
+	found = cursor->find_entry(GlassPostListTable::make_key(term));
+    }
     if (!found) {
 	LOGLINE(DB, "postlist for term not found");
 	number_of_entries = 0;
@@ -862,6 +887,7 @@ GlassPostList::next(double w_min)
     } else {
 	if (!next_in_chunk()) next_chunk();
     }
+    if (tombstones) skip_tombstoned();
 
     if (is_at_end) {
 	LOGLINE(DB, "Moved to end");
@@ -872,6 +898,29 @@ GlassPostList::next(double w_min)
     RETURN(NULL);
 }
 
+Xapian::doccount
+GlassPostList::next_batch(Xapian::docid did_max,
+			  Xapian::docid* dids,
+			  Xapian::termcount* wdfs,
+			  Xapian::doccount n)
+{
+    LOGCALL(DB, Xapian::doccount, "GlassPostList::next_batch", did_max | dids | wdfs | n);
+    AssertRel(n,>,0);
+    Xapian::doccount count = 0;
+    do {
+	if (!have_started) {
+	    have_started = true;
+	} else if (!next_in_chunk()) {
+	    next_chunk();
+	}
+	if (tombstones) skip_tombstoned();
+	if (is_at_end) break;
+	dids[count] = did;
+	wdfs[count++] = wdf;
+    } while (did <= did_max && count != n);
+    RETURN(count);
+}
+
 bool
 GlassPostList::current_chunk_contains(Xapian::docid desired_did)
 {
@@ -963,8 +1012,12 @@ GlassPostList::skip_to(Xapian::docid desired_did, double w_min)
     LOGCALL(DB, PostList *, "GlassPostList::skip_to", desired_did | w_min);
     (void)w_min; // no warning
     // We've started now - if we hadn't already, we're already positioned
-    // at start so there's no need to actually do anything.
-    have_started = true;
+    // at start so there's no need to actually do anything (unless the first
+    // entry is for a tombstoned document).
+    if (!have_started) {
+	have_started = true;
+	if (tombstones) skip_tombstoned();
+    }
 
     // Don't skip back, and don't need to do anything if already there.
     if (is_at_end || desired_did <= did) RETURN(NULL);
@@ -981,6 +1034,7 @@ GlassPostList::skip_to(Xapian::docid desired_did, double w_min)
     bool have_document = move_forward_in_chunk_to_at_least(desired_did);
     (void)have_document;
     Assert(have_document);
+    if (tombstones) skip_tombstoned();
 
     if (is_at_end) {
 	LOGLINE(DB, "Skipped to end");
@@ -1021,6 +1075,34 @@ GlassPostList::jump_to(Xapian::docid desired_did)
     RETURN(desired_did == did);
 }
 
+Xapian::doccount
+GlassPostList::get_termfreq_min() const
+{
+    if (!tombstones) return number_of_entries;
+    // At most all the tombstoned documents are in this posting list.
+    Xapian::doccount n = tombstones->size();
+    return number_of_entries > n ? number_of_entries - n : 0;
+}
+
+Xapian::doccount
+GlassPostList::get_termfreq_max() const
+{
+    if (!tombstones) return number_of_entries;
+    return min(number_of_entries, this_db->get_doccount());
+}
+
+Xapian::doccount
+GlassPostList::get_termfreq_est() const
+{
+    if (!tombstones) return number_of_entries;
+    // Assume tombstoned documents are spread evenly across posting lists.
+    Xapian::doccount doccount = this_db->get_doccount();
+    Xapian::doccount total = doccount + tombstones->size();
+    if (total == 0) return 0;
+    return Xapian::doccount(double(number_of_entries) * doccount / total +
+			    0.5);
+}
+
 string
 GlassPostList::get_description() const
 {
@@ -1128,6 +1210,9 @@ GlassPostListTable::merge_doclen_changes(const map<Xapian::docid, Xapian::termco
     LOGVALUE(DB, doclens.size());
     if (doclens.empty()) return;
 
+    // The impacts depend on the document lengths.
+    invalidate_impact_lists();
+
     // Ensure there's a first chunk.
     string current_key = make_key(string());
     if (!key_exists(current_key)) {
@@ -1183,12 +1268,16 @@ next_doclen_chunk:
     }
     to->flush(this);
     delete to;
+
+    if (doclen_column.exists(*this)) doclen_column.update(*this, doclens);
 }
 
 void
 GlassPostListTable::merge_changes(const string &term,
 				  const Inverter::PostingChanges & changes)
 {
+    invalidate_impact_lists();
+
     {
 	// Rewrite the first chunk of this posting list with the updated
 	// termfreq and collfreq.
@@ -1216,7 +1305,15 @@ GlassPostListTable::merge_changes(const string &term,
 	    lastdid = read_start_of_chunk(&pos, end, firstdid, &islast);
 	}
 
+	Xapian::doccount old_termfreq = termfreq;
 	termfreq += changes.get_tfdelta();
+	if (old_termfreq == 0 && termfreq != 0 && term_filter.exists(*this)) {
+	    term_filter.add(*this, term);
+	}
+	if (term_bitmaps.exists(*this)) {
+	    term_bitmaps.update(*this, term, changes.pl_changes,
+				old_termfreq, termfreq);
+	}
 	if (termfreq == 0) {
 	    // All postings deleted!  So we can shortcut by zapping the
 	    // posting list.
@@ -1249,8 +1346,8 @@ GlassPostListTable::merge_changes(const string &term,
 	    add(current_key, tag);
 	}
     }
-    map<Xapian::docid, Xapian::termcount>::const_iterator j;
-    j = changes.pl_changes.begin();
+    Assert(changes.sorted);
+    auto j = changes.pl_changes.begin();
     Assert(j != changes.pl_changes.end()); // This case is caught above.
 
     Xapian::docid max_did;
@@ -1298,6 +1395,17 @@ next_chunk:
     delete to;
 }
 
+bool
+GlassPostListTable::get_term_bitmap(const string& term,
+				    RoaringBitmap& bitmap) const
+{
+    LOGCALL(DB, bool, "GlassPostListTable::get_term_bitmap", term | Literal("bitmap"));
+    if (!GlassTermBitmaps::read(*this, term, bitmap)) RETURN(false);
+    const GlassTombstones& t = get_tombstones();
+    if (!t.empty()) bitmap.subtract(t.get_bits());
+    RETURN(true);
+}
+
 void
 GlassPostListTable::get_used_docid_range(Xapian::docid & first,
 					 Xapian::docid & last) const
@@ -29,8 +29,13 @@
 
 #include "backends/leafpostlist.h"
 #include "glass_defs.h"
+#include "glass_doclencolumn.h"
+#include "glass_impactlists.h"
 #include "glass_inverter.h"
 #include "glass_positionlist.h"
+#include "glass_termbitmaps.h"
+#include "glass_termfilter.h"
+#include "glass_tombstones.h"
 #include "omassert.h"
 
 #include <memory>
@@ -51,11 +56,27 @@ namespace Glass {
 using Glass::RootInfo;
 
 class GlassPostList;
+class RoaringBitmap;
 
 class GlassPostListTable : public GlassTable {
     /// PostList for looking up document lengths.
     mutable unique_ptr<GlassPostList> doclen_pl;
 
+    /// Documents deleted without removing their postings (read lazily).
+    mutable GlassTombstones tombstones;
+
+    /// Dense array of document lengths, if the table has one.
+    mutable GlassDocLenColumn doclen_column;
+
+    /// Bitmaps for dense terms, if the table has them.
+    mutable GlassTermBitmaps term_bitmaps;
+
+    /// Impact-ordered posting lists, if the table has them.
+    mutable GlassImpactLists impact_lists;
+
+    /// Bloom filter over the terms, if the table has one.
+    mutable GlassTermFilter term_filter;
+
   public:
     /** Create a new table object.
      *
@@ -80,9 +101,162 @@ class GlassPostListTable : public GlassTable {
     { }
 
     void open(int flags_, const RootInfo & root_info,
-	      glass_revision_number_t rev) {
+	      glass_revision_number_t rev, const char* uuid = NULL) {
 	doclen_pl.reset(0);
-	GlassTable::open(flags_, root_info, rev);
+	tombstones.reset();
+	doclen_column.reset();
+	term_bitmaps.reset();
+	impact_lists.reset();
+	term_filter.reset();
+	GlassTable::open(flags_, root_info, rev, uuid);
+    }
+
+    void cancel(const RootInfo& root_info, glass_revision_number_t rev) {
+	tombstones.reset();
+	doclen_column.reset();
+	term_bitmaps.reset();
+	impact_lists.reset();
+	term_filter.reset();
+	GlassTable::cancel(root_info, rev);
+    }
+
+    /// Return the set of tombstoned documents.
+    const GlassTombstones& get_tombstones() const {
+	tombstones.load(*this);
+	return tombstones;
+    }
+
+    /// Tombstone document @a did.
+    void add_tombstone(Xapian::docid did) {
+	tombstones.load(*this);
+	tombstones.add(did);
+    }
+
+    /// Remove document @a did from the set of tombstoned documents.
+    void remove_tombstone(Xapian::docid did) {
+	tombstones.load(*this);
+	tombstones.remove(did);
+    }
+
+    /// Write out any changes to the set of tombstoned documents.
+    void flush_tombstones() {
+	if (tombstones.is_modified()) tombstones.write(*this);
+    }
+
+    /** Does this table hold entries which older versions of Xapian wouldn't
+     *  handle correctly?
+     *
+     *  If so, the database needs a newer format version so they refuse to
+     *  open it.
+     */
+    bool has_extras() const {
+	return !get_tombstones().empty() || has_doclen_column() ||
+	       has_term_bitmaps() || has_current_impact_lists() ||
+	       has_term_filter();
+    }
+
+    /// Does this table have a dense array of document lengths?
+    bool has_doclen_column() const {
+	return doclen_column.exists(*this);
+    }
+
+    /** Add a dense array of document lengths.
+     *
+     *  Once added, it's updated by merge_doclen_changes().
+     */
+    void build_doclen_column() {
+	GlassDocLenColumn::build(*this);
+	doclen_column.reset();
+    }
+
+    /// Does this table have bitmaps for dense terms?
+    bool has_term_bitmaps() const {
+	return term_bitmaps.exists(*this);
+    }
+
+    /** Add bitmaps for dense terms.
+     *
+     *  Once added, they're updated by merge_changes() and
+     *  flush_term_bitmaps().
+     */
+    void build_term_bitmaps(Xapian::doccount doccount) {
+	GlassTermBitmaps::build_all(*this, doccount);
+	term_bitmaps.reset();
+    }
+
+    /// Add and remove bitmaps for terms whose termfreq has changed.
+    void flush_term_bitmaps(Xapian::doccount doccount) {
+	if (term_bitmaps.exists(*this)) term_bitmaps.flush(*this, doccount);
+    }
+
+    /** Read the bitmap for @a term, less any tombstoned documents.
+     *
+     *  @return false if there's no bitmap for @a term.
+     */
+    bool get_term_bitmap(const string& term, RoaringBitmap& bitmap) const;
+
+    /// Does this table have a Bloom filter over the terms?
+    bool has_term_filter() const {
+	return term_filter.exists(*this);
+    }
+
+    /** Add a Bloom filter over the terms.
+     *
+     *  Once added, it's updated by merge_changes() and flush_term_filter().
+     */
+    void build_term_filter() {
+	GlassTermFilter::build_all(*this);
+	term_filter.reset();
+    }
+
+    /// Write out any changes to the Bloom filter over the terms.
+    void flush_term_filter() {
+	if (term_filter.exists(*this)) term_filter.flush(*this);
+    }
+
+    /** Might @a term be in this table?
+     *
+     *  If this returns false, @a term definitely isn't, which we can usually
+     *  tell without searching the table if it has a Bloom filter.
+     */
+    bool may_contain_term(const string& term) const {
+	return term_filter.may_contain(*this, term);
+    }
+
+    /// Does this table have impact-ordered posting lists (even stale ones)?
+    bool has_impact_lists() const {
+	return impact_lists.exists(*this);
+    }
+
+    /// Does this table have impact-ordered posting lists which aren't stale?
+    bool has_current_impact_lists() const {
+	return impact_lists.is_current(*this);
+    }
+
+    /** Mark any impact-ordered posting lists as stale.
+     *
+     *  They aren't updated as postings change, so merge_changes() and
+     *  merge_doclen_changes() call this first.  Stale lists are left for the
+     *  next compaction to drop or rebuild.
+     */
+    void invalidate_impact_lists() {
+	impact_lists.mark_stale(*this);
+    }
+
+    /** Return the serialised BM25Weight the impacts were calculated for.
+     *
+     *  Only call this if has_current_impact_lists() returns true.
+     */
+    const string& get_impact_params() const {
+	return impact_lists.get_params();
+    }
+
+    /** Read the impact-ordered posting list for @a term.
+     *
+     *  @return false if there isn't one.
+     */
+    bool get_impact_list(const string& term, string& data) const {
+	return get_exact_entry(GlassImpactLists::make_key(term), data);
     }
 
     /// Merge changes for a term.
@@ -109,7 +283,7 @@ class GlassPostListTable : public GlassTable {
     }
 
     bool term_exists(const string & term) const {
-	return key_exists(make_key(term));
+	return may_contain_term(term) && key_exists(make_key(term));
     }
 
     /** Returns frequencies for a term.
@@ -185,6 +359,13 @@ class GlassPostList : public LeafPostList {
     /// The number of entries in the posting list.
     Xapian::doccount number_of_entries;
 
+    /** Documents to skip over (NULL if there aren't any).
+     *
+     *  These are documents which have been deleted without removing their
+     *  postings.
+     */
+    const GlassTombstones* tombstones = NULL;
+
     /// Copying is not allowed.
     GlassPostList(const GlassPostList &);
 
@@ -236,6 +417,13 @@ class GlassPostList : public LeafPostList {
      */
     bool move_forward_in_chunk_to_at_least(Xapian::docid desired_did);
 
+    /// Move past any entries for tombstoned documents.
+    void skip_tombstoned() {
+	while (!is_at_end && tombstones->contains(did)) {
+	    if (!next_in_chunk()) next_chunk();
+	}
+    }
+
     GlassPostList(Xapian::Internal::intrusive_ptr<const GlassDatabase> this_db_,
 		  const string & term,
 		  GlassCursor * cursor_);
@@ -266,6 +454,13 @@ class GlassPostList : public LeafPostList {
      */
     Xapian::doccount get_termfreq() const { return number_of_entries; }
 
+    /** The stored termfreq includes tombstoned documents, so if there are
+     *  any we can only give bounds.
+     */
+    Xapian::doccount get_termfreq_min() const;
+    Xapian::doccount get_termfreq_max() const;
+    Xapian::doccount get_termfreq_est() const;
+
     /// Returns the current docid.
     Xapian::docid get_docid() const { Assert(have_started); return did; }
 
@@ -288,6 +483,11 @@ class GlassPostList : public LeafPostList {
     /// Skip to next document with docid >= docid.
     PostList * skip_to(Xapian::docid desired_did, double w_min);
 
+    Xapian::doccount next_batch(Xapian::docid did_max,
+				Xapian::docid* dids,
+				Xapian::termcount* wdfs,
+				Xapian::doccount n);
+
     /// Return true if and only if we're off the end of the list.
     bool at_end() const { return is_at_end; }
 
@@ -39,6 +39,7 @@
 #include <cstring>   /* for memmove */
 #include <climits>   /* for CHAR_BIT */
 
+#include "glass_blockcache.h"
 #include "glass_freelist.h"
 #include "glass_changes.h"
 #include "glass_cursor.h"
@@ -49,9 +50,11 @@
 #include "filetests.h"
 #include "io_utils.h"
 #include "pack.h"
+#include "safesysstat.h"
 #include "wordaccess.h"
 
 #include <algorithm>  // for std::min()
+#include <memory>
 #include <string>
 
 #include "xapian/constants.h"
@@ -165,7 +168,22 @@ GlassTable::read_block(uint4 n, uint8_t * p) const
 	GlassTable::throw_database_closed();
     AssertRel(n,<,free_list.get_first_unused_block());
 
-    io_read_block(handle, reinterpret_cast<char *>(p), block_size, n, offset);
+    // Blocks are copied out of the mapping rather than being used in place,
+    // since a writer can overwrite blocks which this revision still uses -
+    // the checks the cursor code makes on a copy catch that, but the block
+    // could change under us if we used it directly.  Blocks beyond the end
+    // of the mapping were added after it was made, so have to be read.
+    off_t block_end = offset + (off_t(n) + 1) * block_size;
+    if (map_base && usual(block_end <= off_t(map_size))) {
+	memcpy(p, map_base + (block_end - block_size), block_size);
+    } else if (cache_file_id &&
+	       GlassBlockCache::lookup(cache_file_id, n, revision_number,
+				       p, block_size)) {
+	return;
+    } else {
+	io_read_block(handle, reinterpret_cast<char *>(p), block_size, n,
+		      offset);
+    }
 
     if (GET_LEVEL(p) != LEVEL_FREELIST) {
 	int dir_end = DIR_END(p);
@@ -175,6 +193,12 @@ GlassTable::read_block(uint4 n, uint8_t * p) const
 	    throw Xapian::DatabaseCorruptError(msg);
 	}
     }
+
+    // If the block has been overwritten by a later revision then it isn't
+    // the version of the block for revision_number, so don't cache it.
+    if (cache_file_id && REVISION(p) <= revision_number) {
+	GlassBlockCache::add(cache_file_id, n, revision_number, p, block_size);
+    }
 }
 
 /** write_block(n, p, appending) writes block n in the DB file from address p.
@@ -1284,7 +1308,8 @@ GlassTable::add(const string &key, string tag, bool already_compressed)
 	    GlassTable::throw_database_closed();
 	}
 	RootInfo root_info;
-	root_info.init(block_size, compress_min);
+	root_info.init(block_size, compress_min, comp_stream.get_compressor(),
+		       encoding);
 	do_open_to_write(&root_info);
     }
 
@@ -1467,6 +1492,89 @@ GlassTable::readahead_key(const string &key) const
     RETURN(true);
 }
 
+bool
+GlassTable::readahead_keys(const vector<string>& keys) const
+{
+    LOGCALL(DB, bool, "GlassTable::readahead_keys", keys.size());
+
+    // See readahead_key() for why we ignore tables which aren't open.
+    if (handle < 0)
+	RETURN(false);
+
+    if (level == 0 || keys.empty())
+	RETURN(true);
+
+    // The block at the current level which each key is under.
+    vector<uint4> blocks;
+    blocks.reserve(keys.size());
+    {
+	const uint8_t * p = C[level].get_p();
+	for (const string& key : keys) {
+	    if (key.size() > GLASS_BTREE_MAX_KEY_LEN) {
+		// An overlong key cannot be found.
+		blocks.push_back(BLK_UNUSED);
+		continue;
+	    }
+	    form_key(key);
+	    blocks.push_back(BItem(p, find_in_branch(p, kt, -1)).block_given_by());
+	}
+    }
+
+    unique_ptr<uint8_t[]> buf;
+    for (int j = level - 1; ; --j) {
+	// Hint all the distinct blocks needed at this level before we read
+	// any of them.
+	vector<uint4> todo(blocks);
+	sort(todo.begin(), todo.end());
+	todo.erase(unique(todo.begin(), todo.end()), todo.end());
+	for (uint4 n : todo) {
+	    if (n == BLK_UNUSED || n == C[j].get_n())
+		continue;
+	    if (!io_readahead_block(handle, block_size, n, offset))
+		RETURN(false);
+	}
+
+	// We don't read the leaf blocks here - that's left to the actual
+	// lookups.
+	if (j == 0)
+	    break;
+
+	if (!buf)
+	    buf.reset(new uint8_t[block_size]);
+	// Block currently in buf - if the keys are in sorted order, keys which
+	// share a block will be adjacent so we only read each block once.
+	uint4 buf_n = BLK_UNUSED;
+	bool buf_ok = false;
+	for (size_t i = 0; i != keys.size(); ++i) {
+	    uint4 n = blocks[i];
+	    if (n == BLK_UNUSED)
+		continue;
+	    const uint8_t * p;
+	    if (n == C[j].get_n()) {
+		p = C[j].get_p();
+	    } else {
+		if (n != buf_n) {
+		    read_block(n, buf.get());
+		    buf_n = n;
+		    // The block may have been reused by a later revision, in
+		    // which case we just stop reading ahead for this key, and
+		    // leave the actual lookup to report the problem.
+		    buf_ok = (REVISION(buf.get()) <= revision_number &&
+			      GET_LEVEL(buf.get()) == j);
+		}
+		if (!buf_ok) {
+		    blocks[i] = BLK_UNUSED;
+		    continue;
+		}
+		p = buf.get();
+	    }
+	    form_key(keys[i]);
+	    blocks[i] = BItem(p, find_in_branch(p, kt, -1)).block_given_by();
+	}
+    }
+    RETURN(true);
+}
+
 bool
 GlassTable::get_exact_entry(const string &key, string & tag) const
 {
@@ -1590,6 +1698,7 @@ GlassTable::basic_open(const RootInfo * root_info, glass_revision_number_t rev)
     }
 
     compress_min = root_info->get_compress_min();
+    comp_stream.set_compressor(root_info->get_compressor());
 
     /* kt holds constructed items as well as keys */
     kt = LeafItem_wr(zeroed_new(block_size));
@@ -1606,6 +1715,44 @@ GlassTable::basic_open(const RootInfo * root_info, glass_revision_number_t rev)
 	cursor_created_since_last_modification = false;
 	++cursor_version;
     }
+
+    load_dictionary();
+}
+
+void
+GlassTable::load_dictionary()
+{
+    LOGCALL_VOID(DB, "GlassTable::load_dictionary", NO_ARGS);
+    if (comp_stream.get_compressor() != CompressionStream::ZSTD_DICT) return;
+
+    string dictionary;
+    if (!get_exact_entry(GLASS_DICTIONARY_KEY, dictionary)) {
+	throw Xapian::DatabaseCorruptError("Compression dictionary missing "
+					   "from " + name + GLASS_TABLE_EXTENSION);
+    }
+    comp_stream.set_dictionary(dictionary);
+}
+
+void
+GlassTable::set_dictionary(const string& dictionary)
+{
+    LOGCALL_VOID(DB, "GlassTable::set_dictionary", dictionary.size());
+    CompressionStream::check_compressor(CompressionStream::ZSTD_DICT);
+
+    // The dictionary is needed to decompress everything else, so store it
+    // uncompressed.
+    uint4 compress_min_save = compress_min;
+    compress_min = 0;
+    try {
+	add(GLASS_DICTIONARY_KEY, dictionary);
+    } catch (...) {
+	compress_min = compress_min_save;
+	throw;
+    }
+    compress_min = compress_min_save;
+
+    comp_stream.set_compressor(CompressionStream::ZSTD_DICT);
+    comp_stream.set_dictionary(dictionary);
 }
 
 void
@@ -1721,9 +1868,14 @@ GlassTable::GlassTable(const char * tablename_, const string & path_,
 	  split_p(0),
 	  compress_min(0),
 	  comp_stream(Z_DEFAULT_STRATEGY),
+	  encoding(0),
 	  lazy(lazy_),
 	  last_readahead(BLK_UNUSED),
-	  offset(0)
+	  offset(0),
+	  cache_file_id(0),
+	  use_mmap(false),
+	  map_base(NULL),
+	  map_size(0)
 {
     LOGCALL_CTOR(DB, "GlassTable", tablename_ | path_ | readonly_ | lazy_);
 }
@@ -1756,9 +1908,14 @@ GlassTable::GlassTable(const char * tablename_, int fd, off_t offset_,
 	  split_p(0),
 	  compress_min(0),
 	  comp_stream(Z_DEFAULT_STRATEGY),
+	  encoding(0),
 	  lazy(lazy_),
 	  last_readahead(BLK_UNUSED),
-	  offset(offset_)
+	  offset(offset_),
+	  cache_file_id(0),
+	  use_mmap(false),
+	  map_base(NULL),
+	  map_size(0)
 {
     LOGCALL_CTOR(DB, "GlassTable", tablename_ | fd | offset_ | readonly_ | lazy_);
 }
@@ -1788,11 +1945,13 @@ GlassTable::create_and_open(int flags_, const RootInfo & root_info)
 
     flags = flags_;
     block_size = block_size_;
+    encoding = root_info.get_encoding();
 
     if (lazy) {
 	close();
 	(void)io_unlink(name + GLASS_TABLE_EXTENSION);
 	compress_min = root_info.get_compress_min();
+	comp_stream.set_compressor(root_info.get_compressor());
     } else {
 	// FIXME: it would be good to arrange that this works such that there's
 	// always a valid table in place if you run create_and_open() on an
@@ -1810,6 +1969,17 @@ GlassTable::~GlassTable() {
 void GlassTable::close(bool permanent) {
     LOGCALL_VOID(DB, "GlassTable::close", permanent);
 
+    if (cache_file_id) {
+	GlassBlockCache::release_file_id(cache_file_id);
+	cache_file_id = 0;
+    }
+
+    if (map_base) {
+	io_unmap(map_base, map_size);
+	map_base = NULL;
+	map_size = 0;
+    }
+
     if (handle >= 0) {
 	if (single_file()) {
 	    handle = -3 - handle;
@@ -1861,9 +2031,10 @@ GlassTable::flush_db()
 }
 
 void
-GlassTable::commit(glass_revision_number_t revision, RootInfo * root_info)
+GlassTable::commit(glass_revision_number_t revision, RootInfo * root_info,
+		   bool defer_reuse)
 {
-    LOGCALL_VOID(DB, "GlassTable::commit", revision|root_info);
+    LOGCALL_VOID(DB, "GlassTable::commit", revision|root_info|defer_reuse);
     Assert(writable);
 
     if (revision <= revision_number) {
@@ -1901,7 +2072,7 @@ GlassTable::commit(glass_revision_number_t revision, RootInfo * root_info)
 	}
 
 	free_list.set_revision(revision);
-	free_list.commit(this, block_size);
+	free_list.commit(this, block_size, defer_reuse);
 
 	// Save the freelist details into the root_info.
 	string serialised;
@@ -1976,9 +2147,11 @@ GlassTable::cancel(const RootInfo & root_info, glass_revision_number_t rev)
 
 void
 GlassTable::do_open_to_read(const RootInfo * root_info,
-			    glass_revision_number_t rev)
+			    glass_revision_number_t rev,
+			    const char* uuid)
 {
-    LOGCALL(DB, bool, "GlassTable::do_open_to_read", root_info|rev);
+    LOGCALL(DB, bool, "GlassTable::do_open_to_read",
+	    root_info | rev | (const void*)uuid);
     if (handle == -2) {
 	GlassTable::throw_database_closed();
     }
@@ -1999,6 +2172,30 @@ GlassTable::do_open_to_read(const RootInfo * root_info,
 	}
     }
 
+    if (use_mmap) {
+	// The mapping is made afresh each time the table is opened, so after
+	// reopen() it covers any blocks the new revision has added.
+	map_base = io_map_rd(handle, map_size);
+	if (map_base) {
+	    // No point also copying blocks into the shared cache.
+	    uuid = NULL;
+	}
+    }
+
+    struct stat statbuf;
+    if (uuid && fstat(handle, &statbuf) == 0) {
+	// The UUID distinguishes a new database which reuses the inode
+	// number of a deleted one, and the device and inode numbers
+	// distinguish copies of a database.
+	string identity(uuid, Uuid::BINARY_SIZE);
+	identity += tablename;
+	identity += '\0';
+	pack_uint(identity, uint64_t(statbuf.st_dev));
+	pack_uint(identity, uint64_t(statbuf.st_ino));
+	pack_uint(identity, uint64_t(offset));
+	cache_file_id = GlassBlockCache::get_file_id(identity);
+    }
+
     basic_open(root_info, rev);
 
     read_root();
@@ -2006,17 +2203,19 @@ GlassTable::do_open_to_read(const RootInfo * root_info,
 
 void
 GlassTable::open(int flags_, const RootInfo & root_info,
-		 glass_revision_number_t rev)
+		 glass_revision_number_t rev, const char* uuid)
 {
-    LOGCALL_VOID(DB, "GlassTable::open", flags_|root_info|rev);
+    LOGCALL_VOID(DB, "GlassTable::open",
+		 flags_ | root_info | rev | (const void*)uuid);
     close();
 
     flags = flags_;
     block_size = root_info.get_blocksize();
     root = root_info.get_root();
+    encoding = root_info.get_encoding();
 
     if (!writable) {
-	do_open_to_read(&root_info, rev);
+	do_open_to_read(&root_info, rev, uuid);
 	return;
     }
 
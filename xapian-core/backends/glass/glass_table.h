@@ -40,7 +40,9 @@
 #include "common/compression_stream.h"
 
 #include <algorithm>
+#include <cstdint>
 #include <string>
+#include <vector>
 
 namespace Glass {
 
@@ -440,9 +442,13 @@ class GlassTable {
     void basic_open(const RootInfo * root_info,
 		    glass_revision_number_t rev);
 
+    /// Read the compression dictionary if the table uses one.
+    void load_dictionary();
+
     /** Perform the opening operation to read. */
     void do_open_to_read(const RootInfo * root_info,
-			 glass_revision_number_t rev);
+			 glass_revision_number_t rev,
+			 const char* uuid);
 
     /** Perform the opening operation to write. */
     void do_open_to_write(const RootInfo * root_info,
@@ -485,6 +491,21 @@ class GlassTable {
 
     bool readahead_key(const string &key) const;
 
+    /** Readahead the blocks needed to look up several keys.
+     *
+     *  Rather than descending the B-tree for each key in turn, this works
+     *  down a level at a time: it issues readahead hints for the blocks
+     *  needed at a level for all the keys, then reads those blocks to find
+     *  the blocks needed at the next level, so the reads for the different
+     *  keys can be serviced in parallel.  The leaf blocks which would hold
+     *  the keys are hinted but not read.
+     *
+     *  @param keys	The keys to readahead for.
+     *
+     *  @return false if readahead isn't supported for this table.
+     */
+    bool readahead_keys(const std::vector<std::string>& keys) const;
+
     /** Determine whether the btree exists on disk.
      */
     bool exists() const;
@@ -493,6 +514,9 @@ class GlassTable {
      *
      *  @param flags_	flags for opening
      *  @param root_info	root block info
+     *  @param uuid	The database's UUID, which is needed to use the
+     *			shared block cache if the table is opened read-only
+     *			(NULL to not use the cache).
      *
      *  @exception Xapian::DatabaseCorruptError will be thrown if the table
      *	is in a corrupt state.
@@ -501,7 +525,17 @@ class GlassTable {
      *	not present, etc).
      */
     void open(int flags_, const RootInfo & root_info,
-	      glass_revision_number_t rev);
+	      glass_revision_number_t rev, const char* uuid = NULL);
+
+    /** Read the table through a memory mapping of its file.
+     *
+     *  Only has an effect on tables opened read-only, and takes effect the
+     *  next time the table is opened.
+     */
+    void set_use_mmap() { use_mmap = true; }
+
+    /// Return true if set_use_mmap() has been called.
+    bool get_use_mmap() const { return use_mmap; }
 
     /** Return true if this table is open.
      *
@@ -509,6 +543,9 @@ class GlassTable {
      */
     bool is_open() const { return handle >= 0; }
 
+    /// Return the file descriptor of the table (only valid if is_open()).
+    int get_fd() const { return handle; }
+
     /** Return true if this table is writable. */
     bool is_writable() const { return writable; }
 
@@ -533,8 +570,14 @@ class GlassTable {
      *          needs to be greater than any previously used revision.
      *
      *  @param root_info  Information about the root is returned in this.
+     *
+     *  @param defer_reuse  True if the new revision won't be synced before
+     *		changes for the next one start to be written, in which case
+     *		blocks freed by this revision aren't reused until after the
+     *		following commit.
      */
-    void commit(glass_revision_number_t revision, RootInfo * root_info);
+    void commit(glass_revision_number_t revision, RootInfo * root_info,
+		bool defer_reuse = false);
 
     bool sync() {
 	return (flags & Xapian::DB_NO_SYNC) ||
@@ -688,6 +731,49 @@ class GlassTable {
 	return (item_count == 0);
     }
 
+    /** Return the algorithm used to compress tags.
+     *
+     *  The result is a CompressionStream constant.  Compressed tags read
+     *  with keep_compressed set can only be passed to add() with
+     *  already_compressed set for a table using the same algorithm.
+     */
+    int get_compressor() const {
+	return comp_stream.get_compressor();
+    }
+
+    /** Return how the table's entries are encoded.
+     *
+     *  This is recorded in the table's RootInfo, and only the table's user
+     *  interprets it.
+     */
+    unsigned get_encoding() const { return encoding; }
+
+    /// Return the compression dictionary (empty if there isn't one).
+    const std::string& get_dictionary() const {
+	return comp_stream.get_dictionary();
+    }
+
+    /** Compress tags added from now on using zstd with @a dictionary.
+     *
+     *  The dictionary is stored in the table under GLASS_DICTIONARY_KEY, so
+     *  this is only suitable for tables keyed by docid.  The caller needs
+     *  to record CompressionStream::ZSTD_DICT as the compressor in the
+     *  table's RootInfo.
+     *
+     *  @exception Xapian::FeatureUnavailableError if zstd support wasn't
+     *		   compiled in.
+     */
+    void set_dictionary(const std::string& dictionary);
+
+    /** Can tags compressed by @a other be copied to this table as they are?
+     *
+     *  True if both tables compress tags the same way.
+     */
+    bool same_compression(const GlassTable& other) const {
+	return get_compressor() == other.get_compressor() &&
+	       get_dictionary() == other.get_dictionary();
+    }
+
     /** Get a cursor for reading from the table.
      *
      *  The cursor is owned by the caller - it is the caller's
@@ -903,6 +989,9 @@ class GlassTable {
 
     mutable CompressionStream comp_stream;
 
+    /// How the table's entries are encoded (see RootInfo::get_encoding()).
+    unsigned encoding;
+
     /// If true, don't create the table until it's needed.
     bool lazy;
 
@@ -912,6 +1001,25 @@ class GlassTable {
     /// offset to start of table in file.
     off_t offset;
 
+    /** Id of this table's file in GlassBlockCache.
+     *
+     *  0 if we aren't using the cache.
+     */
+    std::uint64_t cache_file_id;
+
+    /// True if set_use_mmap() has been called.
+    bool use_mmap;
+
+    /** Start of the mapping of the table's file, or NULL if not mapped.
+     *
+     *  The whole file is mapped from its start, so for a single-file database
+     *  the table starts @a offset bytes into the mapping.
+     */
+    const char* map_base;
+
+    /// Size of the mapping in bytes.
+    size_t map_size;
+
     /* Debugging methods */
 //    void report_block_full(int m, int n, const uint8_t * p);
 };
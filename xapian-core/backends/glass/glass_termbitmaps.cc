@@ -0,0 +1,348 @@
+/** @file glass_termbitmaps.cc
+ * @brief Bitmaps of the documents indexed by dense terms in a glass database
+ */
+/* Copyright (C) 2026 Xapian contributors
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301 USA
+ */
+
+#include <config.h>
+
+#include "glass_termbitmaps.h"
+
+#include "backends/roaringbitmap.h"
+#include "glass_cursor.h"
+#include "glass_inverter.h"
+#include "glass_table.h"
+#include "omassert.h"
+#include "pack.h"
+#include "stringutils.h"
+
+#include "xapian/error.h"
+
+#include <memory>
+
+using namespace std;
+
+typedef RoaringBitmap::Container Container;
+
+/// Return the prefix of the keys of the containers for @a term.
+static string
+make_term_prefix(const string& term)
+{
+    string prefix = GlassTermBitmaps::make_marker_key();
+    pack_string_preserving_sort(prefix, term);
+    return prefix;
+}
+
+/** Position @a cursor on the next container for the term with @a prefix.
+ *
+ *  @param[out] container_key	The container number.
+ *
+ *  @return false if there are no more containers for the term.
+ */
+static bool
+at_term_container(const GlassCursor& cursor, const string& prefix,
+		  Xapian::docid& container_key)
+{
+    if (cursor.after_end()) return false;
+    const string& key = cursor.current_key;
+    if (!startswith(key, prefix) || key.size() == prefix.size()) return false;
+    // A longer term starting with this term followed by a zero byte sorts
+    // after this term's containers, and its encoded form continues with
+    // \xff, which pack_uint_preserving_sort() never starts with.
+    if (key[prefix.size()] == '\xff') return false;
+    const char* p = key.data() + prefix.size();
+    const char* end = key.data() + key.size();
+    if (!unpack_uint_preserving_sort(&p, end, &container_key) || p != end) {
+	throw Xapian::DatabaseCorruptError("Bad term bitmap key");
+    }
+    return true;
+}
+
+string
+GlassTermBitmaps::make_key(const string& term, Xapian::docid key)
+{
+    string result = make_term_prefix(term);
+    pack_uint_preserving_sort(result, key);
+    return result;
+}
+
+bool
+GlassTermBitmaps::parse_key(const string& key,
+			    string& term, Xapian::docid& container_key)
+{
+    if (!is_key(key) || key.size() == 2) return false;
+    const char* p = key.data() + 2;
+    const char* end = key.data() + key.size();
+    // unpack_string_preserving_sort() accepts a missing terminator, in which
+    // case there's nothing left for the container number.
+    if (!unpack_string_preserving_sort(&p, end, term) || p == end)
+	return false;
+    return unpack_uint_preserving_sort(&p, end, &container_key) && p == end;
+}
+
+bool
+GlassTermBitmaps::read(const GlassTable& table, const string& term,
+		       RoaringBitmap& bitmap)
+{
+    bitmap = RoaringBitmap();
+    unique_ptr<GlassCursor> cursor(table.cursor_get());
+    if (!cursor) return false;
+    string prefix = make_term_prefix(term);
+    (void)cursor->find_entry_ge(prefix);
+    bool found = false;
+    Xapian::docid container_key;
+    while (at_term_container(*cursor, prefix, container_key)) {
+	cursor->read_tag();
+	const string& tag = cursor->current_tag;
+	Container container;
+	if (!container.unserialise(tag.data(), tag.data() + tag.size())) {
+	    throw Xapian::DatabaseCorruptError("Bad term bitmap container");
+	}
+	bitmap.append(container_key, std::move(container));
+	found = true;
+	cursor->next();
+    }
+    return found;
+}
+
+bool
+GlassTermBitmaps::has(const GlassTable& table, const string& term)
+{
+    unique_ptr<GlassCursor> cursor(table.cursor_get());
+    if (!cursor) return false;
+    string prefix = make_term_prefix(term);
+    (void)cursor->find_entry_ge(prefix);
+    Xapian::docid container_key;
+    return at_term_container(*cursor, prefix, container_key);
+}
+
+void
+GlassTermBitmaps::build(GlassTable& table, const string& term)
+{
+    // Collect the containers and write them once we've finished reading the
+    // posting list.
+    vector<pair<Xapian::docid, string>> containers;
+    vector<uint16_t> members;
+    Xapian::docid current = 0;
+    auto end_container = [&]() {
+	if (members.empty()) return;
+	Container container;
+	container.assign(std::move(members));
+	members.clear();
+	containers.emplace_back(current, container.serialise());
+    };
+
+    unique_ptr<GlassCursor> cursor(table.cursor_get());
+    if (!cursor || !cursor->find_entry(pack_glass_postlist_key(term))) return;
+    cursor->read_tag();
+    const char* p = cursor->current_tag.data();
+    const char* end = p + cursor->current_tag.size();
+    Xapian::doccount tf;
+    Xapian::termcount cf;
+    Xapian::docid did;
+    if (!unpack_uint(&p, end, &tf) ||
+	!unpack_uint(&p, end, &cf) ||
+	!unpack_uint(&p, end, &did)) {
+	throw Xapian::DatabaseCorruptError("Bad postlist chunk");
+    }
+    ++did;
+    while (true) {
+	bool is_last;
+	Xapian::docid increase_to_last;
+	Xapian::termcount wdf;
+	if (!unpack_bool(&p, end, &is_last) ||
+	    !unpack_uint(&p, end, &increase_to_last) ||
+	    !unpack_uint(&p, end, &wdf)) {
+	    throw Xapian::DatabaseCorruptError("Bad postlist chunk");
+	}
+	while (true) {
+	    Xapian::docid key = did / RoaringBitmap::CONTAINER_DOCS;
+	    if (key != current) {
+		end_container();
+		current = key;
+	    }
+	    members.push_back(uint16_t(did % RoaringBitmap::CONTAINER_DOCS));
+	    if (p == end) break;
+	    Xapian::docid inc;
+	    if (!unpack_uint(&p, end, &inc) || !unpack_uint(&p, end, &wdf)) {
+		throw Xapian::DatabaseCorruptError("Bad postlist chunk");
+	    }
+	    did += inc + 1;
+	}
+	if (is_last) break;
+
+	if (!cursor->next()) {
+	    throw Xapian::DatabaseCorruptError("Unexpected end of posting "
+					       "list");
+	}
+	const string& key = cursor->current_key;
+	p = key.data();
+	end = p + key.size();
+	string t;
+	if (!unpack_string_preserving_sort(&p, end, t) || t != term ||
+	    !unpack_uint_preserving_sort(&p, end, &did) || p != end) {
+	    throw Xapian::DatabaseCorruptError("Unexpected end of posting "
+					       "list");
+	}
+	cursor->read_tag();
+	p = cursor->current_tag.data();
+	end = p + cursor->current_tag.size();
+    }
+    cursor.reset();
+    end_container();
+
+    for (auto& c : containers) {
+	table.add(make_key(term, c.first), c.second);
+    }
+}
+
+void
+GlassTermBitmaps::remove(GlassTable& table, const string& term)
+{
+    vector<string> keys;
+    {
+	unique_ptr<GlassCursor> cursor(table.cursor_get());
+	if (!cursor) return;
+	string prefix = make_term_prefix(term);
+	(void)cursor->find_entry_ge(prefix);
+	Xapian::docid container_key;
+	while (at_term_container(*cursor, prefix, container_key)) {
+	    keys.push_back(cursor->current_key);
+	    cursor->next();
+	}
+    }
+    for (auto& key : keys) {
+	table.del(key);
+    }
+}
+
+void
+GlassTermBitmaps::build_all(GlassTable& table, Xapian::doccount doccount)
+{
+    // Find the terms worth a bitmap from the termfreqs at the start of the
+    // first chunk of each posting list.
+    vector<string> terms;
+    {
+	unique_ptr<GlassCursor> cursor(table.cursor_get());
+	if (cursor) {
+	    cursor->rewind();
+	    while (cursor->next()) {
+		const string& key = cursor->current_key;
+		// Keys starting with a zero byte are special, except for terms
+		// which start with one (which are encoded as \0\xff).
+		if (key[0] == '\0' && key[1] != '\xff') continue;
+		const char* p = key.data();
+		const char* end = p + key.size();
+		string term;
+		(void)unpack_string_preserving_sort(&p, end, term);
+		// Only the key of the first chunk ends with the term.
+		if (p != end) continue;
+		cursor->read_tag();
+		const char* tag = cursor->current_tag.data();
+		const char* tag_end = tag + cursor->current_tag.size();
+		Xapian::doccount tf;
+		if (!unpack_uint(&tag, tag_end, &tf)) {
+		    throw Xapian::DatabaseCorruptError("Bad postlist chunk");
+		}
+		if (worth_storing(tf, doccount)) terms.push_back(term);
+	    }
+	}
+    }
+    for (auto& term : terms) {
+	build(table, term);
+    }
+    table.add(make_marker_key(), string());
+}
+
+void
+GlassTermBitmaps::check(const GlassTable& table)
+{
+    present = table.key_exists(make_marker_key());
+    checked = true;
+}
+
+void
+GlassTermBitmaps::update(GlassTable& table, const string& term,
+			 const vector<pair<Xapian::docid,
+					   Xapian::termcount>>& changes,
+			 Xapian::doccount old_termfreq,
+			 Xapian::doccount termfreq)
+{
+    Assert(present);
+    bool has_bitmap;
+    auto t = changed_terms.find(term);
+    if (t != changed_terms.end()) {
+	has_bitmap = t->second.second;
+    } else {
+	// A term only has a bitmap if it was worth keeping when its
+	// posting list last changed.
+	has_bitmap = old_termfreq >= MIN_KEEP_TERMFREQ && has(table, term);
+    }
+
+    if (has_bitmap && termfreq == 0) {
+	remove(table, term);
+	has_bitmap = false;
+    } else if (has_bitmap) {
+	auto i = changes.begin();
+	while (i != changes.end()) {
+	    Xapian::docid container_key = i->first / RoaringBitmap::CONTAINER_DOCS;
+	    string key = make_key(term, container_key);
+	    string tag;
+	    Container container;
+	    if (table.get_exact_entry(key, tag) &&
+		!container.unserialise(tag.data(), tag.data() + tag.size())) {
+		throw Xapian::DatabaseCorruptError("Bad term bitmap container");
+	    }
+	    do {
+		unsigned v = i->first % RoaringBitmap::CONTAINER_DOCS;
+		if (i->second == DELETED_POSTING) {
+		    container.remove(v);
+		} else {
+		    container.add(v);
+		}
+		++i;
+	    } while (i != changes.end() &&
+		     i->first / RoaringBitmap::CONTAINER_DOCS == container_key);
+
+	    if (container.empty()) {
+		table.del(key);
+	    } else {
+		table.add(key, container.serialise());
+	    }
+	}
+    }
+
+    if (has_bitmap || termfreq >= MIN_TERMFREQ) {
+	changed_terms[term] = make_pair(termfreq, has_bitmap);
+    } else if (t != changed_terms.end()) {
+	changed_terms.erase(t);
+    }
+}
+
+void
+GlassTermBitmaps::flush(GlassTable& table, Xapian::doccount doccount)
+{
+    for (auto& t : changed_terms) {
+	Xapian::doccount tf = t.second.first;
+	if (t.second.second) {
+	    if (!worth_keeping(tf, doccount)) remove(table, t.first);
+	} else if (worth_storing(tf, doccount)) {
+	    build(table, t.first);
+	}
+    }
+    changed_terms.clear();
+}
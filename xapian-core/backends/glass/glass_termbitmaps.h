@@ -0,0 +1,169 @@
+/** @file glass_termbitmaps.h
+ * @brief Bitmaps of the documents indexed by dense terms in a glass database
+ */
+/* Copyright (C) 2026 Xapian contributors
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301 USA
+ */
+
+#ifndef XAPIAN_INCLUDED_GLASS_TERMBITMAPS_H
+#define XAPIAN_INCLUDED_GLASS_TERMBITMAPS_H
+
+#include "xapian/types.h"
+
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+class GlassTable;
+class RoaringBitmap;
+
+/** Bitmaps of the documents indexed by dense terms.
+ *
+ *  If a database has these (see Xapian::DB_TERM_BITMAPS), then as well as its
+ *  posting list, each term which indexes a large enough fraction of the
+ *  documents has a RoaringBitmap of the documents it indexes.  The matcher
+ *  uses these for terms where the wdf and positions aren't needed (e.g. the
+ *  filter terms of OP_FILTER), and combines those under AND and OR a word at
+ *  a time.
+ *
+ *  The bitmaps are stored in the postlist table, with one entry per
+ *  non-empty container keyed by the term and the container number, so an
+ *  update only rewrites the containers it changes.  Like the posting lists,
+ *  the bitmaps include tombstoned documents, which are removed when a bitmap
+ *  is read.
+ *
+ *  Whether a term is worth a bitmap is only reconsidered when its posting
+ *  list changes, or when the database is compacted.
+ *
+ *  An entry with an empty tag marks that the database has bitmaps.
+ */
+class GlassTermBitmaps {
+    /// Have we checked whether the table has bitmaps?
+    bool checked = false;
+
+    /// Does the table have bitmaps?
+    bool present = false;
+
+    /** The terms changed since flush() was last called.
+     *
+     *  The value is the term's new termfreq and whether it has a bitmap.
+     *  Only terms which have a bitmap or might be worth one are included.
+     */
+    std::map<std::string, std::pair<Xapian::doccount, bool>> changed_terms;
+
+  public:
+    /// Terms with a lower termfreq never get a bitmap.
+    static constexpr Xapian::doccount MIN_TERMFREQ = 256;
+
+    /// Terms with a lower termfreq lose their bitmap.
+    static constexpr Xapian::doccount MIN_KEEP_TERMFREQ = 128;
+
+    /// Is a bitmap worth storing for a term?
+    static bool worth_storing(Xapian::doccount tf, Xapian::doccount doccount) {
+	return tf >= MIN_TERMFREQ && tf >= doccount / 16;
+    }
+
+    /// Is an existing bitmap for a term worth keeping?
+    static bool worth_keeping(Xapian::doccount tf, Xapian::doccount doccount) {
+	return tf >= MIN_KEEP_TERMFREQ && tf >= doccount / 32;
+    }
+
+    /// Return the postlist table key for container @a key of @a term.
+    static std::string make_key(const std::string& term, Xapian::docid key);
+
+    /// Return the key of the entry which marks the bitmaps as present.
+    static std::string make_marker_key() {
+	return std::string("\0\xf8", 2);
+    }
+
+    /// Is @a key the key of the marker or of a bitmap container?
+    static bool is_key(const std::string& key) {
+	return key.size() > 1 && key[0] == '\0' && key[1] == '\xf8';
+    }
+
+    /** Parse the key of a bitmap container.
+     *
+     *  @return false if @a key isn't a valid container key.
+     */
+    static bool parse_key(const std::string& key,
+			  std::string& term, Xapian::docid& container_key);
+
+    /** Read the bitmap for @a term.
+     *
+     *  @return false if there's no bitmap for @a term.
+     */
+    static bool read(const GlassTable& table, const std::string& term,
+		     RoaringBitmap& bitmap);
+
+    /// Is there a bitmap for @a term?
+    static bool has(const GlassTable& table, const std::string& term);
+
+    /** Write a bitmap for @a term.
+     *
+     *  The documents are read from the posting list for @a term in
+     *  @a table.
+     */
+    static void build(GlassTable& table, const std::string& term);
+
+    /// Remove any bitmap for @a term.
+    static void remove(GlassTable& table, const std::string& term);
+
+    /** Write bitmaps for every term in @a table worth one.
+     *
+     *  @a table mustn't already have bitmaps.
+     */
+    static void build_all(GlassTable& table, Xapian::doccount doccount);
+
+    /// Forget cached data so it gets read again.
+    void reset() {
+	checked = false;
+	present = false;
+	changed_terms.clear();
+    }
+
+    /// Does @a table have bitmaps?
+    bool exists(const GlassTable& table) {
+	if (!checked) check(table);
+	return present;
+    }
+
+    /// Check whether @a table has bitmaps.
+    void check(const GlassTable& table);
+
+    /** Apply changes to a term's posting list to its bitmap.
+     *
+     *  Only call this if exists() returns true.
+     *
+     *  @param changes	The changes, in ascending docid order, with a wdf
+     *			of DELETED_POSTING for a removed posting.
+     *  @param old_termfreq	The term's termfreq before the changes.
+     *  @param termfreq	The term's termfreq after the changes.
+     */
+    void update(GlassTable& table, const std::string& term,
+		const std::vector<std::pair<Xapian::docid,
+					    Xapian::termcount>>& changes,
+		Xapian::doccount old_termfreq,
+		Xapian::doccount termfreq);
+
+    /** Add and remove bitmaps for the terms changed since the last call.
+     *
+     *  Call this after the posting list changes have been merged.
+     */
+    void flush(GlassTable& table, Xapian::doccount doccount);
+};
+
+#endif // XAPIAN_INCLUDED_GLASS_TERMBITMAPS_H
@@ -0,0 +1,200 @@
+/** @file glass_termfilter.cc
+ * @brief Bloom filter over the terms in a glass database
+ */
+/* Copyright (C) 2026 Xapian contributors
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301 USA
+ */
+
+#include <config.h>
+
+#include "glass_termfilter.h"
+
+#include "glass_cursor.h"
+#include "glass_table.h"
+#include "omassert.h"
+#include "pack.h"
+
+#include "xapian/error.h"
+
+#include <algorithm>
+#include <memory>
+#include <vector>
+
+using namespace std;
+
+/// The number of bytes in each block.
+static constexpr unsigned BLOCK_BYTES = GlassTermFilter::BLOCK_BITS / 8;
+
+string
+GlassTermFilter::make_key(uint32_t chunk)
+{
+    string key = make_marker_key();
+    pack_uint_preserving_sort(key, chunk);
+    return key;
+}
+
+bool
+GlassTermFilter::parse_key(const string& key, uint32_t& chunk)
+{
+    if (!is_key(key)) return false;
+    const char* p = key.data() + 2;
+    const char* end = key.data() + key.size();
+    return unpack_uint_preserving_sort(&p, end, &chunk) && p == end;
+}
+
+bool
+GlassTermFilter::parse_marker(const string& tag,
+			      uint32_t& blocks, Xapian::doccount& terms)
+{
+    const char* p = tag.data();
+    const char* end = p + tag.size();
+    return unpack_uint(&p, end, &blocks) &&
+	   unpack_uint(&p, end, &terms) &&
+	   p == end &&
+	   blocks != 0;
+}
+
+uint32_t
+GlassTermFilter::blocks_for(Xapian::doccount terms)
+{
+    uint64_t bits = uint64_t(terms) * BITS_PER_TERM;
+    return uint32_t(max(uint64_t(1), (bits + BLOCK_BITS - 1) / BLOCK_BITS));
+}
+
+char*
+GlassTermFilter::get_block(const GlassTable& table, uint64_t h)
+{
+    uint32_t index = block_index(h, n_blocks);
+    uint32_t chunk = index / CHUNK_BLOCKS;
+    auto i = chunks.find(chunk);
+    if (i == chunks.end()) {
+	string tag;
+	uint32_t blocks = min(uint32_t(CHUNK_BLOCKS),
+			      n_blocks - chunk * CHUNK_BLOCKS);
+	size_t size = size_t(blocks) * BLOCK_BYTES;
+	if (!table.get_exact_entry(make_key(chunk), tag) ||
+	    tag.size() != size) {
+	    throw Xapian::DatabaseCorruptError("Term filter chunk missing or "
+					       "wrong size");
+	}
+	i = chunks.emplace(chunk, std::move(tag)).first;
+    }
+    return &i->second[(index % CHUNK_BLOCKS) * BLOCK_BYTES];
+}
+
+void
+GlassTermFilter::build_all(GlassTable& table)
+{
+    remove_all(table);
+
+    // Find the terms from the keys of the first chunk of each posting list.
+    vector<uint64_t> hashes;
+    {
+	unique_ptr<GlassCursor> cursor(table.cursor_get());
+	if (cursor) {
+	    cursor->rewind();
+	    while (cursor->next()) {
+		const string& key = cursor->current_key;
+		// Keys starting with a zero byte are special, except for terms
+		// which start with one (which are encoded as \0\xff).
+		if (key[0] == '\0' && key[1] != '\xff') continue;
+		const char* p = key.data();
+		const char* end = p + key.size();
+		string term;
+		(void)unpack_string_preserving_sort(&p, end, term);
+		// Only the key of the first chunk ends with the term.
+		if (p == end) hashes.push_back(hash(term));
+	    }
+	}
+    }
+
+    uint32_t blocks = blocks_for(hashes.size());
+    string filter(size_t(blocks) * BLOCK_BYTES, '\0');
+    for (uint64_t h : hashes) {
+	block_add(&filter[size_t(block_index(h, blocks)) * BLOCK_BYTES], h);
+    }
+    for (uint32_t chunk = 0; chunk * CHUNK_BLOCKS < blocks; ++chunk) {
+	size_t start = size_t(chunk) * CHUNK_BLOCKS * BLOCK_BYTES;
+	table.add(make_key(chunk),
+		  filter.substr(start, CHUNK_BLOCKS * BLOCK_BYTES));
+    }
+    string tag;
+    pack_uint(tag, blocks);
+    pack_uint(tag, Xapian::doccount(hashes.size()));
+    table.add(make_marker_key(), tag);
+}
+
+void
+GlassTermFilter::remove_all(GlassTable& table)
+{
+    vector<string> keys;
+    {
+	unique_ptr<GlassCursor> cursor(table.cursor_get());
+	if (!cursor) return;
+	(void)cursor->find_entry_ge(make_marker_key());
+	while (!cursor->after_end() && is_key(cursor->current_key)) {
+	    keys.push_back(cursor->current_key);
+	    cursor->next();
+	}
+    }
+    for (auto& key : keys) {
+	table.del(key);
+    }
+}
+
+void
+GlassTermFilter::check(const GlassTable& table)
+{
+    string tag;
+    present = table.get_exact_entry(make_marker_key(), tag);
+    if (present && !parse_marker(tag, n_blocks, n_terms)) {
+	throw Xapian::DatabaseCorruptError("Term filter marker is invalid");
+    }
+    checked = true;
+}
+
+void
+GlassTermFilter::add(const GlassTable& table, const string& term)
+{
+    Assert(present);
+    uint64_t h = hash(term);
+    block_add(get_block(table, h), h);
+    modified_chunks.insert(block_index(h, n_blocks) / CHUNK_BLOCKS);
+    ++n_terms;
+    modified = true;
+}
+
+void
+GlassTermFilter::flush(GlassTable& table)
+{
+    if (!modified) return;
+    // Rebuild once there are twice as many terms as the filter was sized
+    // for, by which point false positives are over ten times as common.
+    if (n_terms / 2 > uint64_t(n_blocks) * BLOCK_BITS / BITS_PER_TERM) {
+	build_all(table);
+	reset();
+	return;
+    }
+    for (uint32_t chunk : modified_chunks) {
+	table.add(make_key(chunk), chunks[chunk]);
+    }
+    modified_chunks.clear();
+    string tag;
+    pack_uint(tag, n_blocks);
+    pack_uint(tag, n_terms);
+    table.add(make_marker_key(), tag);
+    modified = false;
+}
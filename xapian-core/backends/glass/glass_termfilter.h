@@ -0,0 +1,227 @@
+/** @file glass_termfilter.h
+ * @brief Bloom filter over the terms in a glass database
+ */
+/* Copyright (C) 2026 Xapian contributors
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301 USA
+ */
+
+#ifndef XAPIAN_INCLUDED_GLASS_TERMFILTER_H
+#define XAPIAN_INCLUDED_GLASS_TERMFILTER_H
+
+#include "xapian/types.h"
+
+#include <cstdint>
+#include <map>
+#include <set>
+#include <string>
+
+class GlassTable;
+
+/** Bloom filter over the terms in a glass database.
+ *
+ *  If a database has one (see Xapian::DB_TERM_FILTER), looking up a term
+ *  which isn't in the database usually only needs to check a few bits in
+ *  memory rather than searching the postlist table.
+ *
+ *  The filter is split into blocks of BLOCK_BITS bits, and all the bits set
+ *  for a term are in the same block, so a lookup only touches one cache line.
+ *  The blocks are stored in the postlist table in chunks of CHUNK_BLOCKS,
+ *  each of which is read the first time a term hashing to it is looked up.
+ *
+ *  Terms are added to the filter as they're added to the database, but not
+ *  removed (which would need counts rather than bits), so a deleted term may
+ *  still seem to be present.  The filter is sized for the number of terms
+ *  when built, and is rebuilt when committing changes if enough terms have
+ *  been added since that false positives become too common.
+ *
+ *  The entry with the marker key marks that the database has a filter, and
+ *  its tag holds the number of blocks and the number of terms added.
+ */
+class GlassTermFilter {
+    /// Have we checked whether the table has a filter?
+    bool checked = false;
+
+    /// Does the table have a filter?
+    bool present = false;
+
+    /// The number of blocks in the filter.
+    uint32_t n_blocks = 0;
+
+    /// The number of terms added to the filter.
+    Xapian::doccount n_terms = 0;
+
+    /// The chunks read so far, keyed by chunk number.
+    std::map<uint32_t, std::string> chunks;
+
+    /// The chunks modified since flush() was last called.
+    std::set<uint32_t> modified_chunks;
+
+    /// Has n_terms changed since flush() was last called?
+    bool modified = false;
+
+    /// Return the block for a term with hash @a h, reading it if necessary.
+    char* get_block(const GlassTable& table, uint64_t h);
+
+    /** Call @a action with the index of each bit for a term with hash @a h.
+     *
+     *  The high 32 bits of @a h pick the block, so we use double hashing with
+     *  the low 32 bits and an odd multiple of @a h.
+     */
+    template<typename Action>
+    static void for_each_probe(uint64_t h, Action action) {
+	uint32_t bit = uint32_t(h);
+	uint32_t step = uint32_t((h * 0x9e3779b97f4a7c15) >> 32) | 1;
+	for (unsigned i = 0; i != PROBES; ++i) {
+	    action(bit % BLOCK_BITS);
+	    bit += step;
+	}
+    }
+
+  public:
+    /// The number of bits in each block.
+    static constexpr unsigned BLOCK_BITS = 512;
+
+    /// The number of blocks in each chunk stored in the table.
+    static constexpr unsigned CHUNK_BLOCKS = 64;
+
+    /// The number of bits in the filter per term when it's built.
+    static constexpr unsigned BITS_PER_TERM = 12;
+
+    /// The number of bits set in a block for each term.
+    static constexpr unsigned PROBES = 8;
+
+    /// Return the key of the entry which marks the filter as present.
+    static std::string make_marker_key() {
+	return std::string("\0\xb8", 2);
+    }
+
+    /// Return the postlist table key for chunk @a chunk of the filter.
+    static std::string make_key(uint32_t chunk);
+
+    /// Is @a key the key of the marker or of a filter chunk?
+    static bool is_key(const std::string& key) {
+	return key.size() > 1 && key[0] == '\0' && key[1] == '\xb8';
+    }
+
+    /** Parse the key of a filter chunk.
+     *
+     *  @return false if @a key isn't a valid chunk key.
+     */
+    static bool parse_key(const std::string& key, uint32_t& chunk);
+
+    /** Parse the tag of the marker entry.
+     *
+     *  @return false if @a tag isn't valid.
+     */
+    static bool parse_marker(const std::string& tag,
+			     uint32_t& blocks, Xapian::doccount& terms);
+
+    /// Return the number of blocks to use for a filter for @a terms terms.
+    static uint32_t blocks_for(Xapian::doccount terms);
+
+    /// Hash @a term.
+    static uint64_t hash(const std::string& term) {
+	// FNV-1a, which is stored so mustn't change, followed by the
+	// finalising step from MurmurHash3 to spread the effect of each byte
+	// over all the bits.
+	uint64_t h = 0xcbf29ce484222325;
+	for (unsigned char ch : term) {
+	    h ^= ch;
+	    h *= 0x100000001b3;
+	}
+	h ^= h >> 33;
+	h *= 0xff51afd7ed558ccd;
+	h ^= h >> 33;
+	h *= 0xc4ceb9fe1a85ec53;
+	h ^= h >> 33;
+	return h;
+    }
+
+    /// Return the index of the block for a term with hash @a h.
+    static uint32_t block_index(uint64_t h, uint32_t blocks) {
+	return uint32_t(((h >> 32) * blocks) >> 32);
+    }
+
+    /// Set the bits in @a block for a term with hash @a h.
+    static void block_add(char* block, uint64_t h) {
+	for_each_probe(h, [block](unsigned bit) {
+			      block[bit >> 3] |= char(1 << (bit & 7));
+			  });
+    }
+
+    /// Are all the bits in @a block for a term with hash @a h set?
+    static bool block_contains(const char* block, uint64_t h) {
+	bool result = true;
+	for_each_probe(h, [block, &result](unsigned bit) {
+			      if (!(block[bit >> 3] & (1 << (bit & 7))))
+				  result = false;
+			  });
+	return result;
+    }
+
+    /** Write a filter for every term in @a table.
+     *
+     *  Any existing filter is replaced.
+     */
+    static void build_all(GlassTable& table);
+
+    /// Remove the marker and all the chunks of the filter from @a table.
+    static void remove_all(GlassTable& table);
+
+    /// Forget cached data so it gets read again.
+    void reset() {
+	checked = false;
+	present = false;
+	n_blocks = 0;
+	n_terms = 0;
+	chunks.clear();
+	modified_chunks.clear();
+	modified = false;
+    }
+
+    /// Does @a table have a filter?
+    bool exists(const GlassTable& table) {
+	if (!checked) check(table);
+	return present;
+    }
+
+    /// Check whether @a table has a filter.
+    void check(const GlassTable& table);
+
+    /** Might @a term be in @a table?
+     *
+     *  Returns true if there's no filter.
+     */
+    bool may_contain(const GlassTable& table, const std::string& term) {
+	if (!exists(table)) return true;
+	uint64_t h = hash(term);
+	return block_contains(get_block(table, h), h);
+    }
+
+    /** Add @a term to the filter.
+     *
+     *  Only call this if exists() returns true.
+     */
+    void add(const GlassTable& table, const std::string& term);
+
+    /** Write out the changes made by add() since the last call.
+     *
+     *  If the filter has become too full, it's rebuilt instead.
+     */
+    void flush(GlassTable& table);
+};
+
+#endif // XAPIAN_INCLUDED_GLASS_TERMFILTER_H
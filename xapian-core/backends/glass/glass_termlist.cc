@@ -38,12 +38,15 @@ using Xapian::Internal::intrusive_ptr;
 
 GlassTermList::GlassTermList(intrusive_ptr<const GlassDatabase> db_,
 			     Xapian::docid did_,
-			     bool throw_if_not_present)
+			     bool throw_if_not_present,
+			     bool include_tombstoned)
 	: db(db_), did(did_), current_wdf(0), current_termfreq(0)
 {
-    LOGCALL_CTOR(DB, "GlassTermList", db_ | did_ | throw_if_not_present);
+    LOGCALL_CTOR(DB, "GlassTermList", db_ | did_ | throw_if_not_present | include_tombstoned);
 
-    if (!db->termlist_table.get_exact_entry(GlassTermListTable::make_key(did),
+    if ((!include_tombstoned &&
+	 db->postlist_table.get_tombstones().contains(did)) ||
+	!db->termlist_table.get_exact_entry(GlassTermListTable::make_key(did),
 					    data)) {
 	if (!throw_if_not_present) {
 	    pos = NULL;
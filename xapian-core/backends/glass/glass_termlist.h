@@ -92,9 +92,14 @@ class GlassTermList : public TermList {
      *				     signal at_end() before next() is called
      *				     (normally at_end() isn't meaningful
      *				     on a freshly constructed TermList).
+     *  @param include_tombstoned    If true, read the termlist left behind
+     *				     for a document deleted with
+     *				     Xapian::DB_LAZY_DELETE; otherwise such
+     *				     a document is treated as not present.
      */
     GlassTermList(Xapian::Internal::intrusive_ptr<const GlassDatabase> db_,
-		  Xapian::docid did_, bool throw_if_not_present = true);
+		  Xapian::docid did_, bool throw_if_not_present = true,
+		  bool include_tombstoned = false);
 
     /** Return the length of this document.
      *
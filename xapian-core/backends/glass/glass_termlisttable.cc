@@ -52,58 +52,71 @@ GlassTermListTable::set_termlist(Xapian::docid did,
     }
 
     string tag;
-    pack_uint(tag, doclen);
-
-    Xapian::TermIterator t = doc.termlist_begin();
-    if (t != doc.termlist_end()) {
-	pack_uint(tag, termlist_size);
-	string prev_term = *t;
+    TagEncoder encoder(tag, doclen, termlist_size);
+    for (Xapian::TermIterator t = doc.termlist_begin();
+	 t != doc.termlist_end();
+	 ++t) {
+	encoder.append(*t, t.get_wdf());
+    }
+    AssertEq(encoder.get_remaining(), 0);
+    add(make_key(did), tag);
+}
 
-	tag += char(prev_term.size());
-	tag += prev_term;
-	pack_uint(tag, t.get_wdf());
-	--termlist_size;
+GlassTermListTable::TagEncoder::TagEncoder(string& tag_,
+					   Xapian::termcount doclen,
+					   Xapian::termcount termlist_size)
+    : tag(tag_), remaining(termlist_size)
+{
+    pack_uint(tag, doclen);
+    pack_uint(tag, termlist_size);
+}
 
-	while (++t != doc.termlist_end()) {
-	    const string & term = *t;
-	    // If there's a shared prefix with the previous term, we don't
-	    // store it explicitly, but just store the length of the shared
-	    // prefix.  In general, this is a big win.
-	    size_t reuse = common_prefix_length(prev_term, term);
+void
+GlassTermListTable::TagEncoder::append(const string& term,
+				       Xapian::termcount wdf)
+{
+    AssertRel(remaining,>,0);
+    --remaining;
+    if (first) {
+	first = false;
+	tag += char(term.size());
+	tag += term;
+	pack_uint(tag, wdf);
+	prev_term = term;
+	return;
+    }
 
-	    // reuse must be <= prev_term.size(), and we know that value while
-	    // decoding.  So if the wdf is small enough that we can multiply it
-	    // by (prev_term.size() + 1), add reuse and fit the result in a
-	    // byte, then we can pack reuse and the wdf into a single byte and
-	    // save ourselves a byte.  We actually need to add one to the wdf
-	    // before multiplying so that a wdf of 0 can be detected by the
-	    // decoder.
-	    size_t packed = 0;
-	    Xapian::termcount wdf = t.get_wdf();
-	    // If wdf >= 128, then we aren't going to be able to pack it in so
-	    // don't even try to avoid the calculation overflowing and making
-	    // us think we can.
-	    if (wdf < 127)
-		packed = (wdf + 1) * (prev_term.size() + 1) + reuse;
+    // If there's a shared prefix with the previous term, we don't store it
+    // explicitly, but just store the length of the shared prefix.  In
+    // general, this is a big win.
+    size_t reuse = common_prefix_length(prev_term, term);
 
-	    if (packed && packed < 256) {
-		// We can pack the wdf into the same byte.
-		tag += char(packed);
-		tag += char(term.size() - reuse);
-		tag.append(term.data() + reuse, term.size() - reuse);
-	    } else {
-		tag += char(reuse);
-		tag += char(term.size() - reuse);
-		tag.append(term.data() + reuse, term.size() - reuse);
-		// FIXME: pack wdf after reuse next time we rejig the format
-		// incompatibly.
-		pack_uint(tag, wdf);
-	    }
+    // reuse must be <= prev_term.size(), and we know that value while
+    // decoding.  So if the wdf is small enough that we can multiply it by
+    // (prev_term.size() + 1), add reuse and fit the result in a byte, then we
+    // can pack reuse and the wdf into a single byte and save ourselves a byte.
+    // We actually need to add one to the wdf before multiplying so that a wdf
+    // of 0 can be detected by the decoder.
+    size_t packed = 0;
+    // If wdf >= 128, then we aren't going to be able to pack it in so don't
+    // even try to avoid the calculation overflowing and making us think we
+    // can.
+    if (wdf < 127)
+	packed = (wdf + 1) * (prev_term.size() + 1) + reuse;
 
-	    prev_term = *t;
-	    --termlist_size;
-	}
+    if (packed && packed < 256) {
+	// We can pack the wdf into the same byte.
+	tag += char(packed);
+	tag += char(term.size() - reuse);
+	tag.append(term.data() + reuse, term.size() - reuse);
+    } else {
+	tag += char(reuse);
+	tag += char(term.size() - reuse);
+	tag.append(term.data() + reuse, term.size() - reuse);
+	// FIXME: pack wdf after reuse next time we rejig the format
+	// incompatibly.
+	pack_uint(tag, wdf);
     }
-    AssertEq(termlist_size, 0);
-    add(make_key(did), tag);
+
+    prev_term = term;
 }
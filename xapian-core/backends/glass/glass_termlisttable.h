@@ -35,6 +35,38 @@ class Document;
 
 class GlassTermListTable : public GlassTable {
   public:
+    /** Builds the tag for a termlist entry.
+     *
+     *  The terms must be appended in ascending order.
+     */
+    class TagEncoder {
+	std::string& tag;
+
+	std::string prev_term;
+
+	Xapian::termcount remaining;
+
+	bool first = true;
+
+      public:
+	/** Start encoding a termlist.
+	 *
+	 *  @param tag_	String to append the encoded termlist to.
+	 *  @param doclen	The document length.
+	 *  @param termlist_size	The number of terms which will be
+	 *				appended (must be non-zero).
+	 */
+	TagEncoder(std::string& tag_,
+		   Xapian::termcount doclen,
+		   Xapian::termcount termlist_size);
+
+	/// Append a term to the termlist.
+	void append(const std::string& term, Xapian::termcount wdf);
+
+	/// Return the number of terms still to be appended.
+	Xapian::termcount get_remaining() const { return remaining; }
+    };
+
     static std::string make_key(Xapian::docid did) {
 	std::string key;
 	pack_uint_preserving_sort(key, did);
@@ -0,0 +1,239 @@
+/** @file glass_tombstones.cc
+ * @brief Documents deleted from a glass database without removing postings
+ */
+/* Copyright (C) 2026 Xapian contributors
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301 USA
+ */
+
+#include <config.h>
+
+#include "glass_tombstones.h"
+
+#include "glass_cursor.h"
+#include "glass_table.h"
+#include "omassert.h"
+#include "pack.h"
+#include "popcount.h"
+
+#include "xapian/error.h"
+
+#include <memory>
+
+using namespace std;
+
+/// The number of 64-bit words in each chunk.
+static constexpr size_t CHUNK_WORDS = GlassTombstones::CHUNK_DOCS / 64;
+
+string
+GlassTombstones::make_key(Xapian::docid chunk)
+{
+    string key("\0\xf0", 2);
+    pack_uint_preserving_sort(key, chunk);
+    return key;
+}
+
+void
+GlassTombstones::load_(const GlassTable& table)
+{
+    reset();
+    loaded = true;
+    unique_ptr<GlassCursor> cursor(table.cursor_get());
+    if (!cursor) return;
+    (void)cursor->find_entry_ge(string("\0\xf0", 2));
+    while (!cursor->after_end() && is_key(cursor->current_key)) {
+	const char* p = cursor->current_key.data() + 2;
+	const char* end = p + cursor->current_key.size() - 2;
+	Xapian::docid chunk;
+	if (!unpack_uint_preserving_sort(&p, end, &chunk) || p != end) {
+	    throw Xapian::DatabaseCorruptError("Bad tombstone chunk key");
+	}
+	cursor->read_tag();
+	const string& tag = cursor->current_tag;
+	if (tag.size() > CHUNK_WORDS * 8) {
+	    throw Xapian::DatabaseCorruptError("Tombstone chunk too long");
+	}
+	size_t base = size_t(chunk) * CHUNK_WORDS;
+	size_t words = (tag.size() + 7) / 8;
+	if (bits.size() < base + words) bits.resize(base + words);
+	for (size_t i = 0; i != tag.size(); ++i) {
+	    bits[base + i / 8] |= uint64_t(static_cast<unsigned char>(tag[i]))
+				  << (i % 8 * 8);
+	}
+	for (size_t i = 0; i != words; ++i) {
+	    count += popcount(bits[base + i]);
+	}
+	cursor->next();
+    }
+}
+
+void
+GlassTombstones::add(Xapian::docid did)
+{
+    Assert(loaded);
+    auto i = did / 64;
+    if (i >= bits.size()) bits.resize(i + 1);
+    uint64_t bit = uint64_t(1) << (did % 64);
+    if (bits[i] & bit) return;
+    bits[i] |= bit;
+    ++count;
+    modified_chunks.insert(did / CHUNK_DOCS);
+}
+
+void
+GlassTombstones::remove(Xapian::docid did)
+{
+    Assert(loaded);
+    if (!contains(did)) return;
+    bits[did / 64] &= ~(uint64_t(1) << (did % 64));
+    --count;
+    modified_chunks.insert(did / CHUNK_DOCS);
+}
+
+void
+GlassTombstones::write(GlassTable& table)
+{
+    for (Xapian::docid chunk : modified_chunks) {
+	size_t base = size_t(chunk) * CHUNK_WORDS;
+	string tag;
+	for (size_t i = base; i < bits.size() && i != base + CHUNK_WORDS; ++i) {
+	    uint64_t word = bits[i];
+	    for (int j = 0; j != 8; ++j) {
+		tag += char(word >> (j * 8));
+	    }
+	}
+	while (!tag.empty() && tag.back() == '\0') tag.pop_back();
+	if (tag.empty()) {
+	    table.del(make_key(chunk));
+	} else {
+	    table.add(make_key(chunk), tag);
+	}
+    }
+    modified_chunks.clear();
+}
+
+bool
+GlassTombstones::filter_postlist_chunk(string& chunk,
+				       Xapian::docid& first_did) const
+{
+    const char* p = chunk.data();
+    const char* end = p + chunk.size();
+    bool is_last;
+    Xapian::docid increase_to_last;
+    Xapian::termcount wdf;
+    if (!unpack_bool(&p, end, &is_last) ||
+	!unpack_uint(&p, end, &increase_to_last) ||
+	!unpack_uint(&p, end, &wdf)) {
+	throw Xapian::DatabaseCorruptError("Bad postlist chunk");
+    }
+    // Quickly skip chunks which can't contain any tombstoned documents.
+    if (first_did / 64 >= bits.size()) return true;
+
+    string postings;
+    Xapian::docid did = first_did;
+    Xapian::docid new_first = 0, prev = 0;
+    bool removed = false;
+    while (true) {
+	if (contains(did)) {
+	    removed = true;
+	} else {
+	    if (new_first == 0) {
+		new_first = did;
+	    } else {
+		pack_uint(postings, did - prev - 1);
+	    }
+	    pack_uint(postings, wdf);
+	    prev = did;
+	}
+	if (p == end) break;
+	Xapian::docid inc;
+	if (!unpack_uint(&p, end, &inc) || !unpack_uint(&p, end, &wdf)) {
+	    throw Xapian::DatabaseCorruptError("Bad postlist chunk");
+	}
+	did += inc + 1;
+    }
+    if (!removed) return true;
+    if (new_first == 0) return false;
+
+    chunk.resize(0);
+    pack_bool(chunk, is_last);
+    pack_uint(chunk, prev - new_first);
+    chunk += postings;
+    first_did = new_first;
+    return true;
+}
+
+void
+GlassTombstones::count_postings(const GlassTable& table, const string& term,
+				Xapian::doccount& tf,
+				Xapian::termcount& cf) const
+{
+    tf = 0;
+    cf = 0;
+    unique_ptr<GlassCursor> cursor(table.cursor_get());
+    if (!cursor->find_entry(pack_glass_postlist_key(term))) return;
+    cursor->read_tag();
+    const char* p = cursor->current_tag.data();
+    const char* end = p + cursor->current_tag.size();
+    Xapian::doccount dummy_tf;
+    Xapian::termcount dummy_cf;
+    Xapian::docid did;
+    if (!unpack_uint(&p, end, &dummy_tf) ||
+	!unpack_uint(&p, end, &dummy_cf) ||
+	!unpack_uint(&p, end, &did)) {
+	throw Xapian::DatabaseCorruptError("Bad postlist chunk");
+    }
+    ++did;
+    while (true) {
+	bool is_last;
+	Xapian::docid increase_to_last;
+	Xapian::termcount wdf;
+	if (!unpack_bool(&p, end, &is_last) ||
+	    !unpack_uint(&p, end, &increase_to_last) ||
+	    !unpack_uint(&p, end, &wdf)) {
+	    throw Xapian::DatabaseCorruptError("Bad postlist chunk");
+	}
+	while (true) {
+	    if (contains(did)) {
+		++tf;
+		cf += wdf;
+	    }
+	    if (p == end) break;
+	    Xapian::docid inc;
+	    if (!unpack_uint(&p, end, &inc) || !unpack_uint(&p, end, &wdf)) {
+		throw Xapian::DatabaseCorruptError("Bad postlist chunk");
+	    }
+	    did += inc + 1;
+	}
+	if (is_last) break;
+
+	if (!cursor->next()) {
+	    throw Xapian::DatabaseCorruptError("Unexpected end of posting "
+					       "list");
+	}
+	const string& key = cursor->current_key;
+	p = key.data();
+	end = p + key.size();
+	string t;
+	if (!unpack_string_preserving_sort(&p, end, t) || t != term ||
+	    !unpack_uint_preserving_sort(&p, end, &did) || p != end) {
+	    throw Xapian::DatabaseCorruptError("Unexpected end of posting "
+					       "list");
+	}
+	cursor->read_tag();
+	p = cursor->current_tag.data();
+	end = p + cursor->current_tag.size();
+    }
+}
@@ -0,0 +1,141 @@
+/** @file glass_tombstones.h
+ * @brief Documents deleted from a glass database without removing postings
+ */
+/* Copyright (C) 2026 Xapian contributors
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301 USA
+ */
+
+#ifndef XAPIAN_INCLUDED_GLASS_TOMBSTONES_H
+#define XAPIAN_INCLUDED_GLASS_TOMBSTONES_H
+
+#include "xapian/types.h"
+
+#include <cstdint>
+#include <set>
+#include <string>
+#include <vector>
+
+class GlassTable;
+
+/** The set of "tombstoned" documents in a glass database.
+ *
+ *  When a WritableDatabase is opened with Xapian::DB_LAZY_DELETE, deleting a
+ *  document removes its data, values and document length, but leaves its
+ *  postings, positions and termlist in place and records its document ID
+ *  here.  Posting lists skip over tombstoned documents, and compaction drops
+ *  everything left behind for them.  Replacing a tombstoned document removes
+ *  what was left behind first.
+ *
+ *  The set is stored as a bitmap in the postlist table, split into chunks
+ *  covering CHUNK_DOCS document IDs each.  Chunks with no bits set aren't
+ *  stored.
+ */
+class GlassTombstones {
+    /// Bit (did % 64) of bits[did / 64] is set if did is tombstoned.
+    std::vector<uint64_t> bits;
+
+    /// The number of tombstoned documents.
+    Xapian::doccount count = 0;
+
+    /// Has the set been read from the table?
+    bool loaded = false;
+
+    /// The chunks which have changed since they were last written.
+    std::set<Xapian::docid> modified_chunks;
+
+  public:
+    /// The number of document IDs covered by each chunk.
+    static constexpr Xapian::docid CHUNK_DOCS = 16384;
+
+    /// Return the postlist table key for chunk @a chunk.
+    static std::string make_key(Xapian::docid chunk);
+
+    /// Is @a key the key of a tombstone chunk?
+    static bool is_key(const std::string& key) {
+	return key.size() > 1 && key[0] == '\0' && key[1] == '\xf0';
+    }
+
+    /// Read the set from @a table, unless it's already been read.
+    void load(const GlassTable& table) {
+	if (!loaded) load_(table);
+    }
+
+    /// Read the set from @a table.
+    void load_(const GlassTable& table);
+
+    /// Forget the set so it gets read again by the next load().
+    void reset() {
+	bits.clear();
+	count = 0;
+	loaded = false;
+	modified_chunks.clear();
+    }
+
+    /// Is document @a did tombstoned?
+    bool contains(Xapian::docid did) const {
+	auto i = did / 64;
+	return i < bits.size() && (bits[i] >> (did % 64)) & 1;
+    }
+
+    /** Return the set as a bitmap.
+     *
+     *  Bit (did % 64) of word (did / 64) is set if did is tombstoned.
+     */
+    const std::vector<uint64_t>& get_bits() const { return bits; }
+
+    /// Return the number of tombstoned documents.
+    Xapian::doccount size() const { return count; }
+
+    /// Are there no tombstoned documents?
+    bool empty() const { return count == 0; }
+
+    /// Tombstone document @a did.
+    void add(Xapian::docid did);
+
+    /// Remove document @a did from the set.
+    void remove(Xapian::docid did);
+
+    /// Are there changes which haven't been written yet?
+    bool is_modified() const { return !modified_chunks.empty(); }
+
+    /// Write any modified chunks to @a table.
+    void write(GlassTable& table);
+
+    /** Remove the postings for tombstoned documents from a postlist chunk.
+     *
+     *  @param chunk	A chunk without the header which only the first chunk
+     *			for a term has (i.e. starting with the "last chunk"
+     *			flag).  Updated in place.
+     *  @param first_did	The first document ID in @a chunk.  Updated if
+     *			the first posting is removed.
+     *
+     *  @return false if no postings are left.
+     */
+    bool filter_postlist_chunk(std::string& chunk,
+			       Xapian::docid& first_did) const;
+
+    /** Count the postings for tombstoned documents in a posting list.
+     *
+     *  @param table	The postlist table to read from.
+     *  @param term	The term whose posting list to read.
+     *  @param tf	Set to the number of postings for tombstoned documents.
+     *  @param cf	Set to the sum of their wdfs.
+     */
+    void count_postings(const GlassTable& table, const std::string& term,
+			Xapian::doccount& tf, Xapian::termcount& cf) const;
+};
+
+#endif // XAPIAN_INCLUDED_GLASS_TOMBSTONES_H
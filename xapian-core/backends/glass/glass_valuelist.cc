@@ -42,6 +42,20 @@ GlassValueList::update_reader()
     return true;
 }
 
+void
+GlassValueList::find_in_range(const ValueRangeFilter& filter)
+{
+    while (!reader.find_value_in(filter)) {
+	cursor->next();
+	if (cursor->after_end() || !update_reader()) {
+	    // We've reached the end.
+	    delete cursor;
+	    cursor = NULL;
+	    return;
+	}
+    }
+}
+
 GlassValueList::~GlassValueList()
 {
     delete cursor;
@@ -162,6 +176,21 @@ GlassValueList::check(Xapian::docid did)
     return true;
 }
 
+void
+GlassValueList::next_in_range(const ValueRangeFilter& filter)
+{
+    next();
+    if (cursor) find_in_range(filter);
+}
+
+void
+GlassValueList::skip_to_in_range(Xapian::docid did,
+				 const ValueRangeFilter& filter)
+{
+    skip_to(did);
+    if (cursor) find_in_range(filter);
+}
+
 string
 GlassValueList::get_description() const
 {
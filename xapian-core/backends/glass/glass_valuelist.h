@@ -46,6 +46,11 @@ class GlassValueList : public Xapian::ValueIterator::Internal {
     /// Update @a reader to use the chunk currently pointed to by @a cursor.
     bool update_reader();
 
+    /** Move to the first entry from the current one which @a filter
+     *  contains, moving on through later chunks as needed.
+     */
+    void find_in_range(const ValueRangeFilter& filter);
+
   public:
     GlassValueList(Xapian::valueno slot_,
 		   Xapian::Internal::intrusive_ptr<const GlassDatabase> db_)
@@ -67,6 +72,10 @@ class GlassValueList : public Xapian::ValueIterator::Internal {
 
     bool check(Xapian::docid did);
 
+    void next_in_range(const ValueRangeFilter& filter);
+
+    void skip_to_in_range(Xapian::docid did, const ValueRangeFilter& filter);
+
     std::string get_description() const;
 };
 
@@ -28,6 +28,7 @@
 #include "glass_termlist.h"
 #include "debuglog.h"
 #include "backends/documentinternal.h"
+#include "backends/valuerangefilter.h"
 #include "pack.h"
 
 #include "xapian/error.h"
@@ -129,6 +130,57 @@ ValueChunkReader::skip_to(Xapian::docid target)
     p = NULL;
 }
 
+bool
+ValueChunkReader::find_value_in(const ValueRangeFilter& filter)
+{
+    if (p == NULL) return false;
+    if (filter.contains(value)) return true;
+
+    // Decode entries a block at a time so the filter can test the whole
+    // block at once.
+    const unsigned N = ValueRangeFilter::BLOCK_SIZE;
+    Xapian::docid dids[N];
+    uint64_t keys[N];
+    const char* values[N];
+    size_t lens[N];
+    while (p != end) {
+	Xapian::docid d = did;
+	unsigned n = 0;
+	do {
+	    Xapian::docid delta;
+	    if (rare(!unpack_uint(&p, end, &delta)))
+		throw Xapian::DatabaseCorruptError("Failed to unpack streamed value docid");
+	    d += delta + 1;
+
+	    size_t value_len;
+	    if (rare(!unpack_uint(&p, end, &value_len))) {
+		throw Xapian::DatabaseCorruptError("Failed to unpack streamed value length");
+	    }
+	    if (rare(value_len > size_t(end - p))) {
+		throw Xapian::DatabaseCorruptError("Failed to unpack streamed value");
+	    }
+
+	    dids[n] = d;
+	    keys[n] = ValueRangeFilter::key(p, value_len);
+	    values[n] = p;
+	    lens[n] = value_len;
+	    p += value_len;
+	    ++n;
+	} while (n != N && p != end);
+
+	unsigned i = filter.find_first(keys, values, lens, n);
+	if (i != n) {
+	    did = dids[i];
+	    value.assign(values[i], lens[i]);
+	    p = values[i] + lens[i];
+	    return true;
+	}
+	did = d;
+    }
+    p = NULL;
+    return false;
+}
+
 void
 GlassValueManager::add_value(Xapian::docid did, Xapian::valueno slot,
 			     const string & val)
@@ -468,6 +520,82 @@ GlassValueManager::replace_document(Xapian::docid did,
     add_document(did, doc, value_stats);
 }
 
+void
+GlassValueManager::set_value(Xapian::docid did, Xapian::valueno slot,
+			     const string & value,
+			     map<Xapian::valueno, ValueStats> & value_stats)
+{
+    string old_value = get_value(did, slot);
+    if (old_value == value) return;
+
+    std::pair<map<Xapian::valueno, ValueStats>::iterator, bool> i;
+    i = value_stats.insert(make_pair(slot, ValueStats()));
+    ValueStats & stats = i.first->second;
+    if (i.second) {
+	// There were no statistics stored already, so read them.
+	get_value_stats(slot, stats);
+    }
+
+    if (value.empty()) {
+	AssertRelParanoid(stats.freq, >, 0);
+	if (--(stats.freq) == 0) {
+	    stats.lower_bound.resize(0);
+	    stats.upper_bound.resize(0);
+	}
+	remove_value(did, slot);
+    } else {
+	// Replacing an existing value doesn't change the frequency.
+	if (old_value.empty() && (stats.freq)++ == 0) {
+	    stats.lower_bound = value;
+	    stats.upper_bound = value;
+	} else if (value < stats.lower_bound) {
+	    stats.lower_bound = value;
+	} else if (value > stats.upper_bound) {
+	    stats.upper_bound = value;
+	}
+	add_value(did, slot, value);
+    }
+
+    if (!old_value.empty() && !value.empty()) {
+	// The set of slots used hasn't changed.
+	return;
+    }
+    if (!termlist_table->is_open()) return;
+
+    // Update the list of slots used by the document.
+    auto it = slots.find(did);
+    string s;
+    if (it != slots.end()) {
+	s = it->second;
+    } else {
+	(void)termlist_table->get_exact_entry(make_slot_key(did), s);
+    }
+    const char * p = s.data();
+    const char * end = p + s.size();
+    string slots_used;
+    Xapian::valueno prev_slot = static_cast<Xapian::valueno>(-1);
+    Xapian::valueno prev_used = static_cast<Xapian::valueno>(-1);
+    bool done = value.empty();
+    while (p != end) {
+	Xapian::valueno used;
+	if (!unpack_uint(&p, end, &used)) {
+	    throw Xapian::DatabaseCorruptError("Value slot encoding corrupt");
+	}
+	used += prev_used + 1;
+	prev_used = used;
+	if (!done && slot < used) {
+	    pack_uint(slots_used, slot - prev_slot - 1);
+	    prev_slot = slot;
+	    done = true;
+	}
+	if (used == slot) continue;
+	pack_uint(slots_used, used - prev_slot - 1);
+	prev_slot = used;
+    }
+    if (!done) pack_uint(slots_used, slot - prev_slot - 1);
+    swap(slots[did], slots_used);
+}
+
 string
 GlassValueManager::get_value(Xapian::docid did, Xapian::valueno slot) const
 {
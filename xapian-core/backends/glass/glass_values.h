@@ -33,6 +33,7 @@
 #include <string>
 
 class GlassCursor;
+class ValueRangeFilter;
 
 namespace Glass {
 
@@ -129,6 +130,16 @@ class GlassValueManager {
     void replace_document(Xapian::docid did, const Xapian::Document &doc,
 			  std::map<Xapian::valueno, ValueStats> & value_stats);
 
+    /** Set the value in slot @a slot of document @a did.
+     *
+     *  Only the value stream for @a slot is updated, plus the list of slots
+     *  used by the document if a value is added or removed.  An empty
+     *  @a value removes any existing value.
+     */
+    void set_value(Xapian::docid did, Xapian::valueno slot,
+		   const std::string & value,
+		   std::map<Xapian::valueno, ValueStats> & value_stats);
+
     std::string get_value(Xapian::docid did, Xapian::valueno slot) const;
 
     void get_all_values(std::map<Xapian::valueno, std::string> & values,
@@ -203,6 +214,14 @@ class ValueChunkReader {
     void next();
 
     void skip_to(Xapian::docid target);
+
+    /** Move to the first entry from the current one whose value @a filter
+     *  contains.
+     *
+     *  @return true if there is one, false if the end of the chunk was
+     *		reached (in which case we're at_end()).
+     */
+    bool find_value_in(const ValueRangeFilter& filter);
 };
 
 }
@@ -55,6 +55,32 @@ using namespace std;
 // 2015,12,24 1.3.4 2 bytes "components_of" per item eliminated, and much more
 // 2014,11,21 1.3.2 Brass renamed to Glass
 
+/** Glass format version used if any table doesn't compress tags with zlib.
+ *
+ *  The root info for each table then records which compressor it uses.
+ *  Otherwise the format is the same, and we still write GLASS_FORMAT_VERSION
+ *  when all the tables use zlib so older versions of Xapian can read the
+ *  database.
+ */
+#define GLASS_FORMAT_VERSION_COMPRESSOR DATE_TO_VERSION(2026,10,15)
+
+/** Glass format version used if any table's entries aren't encoded in the
+ *  default way.
+ *
+ *  The root info for each table then records its encoding as well as its
+ *  compressor.  This is also only written when it's needed.
+ */
+#define GLASS_FORMAT_VERSION_ENCODING DATE_TO_VERSION(2026,10,16)
+
+/** Glass format version used while the postlist table holds entries which
+ *  older versions of Xapian wouldn't take into account.
+ *
+ *  Otherwise the format is the same as GLASS_FORMAT_VERSION_ENCODING, but
+ *  older versions need to refuse to open the database rather than return
+ *  wrong results or leave these entries out of date when updating it.
+ */
+#define GLASS_FORMAT_VERSION_EXTRAS DATE_TO_VERSION(2026,10,17)
+
 /// Convert date <-> version number.  Dates up to 2141-12-31 fit in 2 bytes.
 #define DATE_TO_VERSION(Y,M,D) \
 	((unsigned(Y) - 2014) << 9 | unsigned(M) << 5 | unsigned(D))
@@ -75,7 +101,7 @@ GlassVersion::GlassVersion(int fd_)
       doccount(0), total_doclen(0), last_docid(0),
       doclen_lbound(0), doclen_ubound(0),
       wdf_ubound(0), spelling_wordfreq_ubound(0),
-      oldest_changeset(0)
+      oldest_changeset(0), postlist_extras(false)
 {
     offset = lseek(fd, 0, SEEK_CUR);
     if (rare(offset < 0)) {
@@ -133,7 +159,12 @@ GlassVersion::read()
     version = static_cast<unsigned char>(buf[GLASS_VERSION_MAGIC_LEN]);
     version <<= 8;
     version |= static_cast<unsigned char>(buf[GLASS_VERSION_MAGIC_LEN + 1]);
-    if (version != GLASS_FORMAT_VERSION) {
+    postlist_extras = (version == GLASS_FORMAT_VERSION_EXTRAS);
+    bool with_encoding = (version == GLASS_FORMAT_VERSION_ENCODING ||
+			  postlist_extras);
+    bool with_compressor = (version == GLASS_FORMAT_VERSION_COMPRESSOR ||
+			    with_encoding);
+    if (version != GLASS_FORMAT_VERSION && !with_compressor) {
 	string msg;
 	if (!single_file()) {
 	    msg = db_dir;
@@ -147,6 +178,18 @@ GlassVersion::read()
 	msg += str(VERSION_TO_YEAR(GLASS_FORMAT_VERSION) * 10000 +
 		   VERSION_TO_MONTH(GLASS_FORMAT_VERSION) * 100 +
 		   VERSION_TO_DAY(GLASS_FORMAT_VERSION));
+	msg += ", ";
+	msg += str(VERSION_TO_YEAR(GLASS_FORMAT_VERSION_COMPRESSOR) * 10000 +
+		   VERSION_TO_MONTH(GLASS_FORMAT_VERSION_COMPRESSOR) * 100 +
+		   VERSION_TO_DAY(GLASS_FORMAT_VERSION_COMPRESSOR));
+	msg += ", ";
+	msg += str(VERSION_TO_YEAR(GLASS_FORMAT_VERSION_ENCODING) * 10000 +
+		   VERSION_TO_MONTH(GLASS_FORMAT_VERSION_ENCODING) * 100 +
+		   VERSION_TO_DAY(GLASS_FORMAT_VERSION_ENCODING));
+	msg += " and ";
+	msg += str(VERSION_TO_YEAR(GLASS_FORMAT_VERSION_EXTRAS) * 10000 +
+		   VERSION_TO_MONTH(GLASS_FORMAT_VERSION_EXTRAS) * 100 +
+		   VERSION_TO_DAY(GLASS_FORMAT_VERSION_EXTRAS));
 	throw Xapian::DatabaseVersionError(msg);
     }
 
@@ -158,7 +201,8 @@ GlassVersion::read()
 	throw Xapian::DatabaseCorruptError("Rev file failed to decode revision");
 
     for (unsigned table_no = 0; table_no < Glass::MAX_; ++table_no) {
-	if (!root[table_no].unserialise(&p, end)) {
+	if (!root[table_no].unserialise(&p, end, with_compressor,
+					with_encoding)) {
 	    throw Xapian::DatabaseCorruptError("Rev file root_info missing");
 	}
 	old_root[table_no] = root[table_no];
@@ -273,13 +317,34 @@ GlassVersion::write(glass_revision_number_t new_rev, int flags)
 {
     LOGCALL(DB, const string, "GlassVersion::write", new_rev|flags);
 
-    string s(GLASS_VERSION_MAGIC, GLASS_VERSION_MAGIC_AND_VERSION_LEN);
+    bool with_compressor = false;
+    bool with_encoding = false;
+    for (unsigned table_no = 0; table_no < Glass::MAX_; ++table_no) {
+	if (root[table_no].get_compressor() != CompressionStream::ZLIB)
+	    with_compressor = true;
+	if (root[table_no].get_encoding() != 0)
+	    with_encoding = with_compressor = true;
+    }
+    if (postlist_extras)
+	with_encoding = with_compressor = true;
+
+    string s(GLASS_VERSION_MAGIC, GLASS_VERSION_MAGIC_LEN);
+    unsigned version = GLASS_FORMAT_VERSION;
+    if (postlist_extras) {
+	version = GLASS_FORMAT_VERSION_EXTRAS;
+    } else if (with_encoding) {
+	version = GLASS_FORMAT_VERSION_ENCODING;
+    } else if (with_compressor) {
+	version = GLASS_FORMAT_VERSION_COMPRESSOR;
+    }
+    s += char((version >> 8) & 0xff);
+    s += char(version & 0xff);
     s.append(uuid.data(), uuid.BINARY_SIZE);
 
     pack_uint(s, new_rev);
 
     for (unsigned table_no = 0; table_no < Glass::MAX_; ++table_no) {
-	root[table_no].serialise(s);
+	root[table_no].serialise(s, with_compressor, with_encoding);
     }
 
     // Serialise database statistics.
@@ -359,39 +424,66 @@ GlassVersion::sync(const string & tmpfile,
     } else {
 	int fd_to_close = fd;
 	fd = -1;
-	if ((flags & Xapian::DB_NO_SYNC) == 0 &&
-	    ((flags & Xapian::DB_FULL_SYNC) ?
-	      !io_full_sync(fd_to_close) :
-	      !io_sync(fd_to_close))) {
-	    int save_errno = errno;
-	    (void)close(fd_to_close);
-	    if (!tmpfile.empty())
-		(void)unlink(tmpfile.c_str());
-	    errno = save_errno;
-	    return false;
-	}
-
-	if (close(fd_to_close) != 0) {
-	    if (!tmpfile.empty()) {
-		int save_errno = errno;
-		(void)unlink(tmpfile.c_str());
-		errno = save_errno;
-	    }
+	if (!sync_file(fd_to_close, tmpfile, db_dir, flags))
 	    return false;
-	}
+    }
 
-	if (!tmpfile.empty()) {
-	    if (!io_tmp_rename(tmpfile, db_dir + "/iamglass")) {
-		return false;
-	    }
-	}
+    for (unsigned table_no = 0; table_no < Glass::MAX_; ++table_no) {
+	old_root[table_no] = root[table_no];
     }
 
+    rev = new_rev;
+    return true;
+}
+
+int
+GlassVersion::defer_sync(glass_revision_number_t new_rev)
+{
+    Assert(new_rev > rev || rev == 0);
+    Assert(!single_file());
+
+    int fd_to_sync = fd;
+    fd = -1;
+
     for (unsigned table_no = 0; table_no < Glass::MAX_; ++table_no) {
 	old_root[table_no] = root[table_no];
     }
 
     rev = new_rev;
+    return fd_to_sync;
+}
+
+bool
+GlassVersion::sync_file(int fd_to_close, const string & tmpfile,
+			const string & dir, int flags)
+{
+    if ((flags & Xapian::DB_NO_SYNC) == 0 &&
+	((flags & Xapian::DB_FULL_SYNC) ?
+	  !io_full_sync(fd_to_close) :
+	  !io_sync(fd_to_close))) {
+	int save_errno = errno;
+	(void)close(fd_to_close);
+	if (!tmpfile.empty())
+	    (void)unlink(tmpfile.c_str());
+	errno = save_errno;
+	return false;
+    }
+
+    if (close(fd_to_close) != 0) {
+	if (!tmpfile.empty()) {
+	    int save_errno = errno;
+	    (void)unlink(tmpfile.c_str());
+	    errno = save_errno;
+	}
+	return false;
+    }
+
+    if (!tmpfile.empty()) {
+	if (!io_tmp_rename(tmpfile, dir + "/iamglass")) {
+	    return false;
+	}
+    }
+
     return true;
 }
 
@@ -414,19 +506,27 @@ static const uint4 compress_min_tab[] = {
 };
 
 void
-GlassVersion::create(unsigned blocksize)
+GlassVersion::create(unsigned blocksize, unsigned compressor,
+		     unsigned position_encoding)
 {
     AssertRel(blocksize,>=,GLASS_MIN_BLOCKSIZE);
     uuid.generate();
     for (unsigned table_no = 0; table_no < Glass::MAX_; ++table_no) {
-	root[table_no].init(blocksize, compress_min_tab[table_no]);
+	uint4 compress_min = compress_min_tab[table_no];
+	unsigned table_compressor = CompressionStream::ZLIB;
+	if (compress_min) table_compressor = compressor;
+	unsigned encoding = 0;
+	if (table_no == Glass::POSITION) encoding = position_encoding;
+	root[table_no].init(blocksize, compress_min, table_compressor,
+			    encoding);
     }
 }
 
 namespace Glass {
 
 void
-RootInfo::init(unsigned blocksize_, uint4 compress_min_)
+RootInfo::init(unsigned blocksize_, uint4 compress_min_, unsigned compressor_,
+	       unsigned encoding_)
 {
     AssertRel(blocksize_,>=,GLASS_MIN_BLOCKSIZE);
     root = 0;
@@ -436,11 +536,13 @@ RootInfo::init(unsigned blocksize_, uint4 compress_min_)
     sequential = true;
     blocksize = blocksize_;
     compress_min = compress_min_;
+    compressor = compressor_;
+    encoding = encoding_;
     fl_serialised.resize(0);
 }
 
 void
-RootInfo::serialise(string &s) const
+RootInfo::serialise(string &s, bool with_compressor, bool with_encoding) const
 {
     pack_uint(s, root);
     unsigned val = level << 2;
@@ -450,18 +552,25 @@ RootInfo::serialise(string &s) const
     pack_uint(s, num_entries);
     pack_uint(s, blocksize >> 11);
     pack_uint(s, compress_min);
+    if (with_compressor) pack_uint(s, compressor);
+    if (with_encoding) pack_uint(s, encoding);
     pack_string(s, fl_serialised);
 }
 
 bool
-RootInfo::unserialise(const char ** p, const char * end)
+RootInfo::unserialise(const char ** p, const char * end, bool with_compressor,
+		      bool with_encoding)
 {
     unsigned val;
+    compressor = CompressionStream::ZLIB;
+    encoding = 0;
     if (!unpack_uint(p, end, &root) ||
 	!unpack_uint(p, end, &val) ||
 	!unpack_uint(p, end, &num_entries) ||
 	!unpack_uint(p, end, &blocksize) ||
 	!unpack_uint(p, end, &compress_min) ||
+	(with_compressor && !unpack_uint(p, end, &compressor)) ||
+	(with_encoding && !unpack_uint(p, end, &encoding)) ||
 	!unpack_string(p, end, fl_serialised)) return false;
     level = val >> 2;
     sequential = val & 0x02;
@@ -32,6 +32,8 @@
 #include <string>
 
 #include "backends/uuids.h"
+#include "common/compression_stream.h"
+#include "common/packedpositions.h"
 #include "internaltypes.h"
 #include "min_non_zero.h"
 #include "xapian/types.h"
@@ -47,14 +49,34 @@ class RootInfo {
     unsigned blocksize;
     /// Should be >= 4 or 0 for no compression.
     uint4 compress_min;
+    /// The algorithm used to compress tags (a CompressionStream constant).
+    unsigned compressor;
+    /** How the table's entries are encoded.
+     *
+     *  0 is the default.  Other values are specific to the table (currently
+     *  only the position table has a choice, of the POSITIONS_* constants).
+     */
+    unsigned encoding;
     std::string fl_serialised;
 
   public:
-    void init(unsigned blocksize_, uint4 compress_min_);
+    void init(unsigned blocksize_, uint4 compress_min_,
+	      unsigned compressor_ = CompressionStream::ZLIB,
+	      unsigned encoding_ = 0);
 
-    void serialise(std::string &s) const;
+    /** Serialise.
+     *
+     *  @param with_compressor	Include the compressor (only allowed in
+     *				newer versions of the format).
+     *  @param with_encoding	Include the encoding (only allowed in the
+     *				newest version of the format, and requires
+     *				@a with_compressor).
+     */
+    void serialise(std::string &s, bool with_compressor,
+		   bool with_encoding) const;
 
-    bool unserialise(const char ** p, const char * end);
+    bool unserialise(const char ** p, const char * end, bool with_compressor,
+		     bool with_encoding);
 
     glass_block_t get_root() const { return root; }
     int get_level() const { return int(level); }
@@ -67,6 +89,8 @@ class RootInfo {
 	return blocksize;
     }
     uint4 get_compress_min() const { return compress_min; }
+    unsigned get_compressor() const { return compressor; }
+    unsigned get_encoding() const { return encoding; }
     const std::string & get_free_list() const { return fl_serialised; }
 
     void set_level(int level_) { level = unsigned(level_); }
@@ -80,6 +104,8 @@ class RootInfo {
 	blocksize = b;
     }
     void set_free_list(const std::string & s) { fl_serialised = s; }
+    void set_compressor(unsigned c) { compressor = c; }
+    void set_encoding(unsigned e) { encoding = e; }
 };
 
 }
@@ -147,6 +173,13 @@ class GlassVersion {
     /// Oldest changeset removed when max_changesets is set
     mutable glass_revision_number_t oldest_changeset;
 
+    /** Does the postlist table hold entries older versions don't handle?
+     *
+     *  If so, we write a newer format version so they refuse to open the
+     *  database.
+     */
+    bool postlist_extras;
+
     /// The serialised database stats.
     std::string serialised_stats;
 
@@ -162,14 +195,24 @@ class GlassVersion {
 	  doccount(0), total_doclen(0), last_docid(0),
 	  doclen_lbound(0), doclen_ubound(0),
 	  wdf_ubound(0), spelling_wordfreq_ubound(0),
-	  oldest_changeset(0) { }
+	  oldest_changeset(0), postlist_extras(false) { }
 
     explicit GlassVersion(int fd_);
 
     ~GlassVersion();
 
-    /** Create the version file. */
-    void create(unsigned blocksize);
+    /** Create the version file.
+     *
+     *  @param compressor	The algorithm to compress tags with in tables
+     *				which compress them (a CompressionStream
+     *				constant).
+     *  @param position_encoding	How to encode the entries in the
+     *					position table (a POSITIONS_*
+     *					constant).
+     */
+    void create(unsigned blocksize,
+		unsigned compressor = CompressionStream::ZLIB,
+		unsigned position_encoding = POSITIONS_INTERPOLATIVE);
 
     void set_changes(GlassChanges * changes_) { changes = changes_; }
 
@@ -186,6 +229,27 @@ class GlassVersion {
     bool sync(const std::string & tmpfile,
 	      glass_revision_number_t new_rev, int flags);
 
+    /** Mark @a new_rev as committed, but leave syncing it to the caller.
+     *
+     *  Only supported for a multi-file database.
+     *
+     *  @return	The fd of the new version file, which the caller must pass
+     *		to sync_file().
+     */
+    int defer_sync(glass_revision_number_t new_rev);
+
+    /** Sync and close a new version file and rename it into place.
+     *
+     *  @param fd_to_close	The fd returned by defer_sync().
+     *  @param tmpfile	The filename returned by write().
+     *  @param dir		The database directory.
+     *  @param flags	The DB_* flags in use.
+     *
+     *  @return true on success; false on failure (with errno set).
+     */
+    static bool sync_file(int fd_to_close, const std::string & tmpfile,
+			  const std::string & dir, int flags);
+
     glass_revision_number_t get_revision() const { return rev; }
 
     const RootInfo & get_root(Glass::table_type tbl) const {
@@ -247,6 +311,13 @@ class GlassVersion {
 	spelling_wordfreq_ubound = ub;
     }
 
+    /** Set whether the postlist table holds entries which older versions of
+     *  Xapian don't handle.
+     *
+     *  This determines the format version which write() uses.
+     */
+    void set_postlist_extras(bool extras) { postlist_extras = extras; }
+
     void add_document(Xapian::termcount doclen) {
 	++doccount;
 	doclen_lbound = min_non_zero(doclen_lbound, doclen);
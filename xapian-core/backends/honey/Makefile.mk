@@ -18,6 +18,7 @@ noinst_HEADERS +=\
 	backends/honey/honey_metadata.h\
 	backends/honey/honey_positionlist.h\
 	backends/honey/honey_postlist.h\
+	backends/honey/honey_postlist_blocks.h\
 	backends/honey/honey_postlist_encodings.h\
 	backends/honey/honey_postlisttable.h\
 	backends/honey/honey_spelling.h\
@@ -44,6 +45,7 @@ lib_src +=\
 	backends/honey/honey_metadata.cc\
 	backends/honey/honey_positionlist.cc\
 	backends/honey/honey_postlist.cc\
+	backends/honey/honey_postlist_blocks.cc\
 	backends/honey/honey_postlisttable.cc\
 	backends/honey/honey_spelling.cc\
 	backends/honey/honey_spellingwordslist.cc\
@@ -27,6 +27,7 @@
 #include "xapian/types.h"
 
 #include <algorithm>
+#include <functional>
 #include <memory>
 #include <queue>
 #include <type_traits>
@@ -35,10 +36,12 @@
 #include <cstdio>
 
 #include "backends/flint_lock.h"
+#include "backends/parallelcompact.h"
 #include "compression_stream.h"
 #include "honey_cursor.h"
 #include "honey_database.h"
 #include "honey_defs.h"
+#include "honey_postlist_blocks.h"
 #include "honey_postlist_encodings.h"
 #include "honey_table.h"
 #include "honey_values.h"
@@ -46,6 +49,7 @@
 #include "filetests.h"
 #include "internaltypes.h"
 #include "pack.h"
+#include "packedpositions.h"
 #include "backends/valuestats.h"
 #include "wordaccess.h"
 
@@ -56,6 +60,8 @@
 # include "../glass/glass_database.h"
 # include "../glass/glass_table.h"
 # include "../glass/glass_values.h"
+#else
+class GlassTombstones;
 #endif
 
 using namespace std;
@@ -155,23 +161,25 @@ template<>
 class PostlistCursor<const GlassTable&> : private GlassCursor {
     Xapian::docid offset;
 
-  public:
-    string key, tag;
-    Xapian::docid firstdid;
-    Xapian::docid chunk_lastdid;
-    Xapian::termcount tf, cf;
-    Xapian::termcount first_wdf;
-    Xapian::termcount wdf_max;
-    bool have_wdfs;
-
-    PostlistCursor(const GlassTable* in, Xapian::docid offset_)
-	: GlassCursor(in), offset(offset_), firstdid(0)
-    {
-	rewind();
-    }
+    /// Documents whose postings to drop (NULL if there aren't any).
+    const GlassTombstones* tombstones;
 
-    bool next() {
-	if (!GlassCursor::next()) return false;
+    /** Frequencies from an initial chunk we dropped.
+     *
+     *  These get added to the next chunk we return, which will be for the
+     *  same term.
+     */
+    Xapian::termcount dropped_tf = 0, dropped_cf = 0;
+
+    /// Read the current entry, returning false if it should be skipped.
+    bool read_entry() {
+	if (GlassTombstones::is_key(current_key)) return false;
+	// Honey's document length chunks can already be read directly.
+	if (GlassDocLenColumn::is_key(current_key)) return false;
+	// Honey doesn't support term bitmaps, impact lists or term filters.
+	if (GlassTermBitmaps::is_key(current_key)) return false;
+	if (GlassImpactLists::is_key(current_key)) return false;
+	if (GlassTermFilter::is_key(current_key)) return false;
 	// We put all chunks into the non-initial chunk form here, then fix up
 	// the first chunk for each term in the merged database as we merge.
 	read_tag();
@@ -353,7 +361,8 @@ class PostlistCursor<const GlassTable&> : private GlassCursor {
 	if (!unpack_string_preserving_sort(&d, e, tname))
 	    throw Xapian::DatabaseCorruptError("Bad postlist key");
 
-	if (d == e) {
+	bool initial = (d == e);
+	if (initial) {
 	    // This is an initial chunk for a term, so adjust tag header.
 	    d = tag.data();
 	    e = d + tag.size();
@@ -363,6 +372,14 @@ class PostlistCursor<const GlassTable&> : private GlassCursor {
 		throw Xapian::DatabaseCorruptError("Bad postlist key");
 	    }
 	    ++firstdid;
+	    if (tombstones) {
+		Xapian::doccount removed_tf;
+		Xapian::termcount removed_cf;
+		tombstones->count_postings(*get_table(), tname,
+					   removed_tf, removed_cf);
+		tf -= removed_tf;
+		cf -= removed_cf;
+	    }
 	    have_wdfs = (cf != 0);
 	    tag.erase(0, d - tag.data());
 	    wdf_max = 0;
@@ -373,6 +390,16 @@ class PostlistCursor<const GlassTable&> : private GlassCursor {
 		throw Xapian::DatabaseCorruptError("Bad postlist key");
 	    key.erase(tmp - 1);
 	}
+	if (tombstones) {
+	    if (!tombstones->filter_postlist_chunk(tag, firstdid)) {
+		dropped_tf += tf;
+		dropped_cf += cf;
+		return false;
+	    }
+	    tf += dropped_tf;
+	    cf += dropped_cf;
+	    dropped_tf = dropped_cf = 0;
+	}
 	firstdid += offset;
 
 	d = tag.data();
@@ -437,6 +464,30 @@ class PostlistCursor<const GlassTable&> : private GlassCursor {
 
 	return true;
     }
+
+  public:
+    string key, tag;
+    Xapian::docid firstdid;
+    Xapian::docid chunk_lastdid;
+    Xapian::termcount tf, cf;
+    Xapian::termcount first_wdf;
+    Xapian::termcount wdf_max;
+    bool have_wdfs;
+
+    PostlistCursor(const GlassTable* in, Xapian::docid offset_,
+		   const GlassTombstones* tombstones_ = NULL)
+	: GlassCursor(in), offset(offset_), tombstones(tombstones_),
+	  firstdid(0)
+    {
+	rewind();
+    }
+
+    bool next() {
+	while (GlassCursor::next()) {
+	    if (read_entry()) return true;
+	}
+	return false;
+    }
 };
 #endif
 
@@ -453,7 +504,11 @@ class PostlistCursor<const HoneyTable&> : private HoneyCursor {
     Xapian::termcount wdf_max;
     bool have_wdfs;
 
-    PostlistCursor(const HoneyTable* in, Xapian::docid offset_)
+    /// Does the posting data for the current term use the blocked encoding?
+    bool blocked = false;
+
+    PostlistCursor(const HoneyTable* in, Xapian::docid offset_,
+		   const GlassTombstones* = NULL)
 	: HoneyCursor(in), offset(offset_), firstdid(0)
     {
 	rewind();
@@ -519,16 +574,30 @@ class PostlistCursor<const HoneyTable&> : private HoneyCursor {
 	    e = d + tag.size();
 
 	    Xapian::docid lastdid;
+	    Xapian::termcount chunk_wdf_max, chunk_doclen_min;
+	    unsigned encoding;
 	    if (!decode_initial_chunk_header(&d, e, tf, cf,
 					     firstdid, lastdid, chunk_lastdid,
-					     first_wdf, wdf_max)) {
+					     first_wdf, wdf_max,
+					     chunk_wdf_max, chunk_doclen_min,
+					     encoding)) {
 		throw Xapian::DatabaseCorruptError("Bad postlist initial "
 						   "chunk header");
 	    }
-	    // Ignore lastdid - we'll need to recalculate it (at least when
-	    // merging, and for simplicity we always do).
+	    // Ignore lastdid and the chunk bounds - we'll need to recalculate
+	    // them (at least when merging, and for simplicity we always do).
 	    (void)lastdid;
+	    (void)chunk_wdf_max;
+	    (void)chunk_doclen_min;
 	    tag.erase(0, d - tag.data());
+	    if (encoding == Honey::POSTINGS_BLOCKED) {
+		blocked = true;
+	    } else if (encoding == Honey::POSTINGS_VARINT) {
+		blocked = false;
+	    } else {
+		throw Xapian::DatabaseCorruptError("Unknown postlist "
+						   "encoding");
+	    }
 
 	    if (tf <= 2) {
 		have_wdfs = false;
@@ -575,21 +644,32 @@ class PostlistCursor<const HoneyTable&> : private HoneyCursor {
 	    d = tag.data();
 	    e = d + tag.size();
 
+	    // We recalculate the chunk bounds when merging.
+	    Xapian::termcount chunk_wdf_max, chunk_doclen_min;
 	    if (have_wdfs) {
 		if (!decode_delta_chunk_header(&d, e, chunk_lastdid, firstdid,
-					       first_wdf)) {
+					       first_wdf, chunk_wdf_max,
+					       chunk_doclen_min)) {
 		    throw Xapian::DatabaseCorruptError("Bad postlist delta "
 						       "chunk header");
 		}
 	    } else {
 		if (!decode_delta_chunk_header_no_wdf(&d, e, chunk_lastdid,
-						      firstdid)) {
+						      firstdid,
+						      chunk_doclen_min)) {
 		    throw Xapian::DatabaseCorruptError("Bad postlist delta "
 						       "chunk header");
 		}
 	    }
 	    tag.erase(0, d - tag.data());
 	}
+	if (blocked) {
+	    // Convert to the usual encoding, which is what merging works with.
+	    string postings;
+	    Honey::decode_postings_blocked(tag.data(), tag.data() + tag.size(),
+					   have_wdfs, postings);
+	    swap(tag, postings);
+	}
 	firstdid += offset;
 	chunk_lastdid += offset;
 	return true;
@@ -599,7 +679,8 @@ class PostlistCursor<const HoneyTable&> : private HoneyCursor {
 template<>
 class PostlistCursor<HoneyTable&> : public PostlistCursor<const HoneyTable&> {
   public:
-    PostlistCursor(HoneyTable* in, Xapian::docid offset_)
+    PostlistCursor(HoneyTable* in, Xapian::docid offset_,
+		   const GlassTombstones* = NULL)
 	: PostlistCursor<const HoneyTable&>(in, offset_) {}
 };
 
@@ -615,11 +696,82 @@ class PostlistCursorGt {
     }
 };
 
+/** Lower bounds on document length for ranges of docids.
+ *
+ *  We record the smallest document length in each doclen chunk we write,
+ *  which gives us a cheap way to find a lower bound on the length of the
+ *  documents in a posting list chunk.
+ */
+class DoclenChunkBounds {
+    /// The last docid and smallest doclen in each doclen chunk, in order.
+    vector<pair<Xapian::docid, Xapian::termcount>> chunks;
+
+    /** The most doclen chunks to consider for one posting list chunk.
+     *
+     *  A posting list chunk which spans a lot of doclen chunks is for a
+     *  sparse term, and the bound over such a range is unlikely to be much
+     *  better than the database-wide bound, so we don't spend time on it.
+     */
+    static constexpr size_t MAX_CHUNKS_TO_SCAN = 16;
+
+  public:
+    /// Record the doclen chunk @a tag with last docid @a chunk_last.
+    void add_chunk(Xapian::docid chunk_last, const string& tag) {
+	size_t width = tag[0] / 8;
+	Xapian::termcount doclen_min = Xapian::termcount(-1);
+	for (size_t i = 1; i + width <= tag.size(); i += width) {
+	    // Entries with all bits set are for docids not in use.
+	    Xapian::termcount doclen = 0;
+	    bool absent = true;
+	    for (size_t j = 0; j != width; ++j) {
+		unsigned char ch = tag[i + j];
+		doclen = (doclen << 8) | ch;
+		absent = absent && ch == 0xff;
+	    }
+	    if (!absent) doclen_min = min(doclen_min, doclen);
+	}
+	chunks.emplace_back(chunk_last, doclen_min);
+    }
+
+    /** Return a lower bound on the doclen of documents in [first, last].
+     *
+     *  Returns 0 if we don't have a useful bound.
+     */
+    Xapian::termcount get(Xapian::docid first, Xapian::docid last) const {
+	auto it = lower_bound(chunks.begin(), chunks.end(),
+			      make_pair(first, Xapian::termcount(0)));
+	Xapian::termcount result = Xapian::termcount(-1);
+	for (size_t n = 0; it != chunks.end(); ++it) {
+	    if (++n > MAX_CHUNKS_TO_SCAN) return 0;
+	    result = min(result, it->second);
+	    if (it->first >= last) break;
+	}
+	return result == Xapian::termcount(-1) ? 0 : result;
+    }
+};
+
+/** Convert the posting data in a postlist chunk to the blocked encoding.
+ *
+ *  @param tag		The chunk, which has the usual encoding on entry.
+ *  @param header_len	The length of the chunk header at the start of @a tag.
+ *  @param have_wdfs	Does the posting data include wdfs?
+ */
+static void
+encode_chunk_blocked(string& tag, size_t header_len, bool have_wdfs)
+{
+    string postings(tag, header_len);
+    tag.resize(header_len);
+    Honey::encode_postings_blocked(postings.data(),
+				   postings.data() + postings.size(),
+				   have_wdfs, tag);
+}
+
 // U : vector<HoneyTable*>::const_iterator
 template<typename T, typename U> void
 merge_postlists(Xapian::Compactor* compactor,
 		T* out, vector<Xapian::docid>::const_iterator offset,
-		U b, U e)
+		U b, U e, bool block_postings,
+		const GlassTombstones* const* tombstones = NULL)
 {
     typedef decltype(**b) table_type; // E.g. HoneyTable
     typedef PostlistCursor<table_type> cursor_type;
@@ -627,7 +779,8 @@ merge_postlists(Xapian::Compactor* compactor,
     priority_queue<cursor_type*, vector<cursor_type*>, gt_type> pq;
     for ( ; b != e; ++b, ++offset) {
 	auto in = *b;
-	auto cursor = new cursor_type(in, *offset);
+	auto cursor = new cursor_type(in, *offset,
+				      tombstones ? *tombstones++ : NULL);
 	if (cursor->next()) {
 	    pq.push(cursor);
 	} else {
@@ -776,6 +929,7 @@ merge_postlists(Xapian::Compactor* compactor,
     }
 
     // Merge doclen chunks.
+    DoclenChunkBounds doclen_bounds;
     while (!pq.empty()) {
 	cursor_type* cur = pq.top();
 	if (key_type(cur->key) != Honey::KEY_DOCLEN_CHUNK) break;
@@ -842,6 +996,7 @@ merge_postlists(Xapian::Compactor* compactor,
 		delete cur;
 	    }
 	}
+	doclen_bounds.add_chunk(chunk_lastdid, tag);
 	out->add(Honey::make_doclenchunk_key(chunk_lastdid), tag);
     }
 
@@ -899,6 +1054,28 @@ merge_postlists(Xapian::Compactor* compactor,
 	    return data.size() * 2u;
 	}
 
+	/// Calculate the highest wdf of the postings in this chunk.
+	Xapian::termcount get_wdf_max() const {
+	    Xapian::termcount result = first_wdf;
+	    if (have_wdfs) {
+		const char* pos = data.data();
+		const char* pos_end = pos + data.size();
+		while (pos != pos_end) {
+		    Xapian::docid delta;
+		    if (!unpack_uint(&pos, pos_end, &delta))
+			throw_database_corrupt("Decoding docid delta", pos);
+		    Xapian::termcount wdf;
+		    if (!unpack_uint(&pos, pos_end, &wdf))
+			throw_database_corrupt("Decoding wdf", pos);
+		    result = max(result, wdf);
+		}
+	    } else if (cf != 0 && tf > 1) {
+		// The wdf is the same for all postings after the first.
+		result = max(result, (cf - first_wdf) / (tf - 1));
+	    }
+	    return result;
+	}
+
 	/// Append postings to tag, which should only contain the chunk header.
 	void append_postings_to(string& tag, bool want_wdfs) {
 	    if (data.empty()) {
@@ -1027,18 +1204,46 @@ merge_postlists(Xapian::Compactor* compactor,
 
 		chunk_lastdid = tags[j - 1].last;
 
+		Xapian::termcount chunk_wdf_max = wdf_max;
+		Xapian::termcount chunk_doclen_min = 0;
+		if (tf > 2) {
+		    if (chunk_lastdid != last_did && cf != 0) {
+			chunk_wdf_max = 0;
+			for (size_t chunk = 0; chunk != j; ++chunk) {
+			    chunk_wdf_max = max(chunk_wdf_max,
+						tags[chunk].get_wdf_max());
+			}
+		    }
+		    chunk_doclen_min = doclen_bounds.get(tags[0].first,
+							 chunk_lastdid);
+		}
+
+		// The blocked encoding is only worthwhile if there are enough
+		// postings to fill at least one block.
+		bool blocked = block_postings &&
+			       tf >= HONEY_POSTLIST_BLOCK_SIZE;
+		unsigned encoding = blocked ? Honey::POSTINGS_BLOCKED :
+					      Honey::POSTINGS_VARINT;
+
 		string first_tag;
 		encode_initial_chunk_header(tf, cf, tags[0].first, last_did,
 					    chunk_lastdid,
-					    first_wdf, wdf_max, first_tag);
+					    first_wdf, wdf_max,
+					    chunk_wdf_max, chunk_doclen_min,
+					    encoding,
+					    first_tag);
 
 		if (tf > 2) {
 		    // If tf <= 2 there's no explicit posting data.
+		    size_t header_len = first_tag.size();
 		    tags[0].append_postings_to(first_tag, have_wdfs);
 		    for (size_t chunk = 1; chunk != j; ++chunk) {
 			tags[chunk].append_postings_to(first_tag, have_wdfs,
 						       tags[chunk - 1].last);
 		    }
+		    if (blocked) {
+			encode_chunk_blocked(first_tag, header_len, have_wdfs);
+		    }
 		}
 		out->add(last_key, first_tag);
 
@@ -1063,23 +1268,37 @@ merge_postlists(Xapian::Compactor* compactor,
 			}
 
 			last_did = tags[j - 1].last;
+			chunk_doclen_min = doclen_bounds.get(tags[i].first,
+							     last_did);
 			string tag;
 			if (have_wdfs) {
+			    chunk_wdf_max = 0;
+			    for (size_t chunk = i; chunk != j; ++chunk) {
+				chunk_wdf_max = max(chunk_wdf_max,
+						    tags[chunk].get_wdf_max());
+			    }
 			    encode_delta_chunk_header(tags[i].first,
 						      last_did,
 						      tags[i].first_wdf,
+						      chunk_wdf_max,
+						      chunk_doclen_min,
 						      tag);
 			} else {
 			    encode_delta_chunk_header_no_wdf(tags[i].first,
 							     last_did,
+							     chunk_doclen_min,
 							     tag);
 			}
 
+			size_t header_len = tag.size();
 			tags[i].append_postings_to(tag, have_wdfs);
 			while (++i != j) {
 			    tags[i].append_postings_to(tag, have_wdfs,
 						       tags[i - 1].last);
 			}
+			if (blocked) {
+			    encode_chunk_blocked(tag, header_len, have_wdfs);
+			}
 
 			out->add(pack_honey_postlist_key(term, last_did), tag);
 		    }
@@ -1117,6 +1336,25 @@ merge_postlists(Xapian::Compactor* compactor,
     }
 }
 
+/** Can compressed tags read by @a cur be copied as they are?
+ *
+ *  Honey tables compress tags with zlib, so tags which are compressed with
+ *  anything else need to be decompressed and recompressed.
+ */
+static inline bool
+keep_compressed(const HoneyCursor&)
+{
+    return true;
+}
+
+#ifdef XAPIAN_HAS_GLASS_BACKEND
+static inline bool
+keep_compressed(const GlassCursor& cur)
+{
+    return cur.get_compressor() == CompressionStream::ZLIB;
+}
+#endif
+
 template<typename T> struct MergeCursor;
 
 #ifdef XAPIAN_HAS_GLASS_BACKEND
@@ -1157,6 +1395,8 @@ merge_spellings(HoneyTable* out,
     priority_queue<cursor_type*, vector<cursor_type*>, gt_type> pq;
     for ( ; b != e; ++b) {
 	auto in = *b;
+	if (in->empty()) continue;
+
 	auto cursor = new cursor_type(in);
 	if (cursor->next()) {
 	    pq.push(cursor);
@@ -1259,7 +1499,7 @@ merge_spellings(HoneyTable* out,
 		    break;
 		}
 		default:
-		    compressed = cur->read_tag(true);
+		    compressed = cur->read_tag(keep_compressed(*cur));
 		    break;
 	    }
 	    out->add(key, cur->current_tag, compressed);
@@ -1359,6 +1599,8 @@ merge_spellings(HoneyTable* out,
     priority_queue<cursor_type*, vector<cursor_type*>, gt_type> pq;
     for ( ; b != e; ++b) {
 	auto in = *b;
+	if (in->empty()) continue;
+
 	auto cursor = new cursor_type(in);
 	if (cursor->next()) {
 	    pq.push(cursor);
@@ -1376,7 +1618,7 @@ merge_spellings(HoneyTable* out,
 	if (pq.empty() || pq.top()->current_key > key) {
 	    // No need to merge the tags, just copy the (possibly compressed)
 	    // tag value.
-	    bool compressed = cur->read_tag(true);
+	    bool compressed = cur->read_tag(keep_compressed(*cur));
 	    out->add(key, cur->current_tag, compressed);
 	    if (cur->next()) {
 		pq.push(cur);
@@ -1474,6 +1716,8 @@ merge_synonyms(T* out, U b, U e)
     priority_queue<cursor_type*, vector<cursor_type*>, gt_type> pq;
     for ( ; b != e; ++b) {
 	auto in = *b;
+	if (in->empty()) continue;
+
 	auto cursor = new cursor_type(in);
 	if (cursor->next()) {
 	    pq.push(cursor);
@@ -1491,7 +1735,7 @@ merge_synonyms(T* out, U b, U e)
 	if (pq.empty() || pq.top()->current_key > key) {
 	    // No need to merge the tags, just copy the (possibly compressed)
 	    // tag value.
-	    bool compressed = cur->read_tag(true);
+	    bool compressed = cur->read_tag(keep_compressed(*cur));
 	    out->add(key, cur->current_tag, compressed);
 	    if (cur->next()) {
 		pq.push(cur);
@@ -1550,25 +1794,52 @@ merge_synonyms(T* out, U b, U e)
     }
 }
 
+/** Split @a n inputs into the groups merged by one pass of a multipass merge.
+ *
+ *  Inputs are merged in pairs, except that the last three are merged
+ *  together if there's an odd number.
+ *
+ *  @return The index of the first input in each group, followed by @a n.
+ */
+static vector<unsigned int>
+split_merge_pass(size_t n)
+{
+    vector<unsigned int> starts;
+    starts.reserve(n / 2 + 1);
+    for (unsigned int i = 0, j; i < n; i = j) {
+	starts.push_back(i);
+	j = i + 2;
+	if (j == n - 1) ++j;
+    }
+    starts.push_back(n);
+    return starts;
+}
+
 template<typename T, typename U> void
 multimerge_postlists(Xapian::Compactor* compactor,
 		     T* out, const char* tmpdir,
 		     const vector<U*>& in,
-		     vector<Xapian::docid> off)
+		     vector<Xapian::docid> off,
+		     bool block_postings,
+		     unsigned parallelism,
+		     const GlassTombstones* const* tombstones = NULL)
 {
     if (in.size() <= 3) {
-	merge_postlists(compactor, out, off.begin(), in.begin(), in.end());
+	merge_postlists(compactor, out, off.begin(), in.begin(), in.end(),
+			block_postings, tombstones);
 	return;
     }
     unsigned int c = 0;
     vector<HoneyTable*> tmp;
-    tmp.reserve(in.size() / 2);
     {
+	vector<unsigned int> starts = split_merge_pass(in.size());
+	tmp.resize(starts.size() - 1);
 	vector<Xapian::docid> newoff;
 	newoff.resize(in.size() / 2);
-	for (unsigned int i = 0, j; i < in.size(); i = j) {
-	    j = i + 2;
-	    if (j == in.size() - 1) ++j;
+	// The merges in a pass are independent, so can run in parallel.
+	run_in_parallel(tmp.size(), parallelism, [&](size_t n) {
+	    unsigned int i = starts[n];
+	    unsigned int j = starts[n + 1];
 
 	    string dest = tmpdir;
 	    char buf[64];
@@ -1586,23 +1857,24 @@ multimerge_postlists(Xapian::Compactor* compactor,
 	    tmptab->create_and_open(flags, root_info);
 
 	    merge_postlists(compactor, tmptab, off.begin() + i,
-			    in.begin() + i, in.begin() + j);
-	    tmp.push_back(tmptab);
+			    in.begin() + i, in.begin() + j, false,
+			    tombstones ? tombstones + i : NULL);
+	    tmp[n] = tmptab;
 	    tmptab->flush_db();
 	    tmptab->commit(1, &root_info);
-	}
+	});
 	swap(off, newoff);
 	++c;
     }
 
     while (tmp.size() > 3) {
-	vector<HoneyTable*> tmpout;
-	tmpout.reserve(tmp.size() / 2);
+	vector<unsigned int> starts = split_merge_pass(tmp.size());
+	vector<HoneyTable*> tmpout(starts.size() - 1);
 	vector<Xapian::docid> newoff;
 	newoff.resize(tmp.size() / 2);
-	for (unsigned int i = 0, j; i < tmp.size(); i = j) {
-	    j = i + 2;
-	    if (j == tmp.size() - 1) ++j;
+	run_in_parallel(tmpout.size(), parallelism, [&](size_t n) {
+	    unsigned int i = starts[n];
+	    unsigned int j = starts[n + 1];
 
 	    string dest = tmpdir;
 	    char buf[64];
@@ -1620,7 +1892,7 @@ multimerge_postlists(Xapian::Compactor* compactor,
 	    tmptab->create_and_open(flags, root_info);
 
 	    merge_postlists(compactor, tmptab, off.begin() + i,
-			    tmp.begin() + i, tmp.begin() + j);
+			    tmp.begin() + i, tmp.begin() + j, false);
 	    if (c > 0) {
 		for (unsigned int k = i; k < j; ++k) {
 		    // FIXME: unlink(tmp[k]->get_path().c_str());
@@ -1628,15 +1900,16 @@ multimerge_postlists(Xapian::Compactor* compactor,
 		    tmp[k] = NULL;
 		}
 	    }
-	    tmpout.push_back(tmptab);
+	    tmpout[n] = tmptab;
 	    tmptab->flush_db();
 	    tmptab->commit(1, &root_info);
-	}
+	});
 	swap(tmp, tmpout);
 	swap(off, newoff);
 	++c;
     }
-    merge_postlists(compactor, out, off.begin(), tmp.begin(), tmp.end());
+    merge_postlists(compactor, out, off.begin(), tmp.begin(), tmp.end(),
+		    block_postings);
     if (c > 0) {
 	for (size_t k = 0; k < tmp.size(); ++k) {
 	    // FIXME: unlink(tmp[k]->get_path().c_str());
@@ -1653,27 +1926,37 @@ template<>
 class PositionCursor<const GlassTable&> : private GlassCursor {
     Xapian::docid offset;
 
+    /// Documents whose positions to drop (NULL if there aren't any).
+    const GlassTombstones* tombstones;
+
   public:
     string key;
     Xapian::docid firstdid;
 
-    PositionCursor(const GlassTable* in, Xapian::docid offset_)
-	: GlassCursor(in), offset(offset_), firstdid(0) {
+    /// The encoding the position lists are stored in.
+    unsigned encoding;
+
+    PositionCursor(const GlassTable* in, Xapian::docid offset_,
+		   const GlassTombstones* tombstones_ = NULL)
+	: GlassCursor(in), offset(offset_), tombstones(tombstones_),
+	  firstdid(0), encoding(in->get_encoding()) {
 	rewind();
     }
 
     bool next() {
-	if (!GlassCursor::next()) return false;
-	read_tag();
-	const char* d = current_key.data();
-	const char* e = d + current_key.size();
 	string term;
 	Xapian::docid did;
-	if (!unpack_string_preserving_sort(&d, e, term) ||
-	    !unpack_uint_preserving_sort(&d, e, &did) ||
-	    d != e) {
-	    throw Xapian::DatabaseCorruptError("Bad position key");
-	}
+	do {
+	    if (!GlassCursor::next()) return false;
+	    const char* d = current_key.data();
+	    const char* e = d + current_key.size();
+	    if (!unpack_string_preserving_sort(&d, e, term) ||
+		!unpack_uint_preserving_sort(&d, e, &did) ||
+		d != e) {
+		throw Xapian::DatabaseCorruptError("Bad position key");
+	    }
+	} while (tombstones && tombstones->contains(did));
+	read_tag();
 
 	key.resize(0);
 	pack_string_preserving_sort(key, term);
@@ -1695,8 +1978,13 @@ class PositionCursor<const HoneyTable&> : private HoneyCursor {
     string key;
     Xapian::docid firstdid;
 
-    PositionCursor(const HoneyTable* in, Xapian::docid offset_)
-	: HoneyCursor(in), offset(offset_), firstdid(0) {
+    /// The encoding the position lists are stored in.
+    unsigned encoding;
+
+    PositionCursor(const HoneyTable* in, Xapian::docid offset_,
+		   const GlassTombstones* = NULL)
+	: HoneyCursor(in), offset(offset_), firstdid(0),
+	  encoding(in->get_encoding()) {
 	rewind();
     }
 
@@ -1736,7 +2024,8 @@ class PositionCursorGt {
 
 template<typename T, typename U> void
 merge_positions(T* out, const vector<U*>& inputs,
-		const vector<Xapian::docid>& offset)
+		const vector<Xapian::docid>& offset,
+		const GlassTombstones* const* tombstones = NULL)
 {
     typedef decltype(*inputs[0]) table_type; // E.g. HoneyTable
     typedef PositionCursor<table_type> cursor_type;
@@ -1744,7 +2033,8 @@ merge_positions(T* out, const vector<U*>& inputs,
     priority_queue<cursor_type*, vector<cursor_type*>, gt_type> pq;
     for (size_t i = 0; i < inputs.size(); ++i) {
 	auto in = inputs[i];
-	auto cursor = new cursor_type(in, offset[i]);
+	auto cursor = new cursor_type(in, offset[i],
+				      tombstones ? tombstones[i] : NULL);
 	if (cursor->next()) {
 	    pq.push(cursor);
 	} else {
@@ -1756,7 +2046,13 @@ merge_positions(T* out, const vector<U*>& inputs,
     while (!pq.empty()) {
 	cursor_type* cur = pq.top();
 	pq.pop();
-	out->add(cur->key, cur->get_tag());
+	if (cur->encoding == out->get_encoding()) {
+	    out->add(cur->key, cur->get_tag());
+	} else {
+	    string tag = cur->get_tag();
+	    convert_positions(tag, cur->encoding, out->get_encoding());
+	    out->add(cur->key, tag);
+	}
 	if (cur->next()) {
 	    pq.push(cur);
 	} else {
@@ -1811,10 +2107,12 @@ template<typename T> void
 merge_docid_keyed(T* out, const vector<const GlassTable*>& inputs,
 		  const vector<Xapian::docid>& offset,
 		  Xapian::termcount& ut_lb, Xapian::termcount& ut_ub,
-		  int table_type = 0)
+		  int table_type = 0,
+		  const GlassTombstones* const* tombstones = NULL)
 {
     for (size_t i = 0; i < inputs.size(); ++i) {
 	Xapian::docid off = offset[i];
+	const GlassTombstones* ts = tombstones ? tombstones[i] : NULL;
 
 	auto in = inputs[i];
 	if (in->empty()) continue;
@@ -1825,8 +2123,12 @@ merge_docid_keyed(T* out, const vector<const GlassTable*>& inputs,
 	string key;
 	while (cur.next()) {
 next_without_next:
-	    // Adjust the key if this isn't the first database.
-	    if (off) {
+	    // Honey tables don't use a compression dictionary.
+	    if (cur.current_key == GLASS_DICTIONARY_KEY) continue;
+
+	    // Adjust the key if this isn't the first database, and drop the
+	    // entries for tombstoned documents.
+	    if (off || ts) {
 		Xapian::docid did;
 		const char* d = cur.current_key.data();
 		const char* e = d + cur.current_key.size();
@@ -1835,6 +2137,7 @@ next_without_next:
 		    msg += inputs[i]->get_path();
 		    throw Xapian::DatabaseCorruptError(msg);
 		}
+		if (ts && ts->contains(did)) continue;
 		did += off;
 		key.resize(0);
 		pack_uint_preserving_sort(key, did);
@@ -1995,7 +2298,7 @@ next_without_next:
 		if (!next_result) break;
 		if (next_already_done) goto next_without_next;
 	    } else {
-		bool compressed = cur.read_tag(true);
+		bool compressed = cur.read_tag(keep_compressed(cur));
 		out->add(key, cur.current_tag, compressed);
 	    }
 	}
@@ -2046,6 +2349,8 @@ HoneyDatabase::compact(Xapian::Compactor* compactor,
 
     bool single_file = (flags & Xapian::DBCOMPACT_SINGLE_FILE);
     bool multipass = (flags & Xapian::DBCOMPACT_MULTIPASS);
+    bool block_postings = (flags & Xapian::DBCOMPACT_BLOCK_POSTINGS);
+    bool packed_positions = (flags & Xapian::DBCOMPACT_PACKED_POSITIONS);
     if (single_file) {
 	// FIXME: Support this combination - we need to put temporary files
 	// somewhere.
@@ -2148,6 +2453,17 @@ HoneyDatabase::compact(Xapian::Compactor* compactor,
 	}
     }
 
+    // Single file output has to be written one table at a time.
+    unsigned parallelism = 1;
+    if (compactor && !single_file) parallelism = compactor->get_parallelism();
+    unique_ptr<SerialisedCompactor> serialised_compactor;
+    if (parallelism > 1) {
+	serialised_compactor.reset(new SerialisedCompactor(*compactor));
+	compactor = serialised_compactor.get();
+    }
+    // Protects in_total, out_total and bad_totals while merging in parallel.
+    CompactionMutex totals_mutex;
+
     string fl_serialised;
 #if 0
     if (single_file) {
@@ -2162,6 +2478,20 @@ if (source_backend == Xapian::DB_BACKEND_GLASS) {
 #ifndef XAPIAN_HAS_GLASS_BACKEND
     throw Xapian::FeatureUnavailableError("Glass backend disabled");
 #else
+    // Merges to run in parallel once all the output tables are set up.
+    vector<function<void()>> merges;
+
+    // Documents deleted with DB_LAZY_DELETE still have postings, positions
+    // and termlists which we need to drop.  Read these up front so the
+    // merges don't race to load them.
+    vector<const GlassTombstones*> tombstones;
+    tombstones.reserve(sources.size());
+    for (auto src : sources) {
+	auto db = static_cast<const GlassDatabase*>(src);
+	const GlassTombstones& ts = db->postlist_table.get_tombstones();
+	tombstones.push_back(ts.empty() ? NULL : &ts);
+    }
+
     vector<HoneyTable*> tabs;
     tabs.reserve(tables_end - tables);
     off_t prev_size = 0;
@@ -2294,6 +2624,13 @@ if (source_backend == Xapian::DB_BACKEND_GLASS) {
 	}
 	tabs.push_back(out);
 	Honey::RootInfo* root_info = version_file_out->root_to_set(t->type);
+	if (t->type == Honey::POSITION) {
+	    // Keep the first source's position list encoding unless we've
+	    // been asked to pack them.
+	    root_info->set_encoding(packed_positions ?
+				    unsigned(POSITIONS_PACKED) :
+				    inputs[0]->get_encoding());
+	}
 	if (single_file) {
 	    root_info->set_free_list(fl_serialised);
 	    root_info->set_offset(table_start_offset);
@@ -2304,103 +2641,126 @@ if (source_backend == Xapian::DB_BACKEND_GLASS) {
 	    out->create_and_open(FLAGS, *root_info);
 	}
 
-	switch (t->type) {
-	    case Honey::POSTLIST: {
-		if (multipass && inputs.size() > 3) {
-		    multimerge_postlists(compactor, out, destdir,
-					 inputs, offset);
-		} else {
-		    merge_postlists(compactor, out, offset.begin(),
-				    inputs.begin(), inputs.end());
+	// Merge the table and report how it went.  We can't start this
+	// until all the output tables exist if we're going to merge them in
+	// parallel.
+	auto merge = [=, &fl_serialised, &prev_size, &version_file_out,
+		      &totals_mutex, &out_total, &bad_totals]() mutable {
+	    switch (t->type) {
+		case Honey::POSTLIST: {
+		    if (multipass && inputs.size() > 3) {
+			multimerge_postlists(compactor, out, destdir,
+					     inputs, offset, block_postings,
+					     parallelism, tombstones.data());
+		    } else {
+			merge_postlists(compactor, out, offset.begin(),
+					inputs.begin(), inputs.end(),
+					block_postings, tombstones.data());
+		    }
+		    break;
+		}
+		case Honey::SPELLING:
+		    merge_spellings(out, inputs.cbegin(), inputs.cend());
+		    break;
+		case Honey::SYNONYM:
+		    merge_synonyms(out, inputs.begin(), inputs.end());
+		    break;
+		case Honey::POSITION:
+		    merge_positions(out, inputs, offset, tombstones.data());
+		    break;
+		default: {
+		    // DocData, Termlist
+		    //
+		    // Glass doesn't track unique term bounds, so the termlist
+		    // merge calculates them.
+		    Xapian::termcount ut_lb = 0, ut_ub = 0;
+		    merge_docid_keyed(out, inputs, offset, ut_lb, ut_ub, t->type,
+				      tombstones.data());
+		    if (t->type == Honey::TERMLIST) {
+			version_file_out->set_unique_terms_lower_bound(ut_lb);
+			version_file_out->set_unique_terms_upper_bound(ut_ub);
+		    }
+		    break;
 		}
-		break;
-	    }
-	    case Honey::SPELLING:
-		merge_spellings(out, inputs.cbegin(), inputs.cend());
-		break;
-	    case Honey::SYNONYM:
-		merge_synonyms(out, inputs.begin(), inputs.end());
-		break;
-	    case Honey::POSITION:
-		merge_positions(out, inputs, offset);
-		break;
-	    default: {
-		// DocData, Termlist
-		auto& v_out = version_file_out;
-		auto ut_lb = v_out->get_unique_terms_lower_bound();
-		auto ut_ub = v_out->get_unique_terms_upper_bound();
-		merge_docid_keyed(out, inputs, offset, ut_lb, ut_ub, t->type);
-		version_file_out->set_unique_terms_lower_bound(ut_lb);
-		version_file_out->set_unique_terms_upper_bound(ut_ub);
-		break;
 	    }
-	}
 
-	// Commit as revision 1.
-	out->flush_db();
-	out->commit(1, root_info);
-	out->sync();
-	if (single_file) fl_serialised = root_info->get_free_list();
+	    // Commit as revision 1.
+	    out->flush_db();
+	    out->commit(1, root_info);
+	    out->sync();
+	    if (single_file) fl_serialised = root_info->get_free_list();
 
-	off_t out_size = 0;
-	if (!bad_stat && !single_file_in) {
-	    off_t db_size;
-	    if (single_file) {
-		db_size = file_size(fd);
-	    } else {
-		db_size = file_size(dest + HONEY_TABLE_EXTENSION);
-	    }
-	    if (errno == 0) {
+	    off_t out_size = 0;
+	    if (!bad_stat && !single_file_in) {
+		off_t db_size;
 		if (single_file) {
-		    off_t old_prev_size = prev_size;
-		    prev_size = db_size;
-		    db_size -= old_prev_size;
+		    db_size = file_size(fd);
+		} else {
+		    db_size = file_size(dest + HONEY_TABLE_EXTENSION);
+		}
+		if (errno == 0) {
+		    if (single_file) {
+			off_t old_prev_size = prev_size;
+			prev_size = db_size;
+			db_size -= old_prev_size;
+		    }
+		    // FIXME: check overflow and set bad_totals
+		    LOCK_COMPACTION(totals_mutex);
+		    out_total += db_size;
+		    out_size = db_size / 1024;
+		} else if (errno != ENOENT) {
+		    LOCK_COMPACTION(totals_mutex);
+		    bad_totals = bad_stat = true;
 		}
-		// FIXME: check overflow and set bad_totals
-		out_total += db_size;
-		out_size = db_size / 1024;
-	    } else if (errno != ENOENT) {
-		bad_totals = bad_stat = true;
 	    }
-	}
-	if (bad_stat) {
-	    if (compactor)
-		compactor->set_status(t->name,
-				      "Done (couldn't stat all the DB files)");
-	} else if (single_file_in) {
-	    if (compactor)
-		compactor->set_status(t->name,
-				      "Done (table sizes unknown for single "
-				      "file DB input)");
-	} else {
-	    string status;
-	    if (out_size == in_size) {
-		status = "Size unchanged (";
+	    if (bad_stat) {
+		if (compactor)
+		    compactor->set_status(t->name,
+					  "Done (couldn't stat all the DB files)");
+	    } else if (single_file_in) {
+		if (compactor)
+		    compactor->set_status(t->name,
+					  "Done (table sizes unknown for single "
+					  "file DB input)");
 	    } else {
-		off_t delta;
-		if (out_size < in_size) {
-		    delta = in_size - out_size;
-		    status = "Reduced by ";
+		string status;
+		if (out_size == in_size) {
+		    status = "Size unchanged (";
 		} else {
-		    delta = out_size - in_size;
-		    status = "INCREASED by ";
-		}
-		if (in_size) {
-		    status += str(100 * delta / in_size);
-		    status += "% ";
+		    off_t delta;
+		    if (out_size < in_size) {
+			delta = in_size - out_size;
+			status = "Reduced by ";
+		    } else {
+			delta = out_size - in_size;
+			status = "INCREASED by ";
+		    }
+		    if (in_size) {
+			status += str(100 * delta / in_size);
+			status += "% ";
+		    }
+		    status += str(delta);
+		    status += "K (";
+		    status += str(in_size);
+		    status += "K -> ";
 		}
-		status += str(delta);
-		status += "K (";
-		status += str(in_size);
-		status += "K -> ";
-	    }
-	    status += str(out_size);
-	    status += "K)";
-	    if (compactor)
-		compactor->set_status(t->name, status);
+		status += str(out_size);
+		status += "K)";
+		if (compactor)
+		    compactor->set_status(t->name, status);
+	    }
+	};
+	if (parallelism > 1) {
+	    merges.push_back(merge);
+	} else {
+	    merge();
 	}
     }
 
+    run_in_parallel(merges.size(), parallelism, [&](size_t i) {
+	merges[i]();
+    });
+
     // If compacting to a single file output and all the tables are empty, pad
     // the output so that it isn't mistaken for a stub database when we try to
     // open it.  For this it needs to at least HONEY_MIN_DB_SIZE in size.
@@ -2447,6 +2807,9 @@ if (source_backend == Xapian::DB_BACKEND_GLASS) {
     }
 #endif
 } else {
+    // Merges to run in parallel once all the output tables are set up.
+    vector<function<void()>> merges;
+
     vector<HoneyTable*> tabs;
     tabs.reserve(tables_end - tables);
     off_t prev_size = HONEY_MIN_DB_SIZE;
@@ -2579,6 +2942,13 @@ if (source_backend == Xapian::DB_BACKEND_GLASS) {
 	}
 	tabs.push_back(out);
 	Honey::RootInfo* root_info = version_file_out->root_to_set(t->type);
+	if (t->type == Honey::POSITION) {
+	    // Keep the first source's position list encoding unless we've
+	    // been asked to pack them.
+	    root_info->set_encoding(packed_positions ?
+				    unsigned(POSITIONS_PACKED) :
+				    inputs[0]->get_encoding());
+	}
 	if (single_file) {
 	    root_info->set_free_list(fl_serialised);
 	    root_info->set_offset(table_start_offset);
@@ -2589,97 +2959,116 @@ if (source_backend == Xapian::DB_BACKEND_GLASS) {
 	    out->create_and_open(FLAGS, *root_info);
 	}
 
-	switch (t->type) {
-	    case Honey::POSTLIST: {
-		if (multipass && inputs.size() > 3) {
-		    multimerge_postlists(compactor, out, destdir,
-					 inputs, offset);
-		} else {
-		    merge_postlists(compactor, out, offset.begin(),
-				    inputs.begin(), inputs.end());
+	// Merge the table and report how it went.  We can't start this
+	// until all the output tables exist if we're going to merge them in
+	// parallel.
+	auto merge = [=, &fl_serialised, &prev_size,
+		      &totals_mutex, &out_total, &bad_totals]() mutable {
+	    switch (t->type) {
+		case Honey::POSTLIST: {
+		    if (multipass && inputs.size() > 3) {
+			multimerge_postlists(compactor, out, destdir,
+					     inputs, offset, block_postings,
+					     parallelism);
+		    } else {
+			merge_postlists(compactor, out, offset.begin(),
+					inputs.begin(), inputs.end(),
+					block_postings);
+		    }
+		    break;
 		}
-		break;
+		case Honey::SPELLING:
+		    merge_spellings(out, inputs.begin(), inputs.end());
+		    break;
+		case Honey::SYNONYM:
+		    merge_synonyms(out, inputs.begin(), inputs.end());
+		    break;
+		case Honey::POSITION:
+		    merge_positions(out, inputs, offset);
+		    break;
+		default:
+		    // DocData, Termlist
+		    merge_docid_keyed(out, inputs, offset);
+		    break;
 	    }
-	    case Honey::SPELLING:
-		merge_spellings(out, inputs.begin(), inputs.end());
-		break;
-	    case Honey::SYNONYM:
-		merge_synonyms(out, inputs.begin(), inputs.end());
-		break;
-	    case Honey::POSITION:
-		merge_positions(out, inputs, offset);
-		break;
-	    default:
-		// DocData, Termlist
-		merge_docid_keyed(out, inputs, offset);
-		break;
-	}
 
-	// Commit as revision 1.
-	out->flush_db();
-	out->commit(1, root_info);
-	out->sync();
-	if (single_file) fl_serialised = root_info->get_free_list();
+	    // Commit as revision 1.
+	    out->flush_db();
+	    out->commit(1, root_info);
+	    out->sync();
+	    if (single_file) fl_serialised = root_info->get_free_list();
 
-	off_t out_size = 0;
-	if (!bad_stat && !single_file_in) {
-	    off_t db_size;
-	    if (single_file) {
-		db_size = file_size(fd);
-	    } else {
-		db_size = file_size(dest + HONEY_TABLE_EXTENSION);
-	    }
-	    if (errno == 0) {
+	    off_t out_size = 0;
+	    if (!bad_stat && !single_file_in) {
+		off_t db_size;
 		if (single_file) {
-		    off_t old_prev_size = prev_size;
-		    prev_size = db_size;
-		    db_size -= old_prev_size;
+		    db_size = file_size(fd);
+		} else {
+		    db_size = file_size(dest + HONEY_TABLE_EXTENSION);
+		}
+		if (errno == 0) {
+		    if (single_file) {
+			off_t old_prev_size = prev_size;
+			prev_size = db_size;
+			db_size -= old_prev_size;
+		    }
+		    // FIXME: check overflow and set bad_totals
+		    LOCK_COMPACTION(totals_mutex);
+		    out_total += db_size;
+		    out_size = db_size / 1024;
+		} else if (errno != ENOENT) {
+		    LOCK_COMPACTION(totals_mutex);
+		    bad_totals = bad_stat = true;
 		}
-		// FIXME: check overflow and set bad_totals
-		out_total += db_size;
-		out_size = db_size / 1024;
-	    } else if (errno != ENOENT) {
-		bad_totals = bad_stat = true;
 	    }
-	}
-	if (bad_stat) {
-	    if (compactor)
-		compactor->set_status(t->name,
-				      "Done (couldn't stat all the DB files)");
-	} else if (single_file_in) {
-	    if (compactor)
-		compactor->set_status(t->name,
-				      "Done (table sizes unknown for single "
-				      "file DB input)");
-	} else {
-	    string status;
-	    if (out_size == in_size) {
-		status = "Size unchanged (";
+	    if (bad_stat) {
+		if (compactor)
+		    compactor->set_status(t->name,
+					  "Done (couldn't stat all the DB files)");
+	    } else if (single_file_in) {
+		if (compactor)
+		    compactor->set_status(t->name,
+					  "Done (table sizes unknown for single "
+					  "file DB input)");
 	    } else {
-		off_t delta;
-		if (out_size < in_size) {
-		    delta = in_size - out_size;
-		    status = "Reduced by ";
+		string status;
+		if (out_size == in_size) {
+		    status = "Size unchanged (";
 		} else {
-		    delta = out_size - in_size;
-		    status = "INCREASED by ";
-		}
-		if (in_size) {
-		    status += str(100 * delta / in_size);
-		    status += "% ";
+		    off_t delta;
+		    if (out_size < in_size) {
+			delta = in_size - out_size;
+			status = "Reduced by ";
+		    } else {
+			delta = out_size - in_size;
+			status = "INCREASED by ";
+		    }
+		    if (in_size) {
+			status += str(100 * delta / in_size);
+			status += "% ";
+		    }
+		    status += str(delta);
+		    status += "K (";
+		    status += str(in_size);
+		    status += "K -> ";
 		}
-		status += str(delta);
-		status += "K (";
-		status += str(in_size);
-		status += "K -> ";
-	    }
-	    status += str(out_size);
-	    status += "K)";
-	    if (compactor)
-		compactor->set_status(t->name, status);
+		status += str(out_size);
+		status += "K)";
+		if (compactor)
+		    compactor->set_status(t->name, status);
+	    }
+	};
+	if (parallelism > 1) {
+	    merges.push_back(merge);
+	} else {
+	    merge();
 	}
     }
 
+    run_in_parallel(merges.size(), parallelism, [&](size_t i) {
+	merges[i]();
+    });
+
     // If compacting to a single file output and all the tables are empty, pad
     // the output so that it isn't mistaken for a stub database when we try to
     // open it.  For this it needs to at least HONEY_MIN_DB_SIZE in size.
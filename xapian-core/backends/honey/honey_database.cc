@@ -49,7 +49,8 @@ HoneyDatabase::throw_termlist_table_close_exception() const
 static_assert(Xapian::DB_READONLY_ & Xapian::DB_NO_TERMLIST,
 	"Xapian::DB_READONLY_ should imply Xapian::DB_NO_TERMLIST");
 
-HoneyDatabase::HoneyDatabase(const std::string& path_, int flags)
+HoneyDatabase::HoneyDatabase(const std::string& path_, int flags,
+			     bool use_mmap)
     : Xapian::Database::Internal(TRANSACTION_READONLY),
       path(path_),
       version_file(path_),
@@ -63,6 +64,8 @@ HoneyDatabase::HoneyDatabase(const std::string& path_, int flags)
       termlist_table(path_, true, (flags & Xapian::DB_NO_TERMLIST)),
       value_manager(postlist_table, termlist_table)
 {
+    if (use_mmap)
+	set_tables_use_mmap();
     version_file.read();
     auto rev = version_file.get_revision();
     docdata_table.open(flags, version_file.get_root(Honey::DOCDATA), rev);
@@ -73,7 +76,7 @@ HoneyDatabase::HoneyDatabase(const std::string& path_, int flags)
     termlist_table.open(flags, version_file.get_root(Honey::TERMLIST), rev);
 }
 
-HoneyDatabase::HoneyDatabase(int fd, int flags)
+HoneyDatabase::HoneyDatabase(int fd, int flags, bool use_mmap)
     : Xapian::Database::Internal(TRANSACTION_READONLY),
       version_file(fd),
       docdata_table(fd, version_file.get_offset(), true),
@@ -87,6 +90,8 @@ HoneyDatabase::HoneyDatabase(int fd, int flags)
 		     (flags & Xapian::DB_NO_TERMLIST)),
       value_manager(postlist_table, termlist_table)
 {
+    if (use_mmap)
+	set_tables_use_mmap();
     version_file.read();
     auto rev = version_file.get_revision();
     docdata_table.open(flags, version_file.get_root(Honey::DOCDATA), rev);
@@ -97,6 +102,17 @@ HoneyDatabase::HoneyDatabase(int fd, int flags)
     termlist_table.open(flags, version_file.get_root(Honey::TERMLIST), rev);
 }
 
+void
+HoneyDatabase::set_tables_use_mmap()
+{
+    docdata_table.set_use_mmap();
+    postlist_table.set_use_mmap();
+    position_table.set_use_mmap();
+    spelling_table.set_use_mmap();
+    synonym_table.set_use_mmap();
+    termlist_table.set_use_mmap();
+}
+
 HoneyDatabase::~HoneyDatabase()
 {
     delete doclen_cursor;
@@ -485,6 +501,14 @@ HoneyDatabase::get_backend_info(string* path_ptr) const
     return BACKEND_HONEY;
 }
 
+int
+HoneyDatabase::get_open_flags() const
+{
+    int flags = Xapian::DB_BACKEND_HONEY;
+    if (postlist_table.get_use_mmap()) flags |= Xapian::DB_MMAP;
+    return flags;
+}
+
 void
 HoneyDatabase::get_used_docid_range(Xapian::docid& first,
 				    Xapian::docid& last) const
@@ -84,12 +84,17 @@ class HoneyDatabase : public Xapian::Database::Internal {
     [[noreturn]]
     void throw_termlist_table_close_exception() const;
 
+    /// Make all the tables read through memory mappings.
+    void set_tables_use_mmap();
+
   public:
     explicit
-    HoneyDatabase(const std::string& path_, int flags = Xapian::DB_READONLY_);
+    HoneyDatabase(const std::string& path_, int flags = Xapian::DB_READONLY_,
+		  bool use_mmap = false);
 
     explicit
-    HoneyDatabase(int fd, int flags = Xapian::DB_READONLY_);
+    HoneyDatabase(int fd, int flags = Xapian::DB_READONLY_,
+		  bool use_mmap = false);
 
     ~HoneyDatabase();
 
@@ -372,6 +377,8 @@ class HoneyDatabase : public Xapian::Database::Internal {
      */
     int get_backend_info(std::string* path) const;
 
+    int get_open_flags() const;
+
     /** Find lowest and highest docids actually in use.
      *
      *  Only used by compaction, so only needs to be implemented by
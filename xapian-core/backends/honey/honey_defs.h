@@ -46,6 +46,13 @@
  */
 #define HONEY_POSTLIST_CHUNK_MAX 2000
 
+/** Number of entries in each block of posting data in the blocked encoding.
+ *
+ *  This is a multiple of 4 so that the SIMD prefix sum used when decoding
+ *  has no leftover entries for a full block.
+ */
+#define HONEY_POSTLIST_BLOCK_SIZE 128
+
 // Maximum size of a document length chunk in bytes.
 #define HONEY_DOCLEN_CHUNK_MAX 2017
 
@@ -75,6 +82,18 @@ enum table_type {
     MAX_
 };
 
+/** Encodings for the posting data in a term's postlist chunks.
+ *
+ *  The encoding is stored in the initial chunk header for terms with tf > 2
+ *  (terms with tf <= 2 don't have any posting data).
+ */
+enum postings_encoding {
+    /// Each entry encoded with pack_uint().
+    POSTINGS_VARINT = 0,
+    /// Bit-packed blocks of entries (see honey_postlist_blocks.h).
+    POSTINGS_BLOCKED = 1
+};
+
 /// Postlist key second bytes when first byte is zero.
 enum {
     KEY_USER_METADATA = 0x00,
@@ -29,6 +29,7 @@
 #include "debuglog.h"
 #include "honey_cursor.h"
 #include "pack.h"
+#include "packedpositions.h"
 
 #include <string>
 
@@ -44,6 +45,10 @@ HoneyPositionTable::pack(string& s,
     pack_uint(s, vec.back());
 
     if (vec.size() > 1) {
+	if (is_packed()) {
+	    encode_packed_positions(s, vec);
+	    return;
+	}
 	BitWriter wr(s);
 	wr.encode(vec[0], vec.back());
 	wr.encode(vec.size() - 2, vec.back() - vec[0]);
@@ -74,6 +79,14 @@ HoneyPositionTable::positionlist_count(Xapian::docid did,
 	RETURN(1);
     }
 
+    if (is_packed()) {
+	Xapian::termcount pos_size;
+	if (!unpack_uint(&pos, end, &pos_size)) {
+	    throw Xapian::DatabaseCorruptError("Position list data corrupt");
+	}
+	RETURN(pos_size + 2);
+    }
+
     // Skip the header we just read.
     BitReader rd(pos, end);
     Xapian::termpos pos_first = rd.decode(pos_last);
@@ -112,10 +125,16 @@ HoneyBasePositionList::set_data(const string& data)
 	return;
     }
 
-    rd.init(pos, end);
-    Xapian::termpos pos_first = rd.decode(pos_last);
-    Xapian::termpos pos_size = rd.decode(pos_last - pos_first) + 2;
-    rd.decode_interpolative(0, pos_size - 1, pos_first, pos_last);
+    Xapian::termpos pos_first;
+    Xapian::termcount pos_size;
+    if (packed) {
+	pos_size = packed_rd.init(pos, end, pos_first);
+    } else {
+	rd.init(pos, end);
+	pos_first = rd.decode(pos_last);
+	pos_size = rd.decode(pos_last - pos_first) + 2;
+	rd.decode_interpolative(0, pos_size - 1, pos_first, pos_last);
+    }
     size = pos_size;
     last = pos_last;
     current_pos = pos_first;
@@ -154,7 +173,11 @@ HoneyBasePositionList::next()
     if (current_pos == last) {
 	return false;
     }
-    current_pos = rd.decode_interpolative_next();
+    if (packed) {
+	current_pos = packed_rd.next();
+    } else {
+	current_pos = rd.decode_interpolative_next();
+    }
     return true;
 }
 
@@ -170,6 +193,11 @@ HoneyBasePositionList::skip_to(Xapian::termpos termpos)
 	}
 	return false;
     }
+    if (packed) {
+	// The blocks record where they end, so we can skip whole blocks.
+	if (current_pos < termpos) current_pos = packed_rd.skip_to(termpos);
+	return true;
+    }
     while (current_pos < termpos) {
 	if (current_pos == last) {
 	    return false;
@@ -179,9 +207,10 @@ HoneyBasePositionList::skip_to(Xapian::termpos termpos)
     return true;
 }
 
-HoneyPositionList::HoneyPositionList(string&& data)
+HoneyPositionList::HoneyPositionList(string&& data, bool packed_)
+    : HoneyBasePositionList(packed_)
 {
-    LOGCALL_CTOR(DB, "HoneyPositionList", data);
+    LOGCALL_CTOR(DB, "HoneyPositionList", data | packed_);
 
     pos_data = std::move(data);
 
@@ -191,6 +220,7 @@ HoneyPositionList::HoneyPositionList(string&& data)
 HoneyPositionList::HoneyPositionList(const HoneyTable& table,
 				     Xapian::docid did,
 				     const string& term)
+    : HoneyBasePositionList(table.get_encoding() == POSITIONS_PACKED)
 {
     LOGCALL_CTOR(DB, "HoneyPositionList", table | did | term);
 
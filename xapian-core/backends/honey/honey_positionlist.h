@@ -29,6 +29,7 @@
 #include "honey_cursor.h"
 #include "honey_lazytable.h"
 #include "pack.h"
+#include "packedpositions.h"
 
 #include <string>
 
@@ -58,11 +59,16 @@ class HoneyPositionTable : public HoneyLazyTable {
 	: HoneyLazyTable("position", fd, offset_, readonly_) { }
 
     /** Pack a position list into a string.
+     *
+     *  The encoding used is the one recorded for the table.
      *
      *  @param s The string to append the position list data to.
      */
     void pack(string& s, const Xapian::VecCOW<Xapian::termpos>& vec) const;
 
+    /// Are entries stored in the packed encoding?
+    bool is_packed() const { return get_encoding() == POSITIONS_PACKED; }
+
     /** Set the position list for term tname in document did.
      */
     void set_positionlist(Xapian::docid did, const string& tname,
@@ -92,6 +98,12 @@ class HoneyBasePositionList : public PositionList {
     /// Interpolative decoder.
     BitReader rd;
 
+    /// Decoder for the packed encoding.
+    PackedPositionReader packed_rd;
+
+    /// Is the data in the packed encoding?
+    bool packed;
+
     /// Current entry.
     Xapian::termpos current_pos;
 
@@ -112,8 +124,9 @@ class HoneyBasePositionList : public PositionList {
     void set_data(const string& data);
 
   public:
-    /// Default constructor.
-    HoneyBasePositionList() {}
+    /// Constructor.
+    explicit
+    HoneyBasePositionList(bool packed_) : packed(packed_) {}
 
     /// Returns size of position list.
     Xapian::termcount get_approx_size() const;
@@ -146,9 +159,12 @@ class HoneyPositionList : public HoneyBasePositionList {
     HoneyPositionList& operator=(const HoneyPositionList&) = delete;
 
   public:
-    /// Construct and initialise with data.
-    explicit
-    HoneyPositionList(string&& data);
+    /** Construct and initialise with data.
+     *
+     *  @param data	The positional data.
+     *  @param packed_	Is @a data in the packed encoding?
+     */
+    HoneyPositionList(string&& data, bool packed_);
 
     /// Construct and initialise with data.
     HoneyPositionList(const HoneyTable& table,
@@ -171,7 +187,8 @@ class HoneyRePositionList : public HoneyBasePositionList {
     /// Constructor.
     explicit
     HoneyRePositionList(const HoneyTable& table)
-	: cursor(&table) {}
+	: HoneyBasePositionList(table.get_encoding() == POSITIONS_PACKED),
+	  cursor(&table) {}
 
     /** Fill list with data, and move the position to the start. */
     void assign_data(string&& data);
@@ -73,10 +73,17 @@ HoneyPostList::HoneyPostList(const HoneyDatabase* db_,
     Xapian::termcount first_wdf;
     Xapian::docid chunk_last;
     Xapian::termcount wdf_max;
+    Xapian::termcount chunk_wdf_max;
+    Xapian::termcount chunk_doclen_min;
+    unsigned encoding;
     if (!decode_initial_chunk_header(&p, pend, tf, cf,
 				     first_did, last_did,
-				     chunk_last, first_wdf, wdf_max))
+				     chunk_last, first_wdf, wdf_max,
+				     chunk_wdf_max, chunk_doclen_min,
+				     encoding))
 	throw Xapian::DatabaseCorruptError("Postlist initial chunk header");
+    if (encoding != POSTINGS_VARINT && encoding != POSTINGS_BLOCKED)
+	throw Xapian::DatabaseCorruptError("Unknown postlist encoding");
 
     Xapian::termcount cf_info = cf;
     if (cf == 0) {
@@ -106,8 +113,9 @@ HoneyPostList::HoneyPostList(const HoneyDatabase* db_,
 	}
     }
 
-    reader.init(tf, cf_info);
-    reader.assign(p, pend - p, first_did, last_did, first_wdf);
+    reader.init(tf, cf_info, encoding);
+    reader.assign(p, pend - p, first_did, chunk_last, first_wdf,
+		  chunk_wdf_max, chunk_doclen_min);
 }
 
 HoneyPostList::~HoneyPostList()
@@ -165,6 +173,18 @@ HoneyPostList::at_end() const
     return cursor == NULL;
 }
 
+bool
+HoneyPostList::get_block_bounds(Xapian::docid& block_last,
+				 Xapian::termcount& wdf_max,
+				 Xapian::termcount& doclen_min) const
+{
+    if (!cursor) return false;
+    block_last = reader.get_last_did_in_chunk();
+    wdf_max = reader.get_wdf_max_in_chunk();
+    doclen_min = reader.get_doclen_min_in_chunk();
+    return true;
+}
+
 PositionList*
 HoneyPostList::open_position_list() const
 {
@@ -201,6 +221,24 @@ HoneyPostList::next(double)
     return NULL;
 }
 
+Xapian::doccount
+HoneyPostList::next_batch(Xapian::docid did_max,
+			  Xapian::docid* dids,
+			  Xapian::termcount* wdfs,
+			  Xapian::doccount n)
+{
+    AssertRel(n,>,0);
+    Xapian::doccount count = 0;
+    do {
+	// Qualify the call so it isn't virtual and can be inlined.
+	(void)HoneyPostList::next(0.0);
+	if (!cursor) break;
+	dids[count] = reader.get_docid();
+	wdfs[count++] = reader.get_wdf();
+    } while (reader.get_docid() <= did_max && count != n);
+    return count;
+}
+
 PostList*
 HoneyPostList::skip_to(Xapian::docid did, double)
 {
@@ -287,31 +325,99 @@ PostingChunkReader::assign(const char* p_, size_t len,
 			   Xapian::docid chunk_last)
 {
     const char* pend = p_ + len;
-    if (collfreq_info ?
-	!decode_delta_chunk_header(&p_, pend, chunk_last, did, wdf) :
-	!decode_delta_chunk_header_no_wdf(&p_, pend, chunk_last, did)) {
-	throw Xapian::DatabaseCorruptError("Postlist delta chunk header");
+    // We must be past the first entry in the posting list now, so handle
+    // the "constant wdf apart from maybe the first entry" case.
+    if (collfreq_info & TOP_BIT_SET(decltype(collfreq_info))) {
+	wdf = collfreq_info &~ TOP_BIT_SET(decltype(collfreq_info));
+	collfreq_info = 0;
+    }
+    if (collfreq_info) {
+	if (!decode_delta_chunk_header(&p_, pend, chunk_last, did, wdf,
+				       chunk_wdf_max, chunk_doclen_min)) {
+	    throw Xapian::DatabaseCorruptError("Postlist delta chunk header");
+	}
+    } else {
+	if (!decode_delta_chunk_header_no_wdf(&p_, pend, chunk_last, did,
+					      chunk_doclen_min)) {
+	    throw Xapian::DatabaseCorruptError("Postlist delta chunk header");
+	}
+	// The wdf is the same for every entry in this chunk.
+	chunk_wdf_max = wdf;
     }
     p = p_;
     end = pend;
     last_did = chunk_last;
+    block_pos = block_n = 0;
 }
 
 void
 PostingChunkReader::assign(const char* p_, size_t len, Xapian::docid did_,
 			   Xapian::docid last_did_in_chunk,
-			   Xapian::termcount wdf_)
+			   Xapian::termcount wdf_,
+			   Xapian::termcount wdf_max_in_chunk,
+			   Xapian::termcount doclen_min_in_chunk)
 {
     p = p_;
     end = p_ + len;
     did = did_;
     last_did = last_did_in_chunk;
     wdf = wdf_;
+    chunk_wdf_max = wdf_max_in_chunk;
+    chunk_doclen_min = doclen_min_in_chunk;
+    block_pos = block_n = 0;
+}
+
+void
+PostingChunkReader::read_block(Xapian::docid base, Xapian::docid target)
+{
+    bool have_wdfs = (collfreq_info != 0);
+    while (true) {
+	if (rare(p == end))
+	    throw Xapian::DatabaseCorruptError("postlist block missing");
+	unsigned n, did_width, wdf_width;
+	Xapian::docid increase;
+	if (!decode_posting_block_header(&p, end, have_wdfs,
+					 n, increase, did_width, wdf_width)) {
+	    throw Xapian::DatabaseCorruptError("postlist block header");
+	}
+	size_t len = posting_block_data_size(n, did_width, wdf_width);
+	if (base + increase >= target) {
+	    decode_posting_block(p, end, n, did_width, wdf_width, base, *block);
+	    p += len;
+	    block_pos = 0;
+	    block_n = n;
+	    return;
+	}
+	// Skip this block without decoding it.
+	p += len;
+	base += increase;
+    }
 }
 
 bool
 PostingChunkReader::next()
 {
+    if (block) {
+	if (++block_pos < block_n) {
+	    did = block->did[block_pos];
+	    if (collfreq_info) wdf = block->wdf[block_pos];
+	    return true;
+	}
+	if (p == end) {
+	    p = NULL;
+	    return false;
+	}
+	// The "constant wdf apart from maybe the first entry" case.
+	if (collfreq_info & TOP_BIT_SET(decltype(collfreq_info))) {
+	    wdf = collfreq_info &~ TOP_BIT_SET(decltype(collfreq_info));
+	    collfreq_info = 0;
+	}
+	read_block(did, 0);
+	did = block->did[0];
+	if (collfreq_info) wdf = block->wdf[0];
+	return true;
+    }
+
     if (p == end) {
 	if (termfreq == 2 && did != last_did) {
 	    did = last_did;
@@ -356,6 +462,21 @@ PostingChunkReader::skip_to(Xapian::docid target)
 	return false;
     }
 
+    if (block) {
+	// The "constant wdf apart from maybe the first entry" case.
+	if (collfreq_info & TOP_BIT_SET(decltype(collfreq_info))) {
+	    wdf = collfreq_info &~ TOP_BIT_SET(decltype(collfreq_info));
+	    collfreq_info = 0;
+	}
+	if (block_n == 0 || block->did[block_n - 1] < target) {
+	    read_block(block_n ? block->did[block_n - 1] : did, target);
+	}
+	while (block->did[block_pos] < target) ++block_pos;
+	did = block->did[block_pos];
+	if (collfreq_info) wdf = block->wdf[block_pos];
+	return true;
+    }
+
     if (p == end) {
 	// Given the checks above, this must be the termfreq == 2 case with the
 	// current position being on the first entry, and so skip_to() must
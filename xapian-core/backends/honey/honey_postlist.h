@@ -24,8 +24,10 @@
 
 #include "backends/leafpostlist.h"
 #include "honey_positionlist.h"
+#include "honey_postlist_blocks.h"
 #include "pack.h"
 
+#include <memory>
 #include <string>
 
 class HoneyCursor;
@@ -85,6 +87,12 @@ class PostingChunkReader {
     /// The last docid in this chunk.
     Xapian::docid last_did;
 
+    /// Upper bound on the wdf of entries in this chunk.
+    Xapian::termcount chunk_wdf_max;
+
+    /// Lower bound on the length of documents in this chunk.
+    Xapian::termcount chunk_doclen_min;
+
     Xapian::doccount termfreq;
 
     /** Value "to do with" collection frequency.
@@ -110,6 +118,25 @@ class PostingChunkReader {
      */
     Xapian::termcount collfreq_info;
 
+    /** Decoded entries if the posting data uses the blocked encoding.
+     *
+     *  NULL for the usual encoding.  With the blocked encoding, p points to
+     *  the header of the next block to decode.
+     */
+    std::unique_ptr<PostingBlock> block;
+
+    /// Index of the current entry in @a block.
+    unsigned block_pos = 0;
+
+    /// Number of entries in @a block (0 if we haven't decoded a block yet).
+    unsigned block_n = 0;
+
+    /** Decode the first block with a last docid >= @a target.
+     *
+     *  @param base	The docid of the entry before the block at p.
+     */
+    void read_block(Xapian::docid base, Xapian::docid target);
+
   public:
     /// Create an uninitialised PostingChunkReader.
     PostingChunkReader() : p(NULL) { }
@@ -121,17 +148,25 @@ class PostingChunkReader {
     }
 
     /// Initialise.
-    void init(Xapian::doccount tf, Xapian::termcount cf_info) {
+    void init(Xapian::doccount tf, Xapian::termcount cf_info,
+	      unsigned encoding) {
 	p = NULL;
 	termfreq = tf;
 	collfreq_info = cf_info;
+	if (encoding == POSTINGS_BLOCKED) {
+	    if (!block) block.reset(new PostingBlock);
+	} else {
+	    block.reset();
+	}
     }
 
     void assign(const char* p_, size_t len, Xapian::docid did);
 
     void assign(const char* p_, size_t len, Xapian::docid did_,
 		Xapian::docid last_did_in_chunk,
-		Xapian::termcount wdf_);
+		Xapian::termcount wdf_,
+		Xapian::termcount wdf_max_in_chunk,
+		Xapian::termcount doclen_min_in_chunk);
 
     bool at_end() const { return p == NULL; }
 
@@ -141,6 +176,14 @@ class PostingChunkReader {
 
     Xapian::termcount get_wdf() const { return wdf; }
 
+    Xapian::docid get_last_did_in_chunk() const { return last_did; }
+
+    Xapian::termcount get_wdf_max_in_chunk() const { return chunk_wdf_max; }
+
+    Xapian::termcount get_doclen_min_in_chunk() const {
+	return chunk_doclen_min;
+    }
+
     /// Advance, returning false if we've run out of data.
     bool next();
 
@@ -197,12 +240,21 @@ class HoneyPostList : public LeafPostList {
 
     bool at_end() const;
 
+    bool get_block_bounds(Xapian::docid& block_last,
+			  Xapian::termcount& wdf_max,
+			  Xapian::termcount& doclen_min) const;
+
     PositionList* open_position_list() const;
 
     PostList* next(double w_min);
 
     PostList* skip_to(Xapian::docid did, double w_min);
 
+    Xapian::doccount next_batch(Xapian::docid did_max,
+				Xapian::docid* dids,
+				Xapian::termcount* wdfs,
+				Xapian::doccount n);
+
     std::string get_description() const;
 };
 
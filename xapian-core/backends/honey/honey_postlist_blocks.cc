@@ -0,0 +1,151 @@
+/** @file honey_postlist_blocks.cc
+ * @brief Blocked encoding of posting data in honey postlist chunks
+ */
+/* Copyright (C) 2026 Xapian contributors
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301 USA
+ */
+
+#include <config.h>
+
+#include "honey_postlist_blocks.h"
+
+#include "bitpack.h"
+#include "omassert.h"
+#include "pack.h"
+#include "xapian/error.h"
+
+#include <cstring>
+
+using namespace std;
+
+namespace Honey {
+
+void
+encode_postings_blocked(const char* p, const char* end,
+			bool have_wdfs, string& out)
+{
+    Xapian::docid deltas[HONEY_POSTLIST_BLOCK_SIZE];
+    Xapian::termcount wdfs[HONEY_POSTLIST_BLOCK_SIZE];
+    while (p != end) {
+	unsigned n = 0;
+	Xapian::docid sum = 0;
+	Xapian::docid deltas_or = 0;
+	Xapian::termcount wdfs_or = 0;
+	do {
+	    if (!unpack_uint(&p, end, &deltas[n]))
+		throw Xapian::DatabaseCorruptError("postlist docid delta");
+	    sum += deltas[n];
+	    deltas_or |= deltas[n];
+	    if (have_wdfs) {
+		if (!unpack_uint(&p, end, &wdfs[n]))
+		    throw Xapian::DatabaseCorruptError("postlist wdf");
+		wdfs_or |= wdfs[n];
+	    }
+	} while (++n != HONEY_POSTLIST_BLOCK_SIZE && p != end);
+
+	pack_uint(out, n - 1);
+	pack_uint(out, sum);
+	unsigned did_width = bit_width(deltas_or);
+	out += char(did_width);
+	unsigned wdf_width = 0;
+	if (have_wdfs) {
+	    wdf_width = bit_width(wdfs_or);
+	    out += char(wdf_width);
+	}
+	pack_bits(out, deltas, n, did_width);
+	pack_bits(out, wdfs, n, wdf_width);
+    }
+}
+
+bool
+decode_posting_block_header(const char** p, const char* end,
+			    bool have_wdfs,
+			    unsigned& n,
+			    Xapian::docid& increase,
+			    unsigned& did_width,
+			    unsigned& wdf_width)
+{
+    if (!unpack_uint(p, end, &n) ||
+	n >= HONEY_POSTLIST_BLOCK_SIZE ||
+	!unpack_uint(p, end, &increase) ||
+	*p == end) {
+	return false;
+    }
+    ++n;
+    increase += n;
+    did_width = static_cast<unsigned char>(*(*p)++);
+    if (did_width > sizeof(Xapian::docid) * 8)
+	return false;
+    wdf_width = 0;
+    if (have_wdfs) {
+	if (*p == end)
+	    return false;
+	wdf_width = static_cast<unsigned char>(*(*p)++);
+	if (wdf_width > sizeof(Xapian::termcount) * 8)
+	    return false;
+    }
+    size_t len = posting_block_data_size(n, did_width, wdf_width);
+    return size_t(end - *p) >= len;
+}
+
+void
+decode_posting_block(const char* p, const char* end,
+		     unsigned n, unsigned did_width, unsigned wdf_width,
+		     Xapian::docid base,
+		     PostingBlock& block)
+{
+    // unpack_bits() reads up to 9 bytes beyond the start of the last value,
+    // so copy the data to a padded buffer if it is too close to the end.
+    size_t len = posting_block_data_size(n, did_width, wdf_width);
+    AssertRel(size_t(end - p), >=, len);
+    unsigned char buf[HONEY_POSTLIST_BLOCK_SIZE * 16 + BITPACK_PADDING];
+    const unsigned char* data = reinterpret_cast<const unsigned char*>(p);
+    if (size_t(end - p) < len + BITPACK_PADDING) {
+	memcpy(buf, p, len);
+	memset(buf + len, 0, BITPACK_PADDING);
+	data = buf;
+    }
+
+    unpack_bits(data, n, did_width, block.did);
+    deltas_to_values(block.did, n, base);
+    data += packed_size(n, did_width);
+    unpack_bits(data, n, wdf_width, block.wdf);
+}
+
+void
+decode_postings_blocked(const char* p, const char* end,
+			bool have_wdfs, string& out)
+{
+    PostingBlock block;
+    Xapian::docid base = 0;
+    while (p != end) {
+	unsigned n, did_width, wdf_width;
+	Xapian::docid increase;
+	if (!decode_posting_block_header(&p, end, have_wdfs,
+					 n, increase, did_width, wdf_width)) {
+	    throw Xapian::DatabaseCorruptError("postlist block header");
+	}
+	decode_posting_block(p, end, n, did_width, wdf_width, base, block);
+	p += posting_block_data_size(n, did_width, wdf_width);
+	for (unsigned i = 0; i != n; ++i) {
+	    pack_uint(out, block.did[i] - base - 1);
+	    base = block.did[i];
+	    if (have_wdfs) pack_uint(out, block.wdf[i]);
+	}
+    }
+}
+
+}
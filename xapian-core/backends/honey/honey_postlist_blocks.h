@@ -0,0 +1,123 @@
+/** @file honey_postlist_blocks.h
+ * @brief Blocked encoding of posting data in honey postlist chunks
+ */
+/* Copyright (C) 2026 Xapian contributors
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301 USA
+ */
+
+#ifndef XAPIAN_INCLUDED_HONEY_POSTLIST_BLOCKS_H
+#define XAPIAN_INCLUDED_HONEY_POSTLIST_BLOCKS_H
+
+#include "honey_defs.h"
+#include "xapian/types.h"
+
+#include <cstddef>
+#include <string>
+
+namespace Honey {
+
+/** Decoded entries from a block of posting data.
+ *
+ *  This is fairly large so PostingChunkReader only allocates one when it is
+ *  reading a posting list which uses the blocked encoding.
+ */
+struct PostingBlock {
+    Xapian::docid did[HONEY_POSTLIST_BLOCK_SIZE];
+
+    Xapian::termcount wdf[HONEY_POSTLIST_BLOCK_SIZE];
+};
+
+/** Convert posting data to the blocked encoding.
+ *
+ *  The input is posting data in the usual form (for each entry the docid
+ *  delta minus one, followed by the wdf if @a have_wdfs, each encoded with
+ *  pack_uint()).  In the blocked encoding, each group of up to
+ *  HONEY_POSTLIST_BLOCK_SIZE entries is stored as:
+ *
+ *  * pack_uint(number of entries - 1)
+ *  * pack_uint(sum of the stored docid deltas)
+ *  * a byte giving the bit width of the stored docid deltas
+ *  * a byte giving the bit width of the wdfs (only if @a have_wdfs)
+ *  * the stored docid deltas, bit-packed
+ *  * the wdfs, bit-packed (only if @a have_wdfs)
+ *
+ *  Values are packed least significant bit first, with each packed array
+ *  padded to a whole number of bytes.  Decoding fixed width values avoids
+ *  the data-dependent branches of pack_uint(), and the header means we can
+ *  skip a whole block without decoding it.
+ *
+ *  @param p,end	The posting data to convert.
+ *  @param have_wdfs	Does the posting data include wdfs?
+ *  @param out		String to append the converted data to.
+ */
+void encode_postings_blocked(const char* p, const char* end,
+			     bool have_wdfs, std::string& out);
+
+/** Convert posting data from the blocked encoding to the usual form.
+ *
+ *  @param p,end	The posting data to convert.
+ *  @param have_wdfs	Does the posting data include wdfs?
+ *  @param out		String to append the converted data to.
+ */
+void decode_postings_blocked(const char* p, const char* end,
+			     bool have_wdfs, std::string& out);
+
+/** Decode the header of a block of posting data.
+ *
+ *  @param p		Pointer to the header, which is updated to point to
+ *			the packed data.
+ *  @param end		End of the posting data.
+ *  @param have_wdfs	Does the posting data include wdfs?
+ *  @param n		Set to the number of entries in the block.
+ *  @param increase	Set to the docid of the last entry in the block minus
+ *			the docid of the entry before the block.
+ *  @param did_width	Set to the bit width of the stored docid deltas.
+ *  @param wdf_width	Set to the bit width of the wdfs (0 if !have_wdfs).
+ *
+ *  @return false if the header or the packed data which follows it is
+ *	    truncated or invalid.
+ */
+bool decode_posting_block_header(const char** p, const char* end,
+				 bool have_wdfs,
+				 unsigned& n,
+				 Xapian::docid& increase,
+				 unsigned& did_width,
+				 unsigned& wdf_width);
+
+/// The size in bytes of the packed data for a block.
+inline size_t
+posting_block_data_size(unsigned n, unsigned did_width, unsigned wdf_width)
+{
+    return (size_t(n) * did_width + 7) / 8 + (size_t(n) * wdf_width + 7) / 8;
+}
+
+/** Decode the packed data for a block.
+ *
+ *  @param p,end	The packed data (as found by
+ *			decode_posting_block_header()).
+ *  @param n,did_width,wdf_width	Values from the block header.
+ *  @param base		The docid of the entry before the block.
+ *  @param block	PostingBlock to fill in (the wdfs are all set to
+ *			zero if wdf_width is zero).
+ */
+void decode_posting_block(const char* p, const char* end,
+			  unsigned n, unsigned did_width, unsigned wdf_width,
+			  Xapian::docid base,
+			  PostingBlock& block);
+
+}
+
+#endif // XAPIAN_INCLUDED_HONEY_POSTLIST_BLOCKS_H
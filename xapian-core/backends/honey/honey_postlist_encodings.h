@@ -21,6 +21,7 @@
 #ifndef XAPIAN_INCLUDED_HONEY_POSTLIST_ENCODINGS_H
 #define XAPIAN_INCLUDED_HONEY_POSTLIST_ENCODINGS_H
 
+#include "honey_defs.h"
 #include "pack.h"
 
 inline void
@@ -31,6 +32,9 @@ encode_initial_chunk_header(Xapian::doccount termfreq,
 			    Xapian::docid chunk_last,
 			    Xapian::termcount first_wdf,
 			    Xapian::termcount wdf_max,
+			    Xapian::termcount chunk_wdf_max,
+			    Xapian::termcount chunk_doclen_min,
+			    unsigned encoding,
 			    std::string& out)
 {
     Assert(termfreq != 0);
@@ -94,6 +98,8 @@ encode_initial_chunk_header(Xapian::doccount termfreq,
 	pack_uint(out, termfreq - 3);
 	pack_uint(out, last - first - (termfreq - 1));
 	pack_uint(out, chunk_last - first);
+	pack_uint(out, chunk_doclen_min);
+	pack_uint(out, encoding);
     } else {
 	AssertRel(collfreq, >=, termfreq);
 	pack_uint(out, collfreq - termfreq + 1);
@@ -108,6 +114,18 @@ encode_initial_chunk_header(Xapian::doccount termfreq,
 	    AssertRel(wdf_max, >=, first_wdf);
 	    pack_uint(out, wdf_max - first_wdf);
 	}
+
+	// Bounds for the postings in this chunk, which allow the matcher to
+	// skip over chunks which can't contain a high enough scoring document.
+	// If this is the only chunk then chunk_wdf_max must equal wdf_max.
+	if (chunk_last != last) {
+	    AssertRel(chunk_wdf_max, <=, wdf_max);
+	    pack_uint(out, wdf_max - chunk_wdf_max);
+	} else {
+	    AssertEq(chunk_wdf_max, wdf_max);
+	}
+	pack_uint(out, chunk_doclen_min);
+	pack_uint(out, encoding);
     }
 }
 
@@ -119,8 +137,12 @@ decode_initial_chunk_header(const char** p, const char* end,
 			    Xapian::docid& last,
 			    Xapian::docid& chunk_last,
 			    Xapian::termcount& first_wdf,
-			    Xapian::termcount& wdf_max)
+			    Xapian::termcount& wdf_max,
+			    Xapian::termcount& chunk_wdf_max,
+			    Xapian::termcount& chunk_doclen_min,
+			    unsigned& encoding)
 {
+    encoding = Honey::POSTINGS_VARINT;
     if (!unpack_uint(p, end, &first)) {
 	return false;
     }
@@ -134,7 +156,8 @@ decode_initial_chunk_header(const char** p, const char* end,
 	// Single occurrence term.
 	termfreq = 1;
 	chunk_last = last = first;
-	wdf_max = first_wdf = collfreq;
+	chunk_wdf_max = wdf_max = first_wdf = collfreq;
+	chunk_doclen_min = 0;
 	return true;
     }
 
@@ -146,7 +169,8 @@ decode_initial_chunk_header(const char** p, const char* end,
 	chunk_last = last = first + termfreq + 1;
 	termfreq = 2;
 	first_wdf = collfreq / 2;
-	wdf_max = max(first_wdf, collfreq - first_wdf);
+	chunk_wdf_max = wdf_max = max(first_wdf, collfreq - first_wdf);
+	chunk_doclen_min = 0;
 	return true;
     }
 
@@ -159,7 +183,8 @@ decode_initial_chunk_header(const char** p, const char* end,
 	first_wdf = last;
 	chunk_last = last = first + termfreq + 1;
 	termfreq = 2;
-	wdf_max = max(first_wdf, collfreq - first_wdf);
+	chunk_wdf_max = wdf_max = max(first_wdf, collfreq - first_wdf);
+	chunk_doclen_min = 0;
 	return true;
     }
 
@@ -188,7 +213,15 @@ decode_initial_chunk_header(const char** p, const char* end,
 	}
     }
 
-    return true;
+    chunk_wdf_max = wdf_max;
+    if (collfreq != 0 && chunk_last != last) {
+	if (!unpack_uint(p, end, &chunk_wdf_max)) {
+	    return false;
+	}
+	chunk_wdf_max = wdf_max - chunk_wdf_max;
+    }
+    return unpack_uint(p, end, &chunk_doclen_min) &&
+	   unpack_uint(p, end, &encoding);
 }
 
 inline bool
@@ -247,42 +280,56 @@ inline void
 encode_delta_chunk_header(Xapian::docid chunk_first,
 			  Xapian::docid chunk_last,
 			  Xapian::termcount chunk_first_wdf,
+			  Xapian::termcount chunk_wdf_max,
+			  Xapian::termcount chunk_doclen_min,
 			  std::string& out)
 {
     Assert(chunk_first_wdf != 0);
+    AssertRel(chunk_wdf_max, >=, chunk_first_wdf);
     pack_uint(out, chunk_last - chunk_first);
     pack_uint(out, chunk_first_wdf - 1);
+    pack_uint(out, chunk_wdf_max - chunk_first_wdf);
+    pack_uint(out, chunk_doclen_min);
 }
 
 inline bool
 decode_delta_chunk_header(const char** p, const char* end,
 			  Xapian::docid chunk_last,
 			  Xapian::docid& chunk_first,
-			  Xapian::termcount& chunk_first_wdf)
+			  Xapian::termcount& chunk_first_wdf,
+			  Xapian::termcount& chunk_wdf_max,
+			  Xapian::termcount& chunk_doclen_min)
 {
     if (!unpack_uint(p, end, &chunk_first) ||
-	!unpack_uint(p, end, &chunk_first_wdf)) {
+	!unpack_uint(p, end, &chunk_first_wdf) ||
+	!unpack_uint(p, end, &chunk_wdf_max) ||
+	!unpack_uint(p, end, &chunk_doclen_min)) {
 	return false;
     }
     chunk_first = chunk_last - chunk_first;
     ++chunk_first_wdf;
+    chunk_wdf_max += chunk_first_wdf;
     return true;
 }
 
 inline void
 encode_delta_chunk_header_no_wdf(Xapian::docid chunk_first,
 				 Xapian::docid chunk_last,
+				 Xapian::termcount chunk_doclen_min,
 				 std::string& out)
 {
     pack_uint(out, chunk_last - chunk_first);
+    pack_uint(out, chunk_doclen_min);
 }
 
 inline bool
 decode_delta_chunk_header_no_wdf(const char** p, const char* end,
 				 Xapian::docid chunk_last,
-				 Xapian::docid& chunk_first)
+				 Xapian::docid& chunk_first,
+				 Xapian::termcount& chunk_doclen_min)
 {
-    if (!unpack_uint(p, end, &chunk_first)) {
+    if (!unpack_uint(p, end, &chunk_first) ||
+	!unpack_uint(p, end, &chunk_doclen_min)) {
 	return false;
     }
     chunk_first = chunk_last - chunk_first;
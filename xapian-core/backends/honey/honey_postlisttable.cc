@@ -146,8 +146,13 @@ HoneyPostListTable::get_wdf_upper_bound(const std::string& term) const
     Xapian::docid chunk_last;
     Xapian::termcount first_wdf;
     Xapian::termcount wdf_max;
+    Xapian::termcount chunk_wdf_max;
+    Xapian::termcount chunk_doclen_min;
+    unsigned encoding;
     if (!decode_initial_chunk_header(&p, pend, tf, cf, first, last, chunk_last,
-				     first_wdf, wdf_max))
+				     first_wdf, wdf_max,
+				     chunk_wdf_max, chunk_doclen_min,
+				     encoding))
 	throw Xapian::DatabaseCorruptError("Postlist initial chunk header");
     return wdf_max;
 }
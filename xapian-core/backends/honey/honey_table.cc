@@ -45,6 +45,7 @@ HoneyTable::create_and_open(int flags_, const RootInfo& root_info)
     Assert(!single_file());
     flags = flags_;
     compress_min = root_info.get_compress_min();
+    table_encoding = root_info.get_encoding();
     if (read_only) {
 	num_entries = root_info.get_num_entries();
 	root = root_info.get_root();
@@ -59,6 +60,7 @@ HoneyTable::open(int flags_, const RootInfo& root_info, honey_revision_number_t)
 {
     flags = flags_;
     compress_min = root_info.get_compress_min();
+    table_encoding = root_info.get_encoding();
     num_entries = root_info.get_num_entries();
     offset = root_info.get_offset();
     root = root_info.get_root();
@@ -67,6 +69,8 @@ HoneyTable::open(int flags_, const RootInfo& root_info, honey_revision_number_t)
 	    throw Xapian::DatabaseOpeningError("Failed to open HoneyTable",
 					       errno);
     }
+    if (use_mmap)
+	store.map();
     store.set_pos(offset);
 }
 
@@ -79,12 +79,30 @@ class BufferedFileCommon {
     unsigned _refs = 0;
     off_t offset = 0;
 
+    /** Mapping of the whole file, or NULL if not mapped.
+     *
+     *  Honey tables are never modified once written, so we can read from the
+     *  mapping directly.
+     */
+    const char* map = nullptr;
+
+    size_t map_size = 0;
+
     BufferedFileCommon(int fd_, off_t offset_)
 	: fd(fd_), _refs(1), offset(offset_) {}
 
+    ~BufferedFileCommon() { unmap(); }
+
     BufferedFileCommon(const BufferedFileCommon&) = delete;
 
     BufferedFileCommon& operator=(const BufferedFileCommon&) = delete;
+
+    void unmap() {
+	if (map) {
+	    io_unmap(map, map_size);
+	    map = nullptr;
+	}
+    }
 };
 
 class BufferedFile {
@@ -124,6 +142,7 @@ class BufferedFile {
 
     void close(bool fd_owned) {
 	if (common && common->fd >= 0) {
+	    common->unmap();
 	    if (fd_owned) ::close(common->fd);
 	    common->fd = -1;
 	}
@@ -131,11 +150,23 @@ class BufferedFile {
 
     void force_close(bool fd_owned) {
 	if (common) {
+	    common->unmap();
 	    if (fd_owned && common->fd >= 0) ::close(common->fd);
 	    common->fd = FORCED_CLOSE;
 	}
     }
 
+    /** Read through a memory mapping of the file.
+     *
+     *  If the file can't be mapped, we just carry on reading it.
+     */
+    void map() {
+	if (read_only && is_open() && !common->map) {
+	    common->map = io_map_rd(common->fd, common->map_size);
+	    buf_end = 0;
+	}
+    }
+
     bool is_open() const { return common && common->fd >= 0; }
 
     bool was_forced_closed() const {
@@ -257,6 +288,12 @@ class BufferedFile {
     }
 
     int read() const {
+	if (common->map) {
+	    off_t i = pos + common->offset;
+	    if (rare(i >= off_t(common->map_size))) return EOF;
+	    ++pos;
+	    return static_cast<unsigned char>(common->map[i]);
+	}
 	if (buf_end == 0) {
 	    // The buffer is currently empty, so we need to read at least one
 	    // byte.
@@ -282,6 +319,15 @@ class BufferedFile {
     }
 
     void read(char* p, size_t len) const {
+	if (common->map) {
+	    off_t start = pos + common->offset;
+	    if (rare(start + off_t(len) > off_t(common->map_size))) {
+		throw Xapian::DatabaseCorruptError("Unexpected end of file");
+	    }
+	    memcpy(p, common->map + start, len);
+	    pos += len;
+	    return;
+	}
 	if (buf_end != 0) {
 	    if (len <= buf_end) {
 		memcpy(p, buf + sizeof(buf) - buf_end, len);
@@ -542,6 +588,8 @@ class HoneyTable {
     bool read_only;
     int flags;
     uint4 compress_min;
+    /// How the table's entries are encoded (see RootInfo::get_encoding()).
+    unsigned table_encoding = 0;
     mutable BufferedFile store;
     mutable std::string last_key;
     SSTIndex index;
@@ -549,6 +597,8 @@ class HoneyTable {
     honey_tablesize_t num_entries = 0;
     bool lazy;
 
+    bool use_mmap = false;
+
     bool single_file() const { return path.empty(); }
 
     /** Offset to add to pointers in this table.
@@ -595,8 +645,24 @@ class HoneyTable {
 
     bool is_writable() const { return !read_only; }
 
+    /** Read the table through a memory mapping of its file.
+     *
+     *  Takes effect the next time the table is opened.
+     */
+    void set_use_mmap() { use_mmap = true; }
+
+    /// Return true if set_use_mmap() has been called.
+    bool get_use_mmap() const { return use_mmap; }
+
     int get_flags() const { return flags; }
 
+    /** Return how the table's entries are encoded.
+     *
+     *  This is recorded in the table's RootInfo, and only the table's user
+     *  interprets it.
+     */
+    unsigned get_encoding() const { return table_encoding; }
+
     void create_and_open(int flags_, const Honey::RootInfo& root_info);
 
     void open(int flags_, const Honey::RootInfo& root_info,
@@ -51,7 +51,10 @@
 using namespace std;
 
 /// Honey format version (date of change):
-#define HONEY_FORMAT_VERSION DATE_TO_VERSION(2018,4,3)
+#define HONEY_FORMAT_VERSION DATE_TO_VERSION(2026,10,17)
+// 2026,10,17       store posting data encoding in initial chunk header and
+//                  position list encoding in root info
+// 2026,10,16       store max wdf and min doclen in posting chunk headers
 // 2018,4,3   1.5.0 outlaw mixed-wdf terms
 // 2018,3,28        don't special case first entry in SSTable
 // 2018,3,27        new key format for value stats, value chunks, doclen chunks
@@ -494,6 +497,7 @@ RootInfo::init(uint4 compress_min_)
     root = 0;
     num_entries = 0;
     compress_min = compress_min_;
+    encoding = 0;
     fl_serialised.resize(0);
 }
 
@@ -505,7 +509,7 @@ RootInfo::serialise(string& s) const
     AssertRel(root, >=, offset);
     pack_uint(s, uoffset);
     pack_uint(s, root - uoffset);
-    pack_uint(s, 0u);
+    pack_uint(s, encoding);
     pack_uint(s, num_entries);
     pack_uint(s, 2048u >> 11);
     pack_uint(s, compress_min);
@@ -516,11 +520,10 @@ bool
 RootInfo::unserialise(const char** p, const char* end)
 {
     std::make_unsigned<off_t>::type uoffset, uroot;
-    unsigned dummy_val;
     unsigned dummy_blocksize;
     if (!unpack_uint(p, end, &uoffset) ||
 	!unpack_uint(p, end, &uroot) ||
-	!unpack_uint(p, end, &dummy_val) ||
+	!unpack_uint(p, end, &encoding) ||
 	!unpack_uint(p, end, &num_entries) ||
 	!unpack_uint(p, end, &dummy_blocksize) ||
 	!unpack_uint(p, end, &compress_min) ||
@@ -529,7 +532,6 @@ RootInfo::unserialise(const char** p, const char* end)
     root = uoffset + uroot;
     // Not meaningful, but still there so that existing honey databases
     // continue to work.
-    (void)dummy_val;
     (void)dummy_blocksize;
     // Map old default to new default.
     if (compress_min == 4) {
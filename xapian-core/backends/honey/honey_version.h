@@ -43,6 +43,12 @@ class RootInfo {
     honey_tablesize_t num_entries;
     /// Should be >= 4 or 0 for no compression.
     uint4 compress_min;
+    /** How the table's entries are encoded.
+     *
+     *  0 is the default.  Other values are specific to the table (currently
+     *  only the position table has a choice, of the POSITIONS_* constants).
+     */
+    unsigned encoding;
     std::string fl_serialised;
 
   public:
@@ -56,12 +62,14 @@ class RootInfo {
     off_t get_root() const { return root; }
     honey_tablesize_t get_num_entries() const { return num_entries; }
     uint4 get_compress_min() const { return compress_min; }
+    unsigned get_encoding() const { return encoding; }
     const std::string& get_free_list() const { return fl_serialised; }
 
     void set_num_entries(honey_tablesize_t n) { num_entries = n; }
     void set_offset(off_t offset_) { offset = offset_; }
     void set_root(off_t root_) { root = root_; }
     void set_free_list(const std::string& s) { fl_serialised = s; }
+    void set_encoding(unsigned encoding_) { encoding = encoding_; }
 };
 
 }
@@ -0,0 +1,97 @@
+/** @file impactlist.cc
+ * @brief Impact-ordered posting lists
+ */
+/* Copyright (C) 2026 Xapian contributors
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301 USA
+ */
+
+#include <config.h>
+
+#include "impactlist.h"
+
+#include "omassert.h"
+#include "serialise-double.h"
+
+#include <algorithm>
+
+using namespace std;
+
+bool
+ImpactParams::unserialise_bm25(const string& s)
+{
+    const char* p = s.data();
+    const char* s_end = p + s.size();
+    try {
+	k1 = unserialise_double(&p, s_end);
+	double k2 = unserialise_double(&p, s_end);
+	// k3 only affects the term's weight.
+	(void)unserialise_double(&p, s_end);
+	b = unserialise_double(&p, s_end);
+	min_normlen = unserialise_double(&p, s_end);
+	return p == s_end && k2 == 0.0;
+    } catch (const Xapian::SerialisationError&) {
+	return false;
+    }
+}
+
+double
+ImpactParams::doc_factor(Xapian::termcount wdf, Xapian::termcount len,
+			 double len_factor) const
+{
+    Xapian::doclength normlen = max(len * len_factor, min_normlen);
+    double wdf_double = wdf;
+    double denom = k1 * (normlen * b + (1 - b)) + wdf_double;
+    AssertRel(denom,>,0);
+    return wdf_double / denom;
+}
+
+void
+encode_impact_list(string& out, vector<pair<unsigned, Xapian::docid>>& postings)
+{
+    sort(postings.begin(), postings.end(),
+	 [](const pair<unsigned, Xapian::docid>& a,
+	    const pair<unsigned, Xapian::docid>& b) {
+	     if (a.first != b.first) return a.first > b.first;
+	     return a.second < b.second;
+	 });
+    auto i = postings.begin();
+    while (i != postings.end()) {
+	unsigned impact = i->first;
+	AssertRel(impact,>=,1);
+	AssertRel(impact,<=,IMPACT_LEVELS);
+	auto j = i;
+	while (j != postings.end() && j->first == impact) ++j;
+	out += char(impact);
+	pack_uint(out, Xapian::doccount(j - i) - 1);
+	Xapian::docid prev = 0;
+	for ( ; i != j; ++i) {
+	    pack_uint(out, i->second - prev - 1);
+	    prev = i->second;
+	}
+    }
+}
+
+bool
+ImpactListReader::next_segment(unsigned& impact, Xapian::doccount& count)
+{
+    while (left) (void)next_docid();
+    if (p == end) return false;
+    impact = static_cast<unsigned char>(*p++);
+    if (impact == 0 || !unpack_uint(&p, end, &count)) throw_corrupt();
+    left = ++count;
+    did = 0;
+    return true;
+}
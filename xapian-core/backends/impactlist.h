@@ -0,0 +1,146 @@
+/** @file impactlist.h
+ * @brief Impact-ordered posting lists
+ */
+/* Copyright (C) 2026 Xapian contributors
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301 USA
+ */
+
+#ifndef XAPIAN_INCLUDED_IMPACTLIST_H
+#define XAPIAN_INCLUDED_IMPACTLIST_H
+
+#include "xapian/types.h"
+
+#include "pack.h"
+#include "xapian/error.h"
+
+#include <string>
+#include <utility>
+#include <vector>
+
+/** The number of levels impacts are quantised to.
+ *
+ *  Impacts range from 1 to IMPACT_LEVELS.
+ */
+#define IMPACT_LEVELS 255
+
+/** The parameters of BM25Weight which impacts depend on.
+ *
+ *  The BM25 weight of a posting is the term's weight (which depends on the
+ *  term's statistics and the query) times a factor between 0 and 1 which
+ *  depends on the wdf and document length.  An impact is that factor
+ *  quantised to an integer between 1 and IMPACT_LEVELS, so the term's weight
+ *  can still be applied at search time.
+ */
+struct ImpactParams {
+    double k1 = 0.0;
+
+    double b = 0.0;
+
+    double min_normlen = 0.0;
+
+    /** Set from a serialised BM25Weight.
+     *
+     *  @return false if @a s isn't a valid serialised BM25Weight, or has a
+     *		non-zero k2 (since then the weight has a part which doesn't
+     *		depend on the term).
+     */
+    bool unserialise_bm25(const std::string& s);
+
+    bool operator==(const ImpactParams& o) const {
+	return k1 == o.k1 && b == o.b && min_normlen == o.min_normlen;
+    }
+
+    /** Calculate the factor which the term's weight is multiplied by.
+     *
+     *  This uses the same formula as BM25Weight::get_sumpart().
+     *
+     *  @param wdf		The wdf of the posting.
+     *  @param len		The length of the document.
+     *  @param len_factor	1 / the average document length (or 0 if
+     *				that's 0).
+     */
+    double doc_factor(Xapian::termcount wdf, Xapian::termcount len,
+		      double len_factor) const;
+
+    /// Quantise a factor returned by doc_factor() to an impact.
+    static unsigned quantise(double factor) {
+	unsigned impact = unsigned(factor * IMPACT_LEVELS + 0.5);
+	if (impact == 0) return 1;
+	if (impact > IMPACT_LEVELS) return IMPACT_LEVELS;
+	return impact;
+    }
+};
+
+/** Encode an impact-ordered posting list.
+ *
+ *  The postings are grouped into a segment for each distinct impact, highest
+ *  impact first.  Each segment is stored as a byte giving the impact,
+ *  pack_uint(number of documents - 1) and the document ids in ascending
+ *  order, as pack_uint(first docid - 1) and then pack_uint(difference - 1)
+ *  for each of the others.
+ *
+ *  @param out		The string to append the encoded list to.
+ *  @param postings	(impact, docid) pairs, which are sorted by this
+ *			function.
+ */
+void encode_impact_list(std::string& out,
+			std::vector<std::pair<unsigned,
+					      Xapian::docid>>& postings);
+
+/// Read an impact-ordered posting list a segment at a time.
+class ImpactListReader {
+    /// The next byte to decode.
+    const char* p;
+
+    /// The end of the encoded list.
+    const char* end;
+
+    /// The number of document ids left in the current segment.
+    Xapian::doccount left = 0;
+
+    /// The last document id read from the current segment.
+    Xapian::docid did = 0;
+
+    [[noreturn]]
+    static void throw_corrupt() {
+	throw Xapian::DatabaseCorruptError("Impact list data corrupt");
+    }
+
+  public:
+    ImpactListReader(const char* p_, const char* end_) : p(p_), end(end_) {}
+
+    /** Move to the next segment.
+     *
+     *  Any document ids not yet read from the current segment are skipped.
+     *
+     *  @param[out] impact	The impact of the segment.
+     *  @param[out] count	The number of documents in the segment.
+     *
+     *  @return false if there are no more segments.
+     */
+    bool next_segment(unsigned& impact, Xapian::doccount& count);
+
+    /// Return the next document id in the current segment, which must exist.
+    Xapian::docid next_docid() {
+	Xapian::docid inc;
+	if (!unpack_uint(&p, end, &inc)) throw_corrupt();
+	--left;
+	did += inc + 1;
+	return did;
+    }
+};
+
+#endif // XAPIAN_INCLUDED_IMPACTLIST_H
@@ -27,6 +27,9 @@
 #include "matcher/orpositionlist.h"
 #include "omassert.h"
 #include "debuglog.h"
+#include "weight/weightinternal.h"
+
+#include <algorithm>
 
 using namespace std;
 
@@ -71,6 +74,35 @@ LeafPostList::recalc_maxweight()
     return weight ? weight->get_maxpart() : 0;
 }
 
+bool
+LeafPostList::get_block_bounds(Xapian::docid&,
+			       Xapian::termcount&,
+			       Xapian::termcount&) const
+{
+    return false;
+}
+
+double
+LeafPostList::get_block_maxweight(Xapian::docid& block_last)
+{
+    if (!weight) {
+	block_last = Xapian::docid(-1);
+	return 0;
+    }
+    Xapian::termcount wdf_max, doclen_min;
+    if (!get_block_bounds(block_last, wdf_max, doclen_min)) {
+	block_last = Xapian::docid(-1);
+	return weight->get_maxpart();
+    }
+    if (block_last != block_maxweight_last) {
+	block_maxweight_last = block_last;
+	block_maxweight = Xapian::Weight::Internal::get_block_maxpart(*weight,
+								      wdf_max,
+								      doclen_min);
+    }
+    return block_maxweight;
+}
+
 TermFreqs
 LeafPostList::get_termfreq_est_using_stats(
 	const Xapian::Weight::Internal & stats) const
@@ -98,6 +130,47 @@ LeafPostList::gather_position_lists(OrPositionList* orposlist)
     orposlist->add_poslist(read_position_list());
 }
 
+LeafPostList*
+LeafPostList::as_leaf_postlist()
+{
+    return this;
+}
+
+Xapian::doccount
+LeafPostList::next_batch(Xapian::docid did_max,
+			 Xapian::docid* dids,
+			 Xapian::termcount* wdfs,
+			 Xapian::doccount n)
+{
+    AssertRel(n,>,0);
+    Xapian::doccount count = 0;
+    do {
+	(void)next(0.0);
+	if (at_end()) break;
+	Xapian::docid did = get_docid();
+	dids[count] = did;
+	wdfs[count++] = get_wdf();
+	if (did > did_max) break;
+    } while (count != n);
+    return count;
+}
+
+void
+LeafPostList::get_weight_batch(Xapian::doccount n,
+			       const Xapian::termcount* wdfs,
+			       const Xapian::termcount* doclens,
+			       const Xapian::termcount* unique_terms,
+			       const Xapian::termcount* wdfdocmaxs,
+			       double* result) const
+{
+    if (!weight) {
+	fill_n(result, n, 0.0);
+	return;
+    }
+    weight->get_sumpart_batch(n, wdfs, doclens, unique_terms, wdfdocmaxs,
+			      result);
+}
+
 LeafPostList *
 LeafPostList::open_nearby_postlist(const std::string &, bool) const
 {
@@ -30,6 +30,12 @@ namespace Xapian {
     class Weight;
 }
 
+/** The number of entries the matcher reads at once from a LeafPostList.
+ *
+ *  See LeafPostList::next_batch().
+ */
+#define POSTLIST_BATCH_SIZE 128
+
 /** Abstract base class for leaf postlists.
  *
  *  This class provides the following features in addition to the PostList
@@ -48,10 +54,34 @@ class LeafPostList : public PostList {
     /// The term name for this postlist (empty for an alldocs postlist).
     std::string term;
 
+    /// The last docid of the block @a block_maxweight is for.
+    Xapian::docid block_maxweight_last = 0;
+
+    /// Cached upper bound on the weight for the current block.
+    double block_maxweight = 0.0;
+
     /// Only constructable as a base class for derived classes.
     explicit LeafPostList(const std::string & term_)
 	: weight(0), term(term_) { }
 
+    /** Get bounds for the current block of entries.
+     *
+     *  Backends which store such information (e.g. per posting list chunk)
+     *  can override this to allow the matcher to skip blocks of documents
+     *  which can't score highly enough.
+     *
+     *  @param[out] block_last	The last docid in the current block.
+     *  @param[out] wdf_max	Upper bound on wdf for entries in the block.
+     *  @param[out] doclen_min	Lower bound on document length for entries in
+     *				the block (0 if not known).
+     *
+     *  @return	true if bounds were returned; false if no block information
+     *		is available.  The default implementation returns false.
+     */
+    virtual bool get_block_bounds(Xapian::docid& block_last,
+				  Xapian::termcount& wdf_max,
+				  Xapian::termcount& doclen_min) const;
+
   public:
     ~LeafPostList();
 
@@ -105,6 +135,8 @@ class LeafPostList : public PostList {
 
     double recalc_maxweight();
 
+    double get_block_maxweight(Xapian::docid& block_last);
+
     TermFreqs get_termfreq_est_using_stats(
 	const Xapian::Weight::Internal & stats) const;
 
@@ -112,6 +144,49 @@ class LeafPostList : public PostList {
 
     void gather_position_lists(OrPositionList* orposlist);
 
+    LeafPostList* as_leaf_postlist();
+
+    /** Advance over a batch of entries.
+     *
+     *  This is equivalent to calling next() repeatedly and recording the docid
+     *  and wdf of each entry, but subclasses can override it to avoid the
+     *  overhead of a virtual method call per entry.
+     *
+     *  Reading stops once @a n entries have been recorded, once an entry with
+     *  a docid greater than @a did_max has been recorded, or when the end of
+     *  the postlist is reached.  Unless at_end() is true afterwards the
+     *  postlist is left positioned on the last entry recorded.
+     *
+     *  @param did_max	Stop after recording an entry beyond this docid.
+     *  @param[out] dids	Array to store the docids in.
+     *  @param[out] wdfs	Array to store the wdfs in.
+     *  @param n		The size of the arrays (must be non-zero).
+     *
+     *  @return The number of entries recorded.
+     */
+    virtual Xapian::doccount next_batch(Xapian::docid did_max,
+					Xapian::docid* dids,
+					Xapian::termcount* wdfs,
+					Xapian::doccount n);
+
+    /** Calculate the weights for a batch of entries.
+     *
+     *  This is equivalent to calling get_weight() for each entry, but uses
+     *  Xapian::Weight::get_sumpart_batch() which can be vectorised.
+     *
+     *  @param n		The number of entries.
+     *  @param wdfs	The wdfs of the entries (as returned by next_batch()).
+     *  @param doclens,unique_terms,wdfdocmaxs	Statistics for the documents.
+     *  @param[out] result	Array to store the weights in (all set to 0 if
+     *				no weighting scheme has been set).
+     */
+    void get_weight_batch(Xapian::doccount n,
+			  const Xapian::termcount* wdfs,
+			  const Xapian::termcount* doclens,
+			  const Xapian::termcount* unique_terms,
+			  const Xapian::termcount* wdfdocmaxs,
+			  double* result) const;
+
     /** Open another postlist from the same database.
      *
      *  @param term_	The term to open a postlist for (must not be an empty
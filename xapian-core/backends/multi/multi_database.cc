@@ -567,6 +567,22 @@ MultiDatabase::commit()
     }
 }
 
+void
+MultiDatabase::commit_async()
+{
+    for (auto&& shard : shards) {
+	shard->commit_async();
+    }
+}
+
+void
+MultiDatabase::wait_for_commit()
+{
+    for (auto&& shard : shards) {
+	shard->wait_for_commit();
+    }
+}
+
 void
 MultiDatabase::cancel()
 {
@@ -633,6 +649,15 @@ MultiDatabase::replace_document(Xapian::docid did, const Xapian::Document& doc)
     shard->replace_document(shard_docid(did, n_shards), doc);
 }
 
+void
+MultiDatabase::set_document_value(Xapian::docid did, Xapian::valueno slot,
+				  const string& value)
+{
+    auto n_shards = shards.size();
+    auto shard = shards[shard_number(did, n_shards)];
+    shard->set_document_value(shard_docid(did, n_shards), slot, value);
+}
+
 Xapian::docid
 MultiDatabase::replace_document(const string& term, const Xapian::Document& doc)
 {
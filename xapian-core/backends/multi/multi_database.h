@@ -24,6 +24,7 @@
 #include "api/termlist.h"
 #include "backends/databaseinternal.h"
 #include "backends/valuelist.h"
+#include "xapian/enquire.h"
 
 class LeafPostList;
 class Matcher;
@@ -44,6 +45,7 @@ class MultiDatabase : public Xapian::Database::Internal {
     friend class PostListTree;
     friend class ValueStreamDocument;
     friend class Xapian::Database;
+    friend class Xapian::Enquire::Internal;
 
     Xapian::SmallVectorI<Xapian::Database::Internal> shards;
 
@@ -149,6 +151,10 @@ class MultiDatabase : public Xapian::Database::Internal {
 
     void commit();
 
+    void commit_async();
+
+    void wait_for_commit();
+
     void cancel();
 
     void begin_transaction(bool flushed);
@@ -166,6 +172,9 @@ class MultiDatabase : public Xapian::Database::Internal {
     Xapian::docid replace_document(const std::string& term,
 				   const Xapian::Document& doc);
 
+    void set_document_value(Xapian::docid did, Xapian::valueno slot,
+			    const std::string& value);
+
     void request_document(Xapian::docid did) const;
 
     void add_spelling(const std::string& word, Xapian::termcount freqinc) const;
@@ -0,0 +1,133 @@
+/** @file parallelcompact.h
+ * @brief Helpers for compacting tables in parallel
+ */
+/* Copyright (C) 2026 Xapian contributors
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301 USA
+ */
+
+#ifndef XAPIAN_INCLUDED_PARALLELCOMPACT_H
+#define XAPIAN_INCLUDED_PARALLELCOMPACT_H
+
+#include <xapian/compactor.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <string>
+
+#ifdef HAVE_STD_THREAD
+# include <atomic>
+# include <exception>
+# include <mutex>
+# include <system_error>
+# include <thread>
+# include <vector>
+# define LOCK_COMPACTION(M) std::lock_guard<std::mutex> compaction_lock(M)
+#else
+# define LOCK_COMPACTION(M) (void)0
+#endif
+
+/// Mutex for shared state updated by tables being compacted in parallel.
+class CompactionMutex {
+#ifdef HAVE_STD_THREAD
+    std::mutex mutex;
+
+  public:
+    operator std::mutex&() { return mutex; }
+#endif
+};
+
+/** Compactor which serialises calls to another Compactor.
+ *
+ *  The Compactor API doesn't require subclasses to be thread-safe, so when
+ *  compacting in parallel we pass one of these to the code doing the merging
+ *  instead of the user's Compactor object.
+ */
+class SerialisedCompactor : public Xapian::Compactor {
+    Xapian::Compactor& compactor;
+
+    CompactionMutex mutex;
+
+  public:
+    explicit SerialisedCompactor(Xapian::Compactor& compactor_)
+	: compactor(compactor_) { }
+
+    void set_status(const std::string& table, const std::string& status) {
+	LOCK_COMPACTION(mutex);
+	compactor.set_status(table, status);
+    }
+
+    std::string
+    resolve_duplicate_metadata(const std::string& key,
+			       size_t num_tags, const std::string tags[]) {
+	LOCK_COMPACTION(mutex);
+	return compactor.resolve_duplicate_metadata(key, num_tags, tags);
+    }
+};
+
+/** Call f(0), f(1), ..., f(n - 1) using up to @a parallelism threads.
+ *
+ *  The calling thread is one of the threads used.  If any of the calls
+ *  throw an exception, the others still run to completion and then the
+ *  exception is rethrown (if several throw, the one from the call with the
+ *  lowest index is rethrown).
+ */
+template<typename F>
+void
+run_in_parallel(std::size_t n, unsigned parallelism, F f)
+{
+#ifdef HAVE_STD_THREAD
+    if (parallelism > 1 && n > 1) {
+	std::size_t n_threads = std::min(std::size_t(parallelism), n);
+	std::vector<std::exception_ptr> errors(n);
+	std::atomic<std::size_t> next(0);
+	auto worker = [&]() {
+	    std::size_t i;
+	    while ((i = next++) < n) {
+		try {
+		    f(i);
+		} catch (...) {
+		    errors[i] = std::current_exception();
+		}
+	    }
+	};
+	std::vector<std::thread> threads;
+	threads.reserve(n_threads - 1);
+	try {
+	    while (threads.size() + 1 < n_threads) {
+		threads.emplace_back(worker);
+	    }
+	} catch (const std::system_error&) {
+	    // Failing to start a thread isn't fatal - we just use fewer
+	    // threads.
+	}
+	worker();
+	for (auto&& t : threads) {
+	    t.join();
+	}
+	for (auto&& e : errors) {
+	    if (e) std::rethrow_exception(e);
+	}
+	return;
+    }
+#else
+    (void)parallelism;
+#endif
+    for (std::size_t i = 0; i != n; ++i) {
+	f(i);
+    }
+}
+
+#endif // XAPIAN_INCLUDED_PARALLELCOMPACT_H
@@ -26,6 +26,8 @@
 
 #include "omassert.h"
 
+#include <cmath>
+
 using namespace std;
 
 PostList::~PostList() {}
@@ -43,6 +45,13 @@ PostList::get_wdf() const
     throw Xapian::InvalidOperationError("get_wdf() not meaningful for this PostingIterator");
 }
 
+double
+PostList::get_block_maxweight(Xapian::docid& block_last)
+{
+    block_last = Xapian::docid(-1);
+    return HUGE_VAL;
+}
+
 PositionList *
 PostList::read_position_list()
 {
@@ -74,3 +83,15 @@ PostList::gather_position_lists(OrPositionList*)
 {
     Assert(false);
 }
+
+LeafPostList*
+PostList::as_leaf_postlist()
+{
+    return NULL;
+}
+
+BitmapPostList*
+PostList::as_bitmap_postlist()
+{
+    return NULL;
+}
@@ -31,6 +31,8 @@
 #include "backends/positionlist.h"
 #include "weight/weightinternal.h"
 
+class BitmapPostList;
+class LeafPostList;
 class OrPositionList;
 
 namespace Xapian {
@@ -104,6 +106,24 @@ class PostList {
      */
     virtual double recalc_maxweight() = 0;
 
+    /** Get an upper bound on the weight for the current block of entries.
+     *
+     *  This allows the matcher to skip whole blocks of documents which
+     *  can't score highly enough (as in "Block-Max WAND").
+     *
+     *  @param[out] block_last	Set to the last docid which the returned
+     *				bound applies to, or Xapian::docid(-1) if no
+     *				block information is available.
+     *
+     *  @return	An upper bound on what get_weight() can return for
+     *		documents from the current position up to and including
+     *		@a block_last.
+     *
+     *  The default implementation returns HUGE_VAL and sets @a block_last to
+     *  Xapian::docid(-1).
+     */
+    virtual double get_block_maxweight(Xapian::docid& block_last);
+
     /** Read the position list for the term in the current document and
      *  return a pointer to it (owned by the PostList).
      *
@@ -189,6 +209,20 @@ class PostList {
     /// Gather PositionList* objects for a subtree.
     virtual void gather_position_lists(OrPositionList* orposlist);
 
+    /** Return this object as a LeafPostList, or NULL if it isn't one.
+     *
+     *  Used by the matcher to find sub-postlists which can be read in
+     *  batches.  The default implementation returns NULL.
+     */
+    virtual LeafPostList* as_leaf_postlist();
+
+    /** Return this object as a BitmapPostList, or NULL if it isn't one.
+     *
+     *  Used by the query optimiser to combine bitmaps under AND and OR.
+     *  The default implementation returns NULL.
+     */
+    virtual BitmapPostList* as_bitmap_postlist();
+
     /// Return a string description of this object.
     virtual std::string get_description() const = 0;
 };
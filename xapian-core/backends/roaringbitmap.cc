@@ -0,0 +1,497 @@
+/** @file roaringbitmap.cc
+ * @brief Compressed bitmap of document ids
+ */
+/* Copyright (C) 2026 Xapian contributors
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301 USA
+ */
+
+#include <config.h>
+
+#include "roaringbitmap.h"
+
+#include "omassert.h"
+#include "popcount.h"
+
+#include <algorithm>
+#include <iterator>
+
+using namespace std;
+
+typedef RoaringBitmap::Container Container;
+
+/// Return the index of the lowest set bit in @a word, which mustn't be 0.
+static inline unsigned
+lowest_bit(uint64_t word)
+{
+    Assert(word != 0);
+    if (false) {
+#if HAVE_DECL___BUILTIN_CTZL
+    } else if (sizeof(uint64_t) == sizeof(unsigned long)) {
+	return __builtin_ctzl(word);
+#endif
+#if HAVE_DECL___BUILTIN_CTZLL
+    } else if (sizeof(uint64_t) == sizeof(unsigned long long)) {
+	return __builtin_ctzll(word);
+#endif
+    }
+    unsigned n = 0;
+    while (!(word & 1)) {
+	word >>= 1;
+	++n;
+    }
+    return n;
+}
+
+/// Append @a v to @a s as a 16-bit big-endian value.
+static inline void
+append16(string& s, unsigned v)
+{
+    s += char(v >> 8);
+    s += char(v);
+}
+
+/// Read a 16-bit big-endian value from @a p.
+static inline unsigned
+read16(const char* p)
+{
+    return unsigned(static_cast<unsigned char>(p[0])) << 8 |
+	   static_cast<unsigned char>(p[1]);
+}
+
+void
+Container::to_bits()
+{
+    bits.assign(BITMAP_WORDS, 0);
+    for (unsigned v : array) {
+	bits[v / 64] |= uint64_t(1) << (v % 64);
+    }
+    vector<uint16_t>().swap(array);
+}
+
+void
+Container::to_array()
+{
+    vector<uint16_t> result;
+    result.reserve(count);
+    for (unsigned w = 0; w != BITMAP_WORDS; ++w) {
+	uint64_t word = bits[w];
+	while (word) {
+	    result.push_back(uint16_t(w * 64 + lowest_bit(word)));
+	    word &= word - 1;
+	}
+    }
+    array.swap(result);
+    vector<uint64_t>().swap(bits);
+}
+
+void
+Container::recount()
+{
+    count = 0;
+    for (uint64_t word : bits) {
+	add_popcount(count, word);
+    }
+}
+
+bool
+Container::contains(unsigned v) const
+{
+    AssertRel(v,<,END);
+    if (!bits.empty()) return (bits[v / 64] >> (v % 64)) & 1;
+    return binary_search(array.begin(), array.end(), v);
+}
+
+unsigned
+Container::next(unsigned v) const
+{
+    if (v >= END) return END;
+    if (bits.empty()) {
+	auto i = lower_bound(array.begin(), array.end(), v);
+	return i == array.end() ? END : *i;
+    }
+    unsigned w = v / 64;
+    uint64_t word = bits[w] & (~uint64_t(0) << (v % 64));
+    while (word == 0) {
+	if (++w == BITMAP_WORDS) return END;
+	word = bits[w];
+    }
+    return w * 64 + lowest_bit(word);
+}
+
+void
+Container::add(unsigned v)
+{
+    AssertRel(v,<,END);
+    if (!bits.empty()) {
+	uint64_t bit = uint64_t(1) << (v % 64);
+	if (!(bits[v / 64] & bit)) {
+	    bits[v / 64] |= bit;
+	    ++count;
+	}
+	return;
+    }
+    auto i = lower_bound(array.begin(), array.end(), v);
+    if (i != array.end() && *i == v) return;
+    array.insert(i, uint16_t(v));
+    ++count;
+    normalise();
+}
+
+void
+Container::remove(unsigned v)
+{
+    AssertRel(v,<,END);
+    if (!bits.empty()) {
+	uint64_t bit = uint64_t(1) << (v % 64);
+	if (bits[v / 64] & bit) {
+	    bits[v / 64] &= ~bit;
+	    --count;
+	    normalise();
+	}
+	return;
+    }
+    auto i = lower_bound(array.begin(), array.end(), v);
+    if (i == array.end() || *i != v) return;
+    array.erase(i);
+    --count;
+}
+
+void
+Container::assign(vector<uint16_t>&& members)
+{
+    array = std::move(members);
+    vector<uint64_t>().swap(bits);
+    count = array.size();
+    normalise();
+}
+
+void
+Container::intersect(const Container& o)
+{
+    if (!bits.empty() && !o.bits.empty()) {
+	for (unsigned i = 0; i != BITMAP_WORDS; ++i) {
+	    bits[i] &= o.bits[i];
+	}
+	recount();
+    } else if (!bits.empty()) {
+	// The result is no larger than o, so will be an array.
+	vector<uint16_t> result;
+	result.reserve(o.array.size());
+	for (unsigned v : o.array) {
+	    if (contains(v)) result.push_back(uint16_t(v));
+	}
+	array.swap(result);
+	vector<uint64_t>().swap(bits);
+	count = array.size();
+    } else if (!o.bits.empty()) {
+	array.erase(remove_if(array.begin(), array.end(),
+			      [&o](uint16_t v) { return !o.contains(v); }),
+		    array.end());
+	count = array.size();
+    } else {
+	vector<uint16_t> result;
+	set_intersection(array.begin(), array.end(),
+			 o.array.begin(), o.array.end(),
+			 back_inserter(result));
+	array.swap(result);
+	count = array.size();
+    }
+    normalise();
+}
+
+void
+Container::unite(const Container& o)
+{
+    if (bits.empty() && o.bits.empty()) {
+	vector<uint16_t> result;
+	result.reserve(array.size() + o.array.size());
+	set_union(array.begin(), array.end(),
+		  o.array.begin(), o.array.end(),
+		  back_inserter(result));
+	array.swap(result);
+	count = array.size();
+	normalise();
+	return;
+    }
+    if (bits.empty()) to_bits();
+    if (!o.bits.empty()) {
+	for (unsigned i = 0; i != BITMAP_WORDS; ++i) {
+	    bits[i] |= o.bits[i];
+	}
+    } else {
+	for (unsigned v : o.array) {
+	    bits[v / 64] |= uint64_t(1) << (v % 64);
+	}
+    }
+    recount();
+}
+
+void
+Container::subtract(const uint64_t* words, size_t n_words)
+{
+    AssertRel(n_words,<=,BITMAP_WORDS);
+    if (!bits.empty()) {
+	for (size_t i = 0; i != n_words; ++i) {
+	    bits[i] &= ~words[i];
+	}
+	recount();
+    } else {
+	auto removed = [=](uint16_t v) {
+	    size_t w = v / 64;
+	    return w < n_words && ((words[w] >> (v % 64)) & 1);
+	};
+	array.erase(remove_if(array.begin(), array.end(), removed),
+		    array.end());
+	count = array.size();
+    }
+    normalise();
+}
+
+bool
+Container::unserialise(const char* p, const char* end)
+{
+    vector<uint16_t>().swap(array);
+    vector<uint64_t>().swap(bits);
+    count = 0;
+    if (p == end) return false;
+    unsigned char type = *p++;
+    size_t len = end - p;
+    switch (type) {
+	case 0: {
+	    // Array.
+	    if (len == 0 || len % 2 != 0 || len / 2 > ARRAY_MAX) return false;
+	    array.reserve(len / 2);
+	    for ( ; p != end; p += 2) {
+		unsigned v = read16(p);
+		if (!array.empty() && v <= array.back()) return false;
+		array.push_back(uint16_t(v));
+	    }
+	    count = array.size();
+	    return true;
+	}
+	case 1: {
+	    // Bitmap.
+	    if (len != BITMAP_WORDS * 8) return false;
+	    bits.resize(BITMAP_WORDS);
+	    for (unsigned i = 0; i != BITMAP_WORDS; ++i) {
+		uint64_t word = 0;
+		for (unsigned j = 0; j != 8; ++j) {
+		    word |= uint64_t(static_cast<unsigned char>(*p++)) << (j * 8);
+		}
+		bits[i] = word;
+	    }
+	    recount();
+	    if (count == 0) return false;
+	    normalise();
+	    return true;
+	}
+	case 2: {
+	    // Runs, each stored as the first value and the length minus one.
+	    if (len == 0 || len % 4 != 0) return false;
+	    unsigned total = 0;
+	    unsigned next_start = 0;
+	    for (const char* q = p; q != end; q += 4) {
+		unsigned start = read16(q);
+		unsigned last = start + read16(q + 2);
+		if (start < next_start || last >= END) return false;
+		total += last - start + 1;
+		next_start = last + 2;
+	    }
+	    if (total > ARRAY_MAX) bits.assign(BITMAP_WORDS, 0);
+	    for ( ; p != end; p += 4) {
+		unsigned start = read16(p);
+		unsigned last = start + read16(p + 2);
+		for (unsigned v = start; v <= last; ++v) {
+		    if (bits.empty()) {
+			array.push_back(uint16_t(v));
+		    } else {
+			bits[v / 64] |= uint64_t(1) << (v % 64);
+		    }
+		}
+	    }
+	    count = total;
+	    return true;
+	}
+    }
+    return false;
+}
+
+string
+Container::serialise() const
+{
+    vector<uint16_t> members;
+    const vector<uint16_t>* m = &array;
+    if (!bits.empty()) {
+	Container tmp = *this;
+	tmp.to_array();
+	members.swap(tmp.array);
+	m = &members;
+    }
+
+    unsigned runs = 0;
+    for (size_t i = 0; i != m->size(); ++i) {
+	if (i == 0 || (*m)[i] != (*m)[i - 1] + 1) ++runs;
+    }
+
+    size_t array_size = 2 * size_t(count);
+    size_t bits_size = 8 * size_t(BITMAP_WORDS);
+    size_t runs_size = 4 * size_t(runs);
+    string result;
+    if (runs_size < array_size && runs_size < bits_size) {
+	result.reserve(1 + runs_size);
+	result += '\x02';
+	size_t i = 0;
+	while (i != m->size()) {
+	    size_t j = i + 1;
+	    while (j != m->size() && (*m)[j] == (*m)[j - 1] + 1) ++j;
+	    append16(result, (*m)[i]);
+	    append16(result, unsigned(j - i - 1));
+	    i = j;
+	}
+    } else if (array_size <= bits_size) {
+	result.reserve(1 + array_size);
+	result += '\x00';
+	for (unsigned v : *m) {
+	    append16(result, v);
+	}
+    } else {
+	Container tmp;
+	const vector<uint64_t>* b = &bits;
+	if (bits.empty()) {
+	    tmp = *this;
+	    tmp.to_bits();
+	    b = &tmp.bits;
+	}
+	result.reserve(1 + bits_size);
+	result += '\x01';
+	for (uint64_t word : *b) {
+	    for (unsigned j = 0; j != 8; ++j) {
+		result += char(word >> (j * 8));
+	    }
+	}
+    }
+    return result;
+}
+
+bool
+RoaringBitmap::contains(Xapian::docid did) const
+{
+    Xapian::docid key = did / CONTAINER_DOCS;
+    auto i = lower_bound(keys.begin(), keys.end(), key);
+    if (i == keys.end() || *i != key) return false;
+    return containers[i - keys.begin()].contains(did % CONTAINER_DOCS);
+}
+
+void
+RoaringBitmap::append(Xapian::docid key, Container&& container)
+{
+    Assert(keys.empty() || key > keys.back());
+    if (container.empty()) return;
+    count += container.size();
+    keys.push_back(key);
+    containers.push_back(std::move(container));
+}
+
+Xapian::docid
+RoaringBitmap::next(size_t& i, Xapian::docid did) const
+{
+    Xapian::docid key = did / CONTAINER_DOCS;
+    if (i < keys.size() && keys[i] < key) {
+	i = lower_bound(keys.begin() + i, keys.end(), key) - keys.begin();
+    }
+    while (i < keys.size()) {
+	unsigned low = (keys[i] == key) ? did % CONTAINER_DOCS : 0;
+	unsigned v = containers[i].next(low);
+	if (v != Container::END) return keys[i] * CONTAINER_DOCS + v;
+	++i;
+    }
+    return 0;
+}
+
+void
+RoaringBitmap::intersect(const RoaringBitmap& o)
+{
+    size_t j = 0, out = 0;
+    count = 0;
+    for (size_t i = 0; i != keys.size(); ++i) {
+	while (j != o.keys.size() && o.keys[j] < keys[i]) ++j;
+	if (j == o.keys.size()) break;
+	if (o.keys[j] != keys[i]) continue;
+	Container& c = containers[i];
+	c.intersect(o.containers[j]);
+	if (c.empty()) continue;
+	count += c.size();
+	if (out != i) {
+	    keys[out] = keys[i];
+	    containers[out] = std::move(c);
+	}
+	++out;
+    }
+    keys.resize(out);
+    containers.resize(out);
+}
+
+void
+RoaringBitmap::unite(const RoaringBitmap& o)
+{
+    vector<Xapian::docid> new_keys;
+    vector<Container> new_containers;
+    new_keys.reserve(keys.size() + o.keys.size());
+    new_containers.reserve(keys.size() + o.keys.size());
+    size_t i = 0, j = 0;
+    count = 0;
+    while (i != keys.size() || j != o.keys.size()) {
+	if (j == o.keys.size() || (i != keys.size() && keys[i] < o.keys[j])) {
+	    new_keys.push_back(keys[i]);
+	    new_containers.push_back(std::move(containers[i++]));
+	} else if (i == keys.size() || o.keys[j] < keys[i]) {
+	    new_keys.push_back(o.keys[j]);
+	    new_containers.push_back(o.containers[j++]);
+	} else {
+	    containers[i].unite(o.containers[j++]);
+	    new_keys.push_back(keys[i]);
+	    new_containers.push_back(std::move(containers[i++]));
+	}
+	count += new_containers.back().size();
+    }
+    keys.swap(new_keys);
+    containers.swap(new_containers);
+}
+
+void
+RoaringBitmap::subtract(const vector<uint64_t>& words)
+{
+    size_t out = 0;
+    count = 0;
+    for (size_t i = 0; i != keys.size(); ++i) {
+	Container& c = containers[i];
+	size_t first_word = size_t(keys[i]) * Container::BITMAP_WORDS;
+	if (first_word < words.size()) {
+	    size_t n_words = min(size_t(Container::BITMAP_WORDS),
+				 words.size() - first_word);
+	    c.subtract(words.data() + first_word, n_words);
+	    if (c.empty()) continue;
+	}
+	count += c.size();
+	if (out != i) {
+	    keys[out] = keys[i];
+	    containers[out] = std::move(c);
+	}
+	++out;
+    }
+    keys.resize(out);
+    containers.resize(out);
+}
@@ -0,0 +1,194 @@
+/** @file roaringbitmap.h
+ * @brief Compressed bitmap of document ids
+ */
+/* Copyright (C) 2026 Xapian contributors
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301 USA
+ */
+
+#ifndef XAPIAN_INCLUDED_ROARINGBITMAP_H
+#define XAPIAN_INCLUDED_ROARINGBITMAP_H
+
+#include "xapian/types.h"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/** A set of document ids stored as a "roaring" bitmap.
+ *
+ *  The document ids are split by their high bits into containers each
+ *  covering CONTAINER_DOCS ids.  A container with few members stores the
+ *  low 16 bits of each in a sorted array, and one with more stores a bitmap,
+ *  so a dense set takes one bit per document id while a sparse one takes
+ *  little more than a sorted array would.  Intersections and unions of two
+ *  bitmap containers work a 64-bit word at a time, and their sizes are
+ *  counted with popcount.
+ */
+class RoaringBitmap {
+  public:
+    /// The set of members of a RoaringBitmap with the same high bits.
+    class Container {
+	/// The members, if stored as an array (empty otherwise).
+	std::vector<uint16_t> array;
+
+	/** The members, if stored as a bitmap (empty otherwise).
+	 *
+	 *  Bit (v % 64) of bits[v / 64] is set if v is a member.
+	 */
+	std::vector<uint64_t> bits;
+
+	/// The number of members.
+	unsigned count = 0;
+
+	/// Convert to storing a bitmap.
+	void to_bits();
+
+	/// Convert to storing an array.
+	void to_array();
+
+	/// Recount the members of a bitmap.
+	void recount();
+
+	/// Switch representation if the other would be smaller.
+	void normalise() {
+	    if (bits.empty()) {
+		if (count > ARRAY_MAX) to_bits();
+	    } else {
+		if (count <= ARRAY_MAX) to_array();
+	    }
+	}
+
+      public:
+	/// The most members a container stores as an array.
+	static constexpr unsigned ARRAY_MAX = 4096;
+
+	/// The number of 64-bit words in a bitmap.
+	static constexpr unsigned BITMAP_WORDS = 1024;
+
+	/// Value next() returns if there are no more members.
+	static constexpr unsigned END = 0x10000;
+
+	/// Return the number of members.
+	unsigned size() const { return count; }
+
+	/// Is the container empty?
+	bool empty() const { return count == 0; }
+
+	/// Is @a v a member?
+	bool contains(unsigned v) const;
+
+	/// Return the smallest member >= @a v, or END if there isn't one.
+	unsigned next(unsigned v) const;
+
+	/// Add @a v.
+	void add(unsigned v);
+
+	/// Remove @a v.
+	void remove(unsigned v);
+
+	/** Set the members.
+	 *
+	 *  @param members	The members in ascending order.
+	 */
+	void assign(std::vector<uint16_t>&& members);
+
+	/// Remove the members which aren't in @a o.
+	void intersect(const Container& o);
+
+	/// Add the members of @a o.
+	void unite(const Container& o);
+
+	/** Remove members given by a bitmap.
+	 *
+	 *  @param words	Bit (v % 64) of words[v / 64] is set if v should
+	 *			be removed.
+	 *  @param n_words	The number of entries in @a words (at most
+	 *			BITMAP_WORDS).
+	 */
+	void subtract(const uint64_t* words, size_t n_words);
+
+	/** Decode a container from its serialised form.
+	 *
+	 *  @return false if the serialised form isn't valid.
+	 */
+	bool unserialise(const char* p, const char* end);
+
+	/** Return the serialised form.
+	 *
+	 *  This is a type byte followed by the members as a sorted array of
+	 *  16-bit values (type 0), a bitmap (type 1) or a list of runs of
+	 *  consecutive values (type 2), whichever is shortest.
+	 */
+	std::string serialise() const;
+    };
+
+    /// The number of document ids each container covers.
+    static constexpr Xapian::docid CONTAINER_DOCS = 0x10000;
+
+  private:
+    /// The high bits (did / CONTAINER_DOCS) for each container, ascending.
+    std::vector<Xapian::docid> keys;
+
+    /// The non-empty containers.
+    std::vector<Container> containers;
+
+    /// The number of members.
+    Xapian::doccount count = 0;
+
+  public:
+    /// Return the number of members.
+    Xapian::doccount size() const { return count; }
+
+    /// Is the set empty?
+    bool empty() const { return count == 0; }
+
+    /// Is @a did a member?
+    bool contains(Xapian::docid did) const;
+
+    /** Append a container.
+     *
+     *  @param key	The high bits of the container's members, which must be
+     *			greater than those of any container already added.
+     *  @param container	The container to append (ignored if empty).
+     */
+    void append(Xapian::docid key, Container&& container);
+
+    /** Find the smallest member >= @a did.
+     *
+     *  @param[in,out] i	The index of the container to start searching
+     *			from.  Updated to the index of the container holding
+     *			the member found.
+     *  @param did	The document id to look for.
+     *
+     *  @return The member found, or 0 if there isn't one.
+     */
+    Xapian::docid next(size_t& i, Xapian::docid did) const;
+
+    /// Remove the members which aren't in @a o.
+    void intersect(const RoaringBitmap& o);
+
+    /// Add the members of @a o.
+    void unite(const RoaringBitmap& o);
+
+    /** Remove members given by a bitmap.
+     *
+     *  @param words	Bit (did % 64) of words[did / 64] is set if did should
+     *			be removed.
+     */
+    void subtract(const std::vector<uint64_t>& words);
+};
+
+#endif // XAPIAN_INCLUDED_ROARINGBITMAP_H
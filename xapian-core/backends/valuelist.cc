@@ -22,6 +22,8 @@
 
 #include "valuelist.h"
 
+#include "valuerangefilter.h"
+
 namespace Xapian {
 
 ValueIterator::Internal::~Internal() { }
@@ -33,4 +35,22 @@ ValueIterator::Internal::check(Xapian::docid did)
     return true;
 }
 
+void
+ValueIterator::Internal::next_in_range(const ValueRangeFilter& filter)
+{
+    do {
+	next();
+    } while (!at_end() && !filter.contains(get_value()));
+}
+
+void
+ValueIterator::Internal::skip_to_in_range(Xapian::docid did,
+					  const ValueRangeFilter& filter)
+{
+    skip_to(did);
+    while (!at_end() && !filter.contains(get_value())) {
+	next();
+    }
+}
+
 }
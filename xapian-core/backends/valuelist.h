@@ -27,6 +27,8 @@
 #include <xapian/types.h>
 #include <xapian/valueiterator.h>
 
+class ValueRangeFilter;
+
 /// Abstract base class for value streams.
 class Xapian::ValueIterator::Internal : public Xapian::Internal::intrusive_base {
     /// Don't allow assignment.
@@ -92,6 +94,21 @@ class Xapian::ValueIterator::Internal : public Xapian::Internal::intrusive_base
      */
     virtual bool check(Xapian::docid did);
 
+    /** Advance to the next entry with a value which @a filter contains.
+     *
+     *  The default implementation calls next() until it finds one.
+     */
+    virtual void next_in_range(const ValueRangeFilter& filter);
+
+    /** Skip forward to the first entry at or after @a did with a value
+     *  which @a filter contains.
+     *
+     *  The default implementation calls skip_to() and then next() until it
+     *  finds one.
+     */
+    virtual void skip_to_in_range(Xapian::docid did,
+				  const ValueRangeFilter& filter);
+
     /// Return a string description of this object.
     virtual std::string get_description() const = 0;
 };
@@ -0,0 +1,146 @@
+/** @file valuerangefilter.h
+ * @brief Test values against a range a block at a time
+ */
+/* Copyright (C) 2026 Xapian contributors
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301 USA
+ */
+
+#ifndef XAPIAN_INCLUDED_VALUERANGEFILTER_H
+#define XAPIAN_INCLUDED_VALUERANGEFILTER_H
+
+#include <cstdint>
+#include <string>
+
+#include "omassert.h"
+#include "wordaccess.h"
+
+/** Test values against a range.
+ *
+ *  Besides testing a single value, this can test a block of values which
+ *  have been decoded to fixed-width keys (see key()) in a loop which the
+ *  compiler can vectorise.  Numeric values serialised with
+ *  Xapian::sortable_serialise() are usually no more than 8 bytes long, so
+ *  the key generally decides the comparison without looking at the value.
+ */
+class ValueRangeFilter {
+    /// Start of the range.
+    std::string lo;
+
+    /// End of the range (ignored if bounded_above is false).
+    std::string hi;
+
+    /// Is there an upper bound?
+    bool bounded_above;
+
+    /// key() of lo.
+    uint64_t lo_key;
+
+    /** key() of hi, or the maximum key if there's no upper bound.
+     *
+     *  Stored as the offset from lo_key so one unsigned comparison can check
+     *  both bounds.
+     */
+    uint64_t span;
+
+    /// Check a value whose key equals the key for one of the bounds.
+    bool contains_tied(const char* p, size_t len) const {
+	int c = lo.compare(0, std::string::npos, p, len);
+	if (c > 0) return false;
+	return !bounded_above || hi.compare(0, std::string::npos, p, len) >= 0;
+    }
+
+  public:
+    /// The maximum number of values find_first() can test at once.
+    static constexpr unsigned BLOCK_SIZE = 64;
+
+    /// Construct a filter for values >= @a lo_.
+    explicit ValueRangeFilter(const std::string& lo_)
+	: lo(lo_), bounded_above(false),
+	  lo_key(key(lo.data(), lo.size())), span(~lo_key) { }
+
+    /// Construct a filter for values between @a lo_ and @a hi_ inclusive.
+    ValueRangeFilter(const std::string& lo_, const std::string& hi_)
+	: lo(lo_), hi(hi_), bounded_above(true),
+	  lo_key(key(lo.data(), lo.size())),
+	  span(key(hi.data(), hi.size()) - lo_key)
+    {
+	if (lo > hi) {
+	    // Nothing can match, but span may have wrapped.  With span zero,
+	    // the only key in range is tied so the exact check rejects it.
+	    span = 0;
+	}
+    }
+
+    /** Return a fixed-width key for a value.
+     *
+     *  This is the first 8 bytes of the value as a big-endian number, padded
+     *  with zero bytes if the value is shorter.  So if the keys for two
+     *  values differ, they compare the same way as the values do.
+     */
+    static uint64_t key(const char* p, size_t len) {
+	if (len >= 8) {
+	    return do_unaligned_read<uint64_t>(
+		    reinterpret_cast<const unsigned char*>(p));
+	}
+	uint64_t k = 0;
+	for (size_t i = 0; i != 8; ++i) {
+	    k <<= 8;
+	    if (i < len) k |= static_cast<unsigned char>(p[i]);
+	}
+	return k;
+    }
+
+    /// Is @a value in the range?
+    bool contains(const std::string& value) const {
+	return value >= lo && (!bounded_above || value <= hi);
+    }
+
+    /** Find the first of a block of values which is in the range.
+     *
+     *  @param keys	key() for each value.
+     *  @param values	Pointer to the data for each value.
+     *  @param lens	Length of each value.
+     *  @param n	Number of values in the block (at most BLOCK_SIZE).
+     *
+     *  @return The index of the first value in the range, or @a n if none
+     *		are.
+     */
+    unsigned find_first(const uint64_t* keys,
+			const char* const* values,
+			const size_t* lens,
+			unsigned n) const {
+	// Classify every value first in a branch-free loop so the compiler
+	// can vectorise it: bit 0 is set if the key is within the keys of
+	// the bounds, and bit 1 if it's equal to one of them, in which case
+	// the value itself needs checking.
+	unsigned char flags[BLOCK_SIZE];
+	AssertRel(n,<=,BLOCK_SIZE);
+	const uint64_t hi_key = lo_key + span;
+	for (unsigned i = 0; i != n; ++i) {
+	    uint64_t k = keys[i];
+	    unsigned in = (k - lo_key <= span);
+	    unsigned tied = (k == lo_key) | (bounded_above & (k == hi_key));
+	    flags[i] = static_cast<unsigned char>(in | (tied << 1));
+	}
+	for (unsigned i = 0; i != n; ++i) {
+	    if (flags[i] == 1) return i;
+	    if (flags[i] == 3 && contains_tied(values[i], lens[i])) return i;
+	}
+	return n;
+    }
+};
+
+#endif // XAPIAN_INCLUDED_VALUERANGEFILTER_H
@@ -29,6 +29,7 @@
 #include <iostream>
 
 #include "gnu_getopt.h"
+#include "parseint.h"
 
 #include "backends/glass/glass_defs.h"
 
@@ -40,6 +41,13 @@ using namespace std;
 #define OPT_HELP 1
 #define OPT_VERSION 2
 #define OPT_NO_RENUMBER 3
+#define OPT_BLOCK_POSTINGS 4
+#define OPT_DOCDATA_DICTIONARY 5
+#define OPT_DOCLEN_COLUMN 6
+#define OPT_TERM_BITMAPS 7
+#define OPT_PACKED_POSITIONS 8
+#define OPT_IMPACT_ORDERED 9
+#define OPT_TERM_FILTER 10
 
 static void show_usage() {
     cout << "Usage: " PROG_NAME " [OPTIONS] SOURCE_DATABASE... DESTINATION_DATABASE\n\n"
@@ -62,6 +70,27 @@ static void show_usage() {
 "                     option is only supported when merging databases if they\n"
 "                     have disjoint ranges of used document ids\n"
 "  -s, --single-file  Produce a single file database\n"
+"  -j, --threads=N    Compact up to N tables at once, and run up to N merges\n"
+"                     at once in each pass of a multipass merge (default 1)\n"
+"      --block-postings\n"
+"                     Store posting lists in bit-packed blocks which are\n"
+"                     faster to decode (honey backend only)\n"
+"      --docdata-dictionary\n"
+"                     Compress document data using a dictionary trained on it\n"
+"                     (glass backend only, needs zstd support)\n"
+"      --doclen-column\n"
+"                     Store an array of document lengths which can be read\n"
+"                     directly (glass backend only)\n"
+"      --term-bitmaps Store bitmaps of the documents indexed by dense terms\n"
+"                     (glass backend only)\n"
+"      --packed-positions\n"
+"                     Store position lists in bit-packed blocks which are\n"
+"                     faster to decode\n"
+"      --impact-ordered\n"
+"                     Store impact-ordered posting lists for score-at-a-time\n"
+"                     matching (glass backend only)\n"
+"      --term-filter  Store a Bloom filter over the terms to speed up looking\n"
+"                     up missing terms (glass backend only)\n"
 "  --help             display this help and exit\n"
 "  --version          output version information and exit" << endl;
 }
@@ -87,6 +116,13 @@ MyCompactor::set_status(const string & table, const string & status)
 {
     if (quiet)
 	return;
+    if (get_parallelism() > 1) {
+	// Updates for different tables are interleaved, so just report the
+	// result for each table.
+	if (!status.empty())
+	    cout << table << ": " << status << endl;
+	return;
+    }
     if (!status.empty())
 	cout << '\r' << table << ": " << status << endl;
     else
@@ -111,7 +147,7 @@ MyCompactor::resolve_duplicate_metadata(const string & key,
 int
 main(int argc, char **argv)
 {
-    const char * opts = "b:B:nFmqs";
+    const char * opts = "b:B:nFmqsj:";
     static const struct option long_opts[] = {
 	{"fuller",	no_argument, 0, 'F'},
 	{"no-full",	no_argument, 0, 'n'},
@@ -120,6 +156,14 @@ main(int argc, char **argv)
 	{"backend",	required_argument, 0, 'B'},
 	{"no-renumber", no_argument, 0, OPT_NO_RENUMBER},
 	{"single-file", no_argument, 0, 's'},
+	{"threads",	required_argument, 0, 'j'},
+	{"block-postings", no_argument, 0, OPT_BLOCK_POSTINGS},
+	{"docdata-dictionary", no_argument, 0, OPT_DOCDATA_DICTIONARY},
+	{"doclen-column", no_argument, 0, OPT_DOCLEN_COLUMN},
+	{"term-bitmaps", no_argument, 0, OPT_TERM_BITMAPS},
+	{"packed-positions", no_argument, 0, OPT_PACKED_POSITIONS},
+	{"impact-ordered", no_argument, 0, OPT_IMPACT_ORDERED},
+	{"term-filter", no_argument, 0, OPT_TERM_FILTER},
 	{"quiet",	no_argument, 0, 'q'},
 	{"help",	no_argument, 0, OPT_HELP},
 	{"version",	no_argument, 0, OPT_VERSION},
@@ -183,6 +227,38 @@ main(int argc, char **argv)
 	    case 's':
 		flags |= Xapian::DBCOMPACT_SINGLE_FILE;
 		break;
+	    case OPT_BLOCK_POSTINGS:
+		flags |= Xapian::DBCOMPACT_BLOCK_POSTINGS;
+		break;
+	    case OPT_DOCDATA_DICTIONARY:
+		flags |= Xapian::DBCOMPACT_DOCDATA_DICTIONARY;
+		break;
+	    case OPT_DOCLEN_COLUMN:
+		flags |= Xapian::DBCOMPACT_DOCLEN_COLUMN;
+		break;
+	    case OPT_TERM_BITMAPS:
+		flags |= Xapian::DBCOMPACT_TERM_BITMAPS;
+		break;
+	    case OPT_PACKED_POSITIONS:
+		flags |= Xapian::DBCOMPACT_PACKED_POSITIONS;
+		break;
+	    case OPT_IMPACT_ORDERED:
+		flags |= Xapian::DBCOMPACT_IMPACT_ORDERED;
+		break;
+	    case OPT_TERM_FILTER:
+		flags |= Xapian::DBCOMPACT_TERM_FILTER;
+		break;
+	    case 'j': {
+		unsigned threads;
+		if (!parse_unsigned(optarg, threads) || threads == 0) {
+		    cerr << PROG_NAME": Bad value '" << optarg
+			 << "' passed for threads - must be a positive integer"
+			 << endl;
+		    exit(1);
+		}
+		compactor.set_parallelism(threads);
+		break;
+	    }
 	    case 'q':
 		compactor.set_quiet(true);
 		break;
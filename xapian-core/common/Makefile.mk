@@ -1,6 +1,7 @@
 noinst_HEADERS +=\
 	common/alignment_cast.h\
 	common/append_filename_arg.h\
+	common/bitpack.h\
 	common/bitstream.h\
 	common/closefrom.h\
 	common/compression_stream.h\
@@ -23,6 +24,7 @@ noinst_HEADERS +=\
 	common/output.h\
 	common/overflow.h\
 	common/pack.h\
+	common/packedpositions.h\
 	common/parseint.h\
 	common/popcount.h\
 	common/posixy_wrapper.h\
@@ -63,6 +65,7 @@ lib_src +=\
 	common/msvc_dirent.cc\
 	common/omassert.cc\
 	common/pack.cc\
+	common/packedpositions.cc\
 	common/posixy_wrapper.cc\
 	common/replicate_utils.cc\
 	common/safe.cc\
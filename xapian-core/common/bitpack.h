@@ -0,0 +1,177 @@
+/** @file bitpack.h
+ * @brief Pack and unpack arrays of fixed width values
+ */
+/* Copyright (C) 2026 Xapian contributors
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301 USA
+ */
+
+#ifndef XAPIAN_INCLUDED_BITPACK_H
+#define XAPIAN_INCLUDED_BITPACK_H
+
+#include "wordaccess.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <string>
+
+#ifdef __SSE2__
+# include <emmintrin.h>
+#endif
+
+/** Bytes unpack_bits() may read beyond the end of the packed data.
+ *
+ *  Callers copy the data to a buffer with this much zeroed padding when it
+ *  isn't known to be followed by enough readable bytes.
+ */
+#define BITPACK_PADDING 16
+
+/// Number of bits needed to represent @a value.
+template<typename U>
+inline unsigned
+bit_width(U value)
+{
+    unsigned width = 0;
+    while (value) {
+	++width;
+	value >>= 1;
+    }
+    return width;
+}
+
+/// The size in bytes of @a n values packed @a width bits each.
+inline size_t
+packed_size(unsigned n, unsigned width)
+{
+    return (size_t(n) * width + 7) / 8;
+}
+
+/** Append @a n values of @a width bits from @a values to @a out.
+ *
+ *  Values are packed least significant bit first, and the result is padded
+ *  to a whole number of bytes.
+ */
+template<typename U>
+inline void
+pack_bits(std::string& out, const U* values, unsigned n, unsigned width)
+{
+    if (width == 0) return;
+    uint64_t acc = 0;
+    unsigned acc_bits = 0;
+    for (unsigned i = 0; i != n; ++i) {
+	uint64_t value = values[i];
+	unsigned bits = width;
+	// Add at most 56 bits at a time so they always fit in acc.
+	while (bits) {
+	    unsigned chunk = std::min(bits, 56u);
+	    acc |= (value & ((uint64_t(1) << chunk) - 1)) << acc_bits;
+	    acc_bits += chunk;
+	    bits -= chunk;
+	    value >>= chunk;
+	    while (acc_bits >= 8) {
+		out += char(acc & 0xff);
+		acc >>= 8;
+		acc_bits -= 8;
+	    }
+	}
+    }
+    if (acc_bits) out += char(acc & 0xff);
+}
+
+/// Read 8 bytes at @a p as a little-endian value.
+inline uint64_t
+read_le64(const unsigned char* p)
+{
+    uint64_t value;
+    std::memcpy(&value, p, sizeof(value));
+#ifdef WORDS_BIGENDIAN
+    value = do_bswap(value);
+#endif
+    return value;
+}
+
+/** Unpack @a n values of @a width bits from @a p to @a out.
+ *
+ *  @a p must be followed by at least 9 readable bytes after the packed data
+ *  (see BITPACK_PADDING).
+ */
+template<typename U>
+inline void
+unpack_bits(const unsigned char* p, unsigned n, unsigned width, U* out)
+{
+    if (width == 0) {
+	for (unsigned i = 0; i != n; ++i) out[i] = 0;
+	return;
+    }
+    if (width <= 57) {
+	// Each value is within a single 8 byte window starting at the byte
+	// containing its first bit, so we can decode without branches.
+	const uint64_t mask = (uint64_t(1) << width) - 1;
+	size_t bit = 0;
+	for (unsigned i = 0; i != n; ++i) {
+	    out[i] = U((read_le64(p + bit / 8) >> (bit % 8)) & mask);
+	    bit += width;
+	}
+	return;
+    }
+
+    const uint64_t mask = width == 64 ? ~uint64_t(0) :
+					(uint64_t(1) << width) - 1;
+    size_t bit = 0;
+    for (unsigned i = 0; i != n; ++i) {
+	unsigned shift = bit % 8;
+	uint64_t value = read_le64(p + bit / 8) >> shift;
+	if (shift) value |= uint64_t(p[bit / 8 + 8]) << (64 - shift);
+	out[i] = U(value & mask);
+	bit += width;
+    }
+}
+
+/** Convert stored deltas in @a v to the values of a strictly increasing
+ *  sequence.
+ *
+ *  Each stored delta is one less than the actual difference from the previous
+ *  value, so v[i] = base + sum(v[0..i]) + i + 1.
+ */
+template<typename U>
+inline void
+deltas_to_values(U* v, unsigned n, U base)
+{
+    unsigned i = 0;
+#ifdef __SSE2__
+    if (sizeof(U) == 4) {
+	// Prefix sum four entries at a time.
+	const __m128i one = _mm_set1_epi32(1);
+	__m128i run = _mm_set1_epi32(int(base));
+	for ( ; i + 4 <= n; i += 4) {
+	    __m128i* ptr = reinterpret_cast<__m128i*>(v + i);
+	    __m128i x = _mm_add_epi32(_mm_loadu_si128(ptr), one);
+	    x = _mm_add_epi32(x, _mm_slli_si128(x, 4));
+	    x = _mm_add_epi32(x, _mm_slli_si128(x, 8));
+	    x = _mm_add_epi32(x, run);
+	    _mm_storeu_si128(ptr, x);
+	    run = _mm_shuffle_epi32(x, 0xff);
+	}
+	if (i) base = v[i - 1];
+    }
+#endif
+    for ( ; i != n; ++i) {
+	base += v[i] + 1;
+	v[i] = base;
+    }
+}
+
+#endif // XAPIAN_INCLUDED_BITPACK_H
@@ -1,5 +1,5 @@
 /** @file compression_stream.cc
- * @brief class wrapper around zlib
+ * @brief class wrapper around zlib, LZ4 and zstd
  */
 /* Copyright (C) 2007,2009,2012,2013,2014,2016,2019 Olly Betts
  * Copyright (C) 2009 Richard Boulton
@@ -24,13 +24,30 @@
 #include "compression_stream.h"
 
 #include "omassert.h"
+#include "pack.h"
 #include "str.h"
 #include "stringutils.h"
 
 #include "xapian/error.h"
 
+#include <cstring>
+
+#ifdef HAVE_LZ4
+# include <lz4.h>
+#endif
+#ifdef HAVE_ZSTD
+# include <zdict.h>
+# include <zstd.h>
+#endif
+
 using namespace std;
 
+#ifdef HAVE_ZSTD
+# ifndef ZSTD_CLEVEL_DEFAULT
+#  define ZSTD_CLEVEL_DEFAULT 3
+# endif
+#endif
+
 CompressionStream::~CompressionStream() {
     if (deflate_zstream) {
 	// Errors which we care about have already been handled, so just ignore
@@ -46,19 +63,125 @@ CompressionStream::~CompressionStream() {
 	delete inflate_zstream;
     }
 
+#ifdef HAVE_ZSTD
+    ZSTD_freeCCtx(zstd_cctx);
+    ZSTD_freeDCtx(zstd_dctx);
+    ZSTD_freeCDict(zstd_cdict);
+    ZSTD_freeDDict(zstd_ddict);
+#endif
+
     delete [] out;
 }
 
-const char*
-CompressionStream::compress(const char* buf, size_t* p_size) {
-    lazy_alloc_deflate_zstream();
-    size_t size = *p_size;
+bool
+CompressionStream::compressor_available(int type)
+{
+    switch (type) {
+	case ZLIB:
+	    return true;
+#ifdef HAVE_LZ4
+	case LZ4:
+	    return true;
+#endif
+#ifdef HAVE_ZSTD
+	case ZSTD:
+	case ZSTD_DICT:
+	    return true;
+#endif
+    }
+    return false;
+}
+
+void
+CompressionStream::check_compressor(int type)
+{
+    if (compressor_available(type)) return;
+    string msg;
+    switch (type) {
+	case LZ4:
+	    msg = "LZ4";
+	    break;
+	case ZSTD:
+	case ZSTD_DICT:
+	    msg = "Zstd";
+	    break;
+	default:
+	    msg = "Unknown compressor (";
+	    msg += str(type);
+	    msg += ')';
+	    throw Xapian::FeatureUnavailableError(msg);
+    }
+    msg += " compression support wasn't enabled when Xapian was built";
+    throw Xapian::FeatureUnavailableError(msg);
+}
+
+void
+CompressionStream::set_compressor(int type)
+{
+    if (type == compressor) return;
+    check_compressor(type);
+    compressor = type;
+}
+
+void
+CompressionStream::set_dictionary(const string& dictionary_)
+{
+    if (dictionary_ == dictionary) return;
+    dictionary = dictionary_;
+#ifdef HAVE_ZSTD
+    // The prepared forms get created again when they're next needed.
+    ZSTD_freeCDict(zstd_cdict);
+    zstd_cdict = NULL;
+    ZSTD_freeDDict(zstd_ddict);
+    zstd_ddict = NULL;
+#endif
+}
+
+string
+CompressionStream::train_dictionary(const string& samples,
+				    const vector<size_t>& sizes,
+				    size_t max_size)
+{
+#ifdef HAVE_ZSTD
+    string result(max_size, '\0');
+    size_t r = ZDICT_trainFromBuffer(&result[0], max_size,
+				     samples.data(), sizes.data(),
+				     unsigned(sizes.size()));
+    if (ZDICT_isError(r)) {
+	// Most likely there wasn't enough sample data.
+	return string();
+    }
+    result.resize(r);
+    return result;
+#else
+    (void)samples;
+    (void)sizes;
+    (void)max_size;
+    check_compressor(ZSTD_DICT);
+    return string();
+#endif
+}
+
+void
+CompressionStream::reserve_out(size_t size)
+{
     if (!out || out_len < size) {
 	out_len = size;
 	delete [] out;
 	out = NULL;
 	out = new char[size];
     }
+}
+
+const char*
+CompressionStream::compress(const char* buf, size_t* p_size) {
+    if (compressor == LZ4) return lz4_compress(buf, p_size);
+    if (compressor == ZSTD || compressor == ZSTD_DICT)
+	return zstd_compress(buf, p_size);
+
+    lazy_alloc_deflate_zstream();
+    size_t size = *p_size;
+    reserve_out(size);
     deflate_zstream->avail_in = static_cast<uInt>(size);
     deflate_zstream->next_in = reinterpret_cast<const Bytef*>(buf);
     deflate_zstream->next_out = reinterpret_cast<Bytef*>(out);
@@ -82,9 +205,25 @@ CompressionStream::compress(const char* buf, size_t* p_size) {
     return out;
 }
 
+void
+CompressionStream::decompress_start()
+{
+    if (compressor == LZ4) {
+	lz4_pending.resize(0);
+    } else if (compressor == ZSTD || compressor == ZSTD_DICT) {
+	zstd_decompress_start();
+    } else {
+	lazy_alloc_inflate_zstream();
+    }
+}
+
 bool
 CompressionStream::decompress_chunk(const char* p, int len, string& buf)
 {
+    if (compressor == LZ4) return lz4_decompress_chunk(p, len, buf);
+    if (compressor == ZSTD || compressor == ZSTD_DICT)
+	return zstd_decompress_chunk(p, len, buf);
+
     Bytef blk[8192];
 
     inflate_zstream->next_in = reinterpret_cast<const Bytef*>(p);
@@ -184,3 +323,190 @@ CompressionStream::lazy_alloc_inflate_zstream() {
 	throw Xapian::DatabaseError(msg);
     }
 }
+
+/* LZ4 compressed data is stored as the length of the uncompressed data and
+ * the length of the compressed data (each encoded with pack_uint()) followed
+ * by an LZ4 block.  Unlike zlib's streams, an LZ4 block can't be decompressed
+ * piecemeal, so we need the compressed length to know when we have it all.
+ */
+
+#ifdef HAVE_LZ4
+/// Maximum size of the header in front of an LZ4 block.
+static const size_t LZ4_HEADER_MAX = 10;
+#endif
+
+const char*
+CompressionStream::lz4_compress(const char* buf, size_t* p_size)
+{
+#ifdef HAVE_LZ4
+    size_t size = *p_size;
+    if (size > size_t(LZ4_MAX_INPUT_SIZE)) return NULL;
+    string header;
+    pack_uint(header, size);
+    // The compressed length needs at least one more byte of header, and it's
+    // only worth storing the compressed version if it's smaller.
+    if (size <= header.size() + 2) return NULL;
+    int capacity = int(size - header.size() - 2);
+    reserve_out(LZ4_HEADER_MAX + capacity);
+    char* block = out + LZ4_HEADER_MAX;
+    int comp_size = LZ4_compress_default(buf, block, int(size), capacity);
+    if (comp_size <= 0) {
+	// It didn't get smaller.
+	return NULL;
+    }
+    pack_uint(header, unsigned(comp_size));
+    if (header.size() + comp_size >= size) {
+	// It didn't get smaller once the header was added.
+	return NULL;
+    }
+    char* start = block - header.size();
+    memcpy(start, header.data(), header.size());
+    *p_size = header.size() + comp_size;
+    return start;
+#else
+    (void)buf;
+    (void)p_size;
+    return NULL;
+#endif
+}
+
+bool
+CompressionStream::lz4_decompress_chunk(const char* p, int len, string& buf)
+{
+#ifdef HAVE_LZ4
+    if (!lz4_pending.empty()) {
+	lz4_pending.append(p, len);
+	p = lz4_pending.data();
+	len = int(lz4_pending.size());
+    }
+    const char* q = p;
+    const char* end = p + len;
+    size_t size, comp_size;
+    if (!unpack_uint(&q, end, &size) || !unpack_uint(&q, end, &comp_size)) {
+	if (q) {
+	    throw Xapian::DatabaseCorruptError("Bad LZ4 compressed data "
+					       "length");
+	}
+	// We don't have the whole header yet.
+	if (lz4_pending.empty()) lz4_pending.assign(p, len);
+	return false;
+    }
+    if (size_t(end - q) < comp_size) {
+	// We don't have all the compressed data yet.
+	if (lz4_pending.empty()) lz4_pending.assign(p, len);
+	return false;
+    }
+    if (size_t(end - q) != comp_size || size > size_t(LZ4_MAX_INPUT_SIZE)) {
+	throw Xapian::DatabaseCorruptError("Bad LZ4 compressed data length");
+    }
+    size_t old_size = buf.size();
+    buf.resize(old_size + size);
+    int r = LZ4_decompress_safe(q, &buf[old_size], int(comp_size), int(size));
+    lz4_pending.resize(0);
+    if (r < 0 || size_t(r) != size) {
+	buf.resize(old_size);
+	throw Xapian::DatabaseError("LZ4 decompression failed");
+    }
+    return true;
+#else
+    (void)p;
+    (void)len;
+    (void)buf;
+    throw Xapian::FeatureUnavailableError("LZ4 compression support wasn't "
+					  "enabled when Xapian was built");
+#endif
+}
+
+const char*
+CompressionStream::zstd_compress(const char* buf, size_t* p_size)
+{
+#ifdef HAVE_ZSTD
+    if (!zstd_cctx) {
+	zstd_cctx = ZSTD_createCCtx();
+	if (!zstd_cctx) throw std::bad_alloc();
+    }
+    size_t size = *p_size;
+    reserve_out(size);
+    size_t r;
+    if (compressor == ZSTD_DICT && !dictionary.empty()) {
+	if (!zstd_cdict) {
+	    zstd_cdict = ZSTD_createCDict(dictionary.data(), dictionary.size(),
+					  ZSTD_CLEVEL_DEFAULT);
+	    if (!zstd_cdict) throw std::bad_alloc();
+	}
+	r = ZSTD_compress_usingCDict(zstd_cctx, out, size, buf, size,
+				     zstd_cdict);
+    } else {
+	r = ZSTD_compressCCtx(zstd_cctx, out, size, buf, size,
+			      ZSTD_CLEVEL_DEFAULT);
+    }
+    if (ZSTD_isError(r) || r >= size) {
+	// It didn't get smaller.
+	return NULL;
+    }
+    *p_size = r;
+    return out;
+#else
+    (void)buf;
+    (void)p_size;
+    return NULL;
+#endif
+}
+
+void
+CompressionStream::zstd_decompress_start()
+{
+#ifdef HAVE_ZSTD
+    if (usual(zstd_dctx)) {
+	size_t r = ZSTD_DCtx_reset(zstd_dctx, ZSTD_reset_session_only);
+	if (rare(ZSTD_isError(r))) {
+	    // Try to recover by deleting the context and starting from
+	    // scratch.
+	    ZSTD_freeDCtx(zstd_dctx);
+	    zstd_dctx = NULL;
+	}
+    }
+    if (!zstd_dctx) {
+	zstd_dctx = ZSTD_createDCtx();
+	if (!zstd_dctx) throw std::bad_alloc();
+    }
+    if (compressor == ZSTD_DICT && !dictionary.empty() && !zstd_ddict) {
+	zstd_ddict = ZSTD_createDDict(dictionary.data(), dictionary.size());
+	if (!zstd_ddict) throw std::bad_alloc();
+    }
+    // Passing NULL means no dictionary.
+    ZSTD_DCtx_refDDict(zstd_dctx,
+		       compressor == ZSTD_DICT ? zstd_ddict : NULL);
+#endif
+}
+
+bool
+CompressionStream::zstd_decompress_chunk(const char* p, int len, string& buf)
+{
+#ifdef HAVE_ZSTD
+    char blk[8192];
+
+    ZSTD_inBuffer in = { p, size_t(len), 0 };
+    while (true) {
+	ZSTD_outBuffer out_buf = { blk, sizeof(blk), 0 };
+	size_t r = ZSTD_decompressStream(zstd_dctx, &out_buf, &in);
+	if (ZSTD_isError(r)) {
+	    string msg = "zstd decompression failed (";
+	    msg += ZSTD_getErrorName(r);
+	    msg += ')';
+	    throw Xapian::DatabaseError(msg);
+	}
+
+	buf.append(blk, out_buf.pos);
+	// A return value of 0 means the frame is complete and fully flushed.
+	if (r == 0) return true;
+	if (in.pos == in.size && out_buf.pos < out_buf.size) return false;
+    }
+#else
+    (void)p;
+    (void)len;
+    (void)buf;
+    throw Xapian::FeatureUnavailableError("Zstd compression support wasn't "
+					  "enabled when Xapian was built");
+#endif
+}
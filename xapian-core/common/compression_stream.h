@@ -1,5 +1,5 @@
 /** @file compression_stream.h
- * @brief class wrapper around zlib
+ * @brief class wrapper around zlib, LZ4 and zstd
  */
 /* Copyright (C) 2012 Dan Colish
  * Copyright (C) 2012,2013,2014,2016 Olly Betts
@@ -24,11 +24,34 @@
 
 #include "internaltypes.h"
 #include <string>
+#include <vector>
 #include <zlib.h>
 
+struct ZSTD_CCtx_s;
+struct ZSTD_DCtx_s;
+struct ZSTD_CDict_s;
+struct ZSTD_DDict_s;
+
 class CompressionStream {
+  public:
+    /** Compression algorithms.
+     *
+     *  These values are stored in database files, so mustn't be changed.
+     */
+    enum {
+	ZLIB = 0,
+	LZ4 = 1,
+	ZSTD = 2,
+	/// Zstd using a dictionary passed to set_dictionary().
+	ZSTD_DICT = 3
+    };
+
+  private:
     int compress_strategy;
 
+    /// The compression algorithm in use.
+    int compressor;
+
     size_t out_len;
 
     char* out;
@@ -39,31 +62,112 @@ class CompressionStream {
     /// Zlib state object for inflating
     z_stream* inflate_zstream;
 
+    /// Zstd state object for compressing
+    ZSTD_CCtx_s* zstd_cctx;
+
+    /// Zstd state object for decompressing
+    ZSTD_DCtx_s* zstd_dctx;
+
+    /// Dictionary for ZSTD_DICT.
+    std::string dictionary;
+
+    /// Zstd dictionary prepared for compressing (created lazily).
+    ZSTD_CDict_s* zstd_cdict;
+
+    /// Zstd dictionary prepared for decompressing (created lazily).
+    ZSTD_DDict_s* zstd_ddict;
+
+    /// LZ4 compressed data buffered until we have all of it.
+    std::string lz4_pending;
+
+    /// Ensure out is at least @a size bytes long.
+    void reserve_out(size_t size);
+
     /// Allocate the zstream for deflating, if not already allocated.
     void lazy_alloc_deflate_zstream();
 
     /// Allocate the zstream for inflating, if not already allocated.
     void lazy_alloc_inflate_zstream();
 
+    const char* lz4_compress(const char* buf, size_t* p_size);
+
+    bool lz4_decompress_chunk(const char* p, int len, std::string& buf);
+
+    const char* zstd_compress(const char* buf, size_t* p_size);
+
+    void zstd_decompress_start();
+
+    bool zstd_decompress_chunk(const char* p, int len, std::string& buf);
+
   public:
     /* Create a new CompressionStream object.
      *
      *  @param compress_strategy_	Z_DEFAULT_STRATEGY,
      *					Z_FILTERED, Z_HUFFMAN_ONLY, or Z_RLE.
+     *					Only used for zlib.
      */
     explicit CompressionStream(int compress_strategy_ = Z_DEFAULT_STRATEGY)
 	: compress_strategy(compress_strategy_),
+	  compressor(ZLIB),
 	  out_len(0),
 	  out(NULL),
 	  deflate_zstream(NULL),
-	  inflate_zstream(NULL)
+	  inflate_zstream(NULL),
+	  zstd_cctx(NULL),
+	  zstd_dctx(NULL),
+	  zstd_cdict(NULL),
+	  zstd_ddict(NULL)
     { }
 
     ~CompressionStream();
 
+    /// Was support for compression algorithm @a type compiled in?
+    static bool compressor_available(int type);
+
+    /** Check support for compression algorithm @a type was compiled in.
+     *
+     *  @exception Xapian::FeatureUnavailableError if it wasn't (or @a type
+     *		   isn't known).
+     */
+    static void check_compressor(int type);
+
+    /** Select the compression algorithm to use.
+     *
+     *  @exception Xapian::FeatureUnavailableError if support for @a type
+     *		   wasn't compiled in (or @a type isn't known).
+     */
+    void set_compressor(int type);
+
+    int get_compressor() const { return compressor; }
+
+    /** Set the dictionary to use for ZSTD_DICT.
+     *
+     *  The same dictionary must be used to decompress data as was used to
+     *  compress it.
+     */
+    void set_dictionary(const std::string& dictionary_);
+
+    const std::string& get_dictionary() const { return dictionary; }
+
+    /** Train a dictionary for ZSTD_DICT.
+     *
+     *  @param samples	The sample data, concatenated.
+     *  @param sizes	The size of each sample in @a samples.
+     *  @param max_size	The maximum size of dictionary to produce.
+     *
+     *  @return The dictionary, or an empty string if there isn't enough
+     *		sample data to train one.
+     *
+     *  @exception Xapian::FeatureUnavailableError if zstd support wasn't
+     *		   compiled in.
+     */
+    static std::string train_dictionary(const std::string& samples,
+					const std::vector<size_t>& sizes,
+					size_t max_size);
+
     const char* compress(const char* buf, size_t* p_size);
 
-    void decompress_start() { lazy_alloc_inflate_zstream(); }
+    void decompress_start();
 
     /** Returns true if this was the final chunk. */
     bool decompress_chunk(const char* p, int len, std::string& buf);
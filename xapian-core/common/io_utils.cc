@@ -24,8 +24,13 @@
 #include "io_utils.h"
 #include "posixy_wrapper.h"
 
+#include "safesysstat.h"
 #include "safeunistd.h"
 
+#ifdef HAVE_MMAP
+# include <sys/mman.h>
+#endif
+
 #include <cerrno>
 #include <cstring>
 #include <string>
@@ -256,6 +261,30 @@ io_readahead_block(int fd, size_t n, off_t b, off_t o)
 }
 #endif
 
+#ifdef HAVE_MMAP
+const char*
+io_map_rd(int fd, size_t& size)
+{
+    struct stat statbuf;
+    if (fstat(fd, &statbuf) < 0 || statbuf.st_size <= 0)
+	return NULL;
+    if (sizeof(off_t) > sizeof(size_t) &&
+	statbuf.st_size != off_t(size_t(statbuf.st_size)))
+	return NULL;
+    size = size_t(statbuf.st_size);
+    void* p = mmap(NULL, size, PROT_READ, MAP_SHARED, fd, 0);
+    if (p == MAP_FAILED)
+	return NULL;
+    return static_cast<const char*>(p);
+}
+
+void
+io_unmap(const char* p, size_t size)
+{
+    (void)munmap(const_cast<char*>(p), size);
+}
+#endif
+
 void
 io_read_block(int fd, char * p, size_t n, off_t b, off_t o)
 {
@@ -156,6 +156,31 @@ bool io_readahead_block(int fd, size_t n, off_t b, off_t o = 0);
 inline bool io_readahead_block(int, size_t, off_t, off_t = 0) { return false; }
 #endif
 
+/** Map the file open on fd into memory for reading.
+ *
+ *  The whole file is mapped, and the mapping won't grow if the file is
+ *  extended later.
+ *
+ *  @param fd	The file descriptor.
+ *  @param size	Set to the size of the mapping in bytes.
+ *
+ *  @return A pointer to the start of the mapping, or NULL if the file can't
+ *	    be mapped (for example, it's empty or mmap() isn't supported) - in
+ *	    this case the caller should fall back to reading the file.
+ */
+#ifdef HAVE_MMAP
+const char* io_map_rd(int fd, size_t& size);
+#else
+inline const char* io_map_rd(int, size_t&) { return NULL; }
+#endif
+
+/// Unmap a mapping returned by io_map_rd().
+#ifdef HAVE_MMAP
+void io_unmap(const char* p, size_t size);
+#else
+inline void io_unmap(const char*, size_t) { }
+#endif
+
 /// Read block b size n bytes into buffer p from file descriptor fd, offset o.
 void io_read_block(int fd, char * p, size_t n, off_t b, off_t o = 0);
 
@@ -0,0 +1,201 @@
+/** @file packedpositions.cc
+ * @brief Bit-packed encoding of position lists
+ */
+/* Copyright (C) 2026 Xapian contributors
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301 USA
+ */
+
+#include <config.h>
+
+#include "packedpositions.h"
+
+#include "bitpack.h"
+#include "bitstream.h"
+#include "omassert.h"
+#include "overflow.h"
+#include "pack.h"
+#include "xapian/error.h"
+
+#include <algorithm>
+#include <cstring>
+
+using namespace std;
+
+[[noreturn]]
+static void
+throw_corrupt()
+{
+    throw Xapian::DatabaseCorruptError("Position list data corrupt");
+}
+
+void
+encode_packed_positions(string& s, const Xapian::VecCOW<Xapian::termpos>& pos)
+{
+    AssertRel(pos.size(), >=, 2);
+    pack_uint(s, pos.size() - 2);
+    pack_uint(s, pos[0]);
+
+    Xapian::termpos deltas[POSITION_BLOCK_SIZE];
+    size_t j = 1;
+    while (j != pos.size()) {
+	unsigned n = unsigned(min(pos.size() - j, size_t(POSITION_BLOCK_SIZE)));
+	Xapian::termpos sum = 0;
+	Xapian::termpos deltas_or = 0;
+	for (unsigned k = 0; k != n; ++k) {
+	    AssertRel(pos[j + k], >, pos[j + k - 1]);
+	    Xapian::termpos delta = pos[j + k] - pos[j + k - 1] - 1;
+	    deltas[k] = delta;
+	    sum += delta;
+	    deltas_or |= delta;
+	}
+	pack_uint(s, sum);
+	unsigned width = bit_width(deltas_or);
+	s += char(width);
+	pack_bits(s, deltas, n, width);
+	j += n;
+    }
+}
+
+void
+convert_positions(string& data, unsigned from, unsigned to)
+{
+    if (from == to) return;
+
+    const char* p = data.data();
+    const char* end = p + data.size();
+    Xapian::termpos pos_last;
+    if (!unpack_uint(&p, end, &pos_last)) {
+	throw_corrupt();
+    }
+    // A single entry position list is the same in every encoding.
+    if (p == end) return;
+
+    Xapian::VecCOW<Xapian::termpos> pos;
+    Xapian::termpos pos_first;
+    Xapian::termcount pos_size;
+    if (from == POSITIONS_PACKED) {
+	PackedPositionReader rd;
+	pos_size = rd.init(p, end, pos_first);
+	pos.reserve(pos_size);
+	pos.push_back(pos_first);
+	while (pos.size() != pos_size) pos.push_back(rd.next());
+	if (!rd.check_all_gone()) throw_corrupt();
+    } else {
+	Xapian::BitReader rd(p, end);
+	pos_first = rd.decode(pos_last);
+	pos_size = rd.decode(pos_last - pos_first) + 2;
+	rd.decode_interpolative(0, pos_size - 1, pos_first, pos_last);
+	pos.reserve(pos_size);
+	pos.push_back(pos_first);
+	while (pos.size() != pos_size) {
+	    pos.push_back(rd.decode_interpolative_next());
+	}
+    }
+    if (pos.back() != pos_last) throw_corrupt();
+
+    string out;
+    pack_uint(out, pos_last);
+    if (to == POSITIONS_PACKED) {
+	encode_packed_positions(out, pos);
+    } else {
+	Xapian::BitWriter wr(out);
+	wr.encode(pos_first, pos_last);
+	wr.encode(pos_size - 2, pos_last - pos_first);
+	wr.encode_interpolative(pos, 0, pos_size - 1);
+	swap(out, wr.freeze());
+    }
+    data = std::move(out);
+}
+
+Xapian::termcount
+PackedPositionReader::init(const char* p_, const char* end_,
+			   Xapian::termpos& first)
+{
+    Xapian::termcount size;
+    if (!unpack_uint(&p_, end_, &size) ||
+	!unpack_uint(&p_, end_, &first)) {
+	throw_corrupt();
+    }
+    p = p_;
+    end = end_;
+    remaining = size + 1;
+    base = first;
+    i = n = 0;
+    return size + 2;
+}
+
+Xapian::termpos
+PackedPositionReader::read_block_header(unsigned& count, unsigned& width)
+{
+    Xapian::termpos sum;
+    if (remaining == 0 || !unpack_uint(&p, end, &sum) || p == end) {
+	throw_corrupt();
+    }
+    count = unsigned(min(remaining, Xapian::termcount(POSITION_BLOCK_SIZE)));
+    width = static_cast<unsigned char>(*p++);
+    Xapian::termpos block_last;
+    if (width > sizeof(Xapian::termpos) * 8 ||
+	size_t(end - p) < packed_size(count, width) ||
+	add_overflows(base, sum, block_last) ||
+	add_overflows(block_last, count, block_last)) {
+	throw_corrupt();
+    }
+    return block_last;
+}
+
+void
+PackedPositionReader::decode_block(unsigned count, unsigned width)
+{
+    // unpack_bits() may read beyond the end of the packed data, so copy the
+    // data to a padded buffer if it is too close to the end.
+    size_t len = packed_size(count, width);
+    unsigned char buf[POSITION_BLOCK_SIZE * sizeof(Xapian::termpos) +
+		      BITPACK_PADDING];
+    const unsigned char* data = reinterpret_cast<const unsigned char*>(p);
+    if (size_t(end - p) < len + BITPACK_PADDING) {
+	memcpy(buf, p, len);
+	memset(buf + len, 0, BITPACK_PADDING);
+	data = buf;
+    }
+    unpack_bits(data, count, width, block);
+    deltas_to_values(block, count, base);
+    p += len;
+    remaining -= count;
+    base = block[count - 1];
+    n = count;
+    i = 0;
+}
+
+Xapian::termpos
+PackedPositionReader::skip_to(Xapian::termpos target)
+{
+    if (i == n || block[n - 1] < target) {
+	// Step over whole blocks which end before target.
+	while (true) {
+	    unsigned count, width;
+	    Xapian::termpos block_last = read_block_header(count, width);
+	    if (block_last >= target) {
+		decode_block(count, width);
+		break;
+	    }
+	    p += packed_size(count, width);
+	    remaining -= count;
+	    base = block_last;
+	}
+    }
+    i = unsigned(lower_bound(block + i, block + n, target) - block);
+    return block[i++];
+}
@@ -0,0 +1,145 @@
+/** @file packedpositions.h
+ * @brief Bit-packed encoding of position lists
+ */
+/* Copyright (C) 2026 Xapian contributors
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301 USA
+ */
+
+#ifndef XAPIAN_INCLUDED_PACKEDPOSITIONS_H
+#define XAPIAN_INCLUDED_PACKEDPOSITIONS_H
+
+#include <xapian/types.h>
+
+#include "api/smallvector.h"
+
+#include <string>
+
+/** Ways the entries in a position table can be encoded.
+ *
+ *  The encoding is chosen when a database is created (or compacted) and
+ *  recorded for the position table as a whole.
+ */
+enum {
+    /// Interpolative coding using BitWriter (the default).
+    POSITIONS_INTERPOLATIVE = 0,
+
+    /// Blocks of bit-packed deltas (see encode_packed_positions()).
+    POSITIONS_PACKED = 1
+};
+
+/// The most positions in each block of a packed position list.
+#define POSITION_BLOCK_SIZE 128
+
+/** Append a position list with at least two entries in the packed encoding.
+ *
+ *  A position list entry starts with pack_uint(last position) whichever
+ *  encoding is used, and that's all there is if there's only one position.
+ *  Otherwise the packed encoding follows that with:
+ *
+ *  * pack_uint(number of positions - 2)
+ *  * pack_uint(first position)
+ *  * the rest of the positions in blocks of up to POSITION_BLOCK_SIZE, each
+ *    stored as pack_uint(sum of the stored deltas), a byte giving their bit
+ *    width and the stored deltas (each one less than the difference from
+ *    the previous position) bit-packed at that width.
+ *
+ *  This is usually a little larger than interpolative coding, but a whole
+ *  block can be decoded in a tight loop without data-dependent branches, and
+ *  the block headers allow skipping over blocks without decoding them.
+ *
+ *  @param s	The string to append to.
+ *  @param pos	The positions, which must be in strictly ascending order.
+ */
+void encode_packed_positions(std::string& s,
+			     const Xapian::VecCOW<Xapian::termpos>& pos);
+
+/** Convert a position list entry from one encoding to another.
+ *
+ *  @param data	The entry to convert, which is updated in place.
+ *  @param from	The encoding @a data is in.
+ *  @param to	The encoding to convert it to.
+ */
+void convert_positions(std::string& data, unsigned from, unsigned to);
+
+/// Read a position list in the packed encoding a block at a time.
+class PackedPositionReader {
+    /// The next block header.
+    const char* p;
+
+    /// End of the encoded data.
+    const char* end;
+
+    /// Number of positions after the current block.
+    Xapian::termcount remaining;
+
+    /// The position before the next block.
+    Xapian::termpos base;
+
+    /// Index in block of the next position to return.
+    unsigned i = 0;
+
+    /// Number of positions in block.
+    unsigned n = 0;
+
+    /// The decoded positions from the current block.
+    Xapian::termpos block[POSITION_BLOCK_SIZE];
+
+    /** Read the header of the next block.
+     *
+     *  @param[out] count	The number of positions in the block.
+     *  @param[out] width	The bit width of the stored deltas.
+     *
+     *  @return The last position in the block.
+     */
+    Xapian::termpos read_block_header(unsigned& count, unsigned& width);
+
+    /// Decode the next block, whose header has already been read.
+    void decode_block(unsigned count, unsigned width);
+
+  public:
+    /** Start reading.
+     *
+     *  @param p_,end_	The encoded data following the last position.
+     *  @param[out] first	The first position.
+     *
+     *  @return The number of positions.
+     */
+    Xapian::termcount init(const char* p_, const char* end_,
+			   Xapian::termpos& first);
+
+    /// Return the next position, which must exist.
+    Xapian::termpos next() {
+	if (i == n) {
+	    unsigned count, width;
+	    (void)read_block_header(count, width);
+	    decode_block(count, width);
+	}
+	return block[i++];
+    }
+
+    /** Return the first position >= @a target.
+     *
+     *  There must be such a position which hasn't been returned yet.
+     */
+    Xapian::termpos skip_to(Xapian::termpos target);
+
+    /// Check all the data has been read.
+    bool check_all_gone() const {
+	return i == n && remaining == 0 && p == end;
+    }
+};
+
+#endif // XAPIAN_INCLUDED_PACKEDPOSITIONS_H
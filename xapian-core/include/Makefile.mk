@@ -9,6 +9,7 @@ inc_HEADERS =\
 
 xapianinclude_HEADERS =\
 	include/xapian/attributes.h\
+	include/xapian/bulkbuilder.h\
 	include/xapian/cluster.h\
 	include/xapian/compactor.h\
 	include/xapian/constants.h\
@@ -28,6 +29,7 @@ xapianinclude_HEADERS =\
 	include/xapian/matchdecider.h\
 	include/xapian/matchspy.h\
 	include/xapian/mset.h\
+	include/xapian/msetcache.h\
 	include/xapian/positioniterator.h\
 	include/xapian/postingiterator.h\
 	include/xapian/postingsource.h\
@@ -71,6 +71,7 @@
 #include <xapian/enquire.h>
 #include <xapian/eset.h>
 #include <xapian/mset.h>
+#include <xapian/msetcache.h>
 #include <xapian/expanddecider.h>
 #include <xapian/keymaker.h>
 #include <xapian/matchdecider.h>
@@ -101,6 +102,7 @@
 #include <xapian/geospatial.h>
 
 // Database compaction and merging
+#include <xapian/bulkbuilder.h>
 #include <xapian/compactor.h>
 
 // ELF visibility annotations for GCC.
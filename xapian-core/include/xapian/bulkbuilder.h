@@ -0,0 +1,172 @@
+/** @file bulkbuilder.h
+ * @brief Build a compacted database from scratch in bulk
+ */
+/* Copyright (C) 2026 Xapian contributors
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301
+ * USA
+ */
+
+#ifndef XAPIAN_INCLUDED_BULKBUILDER_H
+#define XAPIAN_INCLUDED_BULKBUILDER_H
+
+#if !defined XAPIAN_IN_XAPIAN_H && !defined XAPIAN_LIB_BUILD
+# error Never use <xapian/bulkbuilder.h> directly; include <xapian.h> instead.
+#endif
+
+#include <xapian/constants.h>
+#include <xapian/intrusive_ptr.h>
+#include <xapian/types.h>
+#include <xapian/visibility.h>
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+namespace Xapian {
+
+class Compactor;
+class Document;
+
+/** Build a compacted database from a stream of documents.
+ *
+ *  This is intended for building a database from scratch (for example, a
+ *  nightly full rebuild) where the result is going to be compacted anyway,
+ *  such as building a honey database.  It gives the same result as adding
+ *  the documents to a new WritableDatabase and then compacting it with
+ *  Database::compact(), but avoids repeatedly merging changes into the
+ *  posting lists as the database grows, which is where most of the I/O and
+ *  time goes when building a large database.
+ *
+ *  Documents are inverted in memory until a memory limit is reached, and
+ *  then written out as a sorted run to a temporary database.  The runs are
+ *  merged into the output database by finish().  Documents passed to
+ *  add_documents() are inverted by several threads in parallel, and each
+ *  run is written out by a background thread while the next one is built.
+ *
+ *  Documents are given consecutive document IDs starting from 1.
+ */
+class XAPIAN_VISIBILITY_DEFAULT BulkBuilder {
+    /// Don't allow copying.
+    BulkBuilder(const BulkBuilder&) = delete;
+
+    /// Don't allow assignment.
+    BulkBuilder& operator=(const BulkBuilder&) = delete;
+
+  public:
+    /// Class representing the BulkBuilder internals.
+    class Internal;
+    /// @private @internal Reference counted internals.
+    Xapian::Internal::intrusive_ptr_nonnull<Internal> internal;
+
+    /** Start building a database.
+     *
+     *  The runs are stored in temporary databases named by appending
+     *  ".run0", ".run1", etc to @a path, which are removed by finish() or
+     *  the destructor.
+     *
+     *  @param path		The path of the database to build.  This is
+     *				passed to Database::compact() by finish(), so
+     *				mustn't already exist as a database.
+     *  @param flags		Any of the following combined using bitwise-or
+     *				(| in C++):
+     *   - Xapian::DB_BACKEND_HONEY build a honey database (this is the
+     *     default if no backend is specified).
+     *   - Xapian::DB_BACKEND_GLASS build a glass database.
+     *   - Xapian::DBCOMPACT_MULTIPASS, Xapian::DBCOMPACT_SINGLE_FILE,
+     *     Xapian::DBCOMPACT_BLOCK_POSTINGS,
+     *     Xapian::DBCOMPACT_DOCDATA_DICTIONARY,
+     *     Xapian::DBCOMPACT_DOCLEN_COLUMN,
+     *     Xapian::DBCOMPACT_TERM_BITMAPS,
+     *     Xapian::DBCOMPACT_PACKED_POSITIONS,
+     *     Xapian::DBCOMPACT_IMPACT_ORDERED and
+     *     Xapian::DBCOMPACT_TERM_FILTER are passed on to
+     *     Database::compact().
+     *  @param memory_limit	The number of bytes of memory to use to buffer
+     *				inverted documents (default: 0 which means
+     *				256MB).  This is an estimate of the memory used
+     *				by the posting and position data - the run
+     *				being written out and the run being built each
+     *				get half.
+     *  @param parallelism	The maximum number of threads to use to invert
+     *				documents passed to add_documents() (default: 0,
+     *				which means as many threads as the hardware
+     *				supports).
+     */
+    explicit BulkBuilder(const std::string& path,
+			 int flags = 0,
+			 std::size_t memory_limit = 0,
+			 unsigned parallelism = 0);
+
+    /** Destructor.
+     *
+     *  If finish() hasn't been called, the database isn't built and the
+     *  temporary runs are discarded.
+     */
+    ~BulkBuilder();
+
+    /** Add a document.
+     *
+     *  If this throws an exception, the documents buffered in the current
+     *  run are lost, so the database can't be built and any further calls
+     *  (including finish()) throw Xapian::InvalidOperationError.
+     *
+     *  @return The document ID allocated to the document.
+     */
+    Xapian::docid add_document(const Xapian::Document& doc);
+
+    /** Add several documents, inverting them in parallel.
+     *
+     *  See WritableDatabase::add_documents() for details.  If this throws
+     *  an exception, the BulkBuilder can't be used any more, as for
+     *  add_document().
+     *
+     *  @return The document ID allocated to the first document (or 0 if
+     *	       @a docs is empty).
+     */
+    Xapian::docid add_documents(const std::vector<Xapian::Document>& docs);
+
+    /** Set the user-specified metadata associated with a given key.
+     *
+     *  See WritableDatabase::set_metadata() for details.  If the same key is
+     *  set more than once, the last value set is used.
+     */
+    void set_metadata(const std::string& key, const std::string& value);
+
+    /** Merge the runs to build the database.
+     *
+     *  After this has been called, no more documents can be added.
+     *
+     *  @param compactor	Functor to use to report progress and resolve
+     *				duplicate metadata (default: NULL).
+     *  @param block_size	The block size to use for the output database
+     *				(default: 0, which means 8KB).
+     */
+    void finish(Xapian::Compactor* compactor = NULL,
+		unsigned block_size = 0);
+
+    /// Return the number of documents added so far.
+    Xapian::doccount get_doccount() const;
+
+    /// Return the number of runs started so far.
+    unsigned get_run_count() const;
+
+    /// Return a string describing this object.
+    std::string get_description() const;
+};
+
+}
+
+#endif // XAPIAN_INCLUDED_BULKBUILDER_H
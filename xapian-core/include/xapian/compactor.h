@@ -38,6 +38,9 @@ class Database;
 /** Compact a database, or merge and compact several.
  */
 class XAPIAN_VISIBILITY_DEFAULT Compactor {
+    /// Maximum number of threads to use.
+    unsigned parallelism = 1;
+
   public:
     /** Compaction level. */
     typedef enum {
@@ -54,6 +57,34 @@ class XAPIAN_VISIBILITY_DEFAULT Compactor {
 
     virtual ~Compactor();
 
+    /** Set the maximum number of threads to use for compaction.
+     *
+     *  The tables in a database are independent, so they can be compacted
+     *  at the same time on separate threads.  Also, for a multipass merge
+     *  (see Xapian::DBCOMPACT_MULTIPASS) the merges which make up each pass
+     *  can be run in parallel.  This can reduce the time compaction takes
+     *  if the storage can handle several streams of I/O at once (e.g. an
+     *  SSD or RAID array) - most of the time is usually spent in the
+     *  postlist table so the speed-up is limited by that.
+     *
+     *  When compacting in parallel, calls to set_status() and
+     *  resolve_duplicate_metadata() are still serialised, but may be made
+     *  from a thread other than the one which started the compaction, and
+     *  status updates for different tables may be interleaved.
+     *
+     *  @param n  The maximum number of threads to use (default: 1, which
+     *		  means compaction is done entirely in the calling thread).
+     *		  The calling thread is one of the threads used.
+     *
+     *  This feature is currently only supported if Xapian was built with
+     *  support for std::thread.  Single file output is always compacted
+     *  one table at a time.
+     */
+    void set_parallelism(unsigned n) { parallelism = n; }
+
+    /// Get the maximum number of threads to use for compaction.
+    unsigned get_parallelism() const { return parallelism; }
+
     /** Update progress.
      *
      *  Subclass this method if you want to get progress updates during
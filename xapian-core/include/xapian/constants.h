@@ -144,6 +144,27 @@ const int DB_NO_TERMLIST	 = 0x20;
  */
 const int DB_RETRY_LOCK		 = 0x40;
 
+/** Read the database through memory mappings of its files.
+ *
+ *  When opening a Database from a glass or honey database (including a
+ *  single-file database), this flag means table blocks are read from a
+ *  read-only mmap() of each table file instead of with a system call per
+ *  read.  This is most useful when the database fits in memory and is
+ *  searched heavily.  The mappings are replaced when
+ *  Xapian::Database::reopen() moves to a newer revision.
+ *
+ *  This flag is ignored when opening a WritableDatabase, for other backends,
+ *  and on platforms without mmap() (or if mapping a file fails), in which
+ *  case the database is read in the usual way.
+ *
+ *  Note that a database opened with this flag must not be overwritten in
+ *  place (e.g. with Xapian::DB_CREATE_OR_OVERWRITE) while it is open, as
+ *  on many platforms accessing a mapping of a file which has been truncated
+ *  results in a signal (typically SIGBUS).  Modifying the database
+ *  normally (or replacing it by renaming a new one into place) is fine.
+ */
+const int DB_MMAP		 = 0x80;
+
 /** Use the glass backend.
  *
  *  When opening a WritableDatabase, this means create a glass database if a
@@ -201,6 +222,134 @@ const int DB_BACKEND_INMEMORY	 = 0x400;
  */
 const int DB_BACKEND_HONEY	 = 0x500;
 
+/** Delete documents lazily.
+ *
+ *  When opening a glass WritableDatabase, this means that delete_document()
+ *  removes the document's data, values and length, but just marks its
+ *  postings, positions and termlist as deleted instead of removing them,
+ *  which makes deleting much cheaper for documents with many terms.
+ *  Searches skip over the deleted documents, and compacting the database
+ *  removes what was left behind for them.
+ *
+ *  Until the database is compacted, the term and collection frequencies
+ *  still include the deleted documents (though the term frequency is never
+ *  more than the number of documents), so weights may differ a little from
+ *  those for the same database with the documents deleted normally.
+ *
+ *  While there are any documents deleted this way, older versions of Xapian
+ *  which don't know to skip them will refuse to open the database.
+ *
+ *  The flag has no effect for other backends.
+ */
+const int DB_LAZY_DELETE	 = 0x800;
+
+/** When creating a database, compress tags with LZ4 instead of zlib.
+ *
+ *  For backends which support it (currently glass), this means the tables
+ *  which compress their tags (the document data, termlist, spelling and
+ *  synonym tables) use LZ4, which compresses less well than zlib but is much
+ *  faster to decompress.  The choice is recorded for each table, and is
+ *  kept when the database is compacted to glass.
+ *
+ *  Databases created with this flag can't be opened by versions of Xapian
+ *  before 1.5.0.  Xapian::FeatureUnavailableError is thrown when creating
+ *  or opening such a database if LZ4 support wasn't enabled when Xapian
+ *  was built.
+ */
+const int DB_COMPRESS_LZ4	 = 0x1000;
+
+/** When creating a database, compress tags with zstd instead of zlib.
+ *
+ *  This works like Xapian::DB_COMPRESS_LZ4 but uses zstd, which typically
+ *  compresses about as well as zlib and decompresses several times faster.
+ */
+const int DB_COMPRESS_ZSTD	 = 0x2000;
+
+/** Keep a dense array of document lengths.
+ *
+ *  When opening a glass WritableDatabase, this means the database gets an
+ *  array of document lengths indexed by document ID (if it doesn't already
+ *  have one) the next time changes are committed, and it is kept up to date
+ *  from then on.  Looking up a document's length (which weighting schemes
+ *  such as BM25 do for every document they weight) then reads it directly
+ *  instead of searching through the posting list of document lengths.
+ *
+ *  The array is kept by later WritableDatabase objects whether or not this
+ *  flag is specified, and by compaction to glass.  See also
+ *  Xapian::DBCOMPACT_DOCLEN_COLUMN.
+ *
+ *  Databases with the array can't be opened by versions of Xapian before
+ *  1.5.0, which wouldn't keep it up to date.
+ *
+ *  The flag has no effect for other backends (honey databases always store
+ *  document lengths in a form which can be read directly).
+ */
+const int DB_DOCLEN_COLUMN	 = 0x4000;
+
+/** Keep bitmaps of the documents indexed by dense terms.
+ *
+ *  When opening a glass WritableDatabase, this means that the next time
+ *  changes are committed, each term indexing at least 1/16 of the documents
+ *  (and at least 256 of them) gets a compressed bitmap of the documents it
+ *  indexes, as well as its posting list.  Bitmaps are kept up to date from
+ *  then on, and added and removed as terms' frequencies change.
+ *
+ *  These are used for terms where the wdf and positions aren't needed, such
+ *  as the terms on the right of Xapian::Query::OP_FILTER, and several of them
+ *  combined with Xapian::Query::OP_AND or Xapian::Query::OP_OR are
+ *  intersected or united a 64-bit word at a time.
+ *
+ *  The bitmaps are kept by later WritableDatabase objects whether or not this
+ *  flag is specified, and by compaction to glass.  See also
+ *  Xapian::DBCOMPACT_TERM_BITMAPS.
+ *
+ *  Databases with bitmaps can't be opened by versions of Xapian before 1.5.0,
+ *  which wouldn't keep them up to date.
+ *
+ *  The flag has no effect for other backends.
+ */
+const int DB_TERM_BITMAPS	 = 0x8000;
+
+/** When creating a database, store positional data in bit-packed blocks.
+ *
+ *  For backends which support it (currently glass), this means each
+ *  document's positions for a term are stored as blocks of deltas packed at
+ *  a fixed bit width instead of with interpolative coding.  This takes
+ *  somewhat more space, but is much faster to decode, and whole blocks can
+ *  be skipped over, which speeds up phrase and NEAR queries and generating
+ *  snippets.  The choice is recorded in the database, and is kept when the
+ *  database is compacted.  See also Xapian::DBCOMPACT_PACKED_POSITIONS.
+ *
+ *  Databases created with this flag can't be opened by versions of Xapian
+ *  before 1.5.0.
+ */
+const int DB_PACKED_POSITIONS	 = 0x10000;
+
+/** Keep a Bloom filter over the terms, to speed up looking up missing terms.
+ *
+ *  When opening a glass WritableDatabase, this means that the next time
+ *  changes are committed, a Bloom filter is built over the terms in the
+ *  database, using about 12 bits per term.  Checking the filter tells us
+ *  that most terms which aren't in the database are missing without having
+ *  to search the B-tree, which speeds up Database::term_exists(),
+ *  Database::get_termfreq() and queries for terms which don't occur, as can
+ *  happen a lot with generated terms such as unique identifiers.
+ *
+ *  New terms are added to the filter as changes are committed.  Deleted terms
+ *  aren't removed, and the filter is rebuilt once it holds twice the number
+ *  of terms it was sized for.
+ *
+ *  The filter is kept by later WritableDatabase objects whether or not this
+ *  flag is specified, and by compaction to glass.  See also
+ *  Xapian::DBCOMPACT_TERM_FILTER.
+ *
+ *  Databases with the filter can't be opened by versions of Xapian before
+ *  1.5.0, which wouldn't add new terms to it.
+ *
+ *  The flag has no effect for other backends.
+ */
+const int DB_TERM_FILTER	 = 0x20000;
+
 #ifdef XAPIAN_LIB_BUILD
 /** @internal Bit mask for backend codes. */
 const int DB_BACKEND_MASK_	 = 0x700;
@@ -274,6 +423,91 @@ const int DBCOMPACT_MULTIPASS = 8;
  */
 const int DBCOMPACT_SINGLE_FILE = 16;
 
+/** Store posting lists in bit-packed blocks.
+ *
+ *  Posting lists for terms which index enough documents are stored in blocks
+ *  of bit-packed docid deltas and wdfs, which are faster to decode and allow
+ *  whole blocks to be skipped over.
+ *
+ *  Supported by the honey backend (ignored by other backends).
+ */
+const int DBCOMPACT_BLOCK_POSTINGS = 32;
+
+/** Compress document data using a dictionary trained on it.
+ *
+ *  A zstd dictionary is trained from a sample of the document data being
+ *  compacted and used to compress every document's data, which typically
+ *  compresses small document data much better than compressing each on its
+ *  own.  The dictionary is stored in the output database and also used for
+ *  document data added to it later.
+ *
+ *  Supported by the glass backend (ignored by other backends).
+ *  Xapian::FeatureUnavailableError is thrown if zstd support wasn't enabled
+ *  when Xapian was built.
+ */
+const int DBCOMPACT_DOCDATA_DICTIONARY = 64;
+
+/** Add a dense array of document lengths.
+ *
+ *  The output database gets an array of document lengths indexed by
+ *  document ID, as described for Xapian::DB_DOCLEN_COLUMN.  It also gets
+ *  one without this flag if any of the inputs has one.
+ *
+ *  Supported by the glass backend (ignored by other backends, since honey
+ *  always stores document lengths in a form which can be read directly).
+ */
+const int DBCOMPACT_DOCLEN_COLUMN = 128;
+
+/** Add bitmaps of the documents indexed by dense terms.
+ *
+ *  The output database gets bitmaps for dense terms, as described for
+ *  Xapian::DB_TERM_BITMAPS.  It also gets them without this flag if any of
+ *  the inputs has them.
+ *
+ *  Supported by the glass backend (ignored by other backends).
+ */
+const int DBCOMPACT_TERM_BITMAPS = 2048;
+
+/** Store positional data in bit-packed blocks.
+ *
+ *  The output database stores positions as described for
+ *  Xapian::DB_PACKED_POSITIONS.  It also does without this flag if the
+ *  first input does.
+ *
+ *  Supported by the glass and honey backends.
+ */
+const int DBCOMPACT_PACKED_POSITIONS = 4096;
+
+/** Add impact-ordered posting lists.
+ *
+ *  As well as its posting list, each term in the output database gets a copy
+ *  of its postings grouped by the quantised BM25Weight contribution of each,
+ *  highest first.  Xapian::Enquire::set_score_at_a_time() uses these to find
+ *  the top results without having to consider every matching document.
+ *
+ *  The impacts depend on the average document length, so the first change
+ *  made to the database marks the lists as stale.  They then stay on disk
+ *  but aren't used, and set_score_at_a_time() runs the match as normal,
+ *  until the database is compacted again.  The output database also gets
+ *  them without this flag if any of the inputs has them (even stale ones).
+ *
+ *  Until they're marked as stale, the database can't be opened by versions
+ *  of Xapian before 1.5.0, which wouldn't mark them.
+ *
+ *  Supported by the glass backend (ignored by other backends).
+ */
+const int DBCOMPACT_IMPACT_ORDERED = 8192;
+
+/** Add a Bloom filter over the terms.
+ *
+ *  The output database gets a filter over its terms, as described for
+ *  Xapian::DB_TERM_FILTER.  It also gets one without this flag if any of
+ *  the inputs has one.
+ *
+ *  Supported by the glass backend (ignored by other backends).
+ */
+const int DBCOMPACT_TERM_FILTER = 16384;
+
 /** Assume document id is valid.
  *
  *  By default, Database::get_document() checks that the document id passed is
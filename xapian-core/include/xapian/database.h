@@ -679,6 +679,28 @@ class XAPIAN_VISIBILITY_DEFAULT Database {
      *   - Xapian::DBCOMPACT_SINGLE_FILE
      *		Produce a single-file database (only supported for glass
      *		currently).
+     *   - Xapian::DBCOMPACT_BLOCK_POSTINGS
+     *		Store posting lists in bit-packed blocks which are faster to
+     *		decode (only supported for honey, ignored for other backends).
+     *   - Xapian::DBCOMPACT_DOCDATA_DICTIONARY
+     *		Compress document data using a dictionary trained on it (only
+     *		supported for glass, ignored for other backends).
+     *   - Xapian::DBCOMPACT_DOCLEN_COLUMN
+     *		Add a dense array of document lengths (only supported for
+     *		glass, ignored for other backends).
+     *   - Xapian::DBCOMPACT_TERM_BITMAPS
+     *		Add bitmaps of the documents indexed by dense terms (only
+     *		supported for glass, ignored for other backends).
+     *   - Xapian::DBCOMPACT_PACKED_POSITIONS
+     *		Store positional data in bit-packed blocks which are faster to
+     *		decode.
+     *   - Xapian::DBCOMPACT_IMPACT_ORDERED
+     *		Add impact-ordered posting lists for score-at-a-time matching
+     *		(only supported for glass, ignored for other backends).
+     *   - Xapian::DBCOMPACT_TERM_FILTER
+     *		Add a Bloom filter over the terms to speed up looking up terms
+     *		which aren't present (only supported for glass, ignored for
+     *		other backends).
      *   - At most one of:
      *     - Xapian::Compactor::STANDARD - Don't split items unnecessarily.
      *     - Xapian::Compactor::FULL     - Split items whenever it saves space
@@ -1071,11 +1093,50 @@ class XAPIAN_VISIBILITY_DEFAULT WritableDatabase : public Database {
      *  you can improve indexing throughput dramatically by setting
      *  XAPIAN_FLUSH_THRESHOLD in the environment to a larger value.
      *
+     *  For glass databases you can also set XAPIAN_FLUSH_THRESHOLD_BYTES in
+     *  the environment to commit automatically once the batched
+     *  modifications are estimated to be using that many bytes of memory,
+     *  which allows indexing to be given a fixed memory budget.
+     *
      *  @since This method was new in Xapian 1.1.0 - in earlier versions it
      *	       was called flush().
      */
     void commit();
 
+    /** Commit pending modifications without waiting for them to be synced.
+     *
+     *  This writes the pending modifications to the tables like commit()
+     *  does, but for backends which support it (currently glass) the
+     *  syncing to disk is then done by a background thread, and this
+     *  method returns without waiting for that to finish.  You can continue
+     *  to modify the database meanwhile.
+     *
+     *  Readers will see the new revision once it has been synced.  Call
+     *  wait_for_commit() to wait until that has happened, and to find out
+     *  if it failed.  Only one commit can be syncing at once, so a later
+     *  commit (including an automatic one) will wait for an earlier one
+     *  first, as will close().
+     *
+     *  If the sync fails, then the database is closed and
+     *  Xapian::DatabaseError is thrown by wait_for_commit(), or by the
+     *  next commit if that's started first.  In this case, the
+     *  modifications from the failed commit onwards are lost.
+     *
+     *  If replication changesets are being generated, or Xapian was built
+     *  without support for std::thread, this behaves like commit().
+     *
+     *  It's not valid to call commit_async() within a transaction.
+     */
+    void commit_async();
+
+    /** Wait for a commit started by commit_async() to be synced to disk.
+     *
+     *  Returns immediately if there isn't one in progress.
+     *
+     *  @exception Xapian::DatabaseError is thrown if the sync failed.
+     */
+    void wait_for_commit();
+
     /** Begin a transaction.
      *
      *  A Xapian transaction is a set of consecutive modifications to be
@@ -1174,6 +1235,37 @@ class XAPIAN_VISIBILITY_DEFAULT WritableDatabase : public Database {
      */
     Xapian::docid add_document(const Xapian::Document& doc);
 
+    /** Add several documents to the database.
+     *
+     *  This has the same effect as calling add_document() for each document
+     *  in @a docs in turn, but for backends which support it (currently
+     *  glass) the work of inverting the documents is shared between several
+     *  threads, which can make indexing large batches of documents much
+     *  faster on a machine with several cores.
+     *
+     *  Documents are allocated consecutive document IDs in the order they
+     *  appear in @a docs.  As with add_document(), the changes may trigger
+     *  an automatic commit part way through the batch, and if an exception
+     *  is thrown then all uncommitted changes are discarded.
+     *
+     *  @param docs		The documents to add.  Each Document object
+     *				must not be modified or used by another
+     *				thread while this method is running.
+     *  @param parallelism	The maximum number of threads to use
+     *				(default: 0, which means as many threads as
+     *				the hardware supports).  The calling thread is
+     *				one of the threads used.
+     *
+     *  @return The document ID allocated to the first document (or 0 if
+     *	       @a docs is empty).
+     *
+     *  Parallel inversion is only supported if Xapian was built with support
+     *  for std::thread - otherwise the documents are added by the calling
+     *  thread.
+     */
+    Xapian::docid add_documents(const std::vector<Xapian::Document>& docs,
+				unsigned parallelism = 0);
+
     /** Delete a document from the database.
      *
      *  This method removes the document with the specified document ID
@@ -1260,6 +1352,32 @@ class XAPIAN_VISIBILITY_DEFAULT WritableDatabase : public Database {
     Xapian::docid replace_document(const std::string& unique_term,
 				   const Xapian::Document& document);
 
+    /** Set the value in a slot of an existing document.
+     *
+     *  This has the same effect as reading the document, calling
+     *  Document::add_value() on it and then passing it to
+     *  replace_document(), but for backends which support it (currently
+     *  glass) only the value slot is updated - the document's terms, data
+     *  and other values aren't read or rewritten.  This makes it much
+     *  cheaper to update values which change often, such as a popularity
+     *  score used for sorting or with ValueWeightPostingSource.
+     *
+     *  Note that changes to the database won't be immediately committed to
+     *  disk; see commit() for more details.
+     *
+     *  @param did	The document ID of the document to update.
+     *  @param slot	The value slot to set.
+     *  @param value	The new value.  If empty, any existing value in
+     *			@a slot is removed.
+     *
+     *  @exception Xapian::DocNotFoundError is thrown if document @a did
+     *		   doesn't exist.
+     *
+     *  @since 1.5.0
+     */
+    void set_document_value(Xapian::docid did, Xapian::valueno slot,
+			    const std::string& value);
+
     /** Add a word to the spelling dictionary.
      *
      *  If the word is already present, its frequency is increased.
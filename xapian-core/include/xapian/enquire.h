@@ -45,6 +45,7 @@ class ExpandDecider;
 class KeyMaker;
 class MatchDecider;
 class MatchSpy;
+class MSetCache;
 class Query;
 class RSet;
 class Weight;
@@ -358,6 +359,81 @@ class XAPIAN_VISIBILITY_DEFAULT Enquire {
      */
     void set_time_limit(double time_limit);
 
+    /** Set the maximum number of threads to use for the match.
+     *
+     *  When searching a Database with several local shards, the match for
+     *  each shard can be run on a separate thread and the results merged,
+     *  which can reduce the time a search takes on a machine with several
+     *  cores.
+     *
+     *  If there are fewer local shards than threads, shards of databases
+     *  opened read-only by path with at least 20000 documents are also split
+     *  into ranges of document IDs which are matched in parallel.  Each
+     *  extra range needs another handle on the shard, which uses an open
+     *  file descriptor for each table and some memory.  These handles are opened by the first search which needs
+     *  them and kept by this Enquire object for later searches (being
+     *  reopened if the database has since been updated).
+     *
+     *  @param n  The maximum number of threads to use (default: 1, which
+     *		  means the match is run entirely in the calling thread).
+     *		  The calling thread is one of the threads used.
+     *
+     *  Limitations:
+     *
+     *  This feature is currently only supported if Xapian was built with
+     *  support for std::thread.  Only local shards are matched in parallel.
+     *  The match is run serially if a MatchDecider is passed to get_mset(),
+     *  or if any MatchSpy in use doesn't implement clone(),
+     *  serialise_results() and merge_results().  Any KeyMaker used for
+     *  sorting must be safe to call from several threads at once.
+     */
+    void set_parallelism(unsigned n);
+
+    /** Run the match score-at-a-time where possible.
+     *
+     *  A database compacted with Xapian::DBCOMPACT_IMPACT_ORDERED has a copy
+     *  of each posting list grouped by how much each document contributes to
+     *  the BM25 weight.  A score-at-a-time match reads these highest impact
+     *  first, so the best documents are usually found early on and the match
+     *  can be stopped after a fixed amount of work however many documents
+     *  match.
+     *
+     *  The weights are calculated from impacts quantised to 255 levels, so
+     *  differ slightly from those of the normal match.
+     *
+     *  @param enabled	  Whether to use a score-at-a-time match (default:
+     *			  false).
+     *  @param max_postings Stop after this many postings, returning the best
+     *			  documents found so far, with the match estimates
+     *			  based on the term statistics (default: 0, which
+     *			  means process them all, giving exact counts).
+     *
+     *  Limitations:
+     *
+     *  This is only used when searching a single local shard which has impact
+     *  lists which haven't been made stale by changes since it was compacted,
+     *  with a query which is a term or an OP_OR of terms, BM25Weight
+     *  with the parameters the impacts were built for (the defaults), and
+     *  results sorted by relevance with no percentage cut-off, collapsing,
+     *  MatchDecider or MatchSpy.  Otherwise the match is run as normal.
+     */
+    void set_score_at_a_time(bool enabled, Xapian::doccount max_postings = 0);
+
+    /** Use a cache of search results.
+     *
+     *  When a search is repeated, get_mset() returns a copy of the results
+     *  stored in @a cache rather than running the match again.  See
+     *  Xapian::MSetCache for the searches which can be cached.
+     *
+     *  The same MSetCache may be used by several Enquire objects.
+     *
+     *  @param cache	The cache to use.
+     */
+    void set_mset_cache(const Xapian::MSetCache& cache);
+
+    /// Stop using any cache of search results set by set_mset_cache().
+    void clear_mset_cache();
+
     /** Run the query.
      *
      *  Run the query using the settings in this Enquire object and those
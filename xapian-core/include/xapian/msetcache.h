@@ -0,0 +1,124 @@
+/** @file msetcache.h
+ * @brief Cache of MSet objects for repeated searches
+ */
+/* Copyright (C) 2026 Xapian contributors
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301
+ * USA
+ */
+
+#ifndef XAPIAN_INCLUDED_MSETCACHE_H
+#define XAPIAN_INCLUDED_MSETCACHE_H
+
+#if !defined XAPIAN_IN_XAPIAN_H && !defined XAPIAN_LIB_BUILD
+# error Never use <xapian/msetcache.h> directly; include <xapian.h> instead.
+#endif
+
+#include <xapian/intrusive_ptr.h>
+#include <xapian/visibility.h>
+
+#include <cstddef>
+#include <string>
+
+namespace Xapian {
+
+/** Cache of search results.
+ *
+ *  An MSetCache can be attached to one or more Enquire objects with
+ *  Enquire::set_mset_cache(), and then Enquire::get_mset() will return a
+ *  copy of the stored results when the same search is repeated, rather than
+ *  running the match again.
+ *
+ *  Cached results are identified by the query, the weighting scheme, the
+ *  sorting, collapsing and cutoff settings, the parameters passed to
+ *  get_mset(), and the UUID and revision of each shard of the database -
+ *  so results are no longer used once Database::reopen() moves to a new
+ *  revision, and are discarded in least recently used order when the cache
+ *  is full.
+ *
+ *  Results are only cached for searches where they can be reliably
+ *  identified - this requires every shard to be a read-only local glass or
+ *  honey database, that no MatchDecider, MatchSpy or time limit is in use,
+ *  and that the query (including any PostingSource), weighting scheme and
+ *  any KeyMaker used for sorting support serialisation.  Other searches just
+ *  run the match as usual and don't count as cache hits or misses.
+ *
+ *  An MSetCache may be shared between Enquire objects in different threads.
+ */
+class XAPIAN_VISIBILITY_DEFAULT MSetCache {
+  public:
+    /// Class representing the MSetCache internals.
+    class Internal;
+    /// @private @internal Reference counted internals.
+    Xapian::Internal::intrusive_ptr_nonnull<Internal> internal;
+
+    /** Copying is allowed.
+     *
+     *  The internals are reference counted, so copying is cheap, and the
+     *  copy refers to the same cache.
+     */
+    MSetCache(const MSetCache& o);
+
+    /** Copying is allowed.
+     *
+     *  The internals are reference counted, so assignment is cheap, and the
+     *  object assigned to then refers to the same cache as @a o.
+     */
+    MSetCache& operator=(const MSetCache& o);
+
+    /// Move constructor.
+    MSetCache(MSetCache&& o);
+
+    /// Move assignment operator.
+    MSetCache& operator=(MSetCache&& o);
+
+    /** Construct an empty cache.
+     *
+     *  @param max_entries	The maximum number of results to keep
+     *				(default: 1000).
+     */
+    explicit MSetCache(std::size_t max_entries = 1000);
+
+    /// Destructor.
+    ~MSetCache();
+
+    /// Return the number of results currently in the cache.
+    std::size_t size() const;
+
+    /// Return true if the cache is empty.
+    bool empty() const { return size() == 0; }
+
+    /// Return the maximum number of results the cache will keep.
+    std::size_t get_max_entries() const;
+
+    /** Discard all the results in the cache.
+     *
+     *  The hit and miss counts are left unchanged.
+     */
+    void clear();
+
+    /// Return the number of searches which used cached results.
+    unsigned long long get_hits() const;
+
+    /// Return the number of cacheable searches which had to run the match.
+    unsigned long long get_misses() const;
+
+    /// Return a string describing this object.
+    std::string get_description() const;
+};
+
+}
+
+#endif // XAPIAN_INCLUDED_MSETCACHE_H
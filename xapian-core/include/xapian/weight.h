@@ -246,6 +246,28 @@ class XAPIAN_VISIBILITY_DEFAULT Weight {
 			       Xapian::termcount uniqterms,
 			       Xapian::termcount wdfdocmax) const = 0;
 
+    /** Calculate the weight contribution for this object's term to a batch of
+     *  documents.
+     *
+     *  This is equivalent to calling get_sumpart() for each document, but
+     *  allows subclasses to provide an implementation which the compiler can
+     *  vectorise.  The default implementation simply calls get_sumpart() for
+     *  each document.
+     *
+     *  @param n	The number of documents.
+     *  @param wdf	Array of @a n within document frequencies.
+     *  @param doclen	Array of @a n document lengths.
+     *  @param uniqterms	Array of @a n numbers of unique terms.
+     *  @param wdfdocmax	Array of @a n maximum wdf values.
+     *  @param result	Array to store the @a n weight contributions in.
+     */
+    virtual void get_sumpart_batch(Xapian::doccount n,
+				   const Xapian::termcount* wdf,
+				   const Xapian::termcount* doclen,
+				   const Xapian::termcount* uniqterms,
+				   const Xapian::termcount* wdfdocmax,
+				   double* result) const;
+
     /** Return an upper bound on what get_sumpart() can return for any document.
      *
      *  This information is used by the matcher to perform various
@@ -798,6 +820,12 @@ class XAPIAN_VISIBILITY_DEFAULT TfIdfWeight : public Weight {
 		       Xapian::termcount doclen,
 		       Xapian::termcount uniqterm,
 		       Xapian::termcount wdfdocmax) const;
+    void get_sumpart_batch(Xapian::doccount n,
+			   const Xapian::termcount* wdf,
+			   const Xapian::termcount* doclen,
+			   const Xapian::termcount* uniqterms,
+			   const Xapian::termcount* wdfdocmax,
+			   double* result) const;
     double get_maxpart() const;
 
     double get_sumextra(Xapian::termcount doclen,
@@ -911,6 +939,12 @@ class XAPIAN_VISIBILITY_DEFAULT BM25Weight : public Weight {
 		       Xapian::termcount doclen,
 		       Xapian::termcount uniqterm,
 		       Xapian::termcount wdfdocmax) const;
+    void get_sumpart_batch(Xapian::doccount n,
+			   const Xapian::termcount* wdf,
+			   const Xapian::termcount* doclen,
+			   const Xapian::termcount* uniqterms,
+			   const Xapian::termcount* wdfdocmax,
+			   double* result) const;
     double get_maxpart() const;
 
     double get_sumextra(Xapian::termcount doclen,
@@ -1035,6 +1069,12 @@ class XAPIAN_VISIBILITY_DEFAULT BM25PlusWeight : public Weight {
 		       Xapian::termcount doclen,
 		       Xapian::termcount uniqterms,
 		       Xapian::termcount wdfdocmax) const;
+    void get_sumpart_batch(Xapian::doccount n,
+			   const Xapian::termcount* wdf,
+			   const Xapian::termcount* doclen,
+			   const Xapian::termcount* uniqterms,
+			   const Xapian::termcount* wdfdocmax,
+			   double* result) const;
     double get_maxpart() const;
 
     double get_sumextra(Xapian::termcount doclen,
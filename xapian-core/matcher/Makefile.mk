@@ -4,9 +4,11 @@ noinst_HEADERS +=\
 	matcher/boolorpostlist.h\
 	matcher/collapser.h\
 	matcher/deciderpostlist.h\
+	matcher/docidrangepostlist.h\
 	matcher/exactphrasepostlist.h\
 	matcher/externalpostlist.h\
 	matcher/extraweightpostlist.h\
+	matcher/impactsubmatch.h\
 	matcher/localsubmatch.h\
 	matcher/matcher.h\
 	matcher/matchtimeout.h\
@@ -48,9 +50,11 @@ lib_src +=\
 	matcher/boolorpostlist.cc\
 	matcher/collapser.cc\
 	matcher/deciderpostlist.cc\
+	matcher/docidrangepostlist.cc\
 	matcher/exactphrasepostlist.cc\
 	matcher/externalpostlist.cc\
 	matcher/extraweightpostlist.cc\
+	matcher/impactsubmatch.cc\
 	matcher/localsubmatch.cc\
 	matcher/matcher.cc\
 	matcher/maxpostlist.cc\
@@ -0,0 +1,89 @@
+/** @file docidrangepostlist.cc
+ * @brief PostList which restricts another PostList to a range of docids
+ */
+/* Copyright (C) 2026 Xapian contributors
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301 USA
+ */
+
+#include <config.h>
+
+#include "docidrangepostlist.h"
+
+#include "omassert.h"
+#include "str.h"
+
+using namespace std;
+
+Xapian::doccount
+DocidRangePostList::get_termfreq_min() const
+{
+    // Any documents outside the range could match.
+    Xapian::doccount outside = last_docid - (range_end - range_begin);
+    Xapian::doccount result = pl->get_termfreq_min();
+    return result > outside ? result - outside : 0;
+}
+
+Xapian::doccount
+DocidRangePostList::get_termfreq_max() const
+{
+    return min(pl->get_termfreq_max(), range_end - range_begin);
+}
+
+Xapian::doccount
+DocidRangePostList::get_termfreq_est() const
+{
+    // Assume matching documents are evenly spread over the docid space.
+    double est = pl->get_termfreq_est();
+    est *= double(range_end - range_begin) / last_docid;
+    Xapian::doccount result = Xapian::doccount(est + 0.5);
+    return max(get_termfreq_min(), min(result, get_termfreq_max()));
+}
+
+bool
+DocidRangePostList::at_end() const
+{
+    return pl->at_end() || pl->get_docid() >= range_end;
+}
+
+PostList*
+DocidRangePostList::next(double w_min)
+{
+    if (!started) {
+	started = true;
+	return WrapperPostList::skip_to(range_begin, w_min);
+    }
+    return WrapperPostList::next(w_min);
+}
+
+PostList*
+DocidRangePostList::skip_to(Xapian::docid did, double w_min)
+{
+    started = true;
+    return WrapperPostList::skip_to(max(did, range_begin), w_min);
+}
+
+string
+DocidRangePostList::get_description() const
+{
+    string desc = "DocidRangePostList(";
+    desc += str(range_begin);
+    desc += "..";
+    desc += str(range_end);
+    desc += ", ";
+    desc += pl->get_description();
+    desc += ')';
+    return desc;
+}
@@ -0,0 +1,75 @@
+/** @file docidrangepostlist.h
+ * @brief PostList which restricts another PostList to a range of docids
+ */
+/* Copyright (C) 2026 Xapian contributors
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301 USA
+ */
+
+#ifndef XAPIAN_INCLUDED_DOCIDRANGEPOSTLIST_H
+#define XAPIAN_INCLUDED_DOCIDRANGEPOSTLIST_H
+
+#include "wrapperpostlist.h"
+
+/** PostList which restricts another PostList to a range of docids.
+ *
+ *  Used to split the match for a single shard between several threads.
+ */
+class DocidRangePostList : public WrapperPostList {
+    /// The first docid in the range.
+    Xapian::docid range_begin;
+
+    /// One past the last docid in the range.
+    Xapian::docid range_end;
+
+    /// The highest docid which the wrapped PostList could return.
+    Xapian::docid last_docid;
+
+    /// Have we been positioned yet?
+    bool started = false;
+
+  public:
+    /** Construct.
+     *
+     *  @param pl_		The PostList to wrap.
+     *  @param range_begin_	The first docid to return.
+     *  @param range_end_	Stop before reaching this docid.
+     *  @param last_docid_	The highest docid in the shard.
+     */
+    DocidRangePostList(PostList* pl_,
+		       Xapian::docid range_begin_,
+		       Xapian::docid range_end_,
+		       Xapian::docid last_docid_)
+	: WrapperPostList(pl_),
+	  range_begin(range_begin_),
+	  range_end(range_end_),
+	  last_docid(last_docid_) {}
+
+    Xapian::doccount get_termfreq_min() const;
+
+    Xapian::doccount get_termfreq_max() const;
+
+    Xapian::doccount get_termfreq_est() const;
+
+    bool at_end() const;
+
+    PostList* next(double w_min);
+
+    PostList* skip_to(Xapian::docid did, double w_min);
+
+    std::string get_description() const;
+};
+
+#endif // XAPIAN_INCLUDED_DOCIDRANGEPOSTLIST_H
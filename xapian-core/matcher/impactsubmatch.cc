@@ -0,0 +1,306 @@
+/** @file impactsubmatch.cc
+ *  @brief Score-at-a-time match for a local shard with impact-ordered lists.
+ */
+/* Copyright (C) 2026 Xapian contributors
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301 USA
+ */
+
+#include <config.h>
+
+#include "impactsubmatch.h"
+
+#include "api/msetinternal.h"
+#include "api/queryinternal.h"
+#include "api/result.h"
+#include "backends/impactlist.h"
+#include "backends/leafpostlist.h"
+#include "debuglog.h"
+#include "omassert.h"
+
+#include <algorithm>
+#include <memory>
+#include <unordered_map>
+
+using namespace std;
+
+bool
+ImpactSubMatch::add_terms(const Xapian::Query& query)
+{
+    switch (query.get_type()) {
+	case Xapian::Query::LEAF_TERM: {
+	    using Xapian::Internal::QueryTerm;
+	    auto qt = static_cast<const QueryTerm*>(query.internal.get());
+	    terms.emplace_back(qt->get_term(), qt->get_wqf());
+	    return true;
+	}
+	case Xapian::Query::OP_OR:
+	    for (size_t i = 0; i != query.get_num_subqueries(); ++i) {
+		if (!add_terms(query.get_subquery(i)))
+		    return false;
+	    }
+	    return true;
+	default:
+	    return false;
+    }
+}
+
+bool
+ImpactSubMatch::prepare(const Xapian::Query& query)
+{
+    LOGCALL(MATCH, bool, "ImpactSubMatch::prepare", query);
+    terms.clear();
+    if (!add_terms(query))
+	RETURN(false);
+
+    if (wt_factory.name() != "Xapian::BM25Weight")
+	RETURN(false);
+
+    // The impacts must have been calculated with the same parameters as the
+    // weighting scheme we've been asked to use.
+    string db_params;
+    if (!db->get_impact_params(db_params))
+	RETURN(false);
+    ImpactParams built, wanted;
+    if (!built.unserialise_bm25(db_params) ||
+	!wanted.unserialise_bm25(wt_factory.serialise()))
+	RETURN(false);
+    RETURN(built == wanted);
+}
+
+namespace {
+
+/// Our position in the impact list of one query term.
+struct ImpactCursor {
+    ImpactListReader reader;
+
+    /// The weight each unit of impact contributes.
+    double scale;
+
+    /// The impact of the current segment.
+    unsigned impact = 0;
+
+    /// The number of documents in the current segment.
+    Xapian::doccount count = 0;
+
+    ImpactCursor(const string& data, double scale_)
+	: reader(data.data(), data.data() + data.size()), scale(scale_) {}
+
+    /// The weight the current segment contributes to each of its documents.
+    double contribution() const { return impact * scale; }
+};
+
+}
+
+Xapian::MSet
+ImpactSubMatch::get_mset(Xapian::doccount first,
+			 Xapian::doccount maxitems,
+			 Xapian::doccount max_postings,
+			 double weight_threshold,
+			 Xapian::Enquire::docid_order order,
+			 Xapian::Weight::Internal& stats)
+{
+    LOGCALL(MATCH, Xapian::MSet, "ImpactSubMatch::get_mset", first | maxitems | max_postings | weight_threshold);
+
+    ImpactParams params;
+    (void)params.unserialise_bm25(wt_factory.serialise());
+    // The factor which the impacts of a posting with wdf 1 in an empty
+    // document is calculated from.  Dividing a term's weight for such a
+    // posting by this gives the weight of a posting with impact IMPACT_LEVELS.
+    const double unit_factor = params.doc_factor(1, 0, 0.0);
+
+    Xapian::doccount doccount = db->get_doccount();
+    Xapian::doccount tf_max = 0;
+    Xapian::doccount tf_sum = 0;
+    // Probability that a document doesn't match any term, for the estimate.
+    double p_no_match = 1.0;
+
+    vector<string> lists;
+    lists.reserve(terms.size());
+    vector<double> scales;
+    scales.reserve(terms.size());
+    double max_possible = 0.0;
+    for (auto&& t : terms) {
+	lists.emplace_back();
+	Xapian::doccount tf;
+	db->get_freqs(t.first, &tf, NULL);
+	if (tf == 0) {
+	    scales.push_back(0.0);
+	    continue;
+	}
+	if (!db->get_impact_list(t.first, lists.back())) {
+	    throw Xapian::DatabaseCorruptError("No impact list for term " +
+					       t.first);
+	}
+	tf_max = max(tf_max, tf);
+	tf_sum += min(tf, doccount - tf_sum);
+	p_no_match *= 1.0 - double(tf) / doccount;
+
+	unique_ptr<Xapian::Weight> wt(wt_factory.clone());
+	wt->init_(stats, qlen, t.first, t.second, 1.0);
+	double scale = wt->get_sumpart(1, 0, 0, 0) / unit_factor /
+		       IMPACT_LEVELS;
+	scales.push_back(scale);
+
+	// The first segment has the highest impact.
+	ImpactListReader reader(lists.back().data(),
+				lists.back().data() + lists.back().size());
+	unsigned impact;
+	Xapian::doccount count;
+	if (reader.next_segment(impact, count)) {
+	    double max_part = impact * scale;
+	    stats.set_max_part(t.first, max_part);
+	    max_possible += max_part;
+	}
+    }
+
+    vector<ImpactCursor> cursors;
+    cursors.reserve(terms.size());
+    for (size_t i = 0; i != terms.size(); ++i) {
+	if (lists[i].empty()) continue;
+	cursors.emplace_back(lists[i], scales[i]);
+	auto& cursor = cursors.back();
+	if (!cursor.reader.next_segment(cursor.impact, cursor.count))
+	    cursors.pop_back();
+    }
+
+    // Work through the segments from all the terms in descending order of
+    // the weight they contribute, using a heap of the cursors.
+    auto cmp = [&cursors](size_t a, size_t b) {
+	return cursors[a].contribution() < cursors[b].contribution();
+    };
+    vector<size_t> heap;
+    heap.reserve(cursors.size());
+    for (size_t i = 0; i != cursors.size(); ++i) heap.push_back(i);
+    make_heap(heap.begin(), heap.end(), cmp);
+
+    // Accumulated weight for each document we've seen.  This is sized from
+    // the number of postings we can process, as the docid range may be much
+    // larger than the number of documents the query matches.
+    unordered_map<Xapian::docid, double> acc;
+    acc.reserve(max_postings ? min(max_postings, tf_sum) : tf_sum);
+    Xapian::docid last_docid = db->get_lastdocid();
+    Xapian::doccount postings_left = max_postings;
+    bool complete = true;
+    while (!heap.empty()) {
+	pop_heap(heap.begin(), heap.end(), cmp);
+	auto& cursor = cursors[heap.back()];
+	double contribution = cursor.contribution();
+	Xapian::doccount n = cursor.count;
+	if (max_postings) {
+	    if (postings_left == 0) {
+		complete = false;
+		break;
+	    }
+	    if (n > postings_left) {
+		n = postings_left;
+		complete = false;
+	    }
+	    postings_left -= n;
+	}
+	for (Xapian::doccount j = 0; j != n; ++j) {
+	    Xapian::docid did = cursor.reader.next_docid();
+	    if (rare(did > last_docid)) {
+		throw Xapian::DatabaseCorruptError("Impact list has docid "
+						   "past the last");
+	    }
+	    acc[did] += contribution;
+	}
+	if (!complete) break;
+	if (cursor.reader.next_segment(cursor.impact, cursor.count)) {
+	    push_heap(heap.begin(), heap.end(), cmp);
+	} else {
+	    heap.pop_back();
+	}
+    }
+
+    vector<Result> items;
+    double max_attained = 0.0;
+    for (auto&& i : acc) {
+	double w = i.second;
+	if (w < weight_threshold) continue;
+	items.emplace_back(w, i.first);
+	max_attained = max(max_attained, w);
+    }
+
+    Xapian::doccount matches_lower_bound, matches_estimated;
+    Xapian::doccount matches_upper_bound;
+    if (complete) {
+	matches_lower_bound = matches_estimated = matches_upper_bound =
+	    items.size();
+    } else {
+	// Documents only gain weight as we go on, so those already over the
+	// threshold must match.
+	matches_lower_bound = items.size();
+	if (weight_threshold == 0.0)
+	    matches_lower_bound = max(matches_lower_bound, tf_max);
+	matches_upper_bound = tf_sum;
+	matches_estimated = Xapian::doccount(doccount * (1.0 - p_no_match) +
+					     0.5);
+	matches_estimated = max(matches_estimated, matches_lower_bound);
+	matches_estimated = min(matches_estimated, matches_upper_bound);
+    }
+
+    bool docid_descending = (order == Xapian::Enquire::DESCENDING);
+    auto mcmp = [docid_descending](const Result& a, const Result& b) {
+	if (a.get_weight() != b.get_weight())
+	    return a.get_weight() > b.get_weight();
+	if (docid_descending)
+	    return a.get_docid() > b.get_docid();
+	return a.get_docid() < b.get_docid();
+    };
+    Xapian::doccount wanted = first + maxitems;
+    if (wanted < items.size()) {
+	nth_element(items.begin(), items.begin() + wanted, items.end(), mcmp);
+	items.erase(items.begin() + wanted, items.end());
+    }
+    sort(items.begin(), items.end(), mcmp);
+
+    double percent_scale = 0.0;
+    if (!items.empty() && max_attained > 0.0) {
+	// Percentages are scaled so the top document gets the proportion of
+	// the query terms which it matches.
+	Xapian::docid top = items.front().get_docid();
+	Xapian::termcount matched = 0;
+	for (auto&& t : terms) {
+	    unique_ptr<LeafPostList> pl(db->open_leaf_post_list(t.first,
+								 false));
+	    if (!pl) continue;
+	    (void)pl->skip_to(top);
+	    if (!pl->at_end() && pl->get_docid() == top) ++matched;
+	}
+	percent_scale = matched / double(terms.size()) / max_attained;
+    }
+
+    if (first != 0) {
+	if (first >= items.size()) {
+	    items.clear();
+	} else {
+	    items.erase(items.begin(), items.begin() + first);
+	}
+    }
+
+    RETURN(Xapian::MSet(new Xapian::MSet::Internal(first,
+						   matches_upper_bound,
+						   matches_lower_bound,
+						   matches_estimated,
+						   matches_upper_bound,
+						   matches_lower_bound,
+						   matches_estimated,
+						   max_possible,
+						   max_attained,
+						   std::move(items),
+						   percent_scale * 100.0)));
+}
@@ -0,0 +1,106 @@
+/** @file impactsubmatch.h
+ *  @brief Score-at-a-time match for a local shard with impact-ordered lists.
+ */
+/* Copyright (C) 2026 Xapian contributors
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301 USA
+ */
+
+#ifndef XAPIAN_INCLUDED_IMPACTSUBMATCH_H
+#define XAPIAN_INCLUDED_IMPACTSUBMATCH_H
+
+#include "backends/databaseinternal.h"
+#include "weight/weightinternal.h"
+#include "xapian/enquire.h"
+#include "xapian/mset.h"
+#include "xapian/query.h"
+#include "xapian/weight.h"
+
+#include <string>
+#include <vector>
+
+/** Run the match for a local shard score-at-a-time.
+ *
+ *  Instead of working through the matching documents in docid order, this
+ *  reads the segments of the query terms' impact-ordered posting lists
+ *  (see encode_impact_list()) in descending order of their contribution to
+ *  the weight, adding that to an accumulator for each document.  The
+ *  highest weighted documents are usually found early on, so the match can
+ *  be stopped after a fixed number of postings, which bounds the time taken
+ *  however many documents match.
+ *
+ *  The weights are calculated from the quantised impacts, so differ a little
+ *  from those BM25Weight gives.
+ */
+class ImpactSubMatch {
+    /// Don't allow assignment.
+    ImpactSubMatch& operator=(const ImpactSubMatch &) = delete;
+
+    /// Don't allow copying.
+    ImpactSubMatch(const ImpactSubMatch &) = delete;
+
+    /// The shard we're searching.
+    const Xapian::Database::Internal* db;
+
+    /// The query length.
+    Xapian::termcount qlen;
+
+    /// Weight object (used as a factory by calling clone() on it).
+    const Xapian::Weight& wt_factory;
+
+    /// The terms in the query, with their wqf.
+    std::vector<std::pair<std::string, Xapian::termcount>> terms;
+
+    /** Add the terms from @a query to @a terms.
+     *
+     *  @return false if @a query isn't a term or an OP_OR of terms.
+     */
+    bool add_terms(const Xapian::Query& query);
+
+  public:
+    /// Constructor.
+    ImpactSubMatch(const Xapian::Database::Internal* db_,
+		   Xapian::termcount qlen_,
+		   const Xapian::Weight& wt_factory_)
+	: db(db_), qlen(qlen_), wt_factory(wt_factory_) {}
+
+    /** Check if the match for @a query can be run score-at-a-time.
+     *
+     *  This requires @a query to be a term or terms combined with OP_OR, the
+     *  weighting scheme to be BM25Weight with the parameters the impacts were
+     *  calculated for, and the shard to have impact-ordered posting lists.
+     */
+    bool prepare(const Xapian::Query& query);
+
+    /** Run the match.
+     *
+     *  @param first		Zero-based index of the first result to return.
+     *  @param maxitems		The maximum number of results to return.
+     *  @param max_postings	Stop after this many postings (0 means
+     *				process them all).
+     *  @param weight_threshold	Lower bound on weight.
+     *  @param order		Order to return documents with equal weights
+     *				in.
+     *  @param stats		The collated statistics.
+     */
+    Xapian::MSet get_mset(Xapian::doccount first,
+			  Xapian::doccount maxitems,
+			  Xapian::doccount max_postings,
+			  double weight_threshold,
+			  Xapian::Enquire::docid_order order,
+			  Xapian::Weight::Internal& stats);
+};
+
+#endif // XAPIAN_INCLUDED_IMPACTSUBMATCH_H
@@ -27,6 +27,7 @@
 #include "backends/leafpostlist.h"
 #include "debuglog.h"
 #include "extraweightpostlist.h"
+#include "impactsubmatch.h"
 #include "omassert.h"
 #include "queryoptimiser.h"
 #include "synonympostlist.h"
@@ -240,6 +241,24 @@ LocalSubMatch::make_synonym_postlist(PostListTree* pltree,
     RETURN(res.release());
 }
 
+bool
+LocalSubMatch::get_impact_mset(Xapian::doccount first,
+			       Xapian::doccount maxitems,
+			       Xapian::doccount max_postings,
+			       double weight_threshold,
+			       Xapian::Enquire::docid_order order,
+			       Xapian::MSet& mset)
+{
+    LOGCALL(MATCH, bool, "LocalSubMatch::get_impact_mset", first | maxitems | max_postings | weight_threshold);
+    Assert(total_stats);
+    ImpactSubMatch submatch(db, qlen, wt_factory);
+    if (!submatch.prepare(query))
+	RETURN(false);
+    mset = submatch.get_mset(first, maxitems, max_postings, weight_threshold,
+			     order, *total_stats);
+    RETURN(true);
+}
+
 PostList *
 LocalSubMatch::open_post_list(const string& term,
 			      Xapian::termcount wqf,
@@ -277,6 +296,11 @@ LocalSubMatch::open_post_list(const string& term,
 		    // (termfreq would be correct anyway since it's just the
 		    // collection size in this case).
 		    pl->set_term(term);
+		} else if (!weighted && !in_synonym) {
+		    // If the backend stores a bitmap for the term, iterating
+		    // that is cheaper, and it can be combined with others
+		    // under AND or OR a word at a time.
+		    pl = db->open_bitmap_post_list(term);
 		}
 	    }
 	}
@@ -82,6 +82,21 @@ class LocalSubMatch {
 	  full_db_has_positions(full_db_has_positions_)
     {}
 
+    /** Construct a LocalSubMatch using a different handle on the same shard.
+     *
+     *  Used to allow the match for a shard to be split between threads.
+     *
+     *  @param o	The LocalSubMatch to copy the settings of.
+     *  @param db_	Another handle on the same revision of the shard.
+     */
+    LocalSubMatch(const LocalSubMatch& o,
+		  const Xapian::Database::Internal* db_)
+	: total_stats(o.total_stats), query(o.query), qlen(o.qlen), db(db_),
+	  wt_factory(o.wt_factory),
+	  shard_index(o.shard_index),
+	  full_db_has_positions(o.full_db_has_positions)
+    {}
+
     /** Fetch and collate statistics.
      *
      *  Before we can calculate term weights we need to fetch statistics from
@@ -105,6 +120,24 @@ class LocalSubMatch {
 	total_stats = &total_stats_;
     }
 
+    /** Try to run the match score-at-a-time.
+     *
+     *  See ImpactSubMatch for when this is possible.  start_match() must have
+     *  been called first.
+     *
+     *  @param max_postings	Stop after this many postings (0 means
+     *				process them all).
+     *  @param[out] mset	Set to the results if the match was run.
+     *
+     *  @return true if the match was run.
+     */
+    bool get_impact_mset(Xapian::doccount first,
+			 Xapian::doccount maxitems,
+			 Xapian::doccount max_postings,
+			 double weight_threshold,
+			 Xapian::Enquire::docid_order order,
+			 Xapian::MSet& mset);
+
     /// Get PostList.
     PostList * get_postlist(PostListTree* matcher,
 			    Xapian::termcount* total_subqs_ptr);
@@ -25,8 +25,10 @@
 #include "api/enquireinternal.h"
 #include "api/msetinternal.h"
 #include "api/rsetinternal.h"
+#include "backends/backends.h"
 #include "backends/multi/multi_database.h"
 #include "deciderpostlist.h"
+#include "docidrangepostlist.h"
 #include "localsubmatch.h"
 #include "msetcmp.h"
 #include "omassert.h"
@@ -48,6 +50,16 @@
 #include <cfloat> // For DBL_EPSILON.
 #include <vector>
 
+#ifdef HAVE_STD_THREAD
+# include <atomic>
+# include <exception>
+# include <map>
+# include <memory>
+# include <mutex>
+# include <system_error>
+# include <thread>
+#endif
+
 #ifdef HAVE_POLL_H
 # include <poll.h>
 #else
@@ -340,7 +352,6 @@ Matcher::get_local_mset(Xapian::doccount first,
 
     ValueStreamDocument vsdoc(db);
     ++vsdoc._refs;
-    Xapian::Document doc(&vsdoc);
 
     vector<PostList*> postlists;
     postlists.reserve(locals.size());
@@ -385,6 +396,39 @@ Matcher::get_local_mset(Xapian::doccount first,
     Xapian::doccount n_shards = postlists.size();
     pltree.set_postlists(&postlists[0], n_shards);
 
+    return run_local_match(pltree, vsdoc, total_subqs, n_shards == 1,
+			   first, maxitems, check_at_least,
+			   mdecider, sorter, collapse_key, collapse_max,
+			   percent_threshold, percent_threshold_factor,
+			   weight_threshold, order, sort_key, sort_by,
+			   sort_val_reverse, time_limit, matchspies, NULL);
+}
+
+Xapian::MSet
+Matcher::run_local_match(PostListTree& pltree,
+			 ValueStreamDocument& vsdoc,
+			 Xapian::termcount total_subqs,
+			 bool single_shard,
+			 Xapian::doccount first,
+			 Xapian::doccount maxitems,
+			 Xapian::doccount check_at_least,
+			 const Xapian::MatchDecider* mdecider,
+			 const Xapian::KeyMaker* sorter,
+			 Xapian::valueno collapse_key,
+			 Xapian::doccount collapse_max,
+			 int percent_threshold,
+			 double percent_threshold_factor,
+			 double weight_threshold,
+			 Xapian::Enquire::docid_order order,
+			 Xapian::valueno sort_key,
+			 Xapian::Enquire::Internal::sort_setting sort_by,
+			 bool sort_val_reverse,
+			 double time_limit,
+			 const vector<opt_ptr_spy>& matchspies,
+			 atomic<double>* shared_min_weight)
+{
+    Xapian::Document doc(&vsdoc);
+
     // The highest weight a document could get in this match.
     const double max_possible = pltree.recalc_maxweight();
 
@@ -440,7 +484,7 @@ Matcher::get_local_mset(Xapian::doccount first,
 
     // Can we stop once the ProtoMSet is full?
     bool stop_once_full = (sort_forward &&
-			   n_shards == 1 &&
+			   single_shard &&
 			   sort_by == DOCID);
 
     ProtoMSet proto_mset(first, maxitems, check_at_least,
@@ -453,8 +497,27 @@ Matcher::get_local_mset(Xapian::doccount first,
 			 time_limit);
     proto_mset.set_new_min_weight(weight_threshold);
 
+    // The highest minimum weight we've shared with other threads.
+    double published_min_weight = 0.0;
+
     while (true) {
 	double min_weight = proto_mset.get_min_weight();
+	if (shared_min_weight && proto_mset.full() &&
+	    proto_mset.checked_enough()) {
+	    // Share our minimum weight with other threads matching other parts
+	    // of the database, and use theirs if it's higher.  We only do this
+	    // once we'd raise our own minimum weight, as until then we need to
+	    // see every matching document to count matches exactly.
+	    if (min_weight > published_min_weight) {
+		double old = shared_min_weight->load(memory_order_relaxed);
+		while (old < min_weight &&
+		       !shared_min_weight->compare_exchange_weak(
+			   old, min_weight, memory_order_relaxed)) { }
+		published_min_weight = min_weight;
+	    }
+	    min_weight = max(min_weight,
+			     shared_min_weight->load(memory_order_relaxed));
+	}
 	if (!pltree.next(min_weight)) {
 	    break;
 	}
@@ -515,6 +578,469 @@ Matcher::get_local_mset(Xapian::doccount first,
 			       matches_upper_bound);
 }
 
+#ifdef HAVE_STD_THREAD
+/** Minimum number of documents in each docid range when splitting a shard.
+ *
+ *  Splitting a small shard isn't worthwhile as we need to open another
+ *  handle on the shard and build another PostList tree for each range.
+ */
+static constexpr Xapian::docid MIN_DOCS_PER_RANGE = 10000;
+
+/// Does @a query contain a PostingSource?
+static bool
+uses_posting_source(const Xapian::Query& query)
+{
+    if (query.get_type() == Xapian::Query::LEAF_POSTING_SOURCE)
+	return true;
+    for (size_t i = 0; i != query.get_num_subqueries(); ++i) {
+	if (uses_posting_source(query.get_subquery(i)))
+	    return true;
+    }
+    return false;
+}
+#endif
+
+bool
+Matcher::plan_parallel_match(unsigned parallelism,
+			     const Xapian::MatchDecider* mdecider,
+			     const vector<opt_ptr_spy>& matchspies,
+			     vector<Xapian::doccount>& n_ranges) const
+{
+#ifdef HAVE_STD_THREAD
+    if (parallelism <= 1) {
+	return false;
+    }
+
+    // MatchDecider objects count the documents they accept and reject, and
+    // those counts are used to adjust the match estimates, so we can't share
+    // one between threads.
+    if (mdecider) {
+	return false;
+    }
+
+    // Each thread needs its own clone of each MatchSpy, which we then merge
+    // the results from in the same way as for remote shards.  If any of the
+    // MatchSpy objects doesn't support this we just match serially.
+    try {
+	for (auto&& spy : matchspies) {
+	    unique_ptr<Xapian::MatchSpy> clone(spy->clone());
+	}
+    } catch (const Xapian::UnimplementedError&) {
+	return false;
+    }
+
+    Xapian::doccount n_shards = locals.size();
+    Xapian::doccount n_units = 0;
+    n_ranges.assign(n_shards, 0);
+    for (Xapian::doccount i = 0; i != n_shards; ++i) {
+	if (locals[i].get()) {
+	    n_ranges[i] = 1;
+	    ++n_units;
+	}
+    }
+
+    // If we have fewer local shards than threads, split the largest shards
+    // into ranges of docids.  Each extra range needs its own handle on the
+    // shard, so we can only do this for read-only shards which we can reopen
+    // by path.  A PostingSource can't usefully be split as only the one for
+    // the first shard can be used if it doesn't support clone().
+    if (n_units < parallelism && !uses_posting_source(query)) {
+	vector<Xapian::docid> last_docids(n_shards, 0);
+	for (Xapian::doccount i = 0; i != n_shards; ++i) {
+	    if (!locals[i].get()) continue;
+	    const Xapian::Database::Internal* subdb = db.internal.get();
+	    if (n_shards > 1) {
+		auto multidb = static_cast<const MultiDatabase*>(subdb);
+		subdb = multidb->shards[i];
+	    }
+	    string path;
+	    int backend = subdb->get_backend_info(&path);
+	    if ((backend == BACKEND_GLASS || backend == BACKEND_HONEY) &&
+		subdb->is_read_only() && !path.empty()) {
+		last_docids[i] = subdb->get_lastdocid();
+	    }
+	}
+
+	while (n_units < parallelism) {
+	    Xapian::doccount best = n_shards;
+	    Xapian::docid best_range_size = 0;
+	    for (Xapian::doccount i = 0; i != n_shards; ++i) {
+		if (n_ranges[i] == 0) continue;
+		Xapian::docid range_size = last_docids[i] / (n_ranges[i] + 1);
+		if (range_size >= MIN_DOCS_PER_RANGE &&
+		    range_size > best_range_size) {
+		    best = i;
+		    best_range_size = range_size;
+		}
+	    }
+	    if (best == n_shards) break;
+	    ++n_ranges[best];
+	    ++n_units;
+	}
+    }
+
+    return n_units > 1;
+#else
+    (void)parallelism;
+    (void)mdecider;
+    (void)matchspies;
+    (void)n_ranges;
+    return false;
+#endif
+}
+
+#ifdef HAVE_STD_THREAD
+namespace {
+
+/// The objects needed to run the match for a local shard or range of one.
+struct ShardMatch {
+    /// The Database to use (with any extra handle in place of the shard).
+    Xapian::Database db;
+
+    /// LocalSubMatch using an extra handle on the shard (if needed).
+    unique_ptr<LocalSubMatch> submatch;
+
+    ValueStreamDocument vsdoc;
+
+    vector<PostList*> postlists;
+
+    PostListTree pltree;
+
+    vector<Xapian::Internal::opt_intrusive_ptr<Xapian::MatchSpy>> spies;
+
+    /** Lock to hold while matching (NULL if none is needed).
+     *
+     *  Set if this match uses the same backend object as another.
+     */
+    mutex* shard_lock = NULL;
+
+    Xapian::MSet mset;
+
+    exception_ptr error;
+
+    ShardMatch(const Xapian::Database& db_, const Xapian::Weight& wtscheme,
+	       Xapian::doccount n_shards)
+	: db(db_), vsdoc(db), postlists(n_shards), pltree(vsdoc, db, wtscheme) {
+	++vsdoc._refs;
+    }
+};
+
+}
+#endif
+
+void
+Matcher::tighten_range_bounds(vector<Xapian::MSet>::iterator begin,
+			      vector<Xapian::MSet>::iterator end,
+			      Xapian::doccount tf_min, Xapian::doccount tf_max,
+			      bool adjust_lower, bool collapsing)
+{
+    typedef Xapian::doccount Xapian::MSet::Internal::* bound;
+    auto tighten = [&](bound lower, bound est, bound upper) {
+	Xapian::doccount sum_lower = 0, sum_upper = 0;
+	for (auto m = begin; m != end; ++m) {
+	    auto& mi = *m->internal;
+	    sum_lower += mi.*lower;
+	    sum_upper += mi.*upper;
+	}
+	for (auto m = begin; m != end; ++m) {
+	    auto& mi = *m->internal;
+	    if (sum_upper > tf_max) {
+		auto cut = min(sum_upper - tf_max, mi.*upper - mi.*lower);
+		mi.*upper -= cut;
+		sum_upper -= cut;
+	    }
+	    if (adjust_lower && sum_lower < tf_min) {
+		auto add = min(tf_min - sum_lower, mi.*upper - mi.*lower);
+		mi.*lower += add;
+		sum_lower += add;
+	    }
+	    mi.*est = STD_CLAMP(mi.*est, mi.*lower, mi.*upper);
+	}
+    };
+    using Xapian::MSet;
+    tighten(&MSet::Internal::uncollapsed_lower_bound,
+	    &MSet::Internal::uncollapsed_estimated,
+	    &MSet::Internal::uncollapsed_upper_bound);
+    if (!collapsing) {
+	tighten(&MSet::Internal::matches_lower_bound,
+		&MSet::Internal::matches_estimated,
+		&MSet::Internal::matches_upper_bound);
+    }
+}
+
+void
+Matcher::get_local_msets(unsigned parallelism,
+			 vector<Xapian::doccount>& n_ranges,
+			 vector<vector<Xapian::Database>>* range_handles,
+			 vector<Xapian::MSet>& msets,
+			 Xapian::doccount first,
+			 Xapian::doccount maxitems,
+			 Xapian::doccount check_at_least,
+			 const Xapian::Weight& wtscheme,
+			 const Xapian::KeyMaker* sorter,
+			 Xapian::valueno collapse_key,
+			 Xapian::doccount collapse_max,
+			 int percent_threshold,
+			 double weight_threshold,
+			 Xapian::Enquire::docid_order order,
+			 Xapian::valueno sort_key,
+			 Xapian::Enquire::Internal::sort_setting sort_by,
+			 bool sort_val_reverse,
+			 double time_limit,
+			 const vector<opt_ptr_spy>& matchspies)
+{
+#ifdef HAVE_STD_THREAD
+    // Everything which might touch an object shared between threads (e.g. the
+    // reference counts of the Database and Query objects) happens in this
+    // thread - the worker threads only run the match loop for a PostList tree
+    // over a single shard or a range of docids in one.
+    Xapian::doccount n_shards = locals.size();
+    vector<unique_ptr<ShardMatch>> matches;
+    Xapian::termcount total_subqs = 0;
+
+    /// Details of a shard which we split into docid ranges.
+    struct SplitShard {
+	size_t begin, end;
+	Xapian::doccount tf_min, tf_max;
+    };
+    vector<SplitShard> split_shards;
+
+    vector<vector<Xapian::Database>> new_handles;
+    if (!range_handles) range_handles = &new_handles;
+    if (range_handles->size() < n_shards) range_handles->resize(n_shards);
+
+    // The same backend object can appear as more than one shard (e.g. if the
+    // same Database is passed to add_database() twice).  It isn't safe to use
+    // from more than one thread at once, so matches using such an object take
+    // a lock for it, which means they run one at a time.
+    map<const Xapian::Database::Internal*, unique_ptr<mutex>> shard_locks;
+    if (n_shards > 1) {
+	auto multidb = static_cast<const MultiDatabase*>(db.internal.get());
+	map<const Xapian::Database::Internal*, Xapian::doccount> uses;
+	for (Xapian::doccount i = 0; i != n_shards; ++i) {
+	    if (!locals[i].get()) continue;
+	    if (++uses[multidb->shards[i]] == 2) {
+		shard_locks[multidb->shards[i]].reset(new mutex);
+	    }
+	}
+    }
+
+    for (Xapian::doccount i = 0; i != n_shards; ++i) {
+	if (!locals[i].get()) continue;
+
+	const Xapian::Database::Internal* subdb = db.internal.get();
+	if (n_shards > 1) {
+	    auto multidb = static_cast<const MultiDatabase*>(subdb);
+	    subdb = multidb->shards[i];
+	}
+	mutex* shard_lock = NULL;
+	auto l = shard_locks.find(subdb);
+	if (l != shard_locks.end()) shard_lock = l->second.get();
+
+	// We need another handle on the shard for each extra range, as the
+	// backend objects aren't safe to use from more than one thread at
+	// once.  Opening one means reading the version file and the root
+	// blocks of the tables, so we keep them for later matches (reopening
+	// any which are for an older revision).  If we fail to get a handle on
+	// the same revision as the shard (e.g. because the shard has been
+	// updated since it was opened) we just use fewer ranges.
+	vector<Xapian::Database>& handles = (*range_handles)[i];
+	auto same_revision = [subdb](const Xapian::Database& handle) {
+	    const auto& h = *handle.internal;
+	    return h.get_revision() == subdb->get_revision() &&
+		   h.get_uuid() == subdb->get_uuid();
+	};
+	Xapian::doccount k = 1;
+	if (n_ranges[i] > 1) {
+	    try {
+		while (k < n_ranges[i] && k <= handles.size()) {
+		    Xapian::Database& handle = handles[k - 1];
+		    if (!same_revision(handle)) {
+			(void)handle.reopen();
+			if (!same_revision(handle)) break;
+		    }
+		    ++k;
+		}
+		if (k > handles.size()) {
+		    string path;
+		    (void)subdb->get_backend_info(&path);
+		    int flags = subdb->get_open_flags();
+		    while (k < n_ranges[i]) {
+			Xapian::Database handle(path, flags);
+			if (!same_revision(handle)) break;
+			handles.push_back(std::move(handle));
+			++k;
+		    }
+		}
+	    } catch (const Xapian::Error&) {
+	    }
+	}
+
+	Xapian::docid last_docid = subdb->get_lastdocid();
+	SplitShard split{matches.size(), 0, 0, 0};
+	for (Xapian::doccount j = 0; j != k; ++j) {
+	    Xapian::Database unit_db = db;
+	    LocalSubMatch* submatch = locals[i].get();
+	    if (j > 0) {
+		const Xapian::Database& handle = handles[j - 1];
+		if (n_shards == 1) {
+		    unit_db = handle;
+		} else {
+		    // Substitute the extra handle for shard i.
+		    auto multidb =
+			static_cast<const MultiDatabase*>(db.internal.get());
+		    unit_db = Xapian::Database();
+		    for (Xapian::doccount s = 0; s != n_shards; ++s) {
+			if (s == i) {
+			    unit_db.add_database(handle);
+			} else {
+			    Xapian::Database shard(multidb->shards[s]);
+			    unit_db.add_database(shard);
+			}
+		    }
+		}
+	    }
+
+	    unique_ptr<ShardMatch> m(new ShardMatch(unit_db, wtscheme,
+						    n_shards));
+	    if (j > 0) {
+		auto handle_internal = handles[j - 1].internal.get();
+		m->submatch.reset(new LocalSubMatch(*submatch,
+						    handle_internal));
+		submatch = m->submatch.get();
+	    } else {
+		m->shard_lock = shard_lock;
+	    }
+	    Xapian::termcount total_subqs_i = 0;
+	    PostList* pl = submatch->get_postlist(&m->pltree, &total_subqs_i);
+	    total_subqs = max(total_subqs, total_subqs_i);
+	    if (!pl) continue;
+	    if (k > 1) {
+		if (j == 0) {
+		    split.tf_min = pl->get_termfreq_min();
+		    split.tf_max = pl->get_termfreq_max();
+		}
+		auto lo = Xapian::docid(1 + uint64_t(last_docid) * j / k);
+		auto hi = Xapian::docid(1 + uint64_t(last_docid) * (j + 1) / k);
+		pl = new DocidRangePostList(pl, lo, hi, last_docid);
+	    }
+	    m->postlists[i] = pl;
+	    m->pltree.set_postlists(&m->postlists[0], n_shards);
+	    m->spies.reserve(matchspies.size());
+	    for (auto&& spy : matchspies) {
+		m->spies.emplace_back(spy->clone()->release());
+	    }
+	    matches.push_back(std::move(m));
+	}
+	if (k > 1 && matches.size() - split.begin > 1) {
+	    split.end = matches.size();
+	    split_shards.push_back(split);
+	}
+    }
+
+    // When sorting primarily by relevance, the lowest weight in any thread's
+    // full ProtoMSet is also a lower bound on the weight needed to make it
+    // into the merged MSet, so threads share it to skip documents sooner.
+    // That's not true if collapsing (a document might be collapsed away) or
+    // with a percentage cutoff (which is applied after merging).
+    atomic<double> shared_min_weight(0.0);
+    atomic<double>* share_min_weight = NULL;
+    if ((sort_by == REL || sort_by == REL_VAL) &&
+	collapse_max == 0 && percent_threshold == 0) {
+	share_min_weight = &shared_min_weight;
+    }
+
+    atomic<size_t> next_match(0);
+    auto worker = [&]() {
+	size_t j;
+	while ((j = next_match++) < matches.size()) {
+	    ShardMatch& m = *matches[j];
+	    try {
+		unique_lock<mutex> lock;
+		if (m.shard_lock) lock = unique_lock<mutex>(*m.shard_lock);
+		m.mset = run_local_match(m.pltree, m.vsdoc, total_subqs, true,
+					 first, maxitems, check_at_least,
+					 NULL, sorter,
+					 collapse_key, collapse_max,
+					 percent_threshold, 0.0,
+					 weight_threshold, order, sort_key,
+					 sort_by, sort_val_reverse,
+					 time_limit, m.spies,
+					 share_min_weight);
+	    } catch (...) {
+		m.error = current_exception();
+	    }
+	}
+    };
+
+    // The calling thread does some of the work too, so we need one less thread
+    // than the number of threads we're going to use.
+    size_t n_threads = min(size_t(parallelism), matches.size());
+    vector<thread> threads;
+    if (n_threads > 1) threads.reserve(n_threads - 1);
+    try {
+	while (threads.size() + 1 < n_threads) {
+	    threads.emplace_back(worker);
+	}
+    } catch (const system_error&) {
+	// Failing to start a thread isn't fatal - we just use fewer threads.
+    }
+    worker();
+    for (auto&& t : threads) {
+	t.join();
+    }
+
+    for (auto&& m : matches) {
+	if (m->error) {
+	    rethrow_exception(m->error);
+	}
+    }
+
+    for (size_t s = 0; s != matchspies.size(); ++s) {
+	for (auto&& m : matches) {
+	    matchspies[s]->merge_results(m->spies[s]->serialise_results());
+	}
+    }
+
+    size_t msets_begin = msets.size();
+    msets.reserve(msets_begin + matches.size());
+    for (auto&& m : matches) {
+	msets.push_back(std::move(m->mset));
+    }
+
+    // A weight threshold means not all matching documents get counted.
+    bool adjust_lower = (weight_threshold == 0.0 && percent_threshold == 0);
+    for (auto&& split : split_shards) {
+	tighten_range_bounds(msets.begin() + (msets_begin + split.begin),
+			     msets.begin() + (msets_begin + split.end),
+			     split.tf_min, split.tf_max,
+			     adjust_lower, collapse_max != 0);
+    }
+#else
+    // plan_parallel_match() always returns false in this case.
+    (void)parallelism;
+    (void)n_ranges;
+    (void)range_handles;
+    (void)msets;
+    (void)first;
+    (void)maxitems;
+    (void)check_at_least;
+    (void)wtscheme;
+    (void)sorter;
+    (void)collapse_key;
+    (void)collapse_max;
+    (void)percent_threshold;
+    (void)weight_threshold;
+    (void)order;
+    (void)sort_key;
+    (void)sort_by;
+    (void)sort_val_reverse;
+    (void)time_limit;
+    (void)matchspies;
+    Assert(false);
+#endif
+}
+
 Xapian::MSet
 Matcher::get_mset(Xapian::doccount first,
 		  Xapian::doccount maxitems,
@@ -532,7 +1058,11 @@ Matcher::get_mset(Xapian::doccount first,
 		  Xapian::Enquire::Internal::sort_setting sort_by,
 		  bool sort_val_reverse,
 		  double time_limit,
-		  const vector<opt_intrusive_ptr<Xapian::MatchSpy>>& matchspies)
+		  unsigned parallelism,
+		  bool score_at_a_time,
+		  Xapian::doccount max_postings,
+		  const vector<opt_intrusive_ptr<Xapian::MatchSpy>>& matchspies,
+		  vector<vector<Xapian::Database>>* range_handles)
 {
     AssertRel(check_at_least, >=, first + maxitems);
 
@@ -573,18 +1103,51 @@ Matcher::get_mset(Xapian::doccount first,
     }
 #endif
 
+    // If we're running the match for local shards in parallel we get an MSet
+    // for each shard which we need to merge.
+    vector<Xapian::doccount> n_ranges;
+    bool parallel = check_at_least != 0 &&
+		    plan_parallel_match(parallelism, mdecider, matchspies,
+					n_ranges);
+
     Xapian::MSet local_mset;
+    vector<Xapian::MSet> local_msets;
     if (!locals.empty()) {
 	for (auto&& submatch : locals) {
 	    if (submatch.get())
 		submatch->start_match(stats);
 	}
 
+	// A score-at-a-time match accumulates the weights of all the
+	// documents it looks at, so only supports ranking by relevance with
+	// nothing which needs to see each document.
+	bool impact_match = score_at_a_time &&
+			    locals.size() == 1 &&
+			    !mdecider &&
+			    collapse_max == 0 &&
+			    percent_threshold == 0 &&
+			    sort_by == REL &&
+			    matchspies.empty() &&
+			    check_at_least != 0;
+#ifdef XAPIAN_HAS_REMOTE_BACKEND
+	if (!remotes.empty()) impact_match = false;
+#endif
+	if (impact_match) {
+	    Xapian::MSet mset;
+	    if (locals[0]->get_impact_mset(first, maxitems, max_postings,
+					   weight_threshold, order, mset)) {
+		return mset;
+	    }
+	}
+
 	Xapian::doccount local_first = first;
 	Xapian::doccount local_maxitems = maxitems;
 	double local_percent_threshold_factor = percent_threshold_factor;
+	bool merging = parallel;
 #ifdef XAPIAN_HAS_REMOTE_BACKEND
-	if (!remotes.empty()) {
+	if (!remotes.empty()) merging = true;
+#endif
+	if (merging) {
 	    // We need to fetch the first "first" results too, as merging may
 	    // push those down into the part of the merged MSet we care about.
 	    local_first = 0;
@@ -600,27 +1163,41 @@ Matcher::get_mset(Xapian::doccount first,
 	    }
 	    local_percent_threshold_factor = 0.0;
 	}
-#endif
-	local_mset = get_local_mset(local_first, local_maxitems, check_at_least,
-				    wtscheme, mdecider,
-				    sorter, collapse_key, collapse_max,
-				    percent_threshold,
-				    local_percent_threshold_factor,
-				    weight_threshold, order, sort_key, sort_by,
-				    sort_val_reverse, time_limit, matchspies);
+	if (parallel) {
+	    get_local_msets(parallelism, n_ranges, range_handles, local_msets,
+			    local_first, local_maxitems, check_at_least,
+			    wtscheme, sorter, collapse_key, collapse_max,
+			    percent_threshold, weight_threshold, order,
+			    sort_key, sort_by, sort_val_reverse, time_limit,
+			    matchspies);
+	} else {
+	    local_mset = get_local_mset(local_first, local_maxitems,
+					check_at_least,
+					wtscheme, mdecider,
+					sorter, collapse_key, collapse_max,
+					percent_threshold,
+					local_percent_threshold_factor,
+					weight_threshold, order, sort_key,
+					sort_by, sort_val_reverse, time_limit,
+					matchspies);
+	}
     }
 
+    if (!parallel) {
 #ifdef XAPIAN_HAS_REMOTE_BACKEND
-    if (remotes.empty()) {
-	// Another easy case - only local databases.
+	if (remotes.empty()) {
+	    // Another easy case - only local databases.
+	    return local_mset;
+	}
+#else
 	return local_mset;
+#endif
     }
 
-    // We need to merge MSet objects.  We only need the number of remote shards
-    // + 1 if there are any local shards, so reserving n_shards may be more
-    // than we need.
+    // We need to merge MSet objects.
     vector<pair<Xapian::MSet, Xapian::doccount>> msets;
     Xapian::MSet merged_mset;
+#ifdef XAPIAN_HAS_REMOTE_BACKEND
     for_all_remotes(
 	[&](RemoteSubMatch* submatch) {
 	    Xapian::MSet remote_mset = submatch->get_mset(matchspies);
@@ -639,13 +1216,22 @@ Matcher::get_mset(Xapian::doccount first,
 						 db.internal->size());
 	    msets.push_back({remote_mset, 0});
 	});
+#endif
 
     if (!locals.empty()) {
-	if (!local_mset.empty())
-	    msets.push_back({local_mset, 0});
-	merged_mset.internal->merge_stats(local_mset.internal.get(),
-					  collapse_max != 0);
-	merged_mset.internal->stats->merge(stats);
+	if (!parallel) {
+	    local_msets.push_back(local_mset);
+	}
+	for (auto&& shard_mset : local_msets) {
+	    if (!shard_mset.empty())
+		msets.push_back({shard_mset, 0});
+	    merged_mset.internal->merge_stats(shard_mset.internal.get(),
+					      collapse_max != 0);
+	}
+	auto& merged_stats = merged_mset.internal->stats;
+	if (merged_stats.get()) {
+	    merged_stats->merge(stats);
+	}
     }
 
     if (merged_mset.internal->max_possible == 0.0) {
@@ -793,7 +1379,4 @@ Matcher::get_mset(Xapian::doccount first,
     }
 
     return merged_mset;
-#else
-    return local_mset;
-#endif
 }
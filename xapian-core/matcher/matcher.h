@@ -27,12 +27,14 @@
 
 #include "api/enquireinternal.h"
 #include "localsubmatch.h"
+#include "postlisttree.h"
 #include "remotesubmatch.h"
 #include "weight/weightinternal.h"
 
 #include "xapian/database.h"
 #include "xapian/query.h"
 
+#include <atomic>
 #include <memory>
 #include <vector>
 
@@ -104,6 +106,103 @@ class Matcher {
 				double time_limit,
 				const std::vector<opt_ptr_spy>& matchspies);
 
+    /** Run the match for a PostList tree which has been set up.
+     *
+     *  This is the part of the local match which only uses objects specific
+     *  to @a pltree, so it's safe to call for different PostList trees
+     *  over different shards concurrently.
+     *
+     *  @param single_shard	True if @a pltree only has a PostList for one
+     *				shard (in which case docids are returned in
+     *				ascending order).
+     *  @param shared_min_weight	Minimum weight shared between threads
+     *				matching different parts of the database
+     *				(NULL if not sharing).
+     */
+    Xapian::MSet run_local_match(PostListTree& pltree,
+				 ValueStreamDocument& vsdoc,
+				 Xapian::termcount total_subqs,
+				 bool single_shard,
+				 Xapian::doccount first,
+				 Xapian::doccount maxitems,
+				 Xapian::doccount check_at_least,
+				 const Xapian::MatchDecider* mdecider,
+				 const Xapian::KeyMaker* sorter,
+				 Xapian::valueno collapse_key,
+				 Xapian::doccount collapse_max,
+				 int percent_threshold,
+				 double percent_threshold_factor,
+				 double weight_threshold,
+				 Xapian::Enquire::docid_order order,
+				 Xapian::valueno sort_key,
+				 Xapian::Enquire::Internal::sort_setting sort_by,
+				 bool sort_val_reverse,
+				 double time_limit,
+				 const std::vector<opt_ptr_spy>& matchspies,
+				 std::atomic<double>* shared_min_weight);
+
+    /** Check if we can run the match for local shards in parallel.
+     *
+     *  @param parallelism	The maximum number of threads to use.
+     *  @param mdecider	MatchDecider to use (NULL for none).
+     *  @param matchspies	MatchSpy objects to use.
+     *  @param n_ranges	Filled in with the number of docid ranges to
+     *				split each local shard into (0 for remote
+     *				shards).
+     */
+    bool plan_parallel_match(unsigned parallelism,
+			     const Xapian::MatchDecider* mdecider,
+			     const std::vector<opt_ptr_spy>& matchspies,
+			     std::vector<Xapian::doccount>& n_ranges) const;
+
+    /** Tighten the match bounds for a shard which was split into docid ranges.
+     *
+     *  The bounds for each range are derived from those for the whole shard, so
+     *  their sum can be a lot looser than the bounds for the whole shard.  We
+     *  adjust the ranges so that their sum respects the shard's bounds (only the
+     *  sum matters as the bounds get summed when the MSet objects are merged).
+     *
+     *  @param begin,end	The MSet objects for the ranges.
+     *  @param tf_min,tf_max	Bounds on the number of matches in the shard.
+     *  @param adjust_lower	Can the lower bound be raised to @a tf_min?
+     *  @param collapsing	Is collapsing enabled?
+     */
+    static void tighten_range_bounds(std::vector<Xapian::MSet>::iterator begin,
+				     std::vector<Xapian::MSet>::iterator end,
+				     Xapian::doccount tf_min,
+				     Xapian::doccount tf_max,
+				     bool adjust_lower,
+				     bool collapsing);
+
+    /** Run the match for local shards in parallel.
+     *
+     *  The results for each shard (or range of docids in a shard) are
+     *  returned as a separate MSet (with docids already converted to those of
+     *  the combined database) which need to be merged by the caller.  Each
+     *  thread uses its own clones of the MatchSpy objects, the results of
+     *  which are merged into those in @a matchspies.
+     */
+    void get_local_msets(unsigned parallelism,
+			 std::vector<Xapian::doccount>& n_ranges,
+			 std::vector<std::vector<Xapian::Database>>*
+			     range_handles,
+			 std::vector<Xapian::MSet>& msets,
+			 Xapian::doccount first,
+			 Xapian::doccount maxitems,
+			 Xapian::doccount check_at_least,
+			 const Xapian::Weight& wtscheme,
+			 const Xapian::KeyMaker* sorter,
+			 Xapian::valueno collapse_key,
+			 Xapian::doccount collapse_max,
+			 int percent_threshold,
+			 double weight_threshold,
+			 Xapian::Enquire::docid_order order,
+			 Xapian::valueno sort_key,
+			 Xapian::Enquire::Internal::sort_setting sort_by,
+			 bool sort_val_reverse,
+			 double time_limit,
+			 const std::vector<opt_ptr_spy>& matchspies);
+
     /// Perform action on remotes as they become ready using poll() or select().
     template<typename Action> void for_all_remotes(Action action);
 
@@ -185,7 +284,18 @@ class Matcher {
      *  @param sort_val_reverse	Reverse direction keys sort in?
      *  @param time_limit	time in seconds after which to disable
      *				check_at_least (0.0 means don't).
+     *  @param parallelism	Maximum number of threads to use to run the
+     *				match for local shards (1 means run it in the
+     *				calling thread).
+     *  @param score_at_a_time	Run the match score-at-a-time if possible
+     *				(see ImpactSubMatch).
+     *  @param max_postings	Stop a score-at-a-time match after this many
+     *				postings (0 means process them all).
      *  @param matchspies	MatchSpy objects to use
+     *  @param range_handles	Extra handles on each local shard for matching
+     *				ranges of docids in parallel, which are reused
+     *				and added to (NULL to open them for this match
+     *				only).
      */
     Xapian::MSet get_mset(Xapian::doccount first,
 			  Xapian::doccount maxitems,
@@ -203,7 +313,12 @@ class Matcher {
 			  Xapian::Enquire::Internal::sort_setting sort_by,
 			  bool sort_val_reverse,
 			  double time_limit,
-			  const std::vector<opt_ptr_spy>& matchspies);
+			  unsigned parallelism,
+			  bool score_at_a_time,
+			  Xapian::doccount max_postings,
+			  const std::vector<opt_ptr_spy>& matchspies,
+			  std::vector<std::vector<Xapian::Database>>*
+			      range_handles = NULL);
 };
 
 #endif // XAPIAN_INCLUDED_MATCHER_H
@@ -160,6 +160,19 @@ MaxPostList::recalc_maxweight()
     return result;
 }
 
+double
+MaxPostList::get_block_maxweight(Xapian::docid& block_last)
+{
+    double result = 0.0;
+    block_last = Xapian::docid(-1);
+    for (size_t i = 0; i < n_kids; ++i) {
+	Xapian::docid kid_block_last;
+	result = max(result, plist[i]->get_block_maxweight(kid_block_last));
+	block_last = min(block_last, kid_block_last);
+    }
+    return result;
+}
+
 PostList *
 MaxPostList::next(double w_min)
 {
@@ -202,11 +215,14 @@ MaxPostList::next(double w_min)
 	return plist[0];
     }
 
+    if (w_min > 0.0)
+	return skip_weak_blocks(w_min);
+
     return NULL;
 }
 
 PostList *
-MaxPostList::skip_to(Xapian::docid did_min, double w_min)
+MaxPostList::advance_to(Xapian::docid did_min, double w_min)
 {
     Xapian::docid old_did = did;
     did = 0;
@@ -245,6 +261,36 @@ MaxPostList::skip_to(Xapian::docid did_min, double w_min)
     return NULL;
 }
 
+PostList *
+MaxPostList::skip_weak_blocks(double w_min)
+{
+    while (true) {
+	double bound = 0.0;
+	Xapian::docid block_last = Xapian::docid(-1);
+	for (size_t i = 0; i < n_kids; ++i) {
+	    Xapian::docid kid_block_last;
+	    bound = max(bound, plist[i]->get_block_maxweight(kid_block_last));
+	    block_last = min(block_last, kid_block_last);
+	}
+	if (bound >= w_min || block_last == Xapian::docid(-1))
+	    return NULL;
+	// No document up to block_last can achieve w_min, so skip them.
+	PostList * res = advance_to(block_last + 1, w_min);
+	if (res)
+	    return res;
+    }
+}
+
+PostList *
+MaxPostList::skip_to(Xapian::docid did_min, double w_min)
+{
+    PostList * res = advance_to(did_min, w_min);
+    if (res || w_min <= 0.0)
+	return res;
+
+    return skip_weak_blocks(w_min);
+}
+
 string
 MaxPostList::get_description() const
 {
@@ -58,6 +58,16 @@ class MaxPostList : public PostList {
 	matcher->force_recalc();
     }
 
+    /// Advance sub-postlists which are before @a did_min.
+    PostList* advance_to(Xapian::docid did_min, double w_min);
+
+    /** Skip blocks of documents which can't achieve weight @a w_min.
+     *
+     *  Uses the per-block weight bounds from the sub-postlists, the maximum
+     *  of which bounds the weight for the docids covered by all the blocks.
+     */
+    PostList* skip_weak_blocks(double w_min);
+
   public:
     /** Construct from 2 random-access iterators to a container of PostList*,
      *  a pointer to the matcher, and the document collection size.
@@ -96,6 +106,8 @@ class MaxPostList : public PostList {
 
     double recalc_maxweight();
 
+    double get_block_maxweight(Xapian::docid& block_last);
+
     PositionList * read_position_list() {
 	return NULL;
     }
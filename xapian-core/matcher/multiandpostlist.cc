@@ -22,11 +22,66 @@
 #include <config.h>
 
 #include "multiandpostlist.h"
+#include "backends/leafpostlist.h"
 #include "omassert.h"
 #include "debuglog.h"
 
+#include <memory>
+#include <vector>
+
 using namespace std;
 
+struct MultiAndPostList::Batch {
+    /// The sub-postlists (the same objects as in plist).
+    vector<LeafPostList*> leaf;
+
+    /** The docid each sub-postlist is positioned on.
+     *
+     *  Entry 0 isn't used, and other entries may be less than the actual
+     *  position (e.g. 0 if unknown).
+     */
+    vector<Xapian::docid> kid_did;
+
+    /** The wdf from each sub-postlist for each match.
+     *
+     *  The wdf for sub-postlist i for match j is at i * POSTLIST_BATCH_SIZE
+     *  + j.
+     */
+    vector<Xapian::termcount> kid_wdf;
+
+    /// Has a sub-postlist reached its end?
+    bool ended;
+
+    /// Candidate entries read from plist[0].
+    Xapian::docid cand_did[POSTLIST_BATCH_SIZE];
+
+    Xapian::termcount cand_wdf[POSTLIST_BATCH_SIZE];
+
+    /// Matching entries, with the current entry at index pos.
+    Xapian::docid did[POSTLIST_BATCH_SIZE];
+
+    Xapian::termcount wdf[POSTLIST_BATCH_SIZE];
+
+    double weight[POSTLIST_BATCH_SIZE];
+
+    unsigned size = 0;
+
+    unsigned pos = 0;
+
+    /// The value count_matching_subqs() returns for every match.
+    Xapian::termcount subqs;
+
+    /// Statistics for the matching entries.
+    Xapian::termcount doclen[POSTLIST_BATCH_SIZE];
+
+    Xapian::termcount unique_terms[POSTLIST_BATCH_SIZE];
+
+    Xapian::termcount wdfdocmax[POSTLIST_BATCH_SIZE];
+
+    /// Scratch space for calculating the weights for one sub-postlist.
+    double kid_weight[POSTLIST_BATCH_SIZE];
+};
+
 void
 MultiAndPostList::allocate_plist_and_max_wt()
 {
@@ -49,6 +104,94 @@ MultiAndPostList::~MultiAndPostList()
 	delete [] plist;
     }
     delete [] max_wt;
+    delete batch;
+}
+
+void
+MultiAndPostList::enable_batching()
+{
+    unique_ptr<Batch> b(new Batch);
+    for (size_t i = 0; i < n_kids; ++i) {
+	LeafPostList* leaf = plist[i]->as_leaf_postlist();
+	if (!leaf) return;
+	b->leaf.push_back(leaf);
+    }
+    b->kid_did.resize(n_kids);
+    b->kid_wdf.resize(n_kids * POSTLIST_BATCH_SIZE);
+    batch = b.release();
+}
+
+bool
+MultiAndPostList::fill_batch()
+{
+    Batch& b = *batch;
+    const size_t B = POSTLIST_BATCH_SIZE;
+    b.size = b.pos = 0;
+    while (!b.ended) {
+	// Read a batch of candidates from the least frequent sub-postlist and
+	// check each against the others.
+	Xapian::doccount k = b.leaf[0]->next_batch(Xapian::docid(-1),
+						   b.cand_did, b.cand_wdf, B);
+	if (b.leaf[0]->at_end()) b.ended = true;
+	unsigned n = 0;
+	bool kid_ended = false;
+	for (Xapian::doccount j = 0; j != k && !kid_ended; ++j) {
+	    Xapian::docid cand = b.cand_did[j];
+	    size_t i;
+	    for (i = 1; i != n_kids; ++i) {
+		if (b.kid_did[i] < cand) {
+		    LeafPostList* pl = b.leaf[i];
+		    (void)pl->skip_to(cand, 0.0);
+		    if (pl->at_end()) {
+			// There can't be any more matches.
+			kid_ended = b.ended = true;
+			break;
+		    }
+		    b.kid_did[i] = pl->get_docid();
+		}
+		if (b.kid_did[i] != cand) break;
+		b.kid_wdf[i * B + n] = b.leaf[i]->get_wdf();
+	    }
+	    if (i == n_kids) {
+		b.kid_wdf[n] = b.cand_wdf[j];
+		b.did[n++] = cand;
+	    }
+	}
+	if (n == 0) continue;
+
+	b.size = n;
+	b.subqs = 0;
+	for (size_t i = 0; i != n_kids; ++i) {
+	    b.subqs += b.leaf[i]->count_matching_subqs();
+	}
+	for (unsigned j = 0; j != n; ++j) {
+	    Xapian::termcount totwdf = 0;
+	    for (size_t i = 0; i != n_kids; ++i) {
+		totwdf += b.kid_wdf[i * B + j];
+	    }
+	    b.wdf[j] = totwdf;
+	}
+
+	// Calculate the weights for the whole batch.  Summing the
+	// contributions in the same order as get_weight() does gives
+	// identical results.
+	fill_n(b.weight, n, 0.0);
+	// For a leaf postlist count_matching_subqs() is 1 if it has a
+	// weighting scheme, else 0.
+	if (b.subqs == 0) return true;
+	matcher->get_doc_stats_batch(n, b.did,
+				     b.doclen, b.unique_terms, b.wdfdocmax);
+	for (size_t i = 0; i != n_kids; ++i) {
+	    b.leaf[i]->get_weight_batch(n, &b.kid_wdf[i * B],
+					b.doclen, b.unique_terms,
+					b.wdfdocmax, b.kid_weight);
+	    for (unsigned j = 0; j != n; ++j) {
+		b.weight[j] += b.kid_weight[j];
+	    }
+	}
+	return true;
+    }
+    return false;
 }
 
 Xapian::doccount
@@ -154,6 +297,8 @@ MultiAndPostList::get_weight(Xapian::termcount doclen,
 			     Xapian::termcount wdfdocmax) const
 {
     Assert(did);
+    if (batching)
+	return batch->weight[batch->pos];
     double result = 0;
     for (size_t i = 0; i < n_kids; ++i) {
 	result += plist[i]->get_weight(doclen, unique_terms, wdfdocmax);
@@ -211,6 +356,33 @@ advanced_plist0:
 PostList *
 MultiAndPostList::next(double w_min)
 {
+    if (!batching && batch && w_min <= 0.0) {
+	// The sub-postlists are all positioned on the current entry (or
+	// haven't started yet).
+	fill(batch->kid_did.begin(), batch->kid_did.end(), 0);
+	batch->ended = false;
+	batch->size = batch->pos = 0;
+	batching = true;
+    }
+    if (batching) {
+	Batch& b = *batch;
+	if (++b.pos < b.size) {
+	    did = b.did[b.pos];
+	    return NULL;
+	}
+	if (w_min <= 0.0 && fill_batch()) {
+	    did = b.did[0];
+	    return NULL;
+	}
+	batching = false;
+	if (b.ended) {
+	    did = 0;
+	    return NULL;
+	}
+	// Now there's a minimum weight, switch back to the usual approach so
+	// we can use it to skip documents.  We've already checked the entry
+	// plist[0] is positioned on, so advancing it as usual is correct.
+    }
     next_helper(0, w_min);
     return find_next_match(w_min);
 }
@@ -218,6 +390,23 @@ MultiAndPostList::next(double w_min)
 PostList *
 MultiAndPostList::skip_to(Xapian::docid did_min, double w_min)
 {
+    if (batching) {
+	Batch& b = *batch;
+	if (did_min <= did)
+	    return NULL;
+	Xapian::docid* end = b.did + b.size;
+	Xapian::docid* p = lower_bound(b.did + b.pos + 1, end, did_min);
+	if (p != end) {
+	    b.pos = p - b.did;
+	    did = *p;
+	    return NULL;
+	}
+	batching = false;
+	if (b.ended) {
+	    did = 0;
+	    return NULL;
+	}
+    }
     skip_to_helper(0, did_min, w_min);
     return find_next_match(w_min);
 }
@@ -238,6 +427,8 @@ MultiAndPostList::get_description() const
 Xapian::termcount
 MultiAndPostList::get_wdf() const
 {
+    if (batching)
+	return batch->wdf[batch->pos];
     Xapian::termcount totwdf = 0;
     for (size_t i = 0; i < n_kids; ++i) {
 	totwdf += plist[i]->get_wdf();
@@ -248,6 +439,8 @@ MultiAndPostList::get_wdf() const
 Xapian::termcount
 MultiAndPostList::count_matching_subqs() const
 {
+    if (batching)
+	return batch->subqs;
     Xapian::termcount total = 0;
     for (size_t i = 0; i < n_kids; ++i) {
 	total += plist[i]->count_matching_subqs();
@@ -258,6 +451,8 @@ MultiAndPostList::count_matching_subqs() const
 void
 MultiAndPostList::gather_position_lists(OrPositionList* orposlist)
 {
+    // We don't batch if positions are needed.
+    Assert(!batching);
     for (size_t i = 0; i < n_kids; ++i) {
 	plist[i]->gather_position_lists(orposlist);
     }
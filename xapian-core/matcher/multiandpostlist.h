@@ -111,6 +111,24 @@ class MultiAndPostList : public PostList {
     /// Advance the sublists to the next match.
     PostList * find_next_match(double w_min);
 
+    /** State for reading the sub-postlists in batches.
+     *
+     *  Only set if enable_batching() found all the sub-postlists are leaf
+     *  postlists.
+     */
+    struct Batch;
+
+    Batch* batch = NULL;
+
+    /// Are we returning entries from @a batch?
+    bool batching = false;
+
+    /** Find the matches in the next batch of entries from plist[0].
+     *
+     *  @return false if there are no more matches.
+     */
+    bool fill_batch();
+
   public:
     /** Construct from 2 random-access iterators to a container of PostList*,
      *  a pointer to the matcher, and the document collection size.
@@ -154,6 +172,15 @@ class MultiAndPostList : public PostList {
 
     ~MultiAndPostList();
 
+    /** Read the sub-postlists in batches where possible.
+     *
+     *  Only has an effect if all the sub-postlists are leaf postlists.
+     *  Should only be used if positional information won't be needed from
+     *  the sub-postlists, since while batching they are positioned ahead of
+     *  the current entry.
+     */
+    void enable_batching();
+
     Xapian::doccount get_termfreq_min() const;
 
     Xapian::doccount get_termfreq_max() const;
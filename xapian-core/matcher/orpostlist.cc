@@ -23,6 +23,7 @@
 #include "orpostlist.h"
 
 #include "andmaybepostlist.h"
+#include "backends/leafpostlist.h"
 #include "min_non_zero.h"
 #include "multiandpostlist.h"
 #include "postlisttree.h"
@@ -31,6 +32,304 @@
 
 using namespace std;
 
+struct OrPostList::Batch {
+    /// The sub-postlists (the same objects as l and r).
+    LeafPostList* leaf[2];
+
+    /** Entries read from each sub-postlist which haven't been merged yet.
+     *
+     *  The entries are those from index q_begin up to q_end.  If there are
+     *  any, the sub-postlist is positioned on the last of them (or is
+     *  at_end() if ended is true).
+     */
+    Xapian::docid q_did[2][POSTLIST_BATCH_SIZE];
+
+    Xapian::termcount q_wdf[2][POSTLIST_BATCH_SIZE];
+
+    unsigned q_begin[2];
+
+    unsigned q_end[2];
+
+    /// The docid each sub-postlist is positioned on (0 if unspecified).
+    Xapian::docid last[2];
+
+    /// Has each sub-postlist reached its end?
+    bool ended[2];
+
+    /// The docid of the last entry returned before the current batch.
+    Xapian::docid cur;
+
+    /// Merged entries, with the current entry at index pos.
+    Xapian::docid did[2 * POSTLIST_BATCH_SIZE];
+
+    Xapian::termcount wdf[2 * POSTLIST_BATCH_SIZE];
+
+    Xapian::termcount subqs[2 * POSTLIST_BATCH_SIZE];
+
+    double weight[2 * POSTLIST_BATCH_SIZE];
+
+    unsigned size = 0;
+
+    unsigned pos = 0;
+
+    /// Statistics for the merged entries.
+    Xapian::termcount doclen[2 * POSTLIST_BATCH_SIZE];
+
+    Xapian::termcount unique_terms[2 * POSTLIST_BATCH_SIZE];
+
+    Xapian::termcount wdfdocmax[2 * POSTLIST_BATCH_SIZE];
+
+    /// Indices of the merged entries each sub-postlist matches.
+    unsigned side_index[2][POSTLIST_BATCH_SIZE];
+
+    Xapian::termcount side_wdf[2][POSTLIST_BATCH_SIZE];
+
+    unsigned side_n[2];
+
+    /// Scratch space for calculating the weights for one sub-postlist.
+    Xapian::termcount side_doclen[POSTLIST_BATCH_SIZE];
+
+    Xapian::termcount side_unique_terms[POSTLIST_BATCH_SIZE];
+
+    Xapian::termcount side_wdfdocmax[POSTLIST_BATCH_SIZE];
+
+    double side_weight[POSTLIST_BATCH_SIZE];
+};
+
+OrPostList::~OrPostList()
+{
+    delete l;
+    delete r;
+    delete batch;
+}
+
+void
+OrPostList::enable_batching()
+{
+    LeafPostList* l_leaf = l->as_leaf_postlist();
+    LeafPostList* r_leaf = r->as_leaf_postlist();
+    if (l_leaf && r_leaf) {
+	batch = new Batch;
+	batch->leaf[0] = l_leaf;
+	batch->leaf[1] = r_leaf;
+    }
+}
+
+void
+OrPostList::start_batching()
+{
+    Batch& b = *batch;
+    // The entry for each side is either the current entry (in which case
+    // we've already returned it) or after it (in which case it's the first
+    // entry we've read from that side but not yet returned).
+    b.cur = min_non_zero(l_did, r_did);
+    Xapian::docid dids[2] = { l_did, r_did };
+    for (int s = 0; s != 2; ++s) {
+	b.q_begin[s] = b.q_end[s] = 0;
+	if (dids[s] > b.cur) {
+	    b.q_did[s][0] = dids[s];
+	    b.q_wdf[s][0] = b.leaf[s]->get_wdf();
+	    b.q_end[s] = 1;
+	}
+	b.last[s] = dids[s];
+	b.ended[s] = false;
+    }
+    b.size = b.pos = 0;
+    batching = true;
+}
+
+bool
+OrPostList::fill_batch(Xapian::docid target, bool top_up)
+{
+    Batch& b = *batch;
+    for (int s = 0; s != 2; ++s) {
+	// Move any entries left from the last batch to the start.
+	unsigned q_n = b.q_end[s] - b.q_begin[s];
+	if (b.q_begin[s]) {
+	    copy_n(b.q_did[s] + b.q_begin[s], q_n, b.q_did[s]);
+	    copy_n(b.q_wdf[s] + b.q_begin[s], q_n, b.q_wdf[s]);
+	    b.q_begin[s] = 0;
+	    b.q_end[s] = q_n;
+	}
+	if (b.ended[s]) continue;
+
+	LeafPostList* pl = b.leaf[s];
+	if (q_n == 0 && target > b.last[s]) {
+	    (void)pl->skip_to(target, 0.0);
+	    if (pl->at_end()) {
+		b.ended[s] = true;
+		continue;
+	    }
+	    b.last[s] = pl->get_docid();
+	    b.q_did[s][0] = b.last[s];
+	    b.q_wdf[s][0] = pl->get_wdf();
+	    b.q_end[s] = q_n = 1;
+	}
+
+	// If we're not topping up, we only need an entry from each side.
+	unsigned want = top_up ? POSTLIST_BATCH_SIZE - q_n : (q_n ? 0 : 1);
+	if (want == 0) continue;
+	// We can only merge entries up to the lower of the last docids read
+	// from each side, so there's no point reading r much beyond l.
+	Xapian::docid did_max = Xapian::docid(-1);
+	if (s == 1 && !b.ended[0])
+	    did_max = b.q_did[0][b.q_end[0] - 1];
+	Xapian::doccount k = pl->next_batch(did_max,
+					    b.q_did[s] + q_n,
+					    b.q_wdf[s] + q_n,
+					    want);
+	if (k) b.last[s] = b.q_did[s][q_n + k - 1];
+	b.q_end[s] = q_n + k;
+	if (pl->at_end()) b.ended[s] = true;
+    }
+
+    // Any side which hasn't ended has at least one entry now, and we can
+    // merge entries up to the lowest last docid of such sides.
+    Xapian::docid limit = Xapian::docid(-1);
+    for (int s = 0; s != 2; ++s) {
+	if (!b.ended[s]) {
+	    AssertRel(b.q_end[s],>,0);
+	    limit = min(limit, b.q_did[s][b.q_end[s] - 1]);
+	}
+    }
+
+    // For a leaf postlist this is 1 if it has a weighting scheme, else 0.
+    Xapian::termcount side_subqs[2] = {
+	b.leaf[0]->count_matching_subqs(),
+	b.leaf[1]->count_matching_subqs()
+    };
+    unsigned n = 0;
+    b.side_n[0] = b.side_n[1] = 0;
+    unsigned& i = b.q_begin[0];
+    unsigned& j = b.q_begin[1];
+    while (true) {
+	bool have_l = (i != b.q_end[0] && b.q_did[0][i] <= limit);
+	bool have_r = (j != b.q_end[1] && b.q_did[1][j] <= limit);
+	if (have_l && have_r) {
+	    if (b.q_did[0][i] < b.q_did[1][j]) {
+		have_r = false;
+	    } else if (b.q_did[0][i] > b.q_did[1][j]) {
+		have_l = false;
+	    }
+	} else if (!have_l && !have_r) {
+	    break;
+	}
+	Xapian::termcount wdf = 0;
+	Xapian::termcount subqs = 0;
+	if (have_l) {
+	    b.did[n] = b.q_did[0][i];
+	    wdf += b.q_wdf[0][i];
+	    subqs += side_subqs[0];
+	    b.side_wdf[0][b.side_n[0]] = b.q_wdf[0][i];
+	    b.side_index[0][b.side_n[0]++] = n;
+	    ++i;
+	}
+	if (have_r) {
+	    b.did[n] = b.q_did[1][j];
+	    wdf += b.q_wdf[1][j];
+	    subqs += side_subqs[1];
+	    b.side_wdf[1][b.side_n[1]] = b.q_wdf[1][j];
+	    b.side_index[1][b.side_n[1]++] = n;
+	    ++j;
+	}
+	b.wdf[n] = wdf;
+	b.subqs[n] = subqs;
+	++n;
+    }
+    b.size = n;
+    b.pos = 0;
+    if (n == 0) return false;
+
+    // Calculate the weights for the whole batch.  Summing the contributions
+    // in the same order as get_weight() does gives identical results.
+    fill_n(b.weight, n, 0.0);
+    if (side_subqs[0] + side_subqs[1] == 0) return true;
+    pltree->get_doc_stats_batch(n, b.did,
+				b.doclen, b.unique_terms, b.wdfdocmax);
+    for (int s = 0; s != 2; ++s) {
+	unsigned m = b.side_n[s];
+	if (m == 0) continue;
+	for (unsigned k = 0; k != m; ++k) {
+	    unsigned idx = b.side_index[s][k];
+	    b.side_doclen[k] = b.doclen[idx];
+	    b.side_unique_terms[k] = b.unique_terms[idx];
+	    b.side_wdfdocmax[k] = b.wdfdocmax[idx];
+	}
+	b.leaf[s]->get_weight_batch(m, b.side_wdf[s],
+				    b.side_doclen, b.side_unique_terms,
+				    b.side_wdfdocmax, b.side_weight);
+	for (unsigned k = 0; k != m; ++k) {
+	    b.weight[b.side_index[s][k]] += b.side_weight[k];
+	}
+    }
+    return true;
+}
+
+bool
+OrPostList::advance_batch(Xapian::docid target, double w_min,
+			  PostList*& result)
+{
+    Batch& b = *batch;
+    if (b.size) b.cur = b.did[b.size - 1];
+    b.size = b.pos = 0;
+    unsigned q_n[2];
+    for (int s = 0; s != 2; ++s) {
+	if (target) {
+	    while (b.q_begin[s] != b.q_end[s] &&
+		   b.q_did[s][b.q_begin[s]] < target) {
+		++b.q_begin[s];
+	    }
+	}
+	q_n[s] = b.q_end[s] - b.q_begin[s];
+    }
+
+    bool l_done = (b.ended[0] && q_n[0] == 0);
+    bool r_done = (b.ended[1] && q_n[1] == 0);
+    if (l_done || r_done) {
+	// One side has run out.  If the other is positioned on its next
+	// entry or hasn't read beyond the entries we've returned then we can
+	// prune to leave it.
+	int s = l_done ? 1 : 0;
+	if (!b.ended[s] && q_n[s] <= 1) {
+	    PostList*& pl = (s == 0) ? l : r;
+	    if (q_n[s] == 0) {
+		PostList* res = target ? pl->skip_to(target, w_min) :
+					 pl->next(w_min);
+		if (res) {
+		    delete pl;
+		    pl = res;
+		}
+	    }
+	    batching = false;
+	    result = pl;
+	    pl = NULL;
+	    pltree->force_recalc();
+	    return true;
+	}
+    } else if (w_min > 0.0 && q_n[0] <= 1 && q_n[1] <= 1) {
+	// Now there's a minimum weight, switch back to the usual approach so
+	// we can use it to skip documents.  A side with no unmerged entries
+	// is positioned on an entry we've already returned.
+	l_did = q_n[0] ? b.q_did[0][b.q_begin[0]] : b.cur;
+	r_did = q_n[1] ? b.q_did[1][b.q_begin[1]] : b.cur;
+	batching = false;
+	return false;
+    }
+
+    // If there's a minimum weight, avoid reading further ahead than we need
+    // to so we can switch back to the usual approach sooner.
+    if (!fill_batch(target, w_min <= 0.0)) {
+	// Both sides have run out, so prune to leave one which is at_end().
+	batching = false;
+	result = l;
+	l = NULL;
+	pltree->force_recalc();
+	return true;
+    }
+    result = NULL;
+    return true;
+}
+
 PostList*
 OrPostList::decay_to_and(Xapian::docid did,
 			 double w_min,
@@ -85,6 +384,8 @@ OrPostList::get_termfreq_min() const
 Xapian::docid
 OrPostList::get_docid() const
 {
+    if (batching)
+	return batch->did[batch->pos];
     // Handle l_did or r_did being zero correctly (which means the last call on
     // that side was a check() which came back !valid).
     return min_non_zero(l_did, r_did);
@@ -95,6 +396,8 @@ OrPostList::get_weight(Xapian::termcount doclen,
 		       Xapian::termcount unique_terms,
 		       Xapian::termcount wdfdocmax) const
 {
+    if (batching)
+	return batch->weight[batch->pos];
     if (r_did == 0 || l_did < r_did)
 	return l->get_weight(doclen, unique_terms, wdfdocmax);
     if (l_did == 0 || l_did > r_did)
@@ -111,9 +414,105 @@ OrPostList::recalc_maxweight()
     return l_max + r_max;
 }
 
+double
+OrPostList::get_block_maxweight(Xapian::docid& block_last)
+{
+    if (batching || l_did == 0 || r_did == 0) {
+	// The sub-postlists are positioned ahead of the current entry while
+	// batching.
+	// The position of one side is unspecified after check() returned
+	// !valid.
+	block_last = Xapian::docid(-1);
+	return l_max + r_max;
+    }
+    Xapian::docid r_block_last;
+    double result = l->get_block_maxweight(block_last) +
+		    r->get_block_maxweight(r_block_last);
+    block_last = min(block_last, r_block_last);
+    return result;
+}
+
+PostList*
+OrPostList::advance_to(Xapian::docid did, double w_min)
+{
+    bool advance_l = (did > l_did);
+    bool advance_r = (did > r_did);
+
+    if (advance_l) {
+	PostList* result = l->skip_to(did, w_min - r_max);
+	if (result) {
+	    delete l;
+	    l = result;
+	}
+    }
+
+    if (advance_r) {
+	PostList* result = r->skip_to(did, w_min - l_max);
+	if (result) {
+	    delete r;
+	    r = result;
+	}
+    }
+
+    if (advance_l) {
+	if (l->at_end()) {
+	    PostList* result = r;
+	    r = NULL;
+	    pltree->force_recalc();
+	    return result;
+	}
+    }
+
+    if (advance_r) {
+	if (r->at_end()) {
+	    PostList* result = l;
+	    l = NULL;
+	    pltree->force_recalc();
+	    return result;
+	}
+    }
+
+    if (advance_l) {
+	l_did = l->get_docid();
+    }
+
+    if (advance_r) {
+	r_did = r->get_docid();
+    }
+
+    return NULL;
+}
+
+PostList*
+OrPostList::skip_weak_blocks(double w_min)
+{
+    while (true) {
+	Xapian::docid l_block_last, r_block_last;
+	double bound = l->get_block_maxweight(l_block_last) +
+		       r->get_block_maxweight(r_block_last);
+	Xapian::docid block_last = min(l_block_last, r_block_last);
+	if (bound >= w_min || block_last == Xapian::docid(-1))
+	    return NULL;
+	// No document up to block_last can achieve w_min, so skip them.
+	PostList* result = advance_to(block_last + 1, w_min);
+	if (result)
+	    return result;
+    }
+}
+
 PostList*
 OrPostList::next(double w_min)
 {
+    if (!batching && batch && w_min <= 0.0)
+	start_batching();
+    if (batching) {
+	if (++batch->pos < batch->size)
+	    return NULL;
+	PostList* result;
+	if (advance_batch(0, w_min, result))
+	    return result;
+    }
+
     if (w_min > l_max) {
 	if (w_min > r_max) {
 	    // Work out the smallest docid which the AND could match at.
@@ -201,12 +600,30 @@ OrPostList::next(double w_min)
 	r_did = r->get_docid();
     }
 
+    if (w_min > 0.0)
+	return skip_weak_blocks(w_min);
+
     return NULL;
 }
 
 PostList*
 OrPostList::skip_to(Xapian::docid did, double w_min)
 {
+    if (batching) {
+	Batch& b = *batch;
+	if (did <= b.did[b.pos])
+	    return NULL;
+	Xapian::docid* end = b.did + b.size;
+	Xapian::docid* p = lower_bound(b.did + b.pos + 1, end, did);
+	if (p != end) {
+	    b.pos = p - b.did;
+	    return NULL;
+	}
+	PostList* result;
+	if (advance_batch(did, w_min, result))
+	    return result;
+    }
+
     // We always advance_l if l_did is 0, and similarly for advance_r.
     bool advance_l = (did > l_did);
     bool advance_r = (did > r_did);
@@ -222,54 +639,21 @@ OrPostList::skip_to(Xapian::docid did, double w_min)
 	return decay_to_andmaybe(l, r, did, w_min);
     }
 
-    if (advance_l) {
-	PostList* result = l->skip_to(did, w_min - r_max);
-	if (result) {
-	    delete l;
-	    l = result;
-	}
-    }
+    PostList* result = advance_to(did, w_min);
+    if (result || w_min <= 0.0)
+	return result;
 
-    if (advance_r) {
-	PostList* result = r->skip_to(did, w_min - l_max);
-	if (result) {
-	    delete r;
-	    r = result;
-	}
-    }
-
-    if (advance_l) {
-	if (l->at_end()) {
-	    PostList* result = r;
-	    r = NULL;
-	    pltree->force_recalc();
-	    return result;
-	}
-    }
-
-    if (advance_r) {
-	if (r->at_end()) {
-	    PostList* result = l;
-	    l = NULL;
-	    pltree->force_recalc();
-	    return result;
-	}
-    }
-
-    if (advance_l) {
-	l_did = l->get_docid();
-    }
-
-    if (advance_r) {
-	r_did = r->get_docid();
-    }
-
-    return NULL;
+    return skip_weak_blocks(w_min);
 }
 
 PostList*
 OrPostList::check(Xapian::docid did, double w_min, bool& valid)
 {
+    if (batching) {
+	valid = true;
+	return skip_to(did, w_min);
+    }
+
     bool advance_l = (did > l_did);
     bool advance_r = (did > r_did);
     if (!advance_l && !advance_r) {
@@ -441,6 +825,8 @@ OrPostList::get_description() const
 Xapian::termcount
 OrPostList::get_wdf() const
 {
+    if (batching)
+	return batch->wdf[batch->pos];
     if (r_did == 0 || l_did < r_did)
 	return l->get_wdf();
     if (l_did == 0 || l_did > r_did)
@@ -451,6 +837,8 @@ OrPostList::get_wdf() const
 Xapian::termcount
 OrPostList::count_matching_subqs() const
 {
+    if (batching)
+	return batch->subqs[batch->pos];
     if (r_did == 0 || l_did < r_did)
 	return l->count_matching_subqs();
     if (l_did == 0 || l_did > r_did)
@@ -461,6 +849,8 @@ OrPostList::count_matching_subqs() const
 void
 OrPostList::gather_position_lists(OrPositionList* orposlist)
 {
+    // We don't batch if positions are needed.
+    Assert(!batching);
     if (l_did - 1 <= r_did - 1)
 	l->gather_position_lists(orposlist);
     if (l_did - 1 >= r_did - 1)
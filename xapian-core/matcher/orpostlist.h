@@ -57,6 +57,50 @@ class OrPostList : public PostList {
 
     PostListTree* pltree;
 
+    /** State for reading the sub-postlists in batches.
+     *
+     *  Only set if enable_batching() found both sub-postlists are leaf
+     *  postlists.
+     */
+    struct Batch;
+
+    Batch* batch = NULL;
+
+    /** Are we returning entries from @a batch?
+     *
+     *  While this is true, l_did and r_did aren't used and the current entry
+     *  is given by @a batch.
+     */
+    bool batching = false;
+
+    /// Switch to returning entries from @a batch.
+    void start_batching();
+
+    /** Read and merge the next batch of entries from the sub-postlists.
+     *
+     *  @param target	Docid to skip to (0 to just read the entries after
+     *			those already read).
+     *  @param top_up	Read a full batch from each sub-postlist?  If false,
+     *			only read entries we need to make progress, so that
+     *			we can stop batching sooner.
+     *
+     *  @return false if both sub-postlists are exhausted.
+     */
+    bool fill_batch(Xapian::docid target, bool top_up);
+
+    /** Advance once the current batch is exhausted.
+     *
+     *  @param target	Docid to skip to (0 for next()).
+     *  @param w_min	The minimum weight we're interested in.
+     *  @param[out] result	Set to the result to return when we return
+     *				true.
+     *
+     *  @return true if we handled the advance, or false if we've stopped
+     *		batching and the caller should handle it as usual.
+     */
+    bool advance_batch(Xapian::docid target, double w_min,
+		       PostList*& result);
+
     PostList* decay_to_and(Xapian::docid did,
 			   double w_min,
 			   bool* valid_ptr = NULL);
@@ -67,16 +111,32 @@ class OrPostList : public PostList {
 				double w_min,
 				bool* valid_ptr = NULL);
 
+    /// Advance both sides which are before @a did to @a did or beyond.
+    PostList* advance_to(Xapian::docid did, double w_min);
+
+    /** Skip blocks of documents which can't achieve weight @a w_min.
+     *
+     *  Uses the per-block weight bounds from both sides, which are summed
+     *  to give a bound for the range of docids covered by both blocks.
+     */
+    PostList* skip_weak_blocks(double w_min);
+
   public:
     OrPostList(PostList* left, PostList* right,
 	       PostListTree* pltree_, Xapian::doccount db_size_)
 	: l(left), r(right), db_size(db_size_), pltree(pltree_)
     {}
 
-    ~OrPostList() {
-	delete l;
-	delete r;
-    }
+    ~OrPostList();
+
+    /** Read the sub-postlists in batches where possible.
+     *
+     *  Only has an effect if both sub-postlists are leaf postlists.  Should
+     *  only be used if positional information won't be needed from the
+     *  sub-postlists, since while batching they are positioned ahead of the
+     *  current entry.
+     */
+    void enable_batching();
 
     Xapian::doccount get_termfreq_min() const;
 
@@ -97,6 +157,8 @@ class OrPostList : public PostList {
 
     double recalc_maxweight();
 
+    double get_block_maxweight(Xapian::docid& block_last);
+
     PostList* next(double w_min);
 
     PostList* skip_to(Xapian::docid did, double w_min);
@@ -25,6 +25,9 @@
 #include "backends/postlist.h"
 #include "valuestreamdocument.h"
 
+#include <algorithm>
+#include <vector>
+
 class PostListTree {
     PostList* pl = NULL;
 
@@ -63,6 +66,34 @@ class PostListTree {
 
     Xapian::Database::Internal* shard_db = nullptr;
 
+    /** Document statistics fetched by get_doc_stats_batch().
+     *
+     *  A PostList which reads its sub-postlists in batches fetches the
+     *  statistics for a batch of documents before returning them, so we keep
+     *  a copy of the last such batch which get_doc_stats() checks first to
+     *  avoid fetching them a second time.  The docids are in ascending order.
+     */
+    std::vector<Xapian::docid> batch_dids;
+
+    std::vector<Xapian::termcount> batch_doclens;
+
+    std::vector<Xapian::termcount> batch_unique_terms;
+
+    std::vector<Xapian::termcount> batch_wdfdocmaxs;
+
+    /** Index in batch_dids to start searching from.
+     *
+     *  Documents are generally requested in ascending docid order, so we only
+     *  ever move forwards.
+     */
+    mutable size_t batch_pos = 0;
+
+    /// Discard the statistics from get_doc_stats_batch().
+    void clear_doc_stats_batch() {
+	batch_dids.clear();
+	batch_pos = 0;
+    }
+
   public:
     PostListTree(ValueStreamDocument& vsdoc_,
 		 Xapian::Database& db_,
@@ -99,6 +130,7 @@ class PostListTree {
 	}
 	if (current_shard > 0)
 	    vsdoc.new_shard(current_shard);
+	clear_doc_stats_batch();
     }
 
     double recalc_maxweight() {
@@ -196,6 +228,7 @@ class PostListTree {
 		shard_db = multidb->shards[current_shard];
 	    }
 	    vsdoc.new_shard(current_shard);
+	    clear_doc_stats_batch();
 	    use_cached_max_weight = false;
 	}
     }
@@ -207,6 +240,17 @@ class PostListTree {
 	// Fetching the document length and number of unique terms is work we
 	// can avoid if the weighting scheme doesn't use them.
 	if (need_doclength || need_unique_terms || need_wdfdocmax) {
+	    while (batch_pos < batch_dids.size() &&
+		   batch_dids[batch_pos] < shard_did) {
+		++batch_pos;
+	    }
+	    if (batch_pos < batch_dids.size() &&
+		batch_dids[batch_pos] == shard_did) {
+		doclen = batch_doclens[batch_pos];
+		unique_terms = batch_unique_terms[batch_pos];
+		wdfdocmax = batch_wdfdocmaxs[batch_pos];
+		return;
+	    }
 	    if (need_doclength)
 		doclen = shard_db->get_doclength(shard_did);
 	    if (need_unique_terms)
@@ -216,6 +260,40 @@ class PostListTree {
 	}
     }
 
+    /** Get statistics for a batch of documents.
+     *
+     *  Statistics which the weighting scheme doesn't need are set to 0.
+     *
+     *  @param n		The number of documents.
+     *  @param shard_dids	The docids, in ascending order.
+     *  @param[out] doclens,unique_terms,wdfdocmaxs	Arrays to store the
+     *				statistics in.
+     */
+    void get_doc_stats_batch(size_t n,
+			     const Xapian::docid* shard_dids,
+			     Xapian::termcount* doclens,
+			     Xapian::termcount* unique_terms,
+			     Xapian::termcount* wdfdocmaxs) {
+	if (!(need_doclength || need_unique_terms || need_wdfdocmax)) {
+	    std::fill_n(doclens, n, 0);
+	    std::fill_n(unique_terms, n, 0);
+	    std::fill_n(wdfdocmaxs, n, 0);
+	    return;
+	}
+	for (size_t i = 0; i != n; ++i) {
+	    Xapian::docid did = shard_dids[i];
+	    doclens[i] = need_doclength ? shard_db->get_doclength(did) : 0;
+	    unique_terms[i] =
+		need_unique_terms ? shard_db->get_unique_terms(did) : 0;
+	    wdfdocmaxs[i] = need_wdfdocmax ? shard_db->get_wdfdocmax(did) : 0;
+	}
+	batch_dids.assign(shard_dids, shard_dids + n);
+	batch_doclens.assign(doclens, doclens + n);
+	batch_unique_terms.assign(unique_terms, unique_terms + n);
+	batch_wdfdocmaxs.assign(wdfdocmaxs, wdfdocmaxs + n);
+	batch_pos = 0;
+    }
+
     Xapian::termcount count_matching_subqs() const {
 	return pl->count_matching_subqs();
     }
@@ -35,13 +35,7 @@ class ValueGePostList: public ValueRangePostList {
     ValueGePostList(const Xapian::Database::Internal *db_,
 		    Xapian::valueno slot_,
 		    const std::string &begin_)
-	: ValueRangePostList(db_, slot_, begin_, std::string()) {}
-
-    PostList * next(double w_min);
-
-    PostList * skip_to(Xapian::docid, double w_min);
-
-    PostList * check(Xapian::docid did, double w_min, bool &valid);
+	: ValueRangePostList(db_, slot_, begin_) {}
 
     std::string get_description() const;
 };
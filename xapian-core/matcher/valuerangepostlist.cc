@@ -190,15 +190,8 @@ ValueRangePostList::next(double)
 {
     Assert(db);
     if (!valuelist) valuelist = db->open_value_list(slot);
-    valuelist->next();
-    while (!valuelist->at_end()) {
-	const string & v = valuelist->get_value();
-	if (v >= begin && v <= end) {
-	    return NULL;
-	}
-	valuelist->next();
-    }
-    db = NULL;
+    valuelist->next_in_range(filter);
+    if (valuelist->at_end()) db = NULL;
     return NULL;
 }
 
@@ -207,15 +200,8 @@ ValueRangePostList::skip_to(Xapian::docid did, double)
 {
     Assert(db);
     if (!valuelist) valuelist = db->open_value_list(slot);
-    valuelist->skip_to(did);
-    while (!valuelist->at_end()) {
-	const string & v = valuelist->get_value();
-	if (v >= begin && v <= end) {
-	    return NULL;
-	}
-	valuelist->next();
-    }
-    db = NULL;
+    valuelist->skip_to_in_range(did, filter);
+    if (valuelist->at_end()) db = NULL;
     return NULL;
 }
 
@@ -229,8 +215,7 @@ ValueRangePostList::check(Xapian::docid did, double, bool &valid)
     if (!valid) {
 	return NULL;
     }
-    const string & v = valuelist->get_value();
-    valid = (v >= begin && v <= end);
+    valid = filter.contains(valuelist->get_value());
     return NULL;
 }
 
@@ -25,6 +25,7 @@
 
 #include "backends/postlist.h"
 #include "backends/valuelist.h"
+#include "backends/valuerangefilter.h"
 #include "xapian/database.h"
 
 class ValueRangePostList : public PostList {
@@ -35,6 +36,9 @@ class ValueRangePostList : public PostList {
 
     const std::string begin, end;
 
+    /// Tests values against the range.
+    ValueRangeFilter filter;
+
     Xapian::doccount db_size;
 
     ValueList * valuelist;
@@ -45,11 +49,18 @@ class ValueRangePostList : public PostList {
     /// Disallow assignment.
     void operator=(const ValueRangePostList &);
 
+    /// Constructor for a range with no upper bound, for ValueGePostList.
+    ValueRangePostList(const Xapian::Database::Internal *db_,
+		       Xapian::valueno slot_,
+		       const std::string &begin_)
+	: db(db_), slot(slot_), begin(begin_), filter(begin_),
+	  db_size(db->get_doccount()), valuelist(0) { }
+
   public:
     ValueRangePostList(const Xapian::Database::Internal *db_,
 		       Xapian::valueno slot_,
 		       const std::string &begin_, const std::string &end_)
-	: db(db_), slot(slot_), begin(begin_), end(end_),
+	: db(db_), slot(slot_), begin(begin_), end(end_), filter(begin_, end_),
 	  db_size(db->get_doccount()), valuelist(0) { }
 
     ~ValueRangePostList();
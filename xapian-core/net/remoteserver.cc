@@ -666,7 +666,7 @@ RemoteServer::msg_query(const string &message_in)
 					 percent_threshold, weight_threshold,
 					 order,
 					 sort_key, sort_by, sort_value_forward,
-					 time_limit, matchspies);
+					 time_limit, 1, false, 0, matchspies);
     // FIXME: The local side already has these stats, except for the maxpart
     // information.
     mset.internal->set_stats(total_stats.release());
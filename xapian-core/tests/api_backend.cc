@@ -49,6 +49,8 @@
 #include <cerrno>
 #include <fstream>
 #include <iterator>
+#include <map>
+#include <vector>
 
 using namespace std;
 
@@ -1610,6 +1612,180 @@ DEFINE_TESTCASE(getrevision2, glass) {
     TEST_EQUAL(wdb.get_revision(), 0);
 }
 
+/// Check the shared block cache doesn't return stale blocks.
+DEFINE_TESTCASE(blockcache1, glass) {
+    const Xapian::docid N_DOCS = 500;
+    string path = get_named_writable_database_path("blockcache1");
+    for (int round = 0; round != 2; ++round) {
+	// Recreating the database is likely to reuse the inode numbers of the
+	// table files.
+	rm_rf(path);
+	Xapian::WritableDatabase wdb(path, Xapian::DB_CREATE, 2048);
+	for (Xapian::docid did = 1; did <= N_DOCS; ++did) {
+	    Xapian::Document doc;
+	    doc.set_data(str(round) + ":" + str(did));
+	    doc.add_term("t" + str(did % 7));
+	    wdb.add_document(doc);
+	}
+	wdb.commit();
+
+	Xapian::Database db1(path);
+	Xapian::Database db2(path);
+	for (Xapian::docid did = 1; did <= N_DOCS; ++did) {
+	    string expect = str(round) + ":" + str(did);
+	    TEST_EQUAL(db1.get_document(did).get_data(), expect);
+	    TEST_EQUAL(db2.get_document(did).get_data(), expect);
+	}
+
+	// Rewriting the documents reuses blocks freed by earlier revisions.
+	for (int rev = 0; rev != 3; ++rev) {
+	    string prefix = str(round) + "." + str(rev) + ":";
+	    for (Xapian::docid did = 1; did <= N_DOCS; ++did) {
+		Xapian::Document doc;
+		doc.set_data(prefix + str(did));
+		doc.add_term("r" + str(rev));
+		wdb.replace_document(did, doc);
+	    }
+	    wdb.commit();
+	    TEST(db1.reopen());
+	    TEST_EQUAL(db1.get_termfreq("r" + str(rev)), N_DOCS);
+	    for (Xapian::docid did = 1; did <= N_DOCS; ++did) {
+		TEST_EQUAL(db1.get_document(did).get_data(), prefix + str(did));
+	    }
+	}
+
+	// db2 is still open on the original revision, which may have been
+	// overwritten, but if we get a document it must be the right one.
+	try {
+	    for (Xapian::docid did = 1; did <= N_DOCS; ++did) {
+		TEST_EQUAL(db2.get_document(did).get_data(),
+			   str(round) + ":" + str(did));
+	    }
+	} catch (const Xapian::DatabaseModifiedError&) {
+	}
+    }
+}
+
+/// Check that reading through mappings with DB_MMAP gives the same results.
+DEFINE_TESTCASE(mmap1, path) {
+    Xapian::Database db = get_database("apitest_simpledata");
+    Xapian::Database db_mmap(get_database_path("apitest_simpledata"),
+			     Xapian::DB_MMAP);
+    TEST_EQUAL(db_mmap.get_doccount(), db.get_doccount());
+    TEST_EQUAL(db_mmap.get_total_length(), db.get_total_length());
+
+    for (Xapian::docid did = 1; did <= db.get_lastdocid(); ++did) {
+	Xapian::Document doc = db.get_document(did);
+	Xapian::Document doc_mmap = db_mmap.get_document(did);
+	TEST_EQUAL(doc_mmap.get_data(), doc.get_data());
+	TEST_EQUAL(doc_mmap.get_value(0), doc.get_value(0));
+	TEST_EQUAL(db_mmap.get_doclength(did), db.get_doclength(did));
+	auto t = db.termlist_begin(did);
+	auto t_mmap = db_mmap.termlist_begin(did);
+	while (t != db.termlist_end(did)) {
+	    TEST(t_mmap != db_mmap.termlist_end(did));
+	    TEST_EQUAL(*t_mmap, *t);
+	    TEST_EQUAL(t_mmap.get_wdf(), t.get_wdf());
+	    ++t;
+	    ++t_mmap;
+	}
+	TEST(t_mmap == db_mmap.termlist_end(did));
+    }
+
+    Xapian::Enquire enq(db);
+    Xapian::Enquire enq_mmap(db_mmap);
+    for (auto term : { "this", "word", "paragraph" }) {
+	Xapian::Query query(term);
+	enq.set_query(query);
+	enq_mmap.set_query(query);
+	Xapian::MSet mset = enq.get_mset(0, 10);
+	Xapian::MSet mset_mmap = enq_mmap.get_mset(0, 10);
+	TEST(mset_range_is_same(mset, 0, mset_mmap, 0, mset.size()));
+	TEST_EQUAL(mset_mmap.size(), mset.size());
+    }
+}
+
+/// Check DB_MMAP copes with the database growing between revisions.
+DEFINE_TESTCASE(mmap2, glass) {
+    string path = get_named_writable_database_path("mmap2");
+    Xapian::WritableDatabase wdb(path, Xapian::DB_CREATE_OR_OVERWRITE, 2048);
+    Xapian::Document doc;
+    doc.set_data("1");
+    doc.add_term("one");
+    wdb.add_document(doc);
+    wdb.commit();
+
+    Xapian::Database db(path, Xapian::DB_MMAP);
+    TEST_EQUAL(db.get_doccount(), 1);
+
+    // Add enough to extend the table files past the end of the mappings, and
+    // replace the first document so its old blocks get reused.
+    for (Xapian::docid did = 2; did <= 500; ++did) {
+	Xapian::Document newdoc;
+	newdoc.set_data(str(did));
+	newdoc.add_term("t" + str(did % 7));
+	wdb.add_document(newdoc);
+    }
+    doc.set_data("one");
+    wdb.replace_document(1, doc);
+    wdb.commit();
+
+    TEST(db.reopen());
+    TEST_EQUAL(db.get_doccount(), 500);
+    TEST_EQUAL(db.get_document(1).get_data(), "one");
+    for (Xapian::docid did = 2; did <= 500; ++did) {
+	TEST_EQUAL(db.get_document(did).get_data(), str(did));
+    }
+    TEST_EQUAL(db.get_termfreq("t3"), 72);
+}
+
+/// Check readahead for queries with many terms on a multi-level B-tree.
+DEFINE_TESTCASE(readahead1, glass) {
+    // Long terms and small blocks so the postlist table has several levels.
+    const Xapian::docid N_DOCS = 5000;
+    const string suffix = "_with_a_suffix_to_make_the_keys_longer";
+    string path = get_named_writable_database_path("readahead1");
+    Xapian::WritableDatabase wdb(path, Xapian::DB_CREATE_OR_OVERWRITE, 2048);
+    for (Xapian::docid did = 1; did <= N_DOCS; ++did) {
+	Xapian::Document doc;
+	doc.add_term("term" + str(did) + suffix);
+	doc.add_term("even" + str(did % 2));
+	wdb.add_document(doc);
+    }
+    wdb.commit();
+
+    Xapian::Database db(path);
+    vector<Xapian::Query> subqs;
+    for (Xapian::docid did = 1; did <= N_DOCS; did += N_DOCS / 20) {
+	subqs.emplace_back("term" + str(did) + suffix);
+    }
+    Xapian::Query query(Xapian::Query::OP_OR, subqs.begin(), subqs.end());
+    Xapian::Enquire enq(db);
+    enq.set_query(query);
+    TEST_EQUAL(enq.get_mset(0, 100).size(), 20);
+
+    // Rewrite the documents so blocks the reader's revision uses get reused.
+    for (int rev = 0; rev != 3; ++rev) {
+	for (Xapian::docid did = 1; did <= N_DOCS; ++did) {
+	    Xapian::Document doc;
+	    doc.add_term("new" + str(rev) + "_" + str(did) + suffix);
+	    wdb.replace_document(did, doc);
+	}
+	wdb.commit();
+    }
+
+    // Reading ahead mustn't cause a spurious error - the search should
+    // either work or report the database was modified.
+    try {
+	TEST_EQUAL(enq.get_mset(0, 100).size(), 20);
+    } catch (const Xapian::DatabaseModifiedError&) {
+    }
+
+    TEST(db.reopen());
+    enq.set_query(query);
+    TEST_EQUAL(enq.get_mset(0, 100).size(), 0);
+}
+
 /// Feature test for DOC_ASSUME_VALID.
 DEFINE_TESTCASE(getdocumentlazy1, backend) {
     Xapian::Database db = get_database("apitest_simpledata");
@@ -1883,3 +2059,397 @@ DEFINE_TESTCASE(nosuchterm, backend) {
 	TEST_EQUAL(enquire.get_mset(0, 10).size(), 0);
     }
 }
+
+/// Check running the match for local shards in parallel gives the same results.
+DEFINE_TESTCASE(parallelmatch1, backend) {
+    Xapian::Database db = get_database("etext");
+    Xapian::doccount doccount = db.get_doccount();
+    Xapian::Enquire enquire(db);
+    enquire.set_query(Xapian::Query(Xapian::Query::OP_OR,
+				    Xapian::Query("time"),
+				    Xapian::Query("word")));
+    for (int setup = 0; setup != 4; ++setup) {
+	switch (setup) {
+	    case 1:
+		enquire.set_sort_by_value(11, false);
+		break;
+	    case 2:
+		enquire.set_sort_by_relevance_then_value(13, true);
+		break;
+	    case 3:
+		enquire.set_sort_by_relevance();
+		enquire.set_collapse_key(12);
+		break;
+	}
+	for (Xapian::doccount check : {Xapian::doccount(0), doccount}) {
+	    Xapian::ValueCountMatchSpy spy1(13);
+	    enquire.clear_matchspies();
+	    enquire.add_matchspy(&spy1);
+	    enquire.set_parallelism(1);
+	    Xapian::MSet mset1 = enquire.get_mset(3, 20, check);
+
+	    Xapian::ValueCountMatchSpy spy4(13);
+	    enquire.clear_matchspies();
+	    enquire.add_matchspy(&spy4);
+	    enquire.set_parallelism(4);
+	    Xapian::MSet mset4 = enquire.get_mset(3, 20, check);
+
+	    tout << "setup " << setup << ", check " << check << '\n';
+	    TEST_EQUAL(mset1.size(), mset4.size());
+	    TEST(mset_range_is_same(mset1, 0, mset4, 0, mset1.size()));
+	    TEST(mset_range_is_same_weights(mset1, 0, mset4, 0, mset1.size()));
+	    if (check == doccount) {
+		TEST_EQUAL(mset1.get_matches_lower_bound(),
+			   mset4.get_matches_lower_bound());
+		TEST_EQUAL(mset1.get_matches_upper_bound(),
+			   mset4.get_matches_upper_bound());
+		TEST_EQUAL(spy1.get_total(), spy4.get_total());
+		TEST_EQUAL(spy1.get_description(), spy4.get_description());
+	    }
+	}
+    }
+}
+
+static void
+make_parallelmatch2_db(Xapian::WritableDatabase& db, const string&)
+{
+    for (Xapian::docid did = 1; did <= 25000; ++did) {
+	Xapian::Document doc;
+	doc.add_term("all", 1 + did % 5);
+	if (did % 3 == 0) doc.add_term("three", 1 + did % 7);
+	if (did % 7 == 0) doc.add_term("seven", 1 + did % 11);
+	doc.add_term("filler", 1 + did % 13);
+	doc.add_value(0, str(did % 10));
+	db.add_document(doc);
+    }
+}
+
+/// Check splitting a single shard into docid ranges gives the same results.
+DEFINE_TESTCASE(parallelmatch2, generated) {
+    Xapian::Database db = get_database("parallelmatch2",
+				       make_parallelmatch2_db);
+    Xapian::doccount doccount = db.get_doccount();
+    Xapian::Enquire enquire(db);
+    enquire.set_query(Xapian::Query(Xapian::Query::OP_OR,
+				    Xapian::Query("three"),
+				    Xapian::Query("seven")));
+    for (int setup = 0; setup != 3; ++setup) {
+	switch (setup) {
+	    case 1:
+		enquire.set_sort_by_value_then_relevance(0, false);
+		break;
+	    case 2:
+		enquire.set_sort_by_relevance();
+		enquire.set_collapse_key(0);
+		break;
+	}
+	for (Xapian::doccount check : {Xapian::doccount(10), doccount}) {
+	    enquire.set_parallelism(1);
+	    Xapian::MSet mset1 = enquire.get_mset(5, 10, check);
+	    enquire.set_parallelism(4);
+	    Xapian::MSet mset4 = enquire.get_mset(5, 10, check);
+
+	    tout << "setup " << setup << ", check " << check << '\n';
+	    TEST_EQUAL(mset1.size(), mset4.size());
+	    TEST(mset_range_is_same(mset1, 0, mset4, 0, mset1.size()));
+	    TEST(mset_range_is_same_weights(mset1, 0, mset4, 0, mset1.size()));
+	    if (check == doccount) {
+		TEST_EQUAL(mset1.get_matches_lower_bound(),
+			   mset4.get_matches_lower_bound());
+		TEST_EQUAL(mset1.get_matches_upper_bound(),
+			   mset4.get_matches_upper_bound());
+	    }
+	}
+    }
+}
+
+/// Check matching the same shard twice in parallel is safe.
+DEFINE_TESTCASE(parallelmatch3, generated && !remote) {
+    Xapian::Database shard = get_database("parallelmatch2",
+					  make_parallelmatch2_db);
+    Xapian::Database db;
+    db.add_database(shard);
+    db.add_database(shard);
+    Xapian::Enquire enquire(db);
+    enquire.set_query(Xapian::Query(Xapian::Query::OP_OR,
+				    Xapian::Query("three"),
+				    Xapian::Query("seven")));
+    enquire.set_parallelism(1);
+    Xapian::MSet mset1 = enquire.get_mset(0, 20, db.get_doccount());
+    for (unsigned parallelism : {2u, 4u}) {
+	enquire.set_parallelism(parallelism);
+	for (int repeat = 0; repeat != 10; ++repeat) {
+	    Xapian::MSet mset = enquire.get_mset(0, 20, db.get_doccount());
+	    TEST_EQUAL(mset1.size(), mset.size());
+	    TEST(mset_range_is_same(mset1, 0, mset, 0, mset1.size()));
+	    TEST_EQUAL(mset1.get_matches_lower_bound(),
+		       mset.get_matches_lower_bound());
+	}
+    }
+}
+
+/// Check handles kept for docid ranges follow updates to the shard.
+DEFINE_TESTCASE(parallelmatch4, glass) {
+    string path = get_named_writable_database_path("parallelmatch4");
+    Xapian::WritableDatabase wdb(path, Xapian::DB_CREATE_OR_OVERWRITE |
+				       Xapian::DB_BACKEND_GLASS);
+    make_parallelmatch2_db(wdb, string());
+    wdb.commit();
+
+    Xapian::Database db(path);
+    Xapian::Enquire enquire(db);
+    enquire.set_query(Xapian::Query(Xapian::Query::OP_OR,
+				    Xapian::Query("three"),
+				    Xapian::Query("seven")));
+    for (int round = 0; round != 3; ++round) {
+	enquire.set_parallelism(1);
+	Xapian::MSet mset1 = enquire.get_mset(0, 20, db.get_doccount());
+	enquire.set_parallelism(4);
+	Xapian::MSet mset4 = enquire.get_mset(0, 20, db.get_doccount());
+	TEST_EQUAL(mset1.size(), mset4.size());
+	TEST(mset_range_is_same(mset1, 0, mset4, 0, mset1.size()));
+	TEST_EQUAL(mset1.get_matches_lower_bound(),
+		   mset4.get_matches_lower_bound());
+
+	// Update the database so the handles need reopening.
+	for (Xapian::docid did = 3; did <= 21000; did += 3 + round) {
+	    Xapian::Document doc;
+	    doc.add_term("seven", 20);
+	    wdb.replace_document(did, doc);
+	}
+	wdb.commit();
+	TEST(db.reopen());
+    }
+}
+
+static void
+make_blockmax1_db(Xapian::WritableDatabase& db, const string&)
+{
+    for (Xapian::docid did = 1; did <= 20000; ++did) {
+	Xapian::Document doc;
+	// "a" and "b" never occur together, and each only has high wdfs in a
+	// small range of docids, so most blocks of postings can't contain a
+	// high scoring document.
+	if (did % 4 == 0) {
+	    bool hot = (did >= 5800 && did < 6200);
+	    doc.add_term("a", hot ? 20 + did % 7 : 1);
+	} else if (did % 4 == 2) {
+	    bool hot = (did >= 13800 && did < 14200);
+	    doc.add_term("b", hot ? 20 + did % 9 : 1);
+	}
+	if (did % 7 == 0) doc.add_term("c", 1 + did % 4);
+	doc.add_term("filler", 1 + did % 17);
+	db.add_document(doc);
+    }
+}
+
+/// Check skipping blocks of postings which can't score highly enough.
+DEFINE_TESTCASE(blockmax1, generated) {
+    Xapian::Database db = get_database("blockmax1", make_blockmax1_db);
+    Xapian::doccount doccount = db.get_doccount();
+    Xapian::Enquire enquire(db);
+    const Xapian::Query::op ops[] = {
+	Xapian::Query::OP_OR, Xapian::Query::OP_MAX
+    };
+    for (int scheme = 0; scheme != 2; ++scheme) {
+	if (scheme == 1) {
+	    // This scheme's bound depends linearly on the wdf, so the bounds
+	    // for blocks of postings are much tighter.
+	    enquire.set_weighting_scheme(Xapian::TfIdfWeight("ntn"));
+	}
+	for (auto op : ops) {
+	    Xapian::Query query(op, Xapian::Query("a"), Xapian::Query("b"));
+	    for (int i = 0; i != 2; ++i) {
+		if (i == 1) {
+		    query = Xapian::Query(op, query, Xapian::Query("c"));
+		}
+		enquire.set_query(query);
+		tout << scheme << ' ' << query.get_description() << '\n';
+		Xapian::MSet mset = enquire.get_mset(0, 20);
+		Xapian::MSet mset_all = enquire.get_mset(0, 20, doccount);
+		TEST_EQUAL(mset.size(), 20);
+		TEST_EQUAL(mset_all.size(), 20);
+		TEST(mset_range_is_same_weights(mset, 0, mset_all, 0, 20));
+		TEST(mset_range_is_same(mset, 0, mset_all, 0, 20));
+	    }
+	}
+    }
+}
+
+/// Check scoring postings in batches gives the same weights as one at a time.
+DEFINE_TESTCASE(batchmatch1, generated) {
+    Xapian::Database db = get_database("blockmax1", make_blockmax1_db);
+    Xapian::doccount doccount = db.get_doccount();
+    Xapian::Enquire enquire(db);
+    // There are no values in slot 0, so this sorts by docid, which means
+    // there's no minimum weight and the whole match is run in batches.
+    enquire.set_sort_by_value(0, false);
+    enquire.set_docid_order(Xapian::Enquire::ASCENDING);
+    enquire.set_weighting_scheme(Xapian::BM25Weight());
+    for (int scheme = 0; scheme != 3; ++scheme) {
+	if (scheme == 1) {
+	    enquire.set_weighting_scheme(Xapian::BM25PlusWeight());
+	} else if (scheme == 2) {
+	    enquire.set_weighting_scheme(Xapian::TfIdfWeight("ntn"));
+	}
+	map<string, map<Xapian::docid, double>> term_weights;
+	for (const char* term : { "a", "b", "c", "filler" }) {
+	    enquire.set_query(Xapian::Query(term));
+	    Xapian::MSet mset = enquire.get_mset(0, doccount);
+	    for (auto i = mset.begin(); i != mset.end(); ++i) {
+		term_weights[term][*i] = i.get_weight();
+	    }
+	}
+	const vector<string> queries[] = {
+	    { "a", "c" }, { "a", "b", "c" }, { "c", "filler" }
+	};
+	for (auto&& terms : queries) {
+	    for (auto op : { Xapian::Query::OP_OR, Xapian::Query::OP_AND }) {
+		Xapian::Query query(op, terms.begin(), terms.end());
+		enquire.set_query(query);
+		tout << scheme << ' ' << query.get_description() << '\n';
+		Xapian::MSet mset = enquire.get_mset(0, doccount);
+		TEST(!mset.empty() || op == Xapian::Query::OP_AND);
+		Xapian::docid prev = 0;
+		for (auto i = mset.begin(); i != mset.end(); ++i) {
+		    TEST_REL(*i, >, prev);
+		    prev = *i;
+		    double expect = 0.0;
+		    size_t matching = 0;
+		    for (auto&& term : terms) {
+			auto& w = term_weights[term];
+			auto it = w.find(*i);
+			if (it == w.end()) continue;
+			expect += it->second;
+			++matching;
+		    }
+		    TEST_REL(matching, >, 0);
+		    if (op == Xapian::Query::OP_AND)
+			TEST_EQUAL(matching, terms.size());
+		    TEST_EQUAL_DOUBLE(i.get_weight(), expect);
+		}
+	    }
+	}
+    }
+}
+
+/// Check Enquire::set_mset_cache().
+DEFINE_TESTCASE(msetcache1, backend && !remote && !inmemory) {
+    Xapian::Database db = get_database("etext");
+    Xapian::Query query(Xapian::Query::OP_OR,
+			Xapian::Query("time"),
+			Xapian::Query("word"));
+    Xapian::MSetCache cache(2);
+    TEST_EQUAL(cache.get_max_entries(), 2);
+    Xapian::Enquire enquire(db);
+    enquire.set_query(query);
+    enquire.set_sort_by_relevance_then_value(13, true);
+    enquire.set_mset_cache(cache);
+
+    Xapian::MSet mset1 = enquire.get_mset(3, 20);
+    TEST_EQUAL(cache.get_hits(), 0);
+    TEST_EQUAL(cache.get_misses(), 1);
+    TEST_EQUAL(cache.size(), 1);
+
+    Xapian::MSet mset2 = enquire.get_mset(3, 20);
+    TEST_EQUAL(cache.get_hits(), 1);
+    TEST_EQUAL(cache.get_misses(), 1);
+    TEST_EQUAL(mset1.size(), mset2.size());
+    TEST(mset_range_is_same(mset1, 0, mset2, 0, mset1.size()));
+    TEST(mset_range_is_same_weights(mset1, 0, mset2, 0, mset1.size()));
+    TEST_EQUAL(mset1.get_firstitem(), mset2.get_firstitem());
+    TEST_EQUAL(mset1.get_matches_estimated(), mset2.get_matches_estimated());
+    TEST_EQUAL(mset1.get_termfreq("word"), mset2.get_termfreq("word"));
+    TEST_EQUAL(mset1.get_termweight("word"), mset2.get_termweight("word"));
+    TEST_EQUAL(mset1.begin().get_percent(), mset2.begin().get_percent());
+    TEST_EQUAL(mset1.begin().get_document().get_data(),
+	       mset2.begin().get_document().get_data());
+
+    // Different get_mset() parameters need a separate entry.
+    (void)enquire.get_mset(0, 20);
+    TEST_EQUAL(cache.get_hits(), 1);
+    TEST_EQUAL(cache.get_misses(), 2);
+    TEST_EQUAL(cache.size(), 2);
+
+    // The cache can be shared between Enquire objects.
+    Xapian::Enquire enquire2(db);
+    enquire2.set_query(query);
+    enquire2.set_sort_by_relevance_then_value(13, true);
+    enquire2.set_mset_cache(cache);
+    (void)enquire2.get_mset(3, 20);
+    TEST_EQUAL(cache.get_hits(), 2);
+    TEST_EQUAL(cache.get_misses(), 2);
+
+    // A different weighting scheme needs a separate entry, and the least
+    // recently used entry is discarded to make space for it.
+    enquire2.set_weighting_scheme(Xapian::BoolWeight());
+    (void)enquire2.get_mset(3, 20);
+    TEST_EQUAL(cache.get_hits(), 2);
+    TEST_EQUAL(cache.get_misses(), 3);
+    TEST_EQUAL(cache.size(), 2);
+    (void)enquire.get_mset(3, 20);
+    TEST_EQUAL(cache.get_hits(), 3);
+    (void)enquire.get_mset(0, 20);
+    TEST_EQUAL(cache.get_hits(), 3);
+    TEST_EQUAL(cache.get_misses(), 4);
+
+    // Searches with a MatchDecider or MatchSpy aren't cached.
+    Xapian::ValueCountMatchSpy spy(13);
+    enquire.add_matchspy(&spy);
+    (void)enquire.get_mset(3, 20);
+    TEST_EQUAL(cache.get_hits(), 3);
+    TEST_EQUAL(cache.get_misses(), 4);
+    TEST_REL(spy.get_total(), >, 0);
+    enquire.clear_matchspies();
+    Xapian::ValueSetMatchDecider decider(13, true);
+    (void)enquire.get_mset(3, 20, 0, NULL, &decider);
+    TEST_EQUAL(cache.get_hits(), 3);
+    TEST_EQUAL(cache.get_misses(), 4);
+
+    enquire.clear_mset_cache();
+    (void)enquire.get_mset(3, 20);
+    TEST_EQUAL(cache.get_hits(), 3);
+    TEST_EQUAL(cache.get_misses(), 4);
+
+    cache.clear();
+    TEST(cache.empty());
+    TEST_EQUAL(cache.get_hits(), 3);
+}
+
+/// Check cached results aren't used once the database changes.
+DEFINE_TESTCASE(msetcache2, writable && !inmemory && !remote) {
+    Xapian::WritableDatabase wdb = get_writable_database("apitest_simpledata");
+    Xapian::MSetCache cache;
+    Xapian::Query query("paragraph");
+
+    // We can't cache results for a WritableDatabase as it may have
+    // uncommitted changes.
+    Xapian::Enquire wenquire(wdb);
+    wenquire.set_query(query);
+    wenquire.set_mset_cache(cache);
+    (void)wenquire.get_mset(0, 10);
+    TEST_EQUAL(cache.get_misses(), 0);
+    TEST(cache.empty());
+
+    wdb.commit();
+    Xapian::Database db = get_writable_database_as_database();
+    Xapian::Enquire enquire(db);
+    enquire.set_query(query);
+    enquire.set_mset_cache(cache);
+    Xapian::MSet mset1 = enquire.get_mset(0, 10);
+    TEST(!mset1.empty());
+    (void)enquire.get_mset(0, 10);
+    TEST_EQUAL(cache.get_hits(), 1);
+    TEST_EQUAL(cache.get_misses(), 1);
+
+    Xapian::Document doc;
+    doc.add_term("paragraph");
+    wdb.add_document(doc);
+    wdb.commit();
+    TEST(db.reopen());
+    Xapian::MSet mset2 = enquire.get_mset(0, 10);
+    TEST_EQUAL(cache.get_hits(), 1);
+    TEST_EQUAL(cache.get_misses(), 2);
+    TEST_EQUAL(mset2.get_matches_estimated(),
+	       mset1.get_matches_estimated() + 1);
+}
@@ -37,6 +37,7 @@
 #include <cerrno>
 #include <cstdlib>
 #include <fstream>
+#include <map>
 
 #include <sys/types.h>
 #include "safesysstat.h"
@@ -727,3 +728,353 @@ DEFINE_TESTCASE(compact1, compact && writable) {
 
     TEST_EQUAL(Xapian::Database(output).get_doccount(), 3);
 }
+
+static void
+make_blockpostings_db(Xapian::WritableDatabase& db, const string&)
+{
+    for (Xapian::docid did = 1; did <= 3000; ++did) {
+	Xapian::Document doc;
+	// Stored wdfs.
+	doc.add_term("all", 1 + did % 5);
+	// Flat wdf.
+	doc.add_term("flat", 2);
+	// wdf of 1, apart from the first entry.
+	doc.add_term("even", did == 2 ? 3 : 1);
+	if (did % 2 == 1) doc.remove_term("even");
+	// Zero wdf.
+	if (did % 3 == 0) doc.add_boolean_term("Kthree");
+	// Too few postings to be worth using blocks.
+	if (did % 97 == 0) doc.add_term("sparse", did % 4 + 1);
+	// Wide wdfs.
+	if (did % 11 == 0) doc.add_term("big", did * 1000);
+	// Large docid deltas.
+	if (did % 1000 == 1 || did % 13 == 0) doc.add_term("gaps", 2);
+	db.add_document(doc);
+    }
+    db.commit();
+}
+
+/// Check the postlists in @a db match those in @a ref.
+static void
+check_postlists_match(const Xapian::Database& ref, const Xapian::Database& db)
+{
+    for (auto t = ref.allterms_begin(); t != ref.allterms_end(); ++t) {
+	const string& term = *t;
+	tout << term << '\n';
+	TEST_EQUAL(db.get_termfreq(term), t.get_termfreq());
+	TEST_EQUAL(db.get_collection_freq(term), ref.get_collection_freq(term));
+	auto p = db.postlist_begin(term);
+	for (auto q = ref.postlist_begin(term); q != ref.postlist_end(term); ++q) {
+	    TEST(p != db.postlist_end(term));
+	    TEST_EQUAL(*p, *q);
+	    TEST_EQUAL(p.get_wdf(), q.get_wdf());
+	    ++p;
+	}
+	TEST(p == db.postlist_end(term));
+
+	// Check skip_to() with strides both within and across blocks.
+	for (Xapian::docid stride : {7, 37, 500}) {
+	    auto q = ref.postlist_begin(term);
+	    p = db.postlist_begin(term);
+	    for (Xapian::docid did = 1; did <= 3001; did += stride) {
+		q.skip_to(did);
+		p.skip_to(did);
+		if (q == ref.postlist_end(term)) {
+		    TEST(p == db.postlist_end(term));
+		    break;
+		}
+		TEST(p != db.postlist_end(term));
+		TEST_EQUAL(*p, *q);
+		TEST_EQUAL(p.get_wdf(), q.get_wdf());
+	    }
+	}
+    }
+}
+
+// Test compacting with DBCOMPACT_BLOCK_POSTINGS.
+//
+// With multi the docids change on compaction so the postlists won't match.
+DEFINE_TESTCASE(compactblockpostings1, compact && generated && !multi) {
+    string indbpath = get_database_path("compactblockpostings1in",
+					make_blockpostings_db);
+    string outdbpath = get_compaction_output_path("compactblockpostings1out");
+    string outdbpath2 = get_compaction_output_path("compactblockpostings1out2");
+    string outdbpath3 = get_compaction_output_path("compactblockpostings1out3");
+    rm_rf(outdbpath);
+    rm_rf(outdbpath2);
+    rm_rf(outdbpath3);
+
+    Xapian::Database indb(indbpath);
+    indb.compact(outdbpath, Xapian::DBCOMPACT_BLOCK_POSTINGS);
+    Xapian::Database outdb(outdbpath);
+    dbcheck(outdb, 3000, 3000);
+    check_postlists_match(indb, outdb);
+
+    // Check we can read the blocked encoding when compacting.
+    outdb.compact(outdbpath2, Xapian::DBCOMPACT_BLOCK_POSTINGS);
+    check_postlists_match(indb, Xapian::Database(outdbpath2));
+    outdb.compact(outdbpath3);
+    check_postlists_match(indb, Xapian::Database(outdbpath3));
+
+    Xapian::Enquire enq(outdb);
+    enq.set_query(Xapian::Query(Xapian::Query::OP_OR,
+				Xapian::Query("all"), Xapian::Query("gaps")));
+    Xapian::Enquire enq_ref(indb);
+    enq_ref.set_query(enq.get_query());
+    Xapian::MSet mset = enq.get_mset(0, 10);
+    Xapian::MSet mset_ref = enq_ref.get_mset(0, 10);
+    TEST_EQUAL(mset.size(), 10);
+    TEST(mset_range_is_same(mset, 0, mset_ref, 0, 10));
+    TEST(mset_range_is_same_weights(mset, 0, mset_ref, 0, 10));
+}
+
+static Xapian::Document
+make_bulk_doc(Xapian::docid did)
+{
+    Xapian::Document doc;
+    doc.set_data("doc " + str(did));
+    doc.add_posting("all", 1);
+    doc.add_posting("t" + str(did % 37), 2);
+    doc.add_posting("u" + str(did % 101), 3, did % 3 + 1);
+    if (did % 5 == 0) doc.add_boolean_term("Kfive");
+    doc.add_value(0, str(did));
+    return doc;
+}
+
+// Test BulkBuilder gives the same results as adding documents normally.
+DEFINE_TESTCASE(bulkbuilder1, glass) {
+    Xapian::WritableDatabase ref = get_writable_database();
+    string output = get_compaction_output_path("bulkbuilder1out");
+    rm_rf(output);
+    {
+	// Use a small memory limit so we get several runs.
+	Xapian::BulkBuilder builder(output, 0, 64 * 1024);
+	vector<Xapian::Document> docs;
+	Xapian::docid did = 1;
+	for (; did <= 1000; ++did) {
+	    Xapian::Document doc = make_bulk_doc(did);
+	    ref.add_document(doc);
+	    TEST_EQUAL(builder.add_document(doc), did);
+	}
+	for (; did <= 3000; ++did) {
+	    Xapian::Document doc = make_bulk_doc(did);
+	    ref.add_document(doc);
+	    docs.push_back(doc);
+	}
+	TEST_EQUAL(builder.add_documents(docs), 1001);
+	TEST_EQUAL(builder.get_doccount(), 3000);
+	ref.set_metadata("foo", "bar");
+	builder.set_metadata("foo", "wrong");
+	builder.set_metadata("foo", "bar");
+	builder.set_metadata("gone", "x");
+	builder.set_metadata("gone", "");
+	ref.commit();
+
+	builder.finish();
+	TEST_REL(builder.get_run_count(), >, 1);
+	TEST(!dir_exists(output + ".run0"));
+	TEST_EXCEPTION(Xapian::InvalidOperationError,
+		       builder.add_document(Xapian::Document()));
+	TEST_EXCEPTION(Xapian::InvalidOperationError, builder.finish());
+    }
+
+    TEST_EQUAL(Xapian::Database::check(output, 0, &tout), 0);
+    Xapian::Database db(output);
+    dbcheck(db, 3000, 3000);
+    check_postlists_match(ref, db);
+    TEST_EQUAL(db.get_metadata("foo"), "bar");
+    TEST_EQUAL(db.get_metadata("gone"), "");
+    for (Xapian::docid did = 1; did <= 3000; did += 97) {
+	TEST_EQUAL(db.get_document(did).get_data(), "doc " + str(did));
+	TEST_EQUAL(db.get_document(did).get_value(0), str(did));
+	auto t = "u" + str(did % 101);
+	auto p = db.positionlist_begin(did, t);
+	TEST(p != db.positionlist_end(did, t));
+	TEST_EQUAL(*p, 3);
+    }
+
+    // Only honey and glass output is supported.
+    TEST_EXCEPTION(Xapian::InvalidArgumentError,
+		   Xapian::BulkBuilder(output, Xapian::DB_BACKEND_INMEMORY));
+}
+
+// Test a failure to add a document stops BulkBuilder building a database.
+DEFINE_TESTCASE(bulkbuilder2, glass) {
+    string output = get_compaction_output_path("bulkbuilder2out");
+    rm_rf(output);
+    {
+	Xapian::BulkBuilder builder(output);
+	for (Xapian::docid did = 1; did <= 10; ++did) {
+	    TEST_EQUAL(builder.add_document(make_bulk_doc(did)), did);
+	}
+	Xapian::Document doc = make_bulk_doc(11);
+	doc.add_term(string(300, 'x'));
+	TEST_EXCEPTION(Xapian::InvalidArgumentError,
+		       builder.add_document(doc));
+	// The documents already in the run were lost, so finish() mustn't
+	// build a database without them.
+	TEST_EQUAL(builder.get_doccount(), 10);
+	TEST_EXCEPTION(Xapian::InvalidOperationError,
+		       builder.add_document(make_bulk_doc(11)));
+	TEST_EXCEPTION(Xapian::InvalidOperationError,
+		       builder.set_metadata("foo", "bar"));
+	TEST_EXCEPTION(Xapian::InvalidOperationError, builder.finish());
+    }
+    TEST(!dir_exists(output));
+    TEST(!dir_exists(output + ".run0"));
+
+    // Likewise for add_documents().
+    {
+	Xapian::BulkBuilder builder(output);
+	vector<Xapian::Document> docs;
+	for (Xapian::docid did = 1; did <= 10; ++did) {
+	    docs.push_back(make_bulk_doc(did));
+	}
+	docs[5].add_term(string(300, 'x'));
+	TEST_EXCEPTION(Xapian::InvalidArgumentError,
+		       builder.add_documents(docs));
+	TEST_EQUAL(builder.get_doccount(), 0);
+	TEST_EXCEPTION(Xapian::InvalidOperationError, builder.finish());
+    }
+    TEST(!dir_exists(output));
+}
+
+/// Compactor which records the tables it's told have finished.
+class TableStatusCompactor : public Xapian::Compactor {
+  public:
+    map<string, string> done;
+
+    void set_status(const string& table, const string& status) {
+	if (!status.empty()) {
+	    TEST(done.find(table) == done.end());
+	    done[table] = status;
+	}
+    }
+};
+
+// Test compacting tables in parallel gives the same result as serially.
+DEFINE_TESTCASE(compactparallel1, compact) {
+    string indbpath = get_database_path("apitest_simpledata");
+    string serialpath = get_compaction_output_path("compactparallel1serial");
+    string parallelpath = get_compaction_output_path("compactparallel1out");
+
+    // Check with and without multipass.  7 inputs gives two passes, the
+    // first of which merges two pairs and three.
+    for (int flags : {0, int(Xapian::DBCOMPACT_MULTIPASS)}) {
+	rm_rf(serialpath);
+	rm_rf(parallelpath);
+	Xapian::Database db;
+	for (int i = 0; i != 7; ++i) {
+	    db.add_database(Xapian::Database(indbpath));
+	}
+	TableStatusCompactor serial;
+	db.compact(serialpath, flags, 0, serial);
+	TableStatusCompactor compactor;
+	compactor.set_parallelism(4);
+	TEST_EQUAL(compactor.get_parallelism(), 4);
+	db.compact(parallelpath, flags, 0, compactor);
+	TEST_EQUAL(compactor.done.size(), serial.done.size());
+
+	Xapian::Database serialdb(serialpath);
+	Xapian::Database outdb(parallelpath);
+	TEST_EQUAL(outdb.get_doccount(), db.get_doccount());
+	dbcheck(outdb, outdb.get_doccount(), outdb.get_doccount());
+	TEST_EQUAL(Xapian::Database::check(parallelpath, 0, &tout), 0);
+	check_postlists_match(serialdb, outdb);
+	for (Xapian::docid did = 1; did <= outdb.get_doccount(); ++did) {
+	    TEST_EQUAL(outdb.get_document(did).get_data(),
+		       serialdb.get_document(did).get_data());
+	}
+    }
+}
+
+/// Make some small JSON-like document data of the sort a dictionary helps.
+static string
+make_record(Xapian::docid did)
+{
+    static const char* const colours[] = { "red", "green", "blue", "cyan" };
+    string data = "{\"id\":";
+    data += str(did);
+    data += ",\"title\":\"Item number ";
+    data += str(did * 7919 % 10007);
+    data += "\",\"colour\":\"";
+    data += colours[did % 4];
+    data += "\",\"price\":";
+    data += str(did % 97);
+    data += ".99,\"in_stock\":";
+    data += (did % 3) ? "true" : "false";
+    data += '}';
+    return data;
+}
+
+// Test compacting with DBCOMPACT_DOCDATA_DICTIONARY.
+DEFINE_TESTCASE(compactdocdatadict1, glass) {
+    Xapian::WritableDatabase wdb = get_writable_database();
+    for (Xapian::docid did = 1; did <= 5000; ++did) {
+	Xapian::Document doc;
+	doc.set_data(make_record(did));
+	doc.add_term("Q" + str(did));
+	wdb.add_document(doc);
+    }
+    wdb.commit();
+    Xapian::Database db = wdb;
+
+    string plainpath = get_compaction_output_path("compactdocdatadict1plain");
+    string dictpath = get_compaction_output_path("compactdocdatadict1out");
+    rm_rf(plainpath);
+    rm_rf(dictpath);
+    db.compact(plainpath);
+    try {
+	db.compact(dictpath, Xapian::DBCOMPACT_DOCDATA_DICTIONARY);
+    } catch (const Xapian::FeatureUnavailableError&) {
+	SKIP_TEST("zstd support not enabled");
+    }
+
+    // The dictionary should make the docdata table a lot smaller, even
+    // though it's stored in the table too.
+    off_t plain_size = file_size(plainpath + "/docdata.glass");
+    off_t dict_size = file_size(dictpath + "/docdata.glass");
+    tout << "docdata: " << plain_size << " -> " << dict_size << '\n';
+    TEST_REL(dict_size, <, plain_size / 4 * 3);
+
+    TEST_EQUAL(Xapian::Database::check(dictpath, 0, &tout), 0);
+    {
+	Xapian::Database outdb(dictpath);
+	TEST_EQUAL(outdb.get_doccount(), 5000);
+	for (Xapian::docid did = 1; did <= 5000; did += 37) {
+	    TEST_EQUAL(outdb.get_document(did).get_data(), make_record(did));
+	}
+    }
+
+    // Document data added later should use the dictionary too.
+    {
+	Xapian::WritableDatabase outdb(dictpath);
+	Xapian::Document doc;
+	doc.set_data(make_record(5001));
+	outdb.add_document(doc);
+	outdb.replace_document(3, doc);
+	outdb.commit();
+    }
+    TEST_EQUAL(Xapian::Database::check(dictpath, 0, &tout), 0);
+
+    // Compacting again should keep the dictionary, and converting to honey
+    // should drop it.
+    Xapian::Database dictdb(dictpath);
+    const int backends[] = {
+	Xapian::DB_BACKEND_GLASS, Xapian::DB_BACKEND_HONEY
+    };
+    for (int backend : backends) {
+	string outpath = get_compaction_output_path("compactdocdatadict1out2");
+	rm_rf(outpath);
+	dictdb.compact(outpath, backend | Xapian::DBCOMPACT_NO_RENUMBER);
+	Xapian::Database outdb(outpath);
+	TEST_EQUAL(outdb.get_doccount(), 5001);
+	TEST_EQUAL(outdb.get_document(3).get_data(), make_record(5001));
+	TEST_EQUAL(outdb.get_document(4).get_data(), make_record(4));
+	TEST_EQUAL(outdb.get_document(5001).get_data(), make_record(5001));
+	TEST_EQUAL(Xapian::Database::check(outpath, 0, &tout), 0);
+	if (backend == Xapian::DB_BACKEND_GLASS) {
+	    TEST_REL(file_size(outpath + "/docdata.glass"), <, plain_size);
+	}
+    }
+}
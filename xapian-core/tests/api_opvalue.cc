@@ -280,6 +280,71 @@ DEFINE_TESTCASE(valuerange7, generated) {
     }
 }
 
+static void
+make_numericvalues_db(Xapian::WritableDatabase &db, const string &)
+{
+    for (int i = 0; i != 3000; ++i) {
+	Xapian::Document doc;
+	if (i % 3 == 0) doc.add_boolean_term("Q3");
+	if (i % 7 != 6) {
+	    doc.add_value(0, Xapian::sortable_serialise((i % 1000) / 4.0 - 50));
+	}
+	// Values longer than 8 bytes which share their first 8 bytes.
+	doc.add_value(1, "abcdefgh" + string(i % 5, 'x'));
+	db.add_document(doc);
+    }
+}
+
+// Check OP_VALUE_RANGE and OP_VALUE_GE against a brute force check.
+DEFINE_TESTCASE(valuerange8, generated) {
+    Xapian::Database db = get_database("numericvalues",
+				       make_numericvalues_db);
+    Xapian::Enquire enq(db);
+    static const struct { Xapian::valueno slot; string lo, hi; } ranges[] = {
+	{ 0, Xapian::sortable_serialise(-10), Xapian::sortable_serialise(10) },
+	{ 0, Xapian::sortable_serialise(-50), Xapian::sortable_serialise(-50) },
+	{ 0, Xapian::sortable_serialise(199.75), string() },
+	{ 0, Xapian::sortable_serialise(3.25), Xapian::sortable_serialise(3) },
+	{ 0, string(), Xapian::sortable_serialise(0) },
+	{ 1, "abcdefghx", "abcdefghxxx" },
+	{ 1, "abcdefgh", "abcdefgh" },
+	{ 1, "abcdefghxx", string() },
+	{ 1, "abcdefg", string("abcdefgh\0", 9) },
+    };
+    for (auto& r : ranges) {
+	Xapian::Query query;
+	if (r.hi.empty()) {
+	    query = Xapian::Query(Xapian::Query::OP_VALUE_GE, r.slot, r.lo);
+	} else {
+	    query = Xapian::Query(Xapian::Query::OP_VALUE_RANGE, r.slot,
+				  r.lo, r.hi);
+	}
+	// Filtering a term exercises skip_to() and check().
+	Xapian::Query filtered(Xapian::Query::OP_FILTER,
+			       Xapian::Query("Q3"), query);
+	Xapian::doccount expect = 0, expect_filtered = 0;
+	for (Xapian::docid did = 1; did <= db.get_lastdocid(); ++did) {
+	    string v = db.get_document(did).get_value(r.slot);
+	    if (v.empty() || v < r.lo || (!r.hi.empty() && v > r.hi))
+		continue;
+	    ++expect;
+	    if (did % 3 == 1) ++expect_filtered;
+	}
+	tout << query.get_description() << '\n';
+	enq.set_query(query);
+	Xapian::MSet mset = enq.get_mset(0, db.get_doccount());
+	TEST_EQUAL(mset.size(), expect);
+	for (auto i = mset.begin(); i != mset.end(); ++i) {
+	    string v = i.get_document().get_value(r.slot);
+	    TEST(v >= r.lo);
+	    TEST(r.hi.empty() || v <= r.hi);
+	}
+	enq.set_query(filtered);
+	mset = enq.get_mset(0, db.get_doccount());
+	TEST_EQUAL(mset.size(), expect_filtered);
+    }
+}
+
 // Feature test for Query::OP_VALUE_GE.
 DEFINE_TESTCASE(valuege1, backend) {
     Xapian::Database db(get_database("apitest_phrase"));
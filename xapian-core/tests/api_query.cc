@@ -30,6 +30,10 @@
 
 #include "apitest.h"
 
+#include <set>
+#include <string>
+#include <vector>
+
 using namespace std;
 
 DEFINE_TESTCASE(queryterms1, !backend) {
@@ -808,6 +812,159 @@ DEFINE_TESTCASE(dualprefixeditdist1, generated) {
     TEST_EQUAL(mset.size(), 2);
 }
 
+/** Make terms for editdist2 and wildcard4.
+ *
+ *  Terms are made from a few characters (some of which are more than one byte
+ *  in UTF-8) so there are lots of near misses which share prefixes.
+ */
+static vector<string>
+make_near_miss_terms()
+{
+    static const char* const chars[] = {
+	"a", "b", "c", "d", "\xc3\xa9", "\xe1\x80\x80"
+    };
+    vector<string> terms;
+    unsigned seed = 1;
+    for (int n = 0; n != 3000; ++n) {
+	seed = seed * 1103515245 + 12345;
+	unsigned len = (seed >> 16) % 7 + 1;
+	string term;
+	for (unsigned k = 0; k != len; ++k) {
+	    seed = seed * 1103515245 + 12345;
+	    term += chars[(seed >> 16) % 6];
+	}
+	terms.push_back(term);
+    }
+    // Prefixed terms should never be included in the expansion.
+    terms.push_back("Zabc");
+    terms.push_back("Zb");
+    return terms;
+}
+
+static Xapian::Database
+get_near_miss_database(const string& name)
+{
+    return get_database(name,
+			[](Xapian::WritableDatabase& wdb, const string&)
+			{
+			    for (auto&& term : make_near_miss_terms()) {
+				Xapian::Document doc;
+				doc.add_term(term);
+				wdb.add_document(doc);
+			    }
+			});
+}
+
+/// Check the docids @a query matches are those whose term @a expect accepts.
+template<typename F>
+static void
+check_expansion(const Xapian::Database& db, const Xapian::Query& query,
+		F expect)
+{
+    tout << query.get_description() << '\n';
+    Xapian::Enquire enq(db);
+    enq.set_query(query);
+    Xapian::MSet mset = enq.get_mset(0, db.get_doccount());
+    set<Xapian::docid> got(mset.begin(), mset.end());
+    set<Xapian::docid> expected;
+    Xapian::docid did = 0;
+    for (auto&& term : make_near_miss_terms()) {
+	++did;
+	if (term[0] >= 'A' && term[0] <= 'Z') continue;
+	if (expect(term)) expected.insert(did);
+    }
+    TEST_EQUAL(got.size(), expected.size());
+    TEST(got == expected);
+}
+
+/// Edit distance with adjacent transpositions counted as one edit.
+static unsigned
+restricted_edit_distance(const string& a, const string& b)
+{
+    vector<unsigned> x{Xapian::Utf8Iterator(a), Xapian::Utf8Iterator()};
+    vector<unsigned> y{Xapian::Utf8Iterator(b), Xapian::Utf8Iterator()};
+    vector<vector<unsigned>> d(x.size() + 1, vector<unsigned>(y.size() + 1));
+    for (size_t i = 0; i <= x.size(); ++i) {
+	for (size_t j = 0; j <= y.size(); ++j) {
+	    if (i == 0 || j == 0) {
+		d[i][j] = unsigned(i + j);
+		continue;
+	    }
+	    unsigned e = min(d[i - 1][j], d[i][j - 1]) + 1;
+	    e = min(e, d[i - 1][j - 1] + (x[i - 1] != y[j - 1]));
+	    if (i > 1 && j > 1 &&
+		x[i - 1] == y[j - 2] && x[i - 2] == y[j - 1]) {
+		e = min(e, d[i - 2][j - 2] + 1);
+	    }
+	    d[i][j] = e;
+	}
+    }
+    return d[x.size()][y.size()];
+}
+
+/// Check edit distance expansion which skips over hopeless prefixes.
+DEFINE_TESTCASE(editdist2, generated) {
+    Xapian::Database db = get_near_miss_database("editdist2");
+    static const char* const targets[] = {
+	"abcd", "dcba", "bacd", "a", "ab\xc3\xa9", "\xe1\x80\x80\xc3\xa9" "c",
+	"abcdabcdab"
+    };
+    const auto OP_EDIT_DISTANCE = Xapian::Query::OP_EDIT_DISTANCE;
+    const auto OP_SYNONYM = Xapian::Query::OP_SYNONYM;
+    for (const char* target : targets) {
+	for (unsigned k = 1; k <= 3; ++k) {
+	    Xapian::Query q(OP_EDIT_DISTANCE, target, 0, 0, OP_SYNONYM, k);
+	    check_expansion(db, q, [&](const string& term) {
+				return restricted_edit_distance(term,
+								target) <= k;
+			    });
+	}
+    }
+    // With a fixed prefix.
+    Xapian::Query q(OP_EDIT_DISTANCE, "abcd", 0, 0, OP_SYNONYM, 2, 1);
+    check_expansion(db, q, [](const string& term) {
+			return term[0] == 'a' &&
+			       restricted_edit_distance(term, "abcd") <= 2;
+		    });
+}
+
+/// Match glob @a pattern against @a s, where `?` matches one UTF-8 character.
+static bool
+glob_matches(const char* pattern, const char* s, const char* end)
+{
+    if (*pattern == '\0') return s == end;
+    if (*pattern == '*') {
+	for (const char* p = s; p <= end; ++p) {
+	    if (glob_matches(pattern + 1, p, end)) return true;
+	}
+	return false;
+    }
+    if (s == end) return false;
+    if (*pattern == '?') {
+	Xapian::Utf8Iterator it(s, end - s);
+	++it;
+	return glob_matches(pattern + 1, it.raw(), end);
+    }
+    return *pattern == *s && glob_matches(pattern + 1, s + 1, end);
+}
+
+/// Check wildcard expansion which skips over non-matching prefixes.
+DEFINE_TESTCASE(wildcard4, generated) {
+    Xapian::Database db = get_near_miss_database("wildcard4");
+    static const char* const patterns[] = {
+	"a?c*", "?b*", "ab?", "??", "?\xc3\xa9*d", "a*b?c", "\xc3\xa9?a?*",
+	"d??b", "?"
+    };
+    for (const char* pattern : patterns) {
+	Xapian::Query q(Xapian::Query::OP_WILDCARD, pattern, 0,
+			Xapian::Query::WILDCARD_PATTERN_GLOB);
+	check_expansion(db, q, [&](const string& term) {
+			    return glob_matches(pattern, term.data(),
+						term.data() + term.size());
+			});
+    }
+}
+
 struct positional_testcase {
     int window;
     const char * terms[4];
@@ -30,21 +30,28 @@
 
 #include <xapian.h>
 
+#include "dbcheck.h" // For docterms_to_string(), etc.
 #include "filetests.h"
 #include "omassert.h"
 #include "str.h"
 #include "stringutils.h"
 #include "testsuite.h"
 #include "testutils.h"
+#include "twindbs.h"
 #include "unixcmds.h"
 
 #include "apitest.h"
 
 #include "safeunistd.h"
+#include "setenv.h"
+#include <algorithm>
 #include <cmath>
 #include <cstdlib>
+#include <fstream>
+#include <iterator>
 #include <map>
 #include <string>
+#include <vector>
 
 using namespace std;
 
@@ -2009,3 +2016,1129 @@ DEFINE_TESTCASE(protocolbug1, remote && writable) {
 		   db.replace_document(1, doc));
     db.commit();
 }
+
+static Xapian::Document
+make_adddocuments_doc(unsigned n)
+{
+    Xapian::Document doc;
+    doc.set_data("doc " + str(n));
+    doc.add_value(0, str(n % 17));
+    if (n % 97 == 0) {
+	// Some documents without any terms.
+	return doc;
+    }
+    doc.add_term("all");
+    doc.add_term("mod" + str(n % 13), n % 5 + 1);
+    for (unsigned i = 0; i != n % 7 + 1; ++i) {
+	doc.add_posting("word" + str((n + i) % 29), i + 1);
+    }
+    return doc;
+}
+
+/// Check add_documents() gives the same results as add_document().
+DEFINE_TESTCASE(adddocuments1, writable) {
+    Xapian::WritableDatabase db = get_writable_database();
+    Xapian::WritableDatabase ref =
+	get_named_writable_database("adddocuments1_ref");
+
+    // Add some documents one at a time first so there are pending changes.
+    for (unsigned n = 1; n <= 10; ++n) {
+	Xapian::Document doc = make_adddocuments_doc(n);
+	TEST_EQUAL(db.add_document(doc), n);
+	TEST_EQUAL(ref.add_document(doc), n);
+    }
+
+    // Enough documents to need several batches, and with the same
+    // Document object appearing more than once.
+    vector<Xapian::Document> docs;
+    for (unsigned n = 11; n <= 2500; ++n) {
+	docs.push_back(make_adddocuments_doc(n));
+    }
+    docs.push_back(docs.back());
+    TEST_EQUAL(db.add_documents(docs, 4), 11);
+    for (auto&& doc : docs) {
+	ref.add_document(doc);
+    }
+    TEST_EQUAL(db.add_documents(vector<Xapian::Document>()), 0);
+
+    for (int committed = 0; committed != 2; ++committed) {
+	TEST_EQUAL(db.get_doccount(), ref.get_doccount());
+	TEST_EQUAL(db.get_lastdocid(), ref.get_lastdocid());
+	TEST_EQUAL(db.get_total_length(), ref.get_total_length());
+	for (Xapian::docid did = 1; did <= ref.get_lastdocid(); ++did) {
+	    Xapian::Document doc = db.get_document(did);
+	    TEST_EQUAL(doc.get_data(), ref.get_document(did).get_data());
+	    TEST_EQUAL(doc.get_value(0), ref.get_document(did).get_value(0));
+	    TEST_EQUAL(docterms_to_string(db, did),
+		       docterms_to_string(ref, did));
+	}
+	for (auto t = ref.allterms_begin(); t != ref.allterms_end(); ++t) {
+	    TEST_EQUAL(termstats_to_string(db, *t), termstats_to_string(ref, *t));
+	    TEST_EQUAL(postlist_to_string(db, *t), postlist_to_string(ref, *t));
+	}
+	db.commit();
+	ref.commit();
+    }
+}
+
+/// Check an invalid document in add_documents() discards pending changes.
+DEFINE_TESTCASE(adddocuments2, glass) {
+    Xapian::WritableDatabase db = get_writable_database();
+    vector<Xapian::Document> docs;
+    for (unsigned n = 1; n <= 10; ++n) {
+	docs.push_back(make_adddocuments_doc(n));
+    }
+    db.add_documents(docs, 2);
+    db.commit();
+
+    db.add_document(docs[0]);
+    docs[5].add_term(string(300, 'x'));
+    TEST_EXCEPTION(Xapian::InvalidArgumentError, db.add_documents(docs, 2));
+    db.commit();
+    TEST_EQUAL(db.get_doccount(), 10);
+    TEST_EQUAL(db.get_lastdocid(), 10);
+    TEST_EQUAL(db.get_termfreq("all"), 10);
+}
+
+namespace {
+struct unset_flush_threshold_bytes_helper_ {
+    ~unset_flush_threshold_bytes_helper_() {
+	setenv("XAPIAN_FLUSH_THRESHOLD_BYTES", "0", 1);
+    }
+};
+}
+
+/// Test XAPIAN_FLUSH_THRESHOLD_BYTES.
+DEFINE_TESTCASE(flushthresholdbytes1, glass) {
+    unset_flush_threshold_bytes_helper_ ezlxq;
+    setenv("XAPIAN_FLUSH_THRESHOLD_BYTES", "20000", 1);
+    Xapian::WritableDatabase db = get_writable_database();
+    Xapian::Database reader = get_writable_database_as_database();
+
+    Xapian::Document doc;
+    doc.add_term("all");
+    db.add_document(doc);
+    // A small change shouldn't trigger a flush.
+    reader.reopen();
+    TEST_EQUAL(reader.get_doccount(), 0);
+
+    Xapian::doccount n = 1;
+    while (reader.get_doccount() == 0) {
+	Xapian::Document d;
+	d.add_term("all");
+	for (unsigned j = 0; j != 10; ++j) {
+	    d.add_posting("t" + str(n * 10 + j), j + 1);
+	}
+	db.add_document(d);
+	++n;
+	TEST_REL(n, <, 1000);
+	reader.reopen();
+    }
+    TEST_EQUAL(reader.get_doccount(), n);
+    TEST_EQUAL(reader.get_termfreq("all"), n);
+    TEST_EQUAL(reader.get_termfreq("t15"), 1);
+    TEST(reader.has_positions());
+
+    db.close();
+    setenv("XAPIAN_FLUSH_THRESHOLD_BYTES", "x", 1);
+    TEST_EXCEPTION(Xapian::InvalidArgumentError,
+		   get_writable_database_again());
+}
+
+/// Test pending changes to a postlist which aren't in docid order.
+DEFINE_TESTCASE(flushunordered1, writable) {
+    Xapian::WritableDatabase db = get_writable_database();
+    for (unsigned n = 1; n <= 5; ++n) {
+	Xapian::Document doc;
+	doc.add_term("a");
+	doc.add_term("b", n);
+	db.add_document(doc);
+    }
+    db.commit();
+
+    Xapian::Document doc;
+    doc.add_term("a");
+    db.replace_document(5, doc);
+    db.replace_document(2, doc);
+    doc.add_term("b", 7);
+    db.replace_document(5, doc);
+    db.replace_document(1, doc);
+    db.delete_document(2);
+    doc.add_term("c");
+    db.replace_document(2, doc);
+    db.delete_document(4);
+    db.replace_document(2, doc);
+    db.commit();
+
+    TEST_EQUAL(db.get_doccount(), 4);
+    TEST_EQUAL(db.get_termfreq("a"), 4);
+    TEST_EQUAL(db.get_termfreq("b"), 4);
+    TEST_EQUAL(db.get_collection_freq("b"), 7 + 7 + 3 + 7);
+    TEST_EQUAL(db.get_termfreq("c"), 1);
+    string b_postings;
+    for (auto p = db.postlist_begin("b"); p != db.postlist_end("b"); ++p) {
+	b_postings += str(*p);
+	b_postings += ':';
+	b_postings += str(p.get_wdf());
+	b_postings += ' ';
+    }
+    TEST_STRINGS_EQUAL(b_postings, "1:7 2:7 3:3 5:7 ");
+}
+
+/// Test commit_async() and wait_for_commit().
+DEFINE_TESTCASE(commitasync1, glass) {
+    Xapian::WritableDatabase db = get_writable_database();
+    // Nothing to wait for yet.
+    db.wait_for_commit();
+
+    for (unsigned n = 1; n <= 100; ++n) {
+	Xapian::Document doc;
+	doc.set_data(str(n));
+	doc.add_posting("all", n);
+	db.add_document(doc);
+    }
+    db.commit_async();
+
+    // Carry on modifying the database while the commit is syncing.
+    for (unsigned n = 101; n <= 150; ++n) {
+	Xapian::Document doc;
+	doc.add_term("all");
+	db.add_document(doc);
+    }
+    db.delete_document(1);
+    TEST_EQUAL(db.get_doccount(), 149);
+
+    db.wait_for_commit();
+    // Waiting again should be harmless.
+    db.wait_for_commit();
+    Xapian::Database reader = get_writable_database_as_database();
+    TEST_EQUAL(reader.get_doccount(), 100);
+    TEST_EQUAL(reader.get_termfreq("all"), 100);
+    TEST_EQUAL(reader.get_document(100).get_data(), "100");
+
+    // A second asynchronous commit waits for the first.
+    db.commit_async();
+    db.commit_async();
+    db.wait_for_commit();
+    TEST(reader.reopen());
+    TEST_EQUAL(reader.get_doccount(), 149);
+    TEST_EQUAL(reader.get_termfreq("all"), 149);
+
+    db.begin_transaction();
+    TEST_EXCEPTION(Xapian::InvalidOperationError, db.commit_async());
+    db.cancel_transaction();
+
+    // close() should wait for the sync.
+    db.add_document(Xapian::Document());
+    db.commit_async();
+    db.close();
+    TEST(reader.reopen());
+    TEST_EQUAL(reader.get_doccount(), 150);
+}
+
+/** Check a crash while an asynchronous commit is syncing is survivable.
+ *
+ *  Until the new version file is renamed into place, the database on disk is
+ *  still the previous revision, so changes made meanwhile mustn't overwrite
+ *  any blocks which that revision uses.
+ */
+DEFINE_TESTCASE(commitasync2, glass) {
+    string path = get_named_writable_database_path("commitasync2");
+    string crash = get_compaction_output_path("commitasync2crash");
+    Xapian::WritableDatabase db(path, Xapian::DB_CREATE_OR_OVERWRITE |
+				      Xapian::DB_BACKEND_GLASS);
+    const Xapian::doccount N = 2000;
+    auto update = [&](char round) {
+	for (Xapian::docid did = 1; did <= N; ++did) {
+	    Xapian::Document doc;
+	    doc.set_data(string(200, round) + str(did));
+	    doc.add_term(string("r") + round);
+	    doc.add_term("n" + str(did));
+	    db.replace_document(did, doc);
+	}
+    };
+    update('a');
+    db.commit();
+    string old_version;
+    {
+	ifstream in(path + "/iamglass", fstream::binary);
+	old_version.assign(istreambuf_iterator<char>(in),
+			   istreambuf_iterator<char>());
+    }
+
+    // Free all the blocks used for document data and termlists.
+    update('b');
+    db.commit_async();
+    // These changes write blocks to the table files.
+    update('c');
+
+    // Simulate a crash before the version file for the asynchronous commit
+    // was renamed into place.
+    rm_rf(crash);
+    cp_R(path, crash);
+    {
+	ofstream out(crash + "/iamglass", fstream::trunc|fstream::binary);
+	out << old_version;
+    }
+    db.close();
+
+    TEST_EQUAL(Xapian::Database::check(crash), 0);
+    Xapian::Database reader(crash);
+    TEST_EQUAL(reader.get_doccount(), N);
+    TEST_EQUAL(reader.get_termfreq("ra"), N);
+    TEST_EQUAL(reader.get_termfreq("rb"), 0);
+    for (Xapian::docid did = 1; did <= N; ++did) {
+	TEST_EQUAL(reader.get_document(did).get_data(),
+		   string(200, 'a') + str(did));
+    }
+}
+
+/// Check the postings for @a term in @a db are exactly @a expected.
+static void
+check_postings(const Xapian::Database& db, const string& term,
+	       const vector<Xapian::docid>& expected)
+{
+    vector<Xapian::docid> actual(db.postlist_begin(term),
+				 db.postlist_end(term));
+    TEST_EQUAL(actual, expected);
+}
+
+/// Test deleting documents with DB_LAZY_DELETE.
+DEFINE_TESTCASE(lazydelete1, glass) {
+    string path = get_named_writable_database_path("lazydelete1");
+    Xapian::WritableDatabase db(path,
+				Xapian::DB_CREATE_OR_OVERWRITE |
+				Xapian::DB_BACKEND_GLASS |
+				Xapian::DB_LAZY_DELETE);
+    for (Xapian::docid did = 1; did <= 20; ++did) {
+	Xapian::Document doc;
+	doc.set_data(str(did));
+	doc.add_value(0, str(did));
+	doc.add_posting("all", 1);
+	doc.add_term(did % 2 ? "odd" : "even", 2);
+	doc.add_term("n" + str(did));
+	db.add_document(doc);
+    }
+    db.commit();
+    unsigned old_format = glass_format_version(path);
+
+    db.delete_document(1);
+    db.delete_document(2);
+    db.delete_document(3);
+    db.delete_document(10);
+    TEST_EXCEPTION(Xapian::DocNotFoundError, db.delete_document(3));
+
+    // The changes should be visible before they're committed.
+    TEST_EQUAL(db.get_doccount(), 16);
+    check_postings(db, "even", {4, 6, 8, 12, 14, 16, 18, 20});
+    check_postings(db, "n3", {});
+    TEST_EXCEPTION(Xapian::DocNotFoundError, db.get_document(3));
+    TEST_EXCEPTION(Xapian::DocNotFoundError, db.termlist_begin(3));
+    TEST_EXCEPTION(Xapian::DocNotFoundError, db.get_doclength(3));
+    TEST_EQUAL(db.positionlist_begin(3, "all"), db.positionlist_end(3, "all"));
+    TEST_EQUAL(db.get_value_freq(0), 16);
+    // The term frequency isn't updated, but shouldn't exceed the doccount.
+    TEST_REL(db.get_termfreq("all"), <=, db.get_doccount());
+    db.commit();
+    // Older versions mustn't open the database while there are tombstones.
+    TEST_NOT_EQUAL(glass_format_version(path), old_format);
+
+    Xapian::Database reader(path);
+    TEST_EQUAL(reader.get_doccount(), 16);
+    check_postings(reader, "all",
+		   {4, 5, 6, 7, 8, 9, 11, 12, 13, 14, 15, 16, 17, 18, 19, 20});
+    check_postings(reader, "odd", {5, 7, 9, 11, 13, 15, 17, 19});
+    Xapian::PostingIterator p = reader.postlist_begin("even");
+    p.skip_to(9);
+    TEST_EQUAL(*p, 12);
+    TEST_EXCEPTION(Xapian::DocNotFoundError, reader.termlist_begin(2));
+
+    // A search shouldn't match the deleted documents.
+    Xapian::Enquire enquire(reader);
+    enquire.set_query(Xapian::Query("n2"));
+    TEST_EQUAL(enquire.get_mset(0, 10).size(), 0);
+    enquire.set_query(Xapian::Query("all"));
+    TEST_EQUAL(enquire.get_mset(0, 20).size(), 16);
+
+    // Replacing a deleted document should remove what was left behind.
+    Xapian::Document doc;
+    doc.set_data("new");
+    doc.add_posting("all", 1);
+    doc.add_term("new");
+    db.replace_document(3, doc);
+    db.commit();
+    TEST_EQUAL(db.get_doccount(), 17);
+    TEST_EQUAL(db.get_termfreq("n3"), 0);
+    TEST_EQUAL(db.get_document(3).get_data(), "new");
+    TEST_STRINGS_EQUAL(docterms_to_string(db, 3),
+		       "Term(all, wdf=1, pos=[1]), Term(new, wdf=1)");
+    TEST_EQUAL(db.get_doclength(3), 2);
+    check_postings(db, "odd", {5, 7, 9, 11, 13, 15, 17, 19});
+    TEST_EQUAL(Xapian::Database::check(path), 0);
+
+    // Compacting should drop everything left for the deleted documents.
+    const int backends[] = {
+	Xapian::DB_BACKEND_GLASS, Xapian::DB_BACKEND_HONEY
+    };
+    for (int backend : backends) {
+	string out = get_compaction_output_path("lazydelete1out");
+	rm_rf(out);
+	db.compact(out, backend | Xapian::DBCOMPACT_NO_RENUMBER);
+	Xapian::Database cdb(out);
+	TEST_EQUAL(cdb.get_doccount(), 17);
+	TEST_EQUAL(cdb.get_termfreq("all"), 17);
+	TEST_EQUAL(cdb.get_termfreq("even"), 8);
+	TEST_EQUAL(cdb.get_collection_freq("even"), 16);
+	TEST_EQUAL(cdb.get_termfreq("odd"), 8);
+	TEST(!cdb.term_exists("n1"));
+	TEST(!cdb.term_exists("n2"));
+	TEST(!cdb.term_exists("n10"));
+	check_postings(cdb, "even", {4, 6, 8, 12, 14, 16, 18, 20});
+	TEST_EXCEPTION(Xapian::DocNotFoundError, cdb.termlist_begin(2));
+	TEST_EQUAL(cdb.positionlist_begin(2, "all"),
+		   cdb.positionlist_end(2, "all"));
+	TEST_EQUAL(Xapian::Database::check(out), 0);
+	if (backend == Xapian::DB_BACKEND_GLASS)
+	    TEST_EQUAL(glass_format_version(out), old_format);
+    }
+
+    // Once no tombstones are left, the old format version should be used.
+    db.replace_document(1, doc);
+    db.replace_document(2, doc);
+    db.replace_document(10, doc);
+    db.commit();
+    TEST_EQUAL(glass_format_version(path), old_format);
+    TEST_EQUAL(Xapian::Database::check(path), 0);
+}
+
+/// Check WritableDatabase::set_document_value().
+DEFINE_TESTCASE(setdocumentvalue1, writable) {
+    Xapian::WritableDatabase db = get_writable_database();
+    map<Xapian::docid, string> vals;
+    for (Xapian::docid did = 1; did <= 20; ++did) {
+	Xapian::Document doc;
+	doc.add_term("t" + str(did % 3));
+	doc.set_data("data" + str(did));
+	if (did % 2) {
+	    doc.add_value(1, "val" + str(did));
+	    vals[did] = "val" + str(did);
+	} else {
+	    vals[did] = string();
+	}
+	doc.add_value(5, "other");
+	db.add_document(doc);
+    }
+    db.commit();
+
+    TEST_EXCEPTION(Xapian::InvalidArgumentError,
+		   db.set_document_value(0, 1, "x"));
+    TEST_EXCEPTION(Xapian::DocNotFoundError,
+		   db.set_document_value(21, 1, "x"));
+
+    // Change a value, add one and remove one.
+    db.set_document_value(3, 1, "new3");
+    vals[3] = "new3";
+    db.set_document_value(4, 1, "new4");
+    vals[4] = "new4";
+    db.set_document_value(5, 1, string());
+    vals[5] = string();
+    // Setting a slot which isn't set to empty shouldn't do anything.
+    db.set_document_value(6, 1, string());
+
+    // Check the changes are visible before they're committed.
+    for (int pass = 0; pass != 2; ++pass) {
+	for (auto&& i : vals) {
+	    Xapian::Document doc = db.get_document(i.first);
+	    TEST_EQUAL(doc.get_value(1), i.second);
+	    TEST_EQUAL(doc.values_count(), i.second.empty() ? 1 : 2);
+	    TEST_EQUAL(doc.get_value(5), "other");
+	    TEST_EQUAL(doc.get_data(), "data" + str(i.first));
+	    TEST_EQUAL(doc.termlist_count(), 1);
+	}
+	TEST_EQUAL(db.get_value_freq(1), 10);
+	TEST_EQUAL(db.get_value_lower_bound(1), "new3");
+	TEST_EQUAL(db.get_value_freq(5), 20);
+
+	Xapian::ValueIterator v = db.valuestream_begin(1);
+	for (auto&& i : vals) {
+	    if (i.second.empty()) continue;
+	    TEST(v != db.valuestream_end(1));
+	    TEST_EQUAL(v.get_docid(), i.first);
+	    TEST_EQUAL(*v, i.second);
+	    ++v;
+	}
+	TEST(v == db.valuestream_end(1));
+
+	db.commit();
+    }
+
+    // Replacing with a Document whose values were modified after reading
+    // them should restore the value it read.
+    Xapian::Document doc = db.get_document(7);
+    doc.add_value(2, "two");
+    db.set_document_value(7, 1, "new7");
+    TEST_EQUAL(db.get_document(7).get_value(1), "new7");
+    db.replace_document(7, doc);
+    TEST_EQUAL(db.get_document(7).get_value(1), "val7");
+    TEST_EQUAL(db.get_document(7).get_value(2), "two");
+    db.set_document_value(7, 1, "new7");
+    db.set_document_value(7, 2, string());
+
+    // Removing the last value in a slot should reset its bounds.
+    db.set_document_value(1, 5, "a");
+    db.set_document_value(20, 5, "z");
+    TEST_EQUAL(db.get_value_lower_bound(5), "a");
+    TEST_EQUAL(db.get_value_upper_bound(5), "z");
+    for (Xapian::docid did = 1; did <= 20; ++did) {
+	db.set_document_value(did, 5, string());
+    }
+    db.commit();
+    TEST_EQUAL(db.get_value_freq(5), 0);
+    TEST_EQUAL(db.get_value_lower_bound(5), string());
+    TEST_EQUAL(db.get_value_upper_bound(5), string());
+    TEST(db.valuestream_begin(5) == db.valuestream_end(5));
+    vals[7] = "new7";
+    check_vals(db, vals);
+}
+
+/// Check the DB_COMPRESS_LZ4 and DB_COMPRESS_ZSTD flags.
+DEFINE_TESTCASE(compressors1, glass) {
+    // Something compressible which is big enough to be split into several
+    // items.
+    string big;
+    for (int i = 0; i != 5000; ++i) {
+	big += "chunk ";
+	big += str(i % 37);
+    }
+    string zlibpath = get_named_writable_database_path("compressors1zlib");
+    {
+	Xapian::WritableDatabase db(zlibpath,
+				    Xapian::DB_CREATE_OR_OVERWRITE |
+				    Xapian::DB_BACKEND_GLASS);
+	Xapian::Document doc;
+	doc.set_data("zlib " + big);
+	doc.add_term("zlib");
+	db.add_document(doc);
+	db.commit();
+    }
+
+    const int compressors[] = {
+	Xapian::DB_COMPRESS_LZ4, Xapian::DB_COMPRESS_ZSTD
+    };
+    for (int compressor : compressors) {
+	string path = get_named_writable_database_path("compressors1");
+	Xapian::WritableDatabase db;
+	try {
+	    db = Xapian::WritableDatabase(path,
+					  Xapian::DB_CREATE_OR_OVERWRITE |
+					  Xapian::DB_BACKEND_GLASS |
+					  compressor);
+	} catch (const Xapian::FeatureUnavailableError&) {
+	    tout << "Compressor " << compressor << " not available\n";
+	    continue;
+	}
+	for (Xapian::docid did = 1; did <= 10; ++did) {
+	    Xapian::Document doc;
+	    doc.set_data(str(did) + big);
+	    doc.add_term("all");
+	    doc.add_term("n" + str(did));
+	    db.add_document(doc);
+	}
+	db.add_spelling("compression");
+	db.add_synonym("squash", "compress");
+	db.commit();
+	db.close();
+
+	Xapian::Database reader(path);
+	TEST_EQUAL(reader.get_doccount(), 10);
+	TEST_EQUAL(reader.get_document(7).get_data(), "7" + big);
+	TEST_EQUAL(reader.get_spelling_suggestion("compresion"), "compression");
+	TEST_EQUAL(*reader.synonyms_begin("squash"), "compress");
+	TEST_STRINGS_EQUAL(docterms_to_string(reader, 3),
+			   "Term(all, wdf=1), Term(n3, wdf=1)");
+	TEST_EQUAL(Xapian::Database::check(path), 0);
+
+	// Compacting should keep the data intact, including when the inputs
+	// use different compressors.
+	reader.add_database(Xapian::Database(zlibpath));
+	const int backends[] = {
+	    Xapian::DB_BACKEND_GLASS, Xapian::DB_BACKEND_HONEY
+	};
+	for (int backend : backends) {
+	    string out = get_compaction_output_path("compressors1out");
+	    rm_rf(out);
+	    reader.compact(out, backend);
+	    Xapian::Database cdb(out);
+	    TEST_EQUAL(cdb.get_doccount(), 11);
+	    TEST_EQUAL(cdb.get_document(10).get_data(), "10" + big);
+	    TEST_EQUAL(cdb.get_document(11).get_data(), "zlib " + big);
+	    TEST_EQUAL(cdb.get_spelling_suggestion("compresion"),
+		       "compression");
+	    TEST_EQUAL(*cdb.synonyms_begin("squash"), "compress");
+	    TEST_EQUAL(Xapian::Database::check(out), 0);
+	}
+    }
+
+    // Only one compressor can be specified.
+    string path = get_named_writable_database_path("compressors1");
+    TEST_EXCEPTION(Xapian::InvalidArgumentError,
+		   Xapian::WritableDatabase(path,
+					    Xapian::DB_CREATE_OR_OVERWRITE |
+					    Xapian::DB_BACKEND_GLASS |
+					    Xapian::DB_COMPRESS_LZ4 |
+					    Xapian::DB_COMPRESS_ZSTD));
+}
+
+static void
+check_doclengths(const Xapian::Database& db,
+		 const map<Xapian::docid, Xapian::termcount>& doclens)
+{
+    Xapian::docid last = db.get_lastdocid() + 2;
+    for (Xapian::docid did = 1; did <= last; ++did) {
+	auto i = doclens.find(did);
+	if (i == doclens.end()) {
+	    TEST_EXCEPTION(Xapian::DocNotFoundError, db.get_doclength(did));
+	} else {
+	    TEST_EQUAL(db.get_doclength(did), i->second);
+	}
+    }
+}
+
+/// Check the DB_DOCLEN_COLUMN and DBCOMPACT_DOCLEN_COLUMN flags.
+DEFINE_TESTCASE(doclencolumn1, glass) {
+    TwinDatabases twin("doclencolumn1", Xapian::DB_DOCLEN_COLUMN);
+    map<Xapian::docid, Xapian::termcount> doclens;
+    // Weights should be the same as without the column.
+    Xapian::Query query(Xapian::Query::OP_OR,
+			Xapian::Query("all"), Xapian::Query("odd"));
+    auto check = [&](const Xapian::Database& d, const Xapian::Database& p) {
+	check_doclengths(d, doclens);
+	check_same_matches(d, p, query);
+    };
+
+    // Enough documents to need several chunks, with lengths needing entries
+    // of each width, and some empty documents.
+    for (Xapian::docid did = 1; did <= 5000; ++did) {
+	Xapian::Document doc;
+	Xapian::termcount doclen = 0;
+	if (did % 7 != 0) {
+	    doclen = did % 10 + 1;
+	    if (did % 1000 == 1) doclen += 300;
+	    if (did == 4321) doclen += 70000;
+	    if (did == 4322) doclen += 20000000;
+	    doc.add_term("all", doclen);
+	    if (did % 2) doc.add_term("odd");
+	    if (did % 2) ++doclen;
+	}
+	twin.add_document(doc);
+	doclens[did] = doclen;
+    }
+    twin.commit(check);
+
+    // Delete and replace documents, and add a document after a gap.
+    for (Xapian::docid did = 100; did <= 4200; did += 3) {
+	twin.delete_document(did);
+	doclens.erase(did);
+    }
+    for (Xapian::docid did = 2048; did <= 2200; did += 2) {
+	Xapian::Document doc;
+	doc.add_term("all", 3);
+	doc.add_term("odd");
+	twin.replace_document(did, doc);
+	doclens[did] = 4;
+    }
+    {
+	Xapian::Document doc;
+	doc.add_term("all");
+	twin.replace_document(9000, doc);
+	doclens[9000] = 1;
+    }
+    twin.commit(check);
+
+    // The column should be kept up to date without the flag too.
+    twin.reopen_without_flag();
+    for (Xapian::docid did = 1; did <= 2100; did += (did == 1 ? 2000 : 1)) {
+	if (doclens.erase(did)) twin.delete_document(did);
+    }
+    twin.commit(check);
+
+    twin.check_compactions(Xapian::DBCOMPACT_DOCLEN_COLUMN, check);
+}
+
+/// Check the DB_TERM_BITMAPS and DBCOMPACT_TERM_BITMAPS flags.
+DEFINE_TESTCASE(termbitmaps1, glass) {
+    TwinDatabases twin("termbitmaps1", Xapian::DB_TERM_BITMAPS);
+    auto make_doc = [](Xapian::docid did) {
+	Xapian::Document doc;
+	if (did % 7) doc.add_term("text", did % 4 + 1);
+	if (did % 2 == 0) doc.add_term("even");
+	if (did % 3 == 0) doc.add_term("three");
+	if (did % 5 == 0) doc.add_term("five");
+	if (did % 10 == 0) doc.add_term("ten");
+	if (did % 100 == 0) doc.add_term("rare");
+	if (did <= 2000) doc.add_term("low");
+	return doc;
+    };
+
+    Xapian::Query text("text"), even("even"), three("three"), five("five");
+    Xapian::Query ten("ten"), sparse("rare"), low("low");
+    vector<Xapian::Query> filters = {
+	even,
+	Xapian::Query(Xapian::Query::OP_AND, even, three),
+	Xapian::Query(Xapian::Query::OP_OR, five, three),
+	Xapian::Query(Xapian::Query::OP_AND, low,
+		      Xapian::Query(Xapian::Query::OP_OR, even, five)),
+	Xapian::Query(Xapian::Query::OP_AND_NOT, even,
+		      Xapian::Query(Xapian::Query::OP_OR, three, ten)),
+	Xapian::Query(Xapian::Query::OP_AND, even, sparse),
+	Xapian::Query(Xapian::Query::OP_OR, sparse, ten),
+    };
+    // While lazily deleted documents are still counted in the frequencies,
+    // only the documents matching can be compared.
+    bool same_stats = true;
+    auto check = [&](const Xapian::Database& d, const Xapian::Database& p) {
+	for (auto& filter : filters) {
+	    check_same_matches(d, p, Xapian::Query(Xapian::Query::OP_FILTER,
+						   text, filter),
+			       same_stats);
+	    check_same_matches(d, p, Xapian::Query(Xapian::Query::OP_SCALE_WEIGHT,
+						   filter, 0.0));
+	}
+	// Weighted terms don't use the bitmaps.
+	check_same_matches(d, p, Xapian::Query(Xapian::Query::OP_OR,
+					       even, three),
+			   same_stats);
+
+	// The documents each bitmap gives should be exactly those in the
+	// term's posting list, so deleted and tombstoned documents mustn't
+	// be left in it.
+	for (const char* term : { "even", "three", "five", "ten", "rare" }) {
+	    Xapian::Enquire enq(d);
+	    enq.set_query(Xapian::Query(Xapian::Query::OP_SCALE_WEIGHT,
+					Xapian::Query(term), 0.0));
+	    Xapian::MSet mset = enq.get_mset(0, d.get_doccount());
+	    vector<Xapian::docid> dids(mset.begin(), mset.end());
+	    vector<Xapian::docid> plain_dids(p.postlist_begin(term),
+					     p.postlist_end(term));
+	    TEST_EQUAL(dids, plain_dids);
+	}
+    };
+    // Once committed, the number of documents in an intersection of bitmaps
+    // is known exactly.
+    auto check_exact_count = [&](const Xapian::Database& d) {
+	Xapian::Enquire enq(d);
+	enq.set_query(Xapian::Query(Xapian::Query::OP_SCALE_WEIGHT,
+				    filters[1], 0.0));
+	Xapian::MSet mset = enq.get_mset(0, 0);
+	TEST_EQUAL(mset.get_matches_lower_bound(),
+		   mset.get_matches_upper_bound());
+	Xapian::Enquire plain_enq(twin.plain);
+	plain_enq.set_query(filters[1]);
+	TEST_EQUAL(mset.get_matches_lower_bound(),
+		   plain_enq.get_mset(0, twin.plain.get_doccount()).size());
+    };
+
+    // Documents in a second container of each bitmap too.
+    for (Xapian::docid did = 1; did <= 3000; ++did) {
+	twin.replace_document(did, make_doc(did));
+    }
+    for (Xapian::docid did = 70000; did <= 70600; ++did) {
+	twin.replace_document(did, make_doc(did));
+    }
+    twin.commit(check);
+    check_exact_count(Xapian::Database(twin.get_path()));
+
+    // Delete and replace documents, so "ten" loses its bitmap and "rare"
+    // gains one.
+    for (Xapian::docid did = 10; did <= 3000; did += 10) {
+	if (did % 50 == 0) continue;
+	twin.delete_document(did);
+    }
+    for (Xapian::docid did = 1000; did <= 1600; ++did) {
+	if (did % 10 == 0) continue;
+	Xapian::Document doc = make_doc(did);
+	if (did % 2 == 0) doc.remove_term("even");
+	doc.add_term("rare");
+	twin.replace_document(did, doc);
+    }
+    twin.commit(check);
+    check_exact_count(Xapian::Database(twin.get_path()));
+
+    // The bitmaps should be kept up to date without the flag too, including
+    // when documents are deleted lazily.
+    twin.reopen_without_flag(Xapian::DB_LAZY_DELETE);
+    for (Xapian::docid did = 3; did <= 70600; did += (did < 3000 ? 9 : 97)) {
+	twin.delete_document(did);
+    }
+    same_stats = false;
+    twin.commit(check);
+    // Tombstoned documents should be left out of the count.
+    check_exact_count(Xapian::Database(twin.get_path()));
+
+    // Compacting drops the tombstoned documents, so the statistics match
+    // again.
+    same_stats = true;
+    twin.check_compactions(Xapian::DBCOMPACT_TERM_BITMAPS, check);
+}
+
+/// Check the positions of every term in every document match.
+static void
+check_same_positions(const Xapian::Database& db,
+		     const Xapian::Database& plain,
+		     Xapian::docid offset = 0)
+{
+    for (Xapian::docid did = 1; did <= plain.get_lastdocid(); ++did) {
+	for (auto t = plain.termlist_begin(did); t != plain.termlist_end(did);
+	     ++t) {
+	    const string& term = *t;
+	    vector<Xapian::termpos> pos, plain_pos;
+	    for (auto p = db.positionlist_begin(did + offset, term);
+		 p != db.positionlist_end(did + offset, term); ++p) {
+		pos.push_back(*p);
+	    }
+	    for (auto p = t.positionlist_begin(); p != t.positionlist_end();
+		 ++p) {
+		plain_pos.push_back(*p);
+	    }
+	    TEST(pos == plain_pos);
+	    auto db_t = db.termlist_begin(did + offset);
+	    db_t.skip_to(term);
+	    TEST_EQUAL(db_t.positionlist_count(), t.positionlist_count());
+	    if (plain_pos.empty()) continue;
+
+	    // Check skip_to() to positions either side of each block
+	    // boundary and gap.
+	    for (size_t i = 0; i < plain_pos.size(); i += 61) {
+		for (Xapian::termpos target : { plain_pos[i] - 1,
+						plain_pos[i],
+						plain_pos[i] + 1 }) {
+		    auto expect = lower_bound(plain_pos.begin(),
+					      plain_pos.end(), target);
+		    auto p = db.positionlist_begin(did + offset, term);
+		    p.skip_to(target);
+		    if (expect == plain_pos.end()) {
+			TEST(p == db.positionlist_end(did + offset, term));
+		    } else {
+			TEST(p != db.positionlist_end(did + offset, term));
+			TEST_EQUAL(*p, *expect);
+			// Check we can carry on from there.
+			++p;
+			if (++expect == plain_pos.end()) {
+			    TEST(p == db.positionlist_end(did + offset, term));
+			} else {
+			    TEST_EQUAL(*p, *expect);
+			}
+		    }
+		}
+	    }
+	}
+    }
+}
+
+/// Check the DB_PACKED_POSITIONS and DBCOMPACT_PACKED_POSITIONS flags.
+DEFINE_TESTCASE(packedpositions1, glass) {
+    TwinDatabases twin("packedpositions1", Xapian::DB_PACKED_POSITIONS);
+    const char* aba[] = { "a", "b", "a" };
+    const char* cd[] = { "c", "d" };
+    vector<Xapian::Query> queries = {
+	Xapian::Query(Xapian::Query::OP_PHRASE, aba, aba + 2),
+	Xapian::Query(Xapian::Query::OP_PHRASE, aba + 1, aba + 3),
+	Xapian::Query(Xapian::Query::OP_NEAR, aba, aba + 2, 3),
+	Xapian::Query(Xapian::Query::OP_NEAR, cd, cd + 2, 10),
+	Xapian::Query(Xapian::Query::OP_PHRASE, aba, aba + 3, 12),
+    };
+    auto check = [&](const Xapian::Database& d, const Xapian::Database& p) {
+	for (auto& query : queries) {
+	    check_same_matches(d, p, query);
+	}
+	check_same_positions(d, p);
+    };
+
+    for (Xapian::docid did = 1; did <= 100; ++did) {
+	Xapian::Document doc;
+	// Some lists span several blocks, and some blocks have large gaps
+	// so need wider deltas.
+	Xapian::termpos pos = did;
+	for (unsigned k = 0; k <= (did % 5) * 100; ++k) {
+	    doc.add_posting("a", pos);
+	    if (k % 3 == 0) doc.add_posting("b", pos + 1);
+	    pos += 2 + (k * k + did) % 13;
+	    if (k % 97 == 96) pos += 100000 * did;
+	}
+	doc.add_posting("c", did);
+	doc.add_posting("d", 7);
+	doc.add_posting("d", 7 + did);
+	doc.add_term("text");
+	twin.replace_document(did, doc);
+    }
+    twin.commit(check);
+
+    // Lists whose stored deltas need exactly each bit width, or one bit
+    // more, with the widest delta either in the first block (so the width
+    // changes between blocks) or alone in a final partial block.
+    for (unsigned width = 0; width != 32; ++width) {
+	Xapian::Document doc;
+	Xapian::termpos widest = (Xapian::termpos(1) << width) - 1;
+	for (Xapian::termpos delta : { widest, widest + 1 }) {
+	    for (unsigned at : { 100, 128 }) {
+		string term = "w" + str(width) + "_" + str(delta - widest) +
+			      "_" + str(at);
+		Xapian::termpos pos = 1;
+		for (unsigned k = 0; k != 130; ++k) {
+		    doc.add_posting(term, pos);
+		    pos += (k == at ? delta : 0) + 1;
+		}
+	    }
+	}
+	twin.replace_document(101 + width, doc);
+    }
+    twin.commit(check);
+
+    // New lists should still be packed without the flag.
+    twin.reopen_without_flag();
+    for (Xapian::docid did = 1; did <= 20; ++did) {
+	Xapian::Document doc;
+	for (Xapian::termpos pos = did; pos <= 1000; pos += did) {
+	    doc.add_posting("a", pos);
+	    doc.add_posting("b", pos + 1);
+	}
+	twin.replace_document(did, doc);
+    }
+    twin.commit(check);
+
+    // Shards using different encodings should work together.
+    {
+	Xapian::Database mixed, same;
+	mixed.add_database(twin.plain);
+	mixed.add_database(twin.db);
+	same.add_database(twin.plain);
+	same.add_database(twin.plain);
+	check(mixed, same);
+    }
+
+    // Compacting should keep the encoding, and should switch to it with
+    // DBCOMPACT_PACKED_POSITIONS.
+    twin.check_compactions(Xapian::DBCOMPACT_PACKED_POSITIONS, check);
+    string out = get_compaction_output_path("packedpositions1out");
+    rm_rf(out);
+    twin.plain.compact(out, Xapian::DB_BACKEND_HONEY |
+			    Xapian::DBCOMPACT_PACKED_POSITIONS);
+    check(Xapian::Database(out), twin.plain);
+    TEST_EQUAL(Xapian::Database::check(out), 0);
+
+    // Merging with a database which doesn't use the same encoding should
+    // convert its position lists.
+    for (int backend : { Xapian::DB_BACKEND_GLASS, Xapian::DB_BACKEND_HONEY }) {
+	Xapian::Database both;
+	both.add_database(twin.plain);
+	both.add_database(twin.db);
+	rm_rf(out);
+	both.compact(out, backend);
+	Xapian::Database out_db(out);
+	check_same_positions(out_db, twin.plain);
+	check_same_positions(out_db, twin.plain, twin.plain.get_lastdocid());
+	TEST_EQUAL(Xapian::Database::check(out), 0);
+    }
+}
+
+/// Check DBCOMPACT_IMPACT_ORDERED and Enquire::set_score_at_a_time().
+DEFINE_TESTCASE(impactordered1, glass) {
+    string path = get_named_writable_database_path("impactordered1");
+    Xapian::WritableDatabase db(path,
+				Xapian::DB_CREATE_OR_OVERWRITE |
+				Xapian::DB_BACKEND_GLASS);
+    for (Xapian::docid did = 1; did <= 2000; ++did) {
+	Xapian::Document doc;
+	if (did % 2) doc.add_term("a", did % 5 + 1);
+	if (did % 3 == 0) doc.add_term("b", did % 3 + 1);
+	if (did % 7 == 0) doc.add_term("c");
+	if (did % 250 == 0) doc.add_term("rare", 3);
+	doc.add_term("pad", did % 50 + 1);
+	db.replace_document(did, doc);
+    }
+    db.commit();
+    unsigned old_format = glass_format_version(path);
+
+    string out = get_compaction_output_path("impactordered1out");
+    rm_rf(out);
+    db.compact(out, Xapian::DB_BACKEND_GLASS |
+		    Xapian::DBCOMPACT_IMPACT_ORDERED |
+		    Xapian::DBCOMPACT_NO_RENUMBER);
+    TEST_EQUAL(Xapian::Database::check(out), 0);
+    // Older versions mustn't open a database with impact lists.
+    TEST_NOT_EQUAL(glass_format_version(out), old_format);
+
+    Xapian::Query a("a"), b("b"), c("c"), sparse("rare");
+    const Xapian::Query abcr[] = { a, b, c, sparse };
+    vector<Xapian::Query> queries = {
+	a,
+	Xapian::Query(Xapian::Query::OP_OR, a, b),
+	Xapian::Query(Xapian::Query::OP_OR, abcr, abcr + 4),
+	Xapian::Query(Xapian::Query::OP_OR, sparse, Xapian::Query("missing")),
+    };
+
+    Xapian::Database out_db(out);
+    Xapian::Enquire enq(out_db);
+    Xapian::Enquire saat(out_db);
+    saat.set_score_at_a_time(true);
+    for (auto& query : queries) {
+	enq.set_query(query);
+	saat.set_query(query);
+	Xapian::MSet mset = enq.get_mset(0, 2000);
+	Xapian::MSet saat_mset = saat.get_mset(0, 2000);
+	TEST_EQUAL(saat_mset.size(), mset.size());
+	TEST_EQUAL(saat_mset.get_matches_lower_bound(), mset.size());
+	TEST_EQUAL(saat_mset.get_matches_estimated(), mset.size());
+	TEST_EQUAL(saat_mset.get_matches_upper_bound(), mset.size());
+	if (mset.empty()) continue;
+	// Each term's weight is quantised to 255 levels.
+	double tolerance = mset.get_max_possible() / 255.0;
+	map<Xapian::docid, double> weights;
+	for (auto i = mset.begin(); i != mset.end(); ++i) {
+	    weights[*i] = i.get_weight();
+	}
+	double prev = saat_mset.begin().get_weight();
+	for (auto i = saat_mset.begin(); i != saat_mset.end(); ++i) {
+	    TEST(weights.count(*i));
+	    TEST_REL(fabs(i.get_weight() - weights[*i]), <=, tolerance);
+	    TEST_REL(i.get_weight(), <=, prev);
+	    TEST_REL(i.get_weight(), <=, saat_mset.get_max_possible());
+	    prev = i.get_weight();
+	}
+	TEST_EQUAL(saat_mset.begin().get_percent(), mset.begin().get_percent());
+
+	// Check a later page matches the same part of the full results.
+	Xapian::MSet page = saat.get_mset(5, 10);
+	TEST_EQUAL(page.size(), min(mset.size() - 5, 10u));
+	for (Xapian::doccount j = 0; j != page.size(); ++j) {
+	    TEST_EQUAL(*page[j], *saat_mset[j + 5]);
+	}
+
+	// With a budget the match should stop early, but the documents found
+	// should be real matches with the bounds still holding.
+	Xapian::Enquire limited(out_db);
+	limited.set_score_at_a_time(true, 100);
+	limited.set_query(query);
+	Xapian::MSet lmset = limited.get_mset(0, 2000);
+	TEST_REL(lmset.size(), <=, 100);
+	TEST_REL(lmset.get_matches_lower_bound(), <=, mset.size());
+	TEST_REL(lmset.get_matches_upper_bound(), >=, mset.size());
+	for (auto i = lmset.begin(); i != lmset.end(); ++i) {
+	    TEST(weights.count(*i));
+	}
+	if (mset.size() > 100) {
+	    TEST_REL(lmset.size(), <, mset.size());
+	}
+    }
+
+    // Queries and weighting schemes the impacts can't handle should be run
+    // as normal.
+    auto check_fallback = [&](const Xapian::Database& d) {
+	Xapian::Enquire e1(d), e2(d);
+	e2.set_score_at_a_time(true, 10);
+	e1.set_query(Xapian::Query(Xapian::Query::OP_AND, a, b));
+	e2.set_query(Xapian::Query(Xapian::Query::OP_AND, a, b));
+	TEST_EQUAL(e2.get_mset(0, 2000), e1.get_mset(0, 2000));
+	e1.set_query(queries[2]);
+	e2.set_query(queries[2]);
+	e1.set_weighting_scheme(Xapian::BM25Weight(2, 0, 1, 0.5, 0.5));
+	e2.set_weighting_scheme(Xapian::BM25Weight(2, 0, 1, 0.5, 0.5));
+	TEST_EQUAL(e2.get_mset(0, 2000), e1.get_mset(0, 2000));
+	e1.set_weighting_scheme(Xapian::BM25Weight());
+	e2.set_weighting_scheme(Xapian::BM25Weight());
+	e1.set_query(queries[1]);
+	e2.set_query(queries[1]);
+	return make_pair(e2.get_mset(0, 2000), e1.get_mset(0, 2000));
+    };
+    auto res = check_fallback(out_db);
+    // This one should have used the impacts.
+    TEST_REL(res.first.size(), <, res.second.size());
+
+    // Modifying the database should make the impact lists stale, so they're
+    // no longer used.
+    {
+	Xapian::WritableDatabase wdb(out, Xapian::DB_BACKEND_GLASS);
+	Xapian::Document doc;
+	doc.add_term("a");
+	wdb.add_document(doc);
+	wdb.commit();
+	// Further changes shouldn't need to touch them again.
+	wdb.add_document(doc);
+	wdb.commit();
+    }
+    TEST_EQUAL(Xapian::Database::check(out), 0);
+    TEST_EQUAL(glass_format_version(out), old_format);
+    res = check_fallback(Xapian::Database(out));
+    TEST_EQUAL(res.first, res.second);
+
+    // Compacting again should rebuild them.
+    string out2 = get_compaction_output_path("impactordered1out2");
+    rm_rf(out2);
+    Xapian::Database(out).compact(out2, Xapian::DB_BACKEND_GLASS |
+					Xapian::DBCOMPACT_NO_RENUMBER);
+    TEST_EQUAL(Xapian::Database::check(out2), 0);
+    TEST_NOT_EQUAL(glass_format_version(out2), old_format);
+    res = check_fallback(Xapian::Database(out2));
+    TEST_REL(res.first.size(), <, res.second.size());
+}
+
+/// Check the DB_TERM_FILTER and DBCOMPACT_TERM_FILTER flags.
+DEFINE_TESTCASE(termfilter1, glass) {
+    TwinDatabases twin("termfilter1", Xapian::DB_TERM_FILTER);
+    auto add_docs = [&](Xapian::docid first, Xapian::docid last) {
+	for (Xapian::docid did = first; did <= last; ++did) {
+	    Xapian::Document doc;
+	    doc.add_term("id" + str(did));
+	    doc.add_term("common", did % 3 + 1);
+	    if (did % 10 == 0) doc.add_term(string("\0zero", 5) + str(did));
+	    twin.replace_document(did, doc);
+	}
+    };
+    // Check terms which are and aren't present give the same results as a
+    // database without a filter.
+    Xapian::docid last = 1000;
+    auto check = [&](const Xapian::Database& d, const Xapian::Database& p) {
+	for (Xapian::docid did = 1; did <= last; ++did) {
+	    string term = "id" + str(did);
+	    TEST_EQUAL(d.term_exists(term), p.term_exists(term));
+	    TEST_EQUAL(d.get_termfreq(term), p.get_termfreq(term));
+	    TEST_EQUAL(d.get_collection_freq(term),
+		       p.get_collection_freq(term));
+	    term.assign("\0zero", 5);
+	    term += str(did);
+	    TEST_EQUAL(d.term_exists(term), p.term_exists(term));
+	}
+	for (Xapian::docid did = 1; did <= last; did += 37) {
+	    Xapian::Query q(Xapian::Query::OP_OR,
+			    Xapian::Query("id" + str(did)),
+			    Xapian::Query("id" + str(did * 7)));
+	    check_same_matches(d, p, q);
+	    Xapian::Query common("common");
+	    check_same_matches(d, p, Xapian::Query(Xapian::Query::OP_AND,
+						   q, common));
+	}
+    };
+
+    add_docs(1, 200);
+    twin.commit(check);
+
+    // New terms should be found, including enough to make the filter get
+    // rebuilt larger.
+    last = 1200;
+    add_docs(201, 1000);
+    twin.commit(check);
+
+    // Deleted terms may still be in the filter, but mustn't be reported as
+    // present.
+    for (Xapian::docid did = 5; did <= 1000; did += 5) {
+	twin.delete_document(did);
+    }
+    twin.commit(check);
+
+    // The filter should be kept up to date without the flag being given.
+    twin.reopen_without_flag();
+    add_docs(1001, 1100);
+    twin.commit(check);
+
+    twin.check_compactions(Xapian::DBCOMPACT_TERM_FILTER, check);
+}
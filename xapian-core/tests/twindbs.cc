@@ -0,0 +1,145 @@
+/** @file twindbs.cc
+ * @brief Test an optional glass feature against a database without it.
+ */
+/* Copyright (C) 2026 Xapian contributors
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301 USA
+ */
+
+#include <config.h>
+
+#include "twindbs.h"
+
+#include "apitest.h"
+#include "filetests.h"
+#include "testsuite.h"
+#include "testutils.h"
+#include "unixcmds.h"
+
+#include <fstream>
+
+using namespace std;
+
+unsigned
+glass_format_version(const string& path)
+{
+    ifstream in(path + "/iamglass", fstream::binary);
+    char buf[16];
+    in.read(buf, sizeof(buf));
+    TEST_EQUAL(in.gcount(), 16);
+    return unsigned(static_cast<unsigned char>(buf[14])) << 8 |
+	   static_cast<unsigned char>(buf[15]);
+}
+
+void
+check_same_matches(const Xapian::Database& db, const Xapian::Database& plain,
+		   const Xapian::Query& query, bool same_stats)
+{
+    Xapian::Enquire enq(db), plain_enq(plain);
+    enq.set_query(query);
+    plain_enq.set_query(query);
+    if (!same_stats) {
+	enq.set_weighting_scheme(Xapian::BoolWeight());
+	plain_enq.set_weighting_scheme(Xapian::BoolWeight());
+    }
+    Xapian::MSet mset = enq.get_mset(0, 100000);
+    Xapian::MSet plain_mset = plain_enq.get_mset(0, 100000);
+    tout << query.get_description() << '\n';
+    TEST_EQUAL(mset.size(), plain_mset.size());
+    for (Xapian::doccount i = 0; i != mset.size(); ++i) {
+	TEST_EQUAL(*mset[i], *plain_mset[i]);
+	TEST_EQUAL_DOUBLE(mset[i].get_weight(), plain_mset[i].get_weight());
+    }
+}
+
+TwinDatabases::TwinDatabases(const string& name_, int flag)
+    : path(get_named_writable_database_path(name_)),
+      plain_path(get_named_writable_database_path(name_ + "plain")),
+      name(name_),
+      db(path,
+	 Xapian::DB_CREATE_OR_OVERWRITE | Xapian::DB_BACKEND_GLASS | flag),
+      plain(plain_path,
+	    Xapian::DB_CREATE_OR_OVERWRITE | Xapian::DB_BACKEND_GLASS)
+{
+}
+
+void
+TwinDatabases::add_document(const Xapian::Document& doc)
+{
+    TEST_EQUAL(db.add_document(doc), plain.add_document(doc));
+}
+
+void
+TwinDatabases::replace_document(Xapian::docid did, const Xapian::Document& doc)
+{
+    db.replace_document(did, doc);
+    plain.replace_document(did, doc);
+}
+
+bool
+TwinDatabases::delete_document(Xapian::docid did)
+{
+    try {
+	plain.delete_document(did);
+    } catch (const Xapian::DocNotFoundError&) {
+	return false;
+    }
+    db.delete_document(did);
+    return true;
+}
+
+void
+TwinDatabases::commit(const Checker& check)
+{
+    // Changes not yet committed should be visible.
+    check(db, plain);
+    db.commit();
+    plain.commit();
+    check(db, plain);
+    check(Xapian::Database(path), Xapian::Database(plain_path));
+    TEST_EQUAL(Xapian::Database::check(path), 0);
+    // Older versions mustn't open a database with the feature.
+    TEST_NOT_EQUAL(glass_format_version(path),
+		   glass_format_version(plain_path));
+}
+
+void
+TwinDatabases::reopen_without_flag(int flags)
+{
+    db.close();
+    db = Xapian::WritableDatabase(path, Xapian::DB_BACKEND_GLASS | flags);
+}
+
+void
+TwinDatabases::check_compactions(int compact_flag, const Checker& check)
+{
+    struct { Xapian::Database src; int flags; } compactions[] = {
+	{ db, Xapian::DB_BACKEND_GLASS },
+	{ db, Xapian::DB_BACKEND_GLASS | Xapian::DBCOMPACT_SINGLE_FILE },
+	{ db, Xapian::DB_BACKEND_HONEY },
+	{ plain, Xapian::DB_BACKEND_GLASS | compact_flag },
+    };
+    string out = get_compaction_output_path(name + "out");
+    for (auto& c : compactions) {
+	rm_rf(out);
+	c.src.compact(out, c.flags | Xapian::DBCOMPACT_NO_RENUMBER);
+	check(Xapian::Database(out), plain);
+	TEST_EQUAL(Xapian::Database::check(out), 0);
+	if (file_exists(out + "/iamglass")) {
+	    TEST_NOT_EQUAL(glass_format_version(out),
+			   glass_format_version(plain_path));
+	}
+    }
+}
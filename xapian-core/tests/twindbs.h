@@ -0,0 +1,118 @@
+/** @file twindbs.h
+ * @brief Test an optional glass feature against a database without it.
+ */
+/* Copyright (C) 2026 Xapian contributors
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301 USA
+ */
+
+#ifndef XAPIAN_INCLUDED_TWINDBS_H
+#define XAPIAN_INCLUDED_TWINDBS_H
+
+#include <xapian.h>
+
+#include <functional>
+#include <string>
+
+/// Return the format version in the version file of glass database @a path.
+unsigned glass_format_version(const std::string& path);
+
+/** Check that @a db and @a plain give the same results for @a query.
+ *
+ *  If @a same_stats is false, the weights aren't comparable so only check
+ *  that the same documents match.
+ */
+void check_same_matches(const Xapian::Database& db,
+			const Xapian::Database& plain,
+			const Xapian::Query& query,
+			bool same_stats = true);
+
+/** A glass database with an optional feature enabled, and a plain twin.
+ *
+ *  Every change is made to both, so a test can check the feature gives the
+ *  same results as the plain database at each step, and just needs to
+ *  supply the checks specific to the feature.
+ */
+class TwinDatabases {
+    /// Path of the database with the feature.
+    std::string path;
+
+    /// Path of the plain database.
+    std::string plain_path;
+
+    /// Name to base the compaction output path on.
+    std::string name;
+
+  public:
+    /// Compare a database with the feature against a plain database.
+    typedef std::function<void(const Xapian::Database&,
+			       const Xapian::Database&)> Checker;
+
+    /// The database with the feature.
+    Xapian::WritableDatabase db;
+
+    /// The plain database.
+    Xapian::WritableDatabase plain;
+
+    /** Create the databases.
+     *
+     *  @param name_	Name to base the database paths on.
+     *  @param flag	The flag which enables the feature.
+     */
+    TwinDatabases(const std::string& name_, int flag);
+
+    const std::string& get_path() const { return path; }
+
+    const std::string& get_plain_path() const { return plain_path; }
+
+    /// Add @a doc to both databases.
+    void add_document(const Xapian::Document& doc);
+
+    /// Replace document @a did in both databases.
+    void replace_document(Xapian::docid did, const Xapian::Document& doc);
+
+    /** Delete document @a did from both databases.
+     *
+     *  @return false if it doesn't exist.
+     */
+    bool delete_document(Xapian::docid did);
+
+    /** Commit both databases, checking them before and after.
+     *
+     *  @a check is called with the uncommitted changes, after committing and
+     *  with the databases reopened.  The database with the feature is also
+     *  checked with Database::check() and to have a newer format version.
+     */
+    void commit(const Checker& check);
+
+    /** Reopen the database with the feature without passing its flag.
+     *
+     *  The feature should then be kept up to date anyway.
+     *
+     *  @param flags	Any other flags to open it with.
+     */
+    void reopen_without_flag(int flags = 0);
+
+    /** Check compaction keeps the feature, and @a compact_flag adds it.
+     *
+     *  The database with the feature is compacted to glass, single file
+     *  glass and honey, and the plain database to glass with
+     *  @a compact_flag.  @a check is called with each output and the plain
+     *  database, and the glass outputs are checked like commit() does.
+     */
+    void check_compactions(int compact_flag, const Checker& check);
+};
+
+#endif // XAPIAN_INCLUDED_TWINDBS_H
@@ -87,6 +87,8 @@ using namespace std;
 #include "../net/serialise-error.cc"
 #include "../api/error.cc"
 #include "../api/sortable-serialise.cc"
+#include "../backends/glass/glass_blockcache.cc"
+#include "../backends/glass/glass_termfilter.h"
 #include "../include/xapian/intrusive_ptr.h"
 
 // fileutils.cc uses opendir(), etc though not in a function we currently test.
@@ -860,6 +862,80 @@ static void test_parsesigned1()
     parsesigned_helper<long long>();
 }
 
+// Check the block cache forgets file ids once nothing uses them.
+static void test_blockcachefileids1()
+{
+    size_t base = GlassBlockCache::get_file_id_count();
+    uint64_t a = GlassBlockCache::get_file_id("a");
+    if (a == 0) SKIP_TEST("Block cache disabled");
+    TEST_EQUAL(GlassBlockCache::get_file_id("a"), a);
+    uint64_t b = GlassBlockCache::get_file_id("b");
+    TEST_NOT_EQUAL(a, b);
+    TEST_EQUAL(GlassBlockCache::get_file_id_count(), base + 2);
+
+    GlassBlockCache::release_file_id(a);
+    TEST_EQUAL(GlassBlockCache::get_file_id_count(), base + 2);
+    GlassBlockCache::release_file_id(a);
+    TEST_EQUAL(GlassBlockCache::get_file_id_count(), base + 1);
+
+    // A file opened again gets a fresh id, so stale blocks can't be returned.
+    uint64_t a2 = GlassBlockCache::get_file_id("a");
+    TEST_NOT_EQUAL(a2, a);
+    GlassBlockCache::release_file_id(a2);
+    GlassBlockCache::release_file_id(b);
+    TEST_EQUAL(GlassBlockCache::get_file_id_count(), base);
+
+    for (int i = 0; i < 1000; ++i) {
+	GlassBlockCache::release_file_id(GlassBlockCache::get_file_id(str(i)));
+    }
+    TEST_EQUAL(GlassBlockCache::get_file_id_count(), base);
+}
+
+// Check the glass term filter finds the terms added and rejects others.
+static void test_termfilter1()
+{
+    typedef GlassTermFilter F;
+    // The hash is stored in databases, so mustn't change.
+    TEST_EQUAL(F::hash(""), 0xefd01f60ba992926ull);
+    TEST_EQUAL(F::hash("xapian"), 0xff8a10ddb4641628ull);
+
+    const unsigned block_bytes = F::BLOCK_BITS / 8;
+    const unsigned n_terms = 10000;
+    const uint32_t blocks = n_terms * F::BITS_PER_TERM / F::BLOCK_BITS;
+    string filter(size_t(blocks) * block_bytes, '\0');
+    auto block = [&](uint64_t h) {
+	return &filter[size_t(F::block_index(h, blocks)) * block_bytes];
+    };
+
+    // An empty filter contains nothing.
+    for (unsigned i = 0; i != 1000; ++i) {
+	uint64_t h = F::hash("t" + str(i));
+	TEST(F::block_index(h, blocks) < blocks);
+	TEST(!F::block_contains(block(h), h));
+    }
+
+    for (unsigned i = 0; i != n_terms; ++i) {
+	uint64_t h = F::hash("t" + str(i));
+	F::block_add(block(h), h);
+    }
+    for (unsigned i = 0; i != n_terms; ++i) {
+	uint64_t h = F::hash("t" + str(i));
+	TEST(F::block_contains(block(h), h));
+    }
+
+    // With the filter sized for the terms, only a small proportion of other
+    // terms should get through.
+    unsigned false_positives = 0;
+    const unsigned n_tries = 100000;
+    for (unsigned i = 0; i != n_tries; ++i) {
+	uint64_t h = F::hash("u" + str(i));
+	if (F::block_contains(block(h), h)) ++false_positives;
+    }
+    tout << "False positive rate " << false_positives * 100.0 / n_tries
+	 << "%" << endl;
+    TEST_REL(false_positives, <, n_tries / 100);
+}
+
 static const test_desc tests[] = {
     TESTCASE(simple_exceptions_work1),
     TESTCASE(class_exceptions_work1),
@@ -883,6 +959,8 @@ static const test_desc tests[] = {
     TESTCASE(muloverflows1),
     TESTCASE(parseunsigned1),
     TESTCASE(parsesigned1),
+    TESTCASE(blockcachefileids1),
+    TESTCASE(termfilter1),
     END_OF_TESTCASES
 };
 
@@ -133,6 +133,31 @@ BM25PlusWeight::get_sumpart(Xapian::termcount wdf, Xapian::termcount len,
     RETURN(termweight * ((param_k1 + 1) * wdf_double / denom + param_delta));
 }
 
+void
+BM25PlusWeight::get_sumpart_batch(Xapian::doccount n,
+				  const Xapian::termcount* wdf,
+				  const Xapian::termcount* len,
+				  const Xapian::termcount*,
+				  const Xapian::termcount*,
+				  double* result) const
+{
+    LOGCALL_VOID(WTCALC, "BM25PlusWeight::get_sumpart_batch", n);
+    // Use locals so the loop can be vectorised - see
+    // BM25Weight::get_sumpart_batch().
+    const double k1 = param_k1;
+    const double b = param_b;
+    const double delta = param_delta;
+    const double factor = len_factor;
+    const double min_normlen = param_min_normlen;
+    const double tw = termweight;
+    for (Xapian::doccount i = 0; i != n; ++i) {
+	Xapian::doclength normlen = max(len[i] * factor, min_normlen);
+	double wdf_double = wdf[i];
+	double denom = k1 * (normlen * b + (1 - b)) + wdf_double;
+	result[i] = tw * ((k1 + 1) * wdf_double / denom + delta);
+    }
+}
+
 double
 BM25PlusWeight::get_maxpart() const
 {
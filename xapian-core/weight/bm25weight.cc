@@ -180,6 +180,32 @@ BM25Weight::get_sumpart(Xapian::termcount wdf, Xapian::termcount len,
     RETURN(termweight * (wdf_double / denom));
 }
 
+void
+BM25Weight::get_sumpart_batch(Xapian::doccount n,
+			      const Xapian::termcount* wdf,
+			      const Xapian::termcount* len,
+			      const Xapian::termcount*,
+			      const Xapian::termcount*,
+			      double* result) const
+{
+    LOGCALL_VOID(WTCALC, "BM25Weight::get_sumpart_batch", n);
+    // Copy the parameters to locals so the compiler knows that storing to
+    // result can't change them, which allows the loop to be vectorised.  The
+    // calculation is exactly that in get_sumpart() so the results are
+    // identical.
+    const double k1 = param_k1;
+    const double b = param_b;
+    const double factor = len_factor;
+    const double min_normlen = param_min_normlen;
+    const double tw = termweight;
+    for (Xapian::doccount i = 0; i != n; ++i) {
+	Xapian::doclength normlen = max(len[i] * factor, min_normlen);
+	double wdf_double = wdf[i];
+	double denom = k1 * (normlen * b + (1 - b)) + wdf_double;
+	result[i] = tw * (wdf_double / denom);
+    }
+}
+
 double
 BM25Weight::get_maxpart() const
 {
@@ -218,6 +218,55 @@ TfIdfWeight::get_sumpart(Xapian::termcount wdf,
     return get_wtn(wdfn * idfn, wt_norm_) * wqf_factor;
 }
 
+void
+TfIdfWeight::get_sumpart_batch(Xapian::doccount n,
+			       const Xapian::termcount* wdf,
+			       const Xapian::termcount* doclen,
+			       const Xapian::termcount* uniqterms,
+			       const Xapian::termcount* wdfdocmax,
+			       double* result) const
+{
+    // get_wtn() currently always returns its argument unchanged, so we can
+    // fold idfn and wqf_factor into a single multiplier.  For the simpler
+    // wdf normalisations we select the calculation once rather than for each
+    // document, giving loops which the compiler can vectorise.
+    const double mult = idfn;
+    const double wqf = wqf_factor;
+    switch (wdf_norm_) {
+	case wdf_norm::NONE:
+	    for (Xapian::doccount i = 0; i != n; ++i) {
+		double wdfn = wdf[i];
+		result[i] = (wdfn * mult) * wqf;
+	    }
+	    return;
+	case wdf_norm::BOOLEAN:
+	    for (Xapian::doccount i = 0; i != n; ++i) {
+		double wdfn = wdf[i] ? 1.0 : 0.0;
+		result[i] = (wdfn * mult) * wqf;
+	    }
+	    return;
+	case wdf_norm::SQUARE:
+	    for (Xapian::doccount i = 0; i != n; ++i) {
+		double wdfn = wdf[i] * wdf[i];
+		result[i] = (wdfn * mult) * wqf;
+	    }
+	    return;
+	case wdf_norm::MAX:
+	    for (Xapian::doccount i = 0; i != n; ++i) {
+		double wdfn = double(wdf[i]) / wdfdocmax[i];
+		result[i] = (wdfn * mult) * wqf;
+	    }
+	    return;
+	default:
+	    break;
+    }
+    for (Xapian::doccount i = 0; i != n; ++i) {
+	double wdfn = get_wdfn(wdf[i], doclen[i], uniqterms[i], wdfdocmax[i],
+			       wdf_norm_);
+	result[i] = get_wtn(wdfn * idfn, wt_norm_) * wqf_factor;
+    }
+}
+
 // An upper bound can be calculated simply on the basis of wdf_max as termfreq
 // and N are constants.
 double
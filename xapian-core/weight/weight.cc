@@ -147,6 +147,19 @@ Weight::unserialise(const string &) const
     throw Xapian::UnimplementedError("unserialise() not supported for this Xapian::Weight subclass");
 }
 
+void
+Weight::get_sumpart_batch(Xapian::doccount n,
+			  const Xapian::termcount* wdf,
+			  const Xapian::termcount* doclen,
+			  const Xapian::termcount* uniqterms,
+			  const Xapian::termcount* wdfdocmax,
+			  double* result) const
+{
+    for (Xapian::doccount i = 0; i != n; ++i) {
+	result[i] = get_sumpart(wdf[i], doclen[i], uniqterms[i], wdfdocmax[i]);
+    }
+}
+
 const Weight *
 Weight::create(const string & s, const Registry & reg)
 {
@@ -30,6 +30,7 @@
 #include "str.h"
 #include "api/termlist.h"
 
+#include <algorithm>
 #include <memory>
 #include <set>
 
@@ -127,6 +128,48 @@ Weight::Internal::merge(const Weight::Internal& o)
     }
 }
 
+double
+Weight::Internal::get_block_maxpart(const Xapian::Weight& wt,
+				    Xapian::termcount wdf_max,
+				    Xapian::termcount doclen_min)
+{
+    bool tighter_wdf = (wt.stats_needed & WDF_MAX) &&
+		       wdf_max < wt.wdf_upper_bound_;
+    bool tighter_doclen = (wt.stats_needed & DOC_LENGTH_MIN) &&
+			  doclen_min > wt.doclength_lower_bound_;
+    if (!tighter_wdf && !tighter_doclen) {
+	// No tighter than the bounds for the whole posting list.
+	return wt.get_maxpart();
+    }
+    // The Weight object is owned by the postlist asking for the bound, so we
+    // can temporarily adjust its bounds in place.  We can't use a clone as
+    // the factor passed to init() isn't kept.  The bounds are restored even
+    // if get_maxpart() throws.
+    class BoundsRestorer {
+	Xapian::Weight& w;
+
+	Xapian::termcount wdf_upper_bound;
+
+	Xapian::termcount doclength_lower_bound;
+
+      public:
+	explicit BoundsRestorer(Xapian::Weight& w_)
+	    : w(w_),
+	      wdf_upper_bound(w_.wdf_upper_bound_),
+	      doclength_lower_bound(w_.doclength_lower_bound_) { }
+
+	~BoundsRestorer() {
+	    w.wdf_upper_bound_ = wdf_upper_bound;
+	    w.doclength_lower_bound_ = doclength_lower_bound;
+	}
+    };
+    Xapian::Weight& w = const_cast<Xapian::Weight&>(wt);
+    BoundsRestorer restorer(w);
+    if (tighter_wdf) w.wdf_upper_bound_ = wdf_max;
+    if (tighter_doclen) w.doclength_lower_bound_ = doclen_min;
+    return w.get_maxpart();
+}
+
 string
 Weight::Internal::get_description() const
 {
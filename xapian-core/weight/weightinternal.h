@@ -242,6 +242,23 @@ class Weight::Internal {
     /// Return a std::string describing this object.
     std::string get_description() const;
 
+    /** Calculate an upper bound on the weight for a block of postings.
+     *
+     *  The result is what @a wt's get_maxpart() returns with its wdf upper
+     *  bound and doclength lower bound tightened to @a wdf_max and
+     *  @a doclen_min.  Weighting schemes which calculate their bound in
+     *  get_maxpart() from these statistics give a tighter bound, while others
+     *  just return their usual bound.
+     *
+     *  @param wt		Weight object, which must be initialised.
+     *  @param wdf_max	Upper bound on the wdf in the block.
+     *  @param doclen_min	Lower bound on the document length in the block
+     *			(0 if not known).
+     */
+    static double get_block_maxpart(const Xapian::Weight& wt,
+				    Xapian::termcount wdf_max,
+				    Xapian::termcount doclen_min);
+
     static bool double_param(const char ** p, double * ptr_val) {
 	char *end;
 	errno = 0;